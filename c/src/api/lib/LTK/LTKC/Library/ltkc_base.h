@@ -42,10 +42,14 @@ struct LLRP_SDecoder;
 struct LLRP_SDecoderOps;
 struct LLRP_SDecoderStream;
 struct LLRP_SDecoderStreamOps;
+struct LLRP_SFrameDecoder;
 struct LLRP_SEncoder;
 struct LLRP_SEncoderOps;
 struct LLRP_SEncoderStream;
 struct LLRP_SEncoderStreamOps;
+struct LLRP_SArena;
+struct LLRP_SArenaChunk;
+struct LLRP_SArenaAdopted;
 
 
 typedef enum LLRP_ResultCode            LLRP_tResultCode;
@@ -69,6 +73,9 @@ typedef struct LLRP_SEncoder            LLRP_tSEncoder;
 typedef struct LLRP_SEncoderOps         LLRP_tSEncoderOps;
 typedef struct LLRP_SEncoderStream      LLRP_tSEncoderStream;
 typedef struct LLRP_SEncoderStreamOps   LLRP_tSEncoderStreamOps;
+typedef struct LLRP_SArena              LLRP_tSArena;
+typedef struct LLRP_SArenaChunk         LLRP_tSArenaChunk;
+typedef struct LLRP_SArenaAdopted       LLRP_tSArenaAdopted;
 
 
 typedef struct
@@ -376,6 +383,18 @@ struct LLRP_STypeDescriptor
       LLRP_tSElement *          pElement,
       LLRP_tSDecoderStream *    pDecoderStream);
 
+    /* Generated for most types: decodes the fields straight from
+     * a frame, ending before iLimit, checking the bounds once
+     * rather than field by field. Returns FALSE, having possibly
+     * filled in some fields, if anything is amiss; the frame
+     * decoder then starts over with pfDecodeFields(), which
+     * reports the error. NULL if the type has none. */
+    llrp_bool_t
+    (*pfDecodeFrameFields) (
+      LLRP_tSElement *          pElement,
+      struct LLRP_SFrameDecoder *pDecoder,
+      unsigned int              iLimit);
+
     /* After fields are decoded, the CDecoder itself takes care
      * of gathering the subparameters into m_listAllSubParameters.
      * Once the end of the enclosing TLV (or message) is reached
@@ -474,9 +493,16 @@ struct LLRP_SEnumTableEntry
  * A collection of pointers to STypeDescriptors.
  * During decode operations types can be looked up
  * by code (vendor and typenum) or by name.
+ *
+ * Custom types and names are found through open-addressed
+ * hash indexes, filled as types are enrolled. Each index
+ * has at least twice as many slots as it can hold entries.
  */
 #define LTKC_MAX_CUSTOM_MESSAGE     100u
 #define LTKC_MAX_CUSTOM_PARAMETER   300u
+#define LTKC_CUSTOM_MESSAGE_INDEX_SIZE      256u
+#define LTKC_CUSTOM_PARAMETER_INDEX_SIZE    1024u
+#define LTKC_NAME_INDEX_SIZE                8192u
 struct LLRP_STypeRegistry
 {
     /* Standard messages subscripted by type number */
@@ -484,14 +510,24 @@ struct LLRP_STypeRegistry
     /* Standard parameters subscripted by type number */
     const LLRP_tSTypeDescriptor * apStdParameterTypeDescriptors[1024u];
 
-    /* Custom messages, sequential search */
+    /* Custom messages, in enrolment order */
     const LLRP_tSTypeDescriptor *
                 apCustMessageTypeDescriptors[LTKC_MAX_CUSTOM_MESSAGE];
     unsigned int                nCustMessageTypeDescriptors;
-    /* Custom parameters, sequential search */
+    /* Custom parameters, in enrolment order */
     const LLRP_tSTypeDescriptor *
                 apCustParameterTypeDescriptors[LTKC_MAX_CUSTOM_PARAMETER];
     unsigned int                nCustParameterTypeDescriptors;
+
+    /* Custom messages hashed by vendor and subtype */
+    const LLRP_tSTypeDescriptor *
+                apCustMessageIndex[LTKC_CUSTOM_MESSAGE_INDEX_SIZE];
+    /* Custom parameters hashed by vendor and subtype */
+    const LLRP_tSTypeDescriptor *
+                apCustParameterIndex[LTKC_CUSTOM_PARAMETER_INDEX_SIZE];
+    /* All types hashed by name */
+    const LLRP_tSTypeDescriptor *
+                apNameIndex[LTKC_NAME_INDEX_SIZE];
 };
 
 /* Create a new TypeRegistry */
@@ -535,6 +571,12 @@ LLRP_TypeRegistry_lookupCustomParameter (
   unsigned int                  VendorID,
   unsigned int                  ParameterSubTypeNum);
 
+/* Lookup a type descriptor by name, "Name" or "prefix:Name". NULL=>not found */
+const LLRP_tSTypeDescriptor *
+LLRP_TypeRegistry_lookupByName (
+  const LLRP_tSTypeRegistry *   pTypeRegistry,
+  const char *                  pElementName);
+
 
 /*
  * SElement
@@ -573,6 +615,17 @@ struct LLRP_SElement
 
     /* List of all sub elements */
     LLRP_tSParameter *          listAllSubParameters;
+
+    /* Last entry of listAllSubParameters, for appending in O(1) */
+    LLRP_tSParameter *          pLastAllSubParameter;
+
+    /* The sub-parameter list most recently appended to, and its
+     * last entry, so building a list in order is O(1) per entry */
+    LLRP_tSParameter **         ppLastListHead;
+    LLRP_tSParameter *          pLastListEntry;
+
+    /* Arena holding this element, NULL if it was malloc()ed */
+    LLRP_tSArena *              pArena;
 };
 
 struct LLRP_SMessage
@@ -591,11 +644,67 @@ struct LLRP_SParameter
     /* Next pointer for list of all sub elements */
     LLRP_tSParameter *          pNextAllSubParameters;
 
+    /* Previous pointer for list of all sub elements */
+    LLRP_tSParameter *          pPrevAllSubParameters;
+
     /* Next pointer for element headed by specific member */
     LLRP_tSParameter *          pNextSubParameter;
 };
 
 
+/*
+ * An arena holds a whole decoded message tree, elements and
+ * vector fields alike, in a few large chunks. Destructing the
+ * root element releases everything in one step; destructing
+ * any other element of the tree does nothing.
+ *
+ * Heap allocated parameters and vector values that are later
+ * attached to an arena element are adopted by the arena and
+ * released along with it.
+ */
+struct LLRP_SArena
+{
+    /* The element whose destruct releases the arena */
+    LLRP_tSElement *            pRoot;
+
+    /* Chunks, most recent first, and the free space in the first */
+    LLRP_tSArenaChunk *         pChunkList;
+    unsigned char *             pNext;
+    unsigned int                nLeft;
+
+    /* Size of the next chunk to allocate */
+    unsigned int                nNextChunkSize;
+
+    /* Heap allocations to release with the arena */
+    LLRP_tSArenaAdopted *       pAdoptedList;
+};
+
+/* Typical decoded tree size relative to its frame, to size an arena */
+#define LLRP_ARENA_BYTES_PER_FRAME_BYTE 20u
+
+extern LLRP_tSArena *
+LLRP_Arena_construct (
+  unsigned int                  nSizeHint);
+
+extern void
+LLRP_Arena_destruct (
+  LLRP_tSArena *                pArena);
+
+extern void *
+LLRP_Arena_alloc (
+  LLRP_tSArena *                pArena,
+  unsigned int                  nByte);
+
+extern LLRP_tResultCode
+LLRP_Arena_adoptMemory (
+  LLRP_tSArena *                pArena,
+  void *                        pMemory);
+
+extern LLRP_tResultCode
+LLRP_Arena_adoptElement (
+  LLRP_tSArena *                pArena,
+  LLRP_tSElement *              pElement);
+
 /*
  * ltkc_element.c
  */
@@ -603,6 +712,15 @@ LLRP_tSElement *
 LLRP_Element_construct (
   const LLRP_tSTypeDescriptor *  pTypeDescriptor);
 
+extern LLRP_tSElement *
+LLRP_Element_constructInArena (
+  const LLRP_tSTypeDescriptor * pTypeDescriptor,
+  LLRP_tSArena *                pArena);
+
+extern void
+LLRP_Element_arenaDestruct (
+  LLRP_tSElement *              pElement);
+
 extern void
 LLRP_Element_destruct (
   LLRP_tSElement *              pElement);
@@ -642,6 +760,10 @@ LLRP_Element_attachToSubParameterList (
   LLRP_tSParameter **           ppListHead,
   LLRP_tSParameter *            pValue);
 
+extern LLRP_tSParameter **
+LLRP_Element_findSubParameterListTail (
+  LLRP_tSParameter **           ppListHead);
+
 extern void
 LLRP_Element_clearSubParameterList (
   LLRP_tSElement *              pElement,
@@ -1213,3 +1335,9 @@ LLRP_toXMLString (
   const LLRP_tSElement *        pElement,
   char *                        pBuffer,
   int                           nBuffer);
+
+extern LLRP_tResultCode
+LLRP_toXMLFile (
+  const LLRP_tSElement *        pElement,
+  FILE *                        pFile,
+  int                           bCompact);
@@ -65,12 +65,19 @@ static LLRP_tResultCode
 recvAdvance (
   LLRP_tSConnection *           pConn,
   int                           nMaxMS,
-  time_t                        timeLimit);
+  llrp_u64_t                    timeLimit);
 
-static time_t
+static llrp_u64_t
 calculateTimeLimit (
   int                           nMaxMS);
 
+static llrp_u64_t
+monotonicMS (void);
+
+static LLRP_tResultCode
+sendBuffer (
+  LLRP_tSConnection *           pConn);
+
 
 
 /**
@@ -134,6 +141,7 @@ LLRP_Conn_construct (
     pConn->fd = -1;
     pConn->pTypeRegistry = pTypeRegistry;
     pConn->nBufferSize = nBufferSize;
+    pConn->bNoDelay = TRUE;
 
     /*
      * Allocate and check each the recv and send buffers.
@@ -147,6 +155,18 @@ LLRP_Conn_construct (
         return NULL;
     }
 
+    /*
+     * One encoder serves every send. It always encodes
+     * into the send buffer.
+     */
+    pConn->Send.pEncoder = LLRP_FrameEncoder_construct(pConn->Send.pBuffer,
+                                                        nBufferSize);
+    if(NULL == pConn->Send.pEncoder)
+    {
+        LLRP_Conn_destruct(pConn);
+        return NULL;
+    }
+
     /*
      * Zero-fill buffers just so debugger printing is reasonable
      */
@@ -206,6 +226,10 @@ LLRP_Conn_destruct (
         {
             free(pConn->Send.pBuffer);
         }
+        if(NULL != pConn->Send.pEncoder)
+        {
+            LLRP_Encoder_destruct(&pConn->Send.pEncoder->encoderHdr);
+        }
 
         /*
          * Wipe it out so any stale uses are likely to crash
@@ -312,6 +336,17 @@ LLRP_Conn_openConnectionToReader (
         return -3;
     }
 
+    /*
+     * Size the receive buffer before connecting so the
+     * window scale offered in the SYN can cover it.
+     * Best effort, like no delay below.
+     */
+    if(0 < pConn->nSocketRecvBufferSize)
+    {
+        Flag = pConn->nSocketRecvBufferSize;
+        setsockopt(Sock, SOL_SOCKET, SO_RCVBUF, (void*)&Flag, sizeof Flag);
+    }
+
     /*
      * Connect the socket to reader. This can stall.
      */
@@ -320,7 +355,7 @@ LLRP_Conn_openConnectionToReader (
     {
         /* Connect failed */
         pConn->pConnectErrorStr = "connect() failed";
-        close(pConn->fd);
+        close(Sock);
         return -4;
     }
 
@@ -328,8 +363,11 @@ LLRP_Conn_openConnectionToReader (
      * Best effort to set no delay. If this doesn't work
      * (no reason it shouldn't) we do not declare defeat.
      */
-    Flag = 1;
-    setsockopt(Sock, IPPROTO_TCP, TCP_NODELAY, (void*)&Flag, sizeof Flag);
+    if(pConn->bNoDelay)
+    {
+        Flag = 1;
+        setsockopt(Sock, IPPROTO_TCP, TCP_NODELAY, (void*)&Flag, sizeof Flag);
+    }
 
     /*
      * Record the socket in the connection instance
@@ -390,6 +428,13 @@ LLRP_Conn_closeConnectionToReader (
 
     pConn->fd = -1;
 
+    /*
+     * Whatever was read ahead belongs to the old stream.
+     */
+    pConn->Recv.nBuffer = 0;
+    pConn->Recv.iFrame = 0;
+    pConn->Recv.bFrameValid = FALSE;
+
     return 0;
 }
 
@@ -524,7 +569,7 @@ LLRP_Conn_sendMessage (
   LLRP_tSMessage *              pMessage)
 {
     LLRP_tSErrorDetails *       pError = &pConn->Send.ErrorDetails;
-    LLRP_tSFrameEncoder *       pEncoder;
+    LLRP_tSFrameEncoder *       pEncoder = pConn->Send.pEncoder;
 
     /*
      * Clear the error details in the send state.
@@ -542,22 +587,10 @@ LLRP_Conn_sendMessage (
     }
 
     /*
-     * Construct a frame encoder. It needs to know the buffer
-     * base and maximum size.
+     * Start the connection's encoder over at the
+     * beginning of the send buffer.
      */
-
-    pEncoder = LLRP_FrameEncoder_construct(pConn->Send.pBuffer,
-                                                pConn->nBufferSize);
-
-    /*
-     * Check that the encoder actually got created.
-     */
-    if(NULL == pEncoder)
-    {
-        LLRP_Error_resultCodeAndWhatStr(pError,
-            LLRP_RC_MiscError, "encoder constructor failed");
-        return pError->eResultCode;
-    }
+    LLRP_FrameEncoder_reset(pEncoder);
 
     /*
      * Encode the message. Return value is ignored.
@@ -575,32 +608,13 @@ LLRP_Conn_sendMessage (
     pConn->Send.ErrorDetails = pEncoder->encoderHdr.ErrorDetails;
     pConn->Send.nBuffer = pEncoder->iNext;
 
-    /*
-     * Bye bye li'l encoder.
-     */
-    LLRP_Encoder_destruct(&pEncoder->encoderHdr);
-
     /*
      * If the encoding appears complete write the frame
-     * to the connection. NB: this is not ready for
-     * non-blocking I/O (EWOULDBLOCK).
+     * to the connection.
      */
     if(LLRP_RC_OK == pError->eResultCode)
     {
-        int             rc;
-
-        rc = write(pConn->fd, pConn->Send.pBuffer, pConn->Send.nBuffer);
-        pError->OtherDetail = rc;
-        if (-1 == rc)
-        {
-          pError->tcpErrno = errno;
-        }
-        if(rc != pConn->Send.nBuffer)
-        {
-            /* Yikes! */
-            LLRP_Error_resultCodeAndWhatStr(pError,
-                LLRP_RC_SendIOError, "send IO error");
-        }
+        sendBuffer(pConn);
     }
 
     /*
@@ -610,6 +624,75 @@ LLRP_Conn_sendMessage (
 }
 
 
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send an already encoded LLRP frame to a connection
+ **
+ ** Commands that never change can be encoded once and sent
+ ** from then on with this. The frame is copied to the send
+ ** buffer and given the MessageID, so the caller's copy is
+ ** left alone and the send buffer holds what went out, just
+ ** like after LLRP_Conn_sendMessage().
+ **
+ ** @param[in]  pConn           Pointer to the connection instance.
+ ** @param[in]  pFrame          The encoded frame
+ ** @param[in]  nFrame          Length of the frame, in bytes
+ ** @param[in]  MessageID       MessageID to send the frame with
+ **
+ ** @return     LLRP_RC_OK          Frame sent
+ **             LLRP_RC_SendIOError I/O error in write().
+ **                                 Probably means fd is bad.
+ **             LLRP_RC_InvalidLength
+ **                                 nFrame disagrees with the frame
+ **                                 header or the send buffer size
+ **
+ *****************************************************************************/
+
+LLRP_tResultCode
+LLRP_Conn_sendFrame (
+  LLRP_tSConnection *           pConn,
+  const unsigned char *         pFrame,
+  unsigned int                  nFrame,
+  llrp_u32_t                    MessageID)
+{
+    LLRP_tSErrorDetails *       pError = &pConn->Send.ErrorDetails;
+    unsigned char *             pBuffer = pConn->Send.pBuffer;
+    LLRP_tSFrameExtract         frameExtract;
+
+    LLRP_Error_clear(pError);
+
+    if(0 > pConn->fd)
+    {
+        LLRP_Error_resultCodeAndWhatStr(pError,
+            LLRP_RC_MiscError, "not connected");
+        return pError->eResultCode;
+    }
+
+    /*
+     * The frame must be whole, as its own header says.
+     */
+    frameExtract = LLRP_FrameExtract(pFrame, nFrame);
+    if(LLRP_FRAME_READY != frameExtract.eStatus ||
+       frameExtract.MessageLength != nFrame ||
+       pConn->nBufferSize < nFrame)
+    {
+        LLRP_Error_resultCodeAndWhatStr(pError,
+            LLRP_RC_InvalidLength, "frame length mismatch");
+        return pError->eResultCode;
+    }
+
+    memcpy(pBuffer, pFrame, nFrame);
+    pBuffer[6] = (unsigned char)(MessageID >> 24u);
+    pBuffer[7] = (unsigned char)(MessageID >> 16u);
+    pBuffer[8] = (unsigned char)(MessageID >> 8u);
+    pBuffer[9] = (unsigned char)MessageID;
+    pConn->Send.nBuffer = nFrame;
+
+    return sendBuffer(pConn);
+}
+
+
 /**
  *****************************************************************************
  **
@@ -655,7 +738,7 @@ LLRP_Conn_recvMessage (
   LLRP_tSConnection *           pConn,
   int                           nMaxMS)
 {
-    time_t                      timeLimit = calculateTimeLimit(nMaxMS);
+    llrp_u64_t                  timeLimit = calculateTimeLimit(nMaxMS);
     LLRP_tResultCode            lrc;
     LLRP_tSMessage *            pMessage;
 
@@ -720,6 +803,51 @@ LLRP_Conn_getRecvError (
 }
 
 
+/**
+ *****************************************************************************
+ **
+ ** @brief  Tell whether a message can be received without the socket
+ **
+ ** Frames read ahead are held in the receive buffer, so a
+ ** poll() or select() on the socket does not see them. Callers
+ ** that wait on the socket should check this first.
+ **
+ ** @param[in]  pConn           Pointer to the connection instance.
+ **
+ ** @return     !=0             A message is queued or a complete
+ **                             frame is buffered
+ **             ==0             Receiving would go to the socket
+ **
+ *****************************************************************************/
+
+int
+LLRP_Conn_hasBufferedMessage (
+  LLRP_tSConnection *           pConn)
+{
+    unsigned int                iNext = pConn->Recv.iFrame;
+    LLRP_tSFrameExtract         frameExtract;
+
+    if(NULL != pConn->pInputQueue)
+    {
+        return TRUE;
+    }
+
+    if(pConn->Recv.bFrameValid)
+    {
+        iNext += pConn->Recv.FrameExtract.MessageLength;
+    }
+    if(iNext >= pConn->Recv.nBuffer)
+    {
+        return FALSE;
+    }
+
+    frameExtract = LLRP_FrameExtract(&pConn->Recv.pBuffer[iNext],
+                                     pConn->Recv.nBuffer - iNext);
+
+    return LLRP_FRAME_READY == frameExtract.eStatus;
+}
+
+
 /**
  *****************************************************************************
  **
@@ -738,7 +866,7 @@ LLRP_Conn_getRecvError (
  ** queue while we continue to look for the sought message.
  **
  ** About timeLimit....
- ** The timeLimit is the last time() we'll try to receive
+ ** The timeLimit is the last monotonicMS() we'll try to receive
  ** the sought message and prevents "spinning".
  ** It is conceivable that a steady stream of messages
  ** other than the one sought could arrive, and the time
@@ -774,7 +902,7 @@ LLRP_Conn_recvResponse (
   const LLRP_tSTypeDescriptor * pResponseType,
   llrp_u32_t                    ResponseMessageID)
 {
-    time_t                      timeLimit = calculateTimeLimit(nMaxMS);
+    llrp_u64_t                  timeLimit = calculateTimeLimit(nMaxMS);
     const LLRP_tSTypeDescriptor *pErrorMsgType;
     LLRP_tResultCode            lrc;
     LLRP_tSMessage *            pMessage;
@@ -872,11 +1000,84 @@ LLRP_Conn_recvResponse (
 }
 
 
+/**
+ *****************************************************************************
+ **
+ ** @brief  Internal routine to write the send buffer to the connection
+ **
+ ** Short writes are continued from where they stopped, and
+ ** a socket that would block is waited on until it drains,
+ ** so the whole frame goes out even on a non-blocking fd.
+ **
+ ** @param[in]  pConn           Pointer to the connection instance.
+ **
+ ** @return     LLRP_RC_OK          Frame sent
+ **             LLRP_RC_SendIOError I/O error in write() or poll().
+ **                                 Probably means fd is bad.
+ **
+ *****************************************************************************/
+
+static LLRP_tResultCode
+sendBuffer (
+  LLRP_tSConnection *           pConn)
+{
+    LLRP_tSErrorDetails *       pError = &pConn->Send.ErrorDetails;
+    unsigned int                nSent = 0;
+
+    while(nSent < pConn->Send.nBuffer)
+    {
+        ssize_t                 rc;
+
+        rc = write(pConn->fd, &pConn->Send.pBuffer[nSent],
+                pConn->Send.nBuffer - nSent);
+        if(0 < rc)
+        {
+            nSent += rc;
+            continue;
+        }
+
+        if(0 > rc && EINTR == errno)
+        {
+            continue;
+        }
+
+        if(0 > rc && (EAGAIN == errno || EWOULDBLOCK == errno))
+        {
+            struct pollfd       pfd;
+
+            pfd.fd = pConn->fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+
+            if(0 <= poll(&pfd, 1, -1) || EINTR == errno)
+            {
+                continue;
+            }
+        }
+
+        /* Yikes! */
+        pError->tcpErrno = errno;
+        LLRP_Error_resultCodeAndWhatStr(pError,
+            LLRP_RC_SendIOError, "send IO error");
+        break;
+    }
+
+    pError->OtherDetail = nSent;
+
+    return pError->eResultCode;
+}
+
+
 /**
  *****************************************************************************
  **
  ** @brief  Internal routine to advance receiver
  **
+ ** Reads take whatever the socket has ready, up to the free
+ ** space in the buffer, so one read usually brings in several
+ ** frames. Those are handed out by later calls without going
+ ** back to the socket.
+ **
  ** @param[in]  pConn           Pointer to the connection instance.
  ** @param[in]  nMaxMS          -1 => block indefinitely
  **                              0 => just peek at input queue and
@@ -900,7 +1101,7 @@ static LLRP_tResultCode
 recvAdvance (
   LLRP_tSConnection *           pConn,
   int                           nMaxMS,
-  time_t                        timeLimit)
+  llrp_u64_t                    timeLimit)
 {
     LLRP_tSErrorDetails *       pError = &pConn->Recv.ErrorDetails;
 
@@ -909,12 +1110,30 @@ recvAdvance (
      */
     LLRP_Error_clear(pError);
 
+    /*
+     * The frame handed out last time is done with. Anything
+     * after it in the buffer was read ahead.
+     */
+    if(pConn->Recv.bFrameValid)
+    {
+        pConn->Recv.iFrame += pConn->Recv.FrameExtract.MessageLength;
+    }
+    if(pConn->Recv.iFrame >= pConn->Recv.nBuffer)
+    {
+        pConn->Recv.iFrame = 0;
+        pConn->Recv.nBuffer = 0;
+    }
+
     /*
      * Loop until victory or some sort of exception happens
      */
     for(;;)
     {
         int                     rc;
+        unsigned char *         pFrame =
+                                  &pConn->Recv.pBuffer[pConn->Recv.iFrame];
+        unsigned int            nFrame =
+                                  pConn->Recv.nBuffer - pConn->Recv.iFrame;
 
         /*
          * Note that the frame is in progress.
@@ -941,8 +1160,7 @@ recvAdvance (
          * LLRP_FRAME_NEED_MORE Need more input bytes to finish the frame.
          *                      The nBytesNeeded field is how many more.
          */
-        pConn->Recv.FrameExtract =
-            LLRP_FrameExtract(pConn->Recv.pBuffer, pConn->Recv.nBuffer);
+        pConn->Recv.FrameExtract = LLRP_FrameExtract(pFrame, nFrame);
 
         /*
          * Framing error?
@@ -960,9 +1178,30 @@ recvAdvance (
          */
         if(LLRP_FRAME_NEED_MORE == pConn->Recv.FrameExtract.eStatus)
         {
-            unsigned int        nRead = pConn->Recv.FrameExtract.nBytesNeeded;
-            unsigned char *     pBufPos =
-                                  &pConn->Recv.pBuffer[pConn->Recv.nBuffer];
+            unsigned int        nNeeded = pConn->Recv.FrameExtract.nBytesNeeded;
+            llrp_u64_t          now = 0;
+
+            /*
+             * A frame that can never fit would overrun the buffer.
+             */
+            if(nFrame + nNeeded > pConn->nBufferSize)
+            {
+                LLRP_Error_resultCodeAndWhatStr(pError,
+                    LLRP_RC_ExcessiveLength, "frame larger than recv buffer");
+                break;
+            }
+
+            /*
+             * Slide the partial frame to the front when the rest
+             * of it won't fit behind. It is rarely more than a
+             * read's worth of bytes.
+             */
+            if(pConn->Recv.nBuffer + nNeeded > pConn->nBufferSize)
+            {
+                memmove(pConn->Recv.pBuffer, pFrame, nFrame);
+                pConn->Recv.iFrame = 0;
+                pConn->Recv.nBuffer = nFrame;
+            }
 
             /*
              * Before we do anything that might block,
@@ -970,7 +1209,8 @@ recvAdvance (
              */
             if(0 != timeLimit)
             {
-                if(time(NULL) > timeLimit)
+                now = monotonicMS();
+                if(now > timeLimit)
                 {
                     /* Timeout */
                     LLRP_Error_resultCodeAndWhatStr(pError,
@@ -981,17 +1221,24 @@ recvAdvance (
 
             /*
              * If this is not a block indefinitely request use poll()
-             * to see if there is data in time.
+             * to see if there is data in time. Waits are cut
+             * to what is left before the time limit.
              */
             if(nMaxMS >= 0)
             {
                 struct pollfd           pfd;
+                int                     nPollMS = nMaxMS;
+
+                if(0 < nMaxMS && timeLimit - now < (llrp_u64_t)nPollMS)
+                {
+                    nPollMS = (int)(timeLimit - now);
+                }
 
                 pfd.fd = pConn->fd;
                 pfd.events = POLLIN;
                 pfd.revents = 0;
 
-                rc = poll(&pfd, 1, nMaxMS);
+                rc = poll(&pfd, 1, nPollMS);
                 if(0 > rc)
                 {
                     /* Error */
@@ -1009,9 +1256,11 @@ recvAdvance (
             }
 
             /*
-             * Read some number of bytes from the socket.
+             * Read as much as the socket has ready and the
+             * buffer can hold. At least nNeeded bytes fit.
              */
-            rc = read(pConn->fd, pBufPos, nRead);
+            rc = read(pConn->fd, &pConn->Recv.pBuffer[pConn->Recv.nBuffer],
+                    pConn->nBufferSize - pConn->Recv.nBuffer);
             if(0 > rc)
             {
                 /*
@@ -1057,67 +1306,93 @@ recvAdvance (
             LLRP_tSMessage **       ppMessageTail;
 
             /*
-             * Construct a new frame decoder. It needs the registry
-             * to facilitate decoding.
+             * The frame hook gets first look. If it hands back
+             * a message that stands in for the frame, there is
+             * nothing to decode.
              */
-            pDecoder = LLRP_FrameDecoder_construct(pConn->pTypeRegistry,
-                    pConn->Recv.pBuffer, pConn->Recv.nBuffer);
-
-            /*
-             * Make sure we really got one. If not, weird problem.
-             */
-            if(pDecoder == NULL)
+            pMessage = NULL;
+            if(NULL != pConn->pfFrameHook)
             {
-                /* All we can do is discard the frame. */
-                pConn->Recv.nBuffer = 0;
-                pConn->Recv.bFrameValid = FALSE;
-                LLRP_Error_resultCodeAndWhatStr(pError,
-                    LLRP_RC_MiscError, "decoder constructor failed");
-                break;
+                pMessage = pConn->pfFrameHook(pConn->pFrameHookContext,
+                        &pConn->Recv.FrameExtract, pFrame);
             }
 
-            /*
-             * Now ask the nice, brand new decoder to decode the frame.
-             * It returns NULL for some kind of error.
-             * The &...decoderHdr is in lieu of type casting since
-             * the generic LLRP_Decoder_decodeMessage() takes the
-             * generic LLRP_tSDecoder.
-             */
-            pMessage = LLRP_Decoder_decodeMessage(&pDecoder->decoderHdr);
-
-            /*
-             * Always capture the error details even when it works.
-             * Whatever happened, we are done with the decoder.
-             */
-            pConn->Recv.ErrorDetails = pDecoder->decoderHdr.ErrorDetails;
-
-            /*
-             * Bye bye and thank you li'l decoder.
-             */
-            LLRP_Decoder_destruct(&pDecoder->decoderHdr);
-
-            /*
-             * If NULL there was an error. Clean up the
-             * receive state. Return the error.
-             */
             if(NULL == pMessage)
             {
                 /*
-                 * Make sure the return is not LLRP_RC_OK
+                 * Construct a new frame decoder. It needs the registry
+                 * to facilitate decoding.
+                 */
+                pDecoder = LLRP_FrameDecoder_construct(pConn->pTypeRegistry,
+                        pFrame, pConn->Recv.FrameExtract.MessageLength);
+
+                /*
+                 * A decoded tree takes a few times the frame size.
+                 * If the arena can't be had, decode onto the heap.
+                 */
+                if(NULL != pDecoder && pConn->bDecodeIntoArena)
+                {
+                    pDecoder->pArena = LLRP_Arena_construct(
+                            LLRP_ARENA_BYTES_PER_FRAME_BYTE *
+                                pConn->Recv.FrameExtract.MessageLength);
+                }
+
+                /*
+                 * Make sure we really got one. If not, weird problem.
                  */
-                if(LLRP_RC_OK == pError->eResultCode)
+                if(pDecoder == NULL)
                 {
+                    /* All we can do is discard the frame. */
+                    pConn->Recv.iFrame += pConn->Recv.FrameExtract.MessageLength;
+                    pConn->Recv.bFrameValid = FALSE;
                     LLRP_Error_resultCodeAndWhatStr(pError,
-                        LLRP_RC_MiscError, "NULL message but no error");
+                        LLRP_RC_MiscError, "decoder constructor failed");
+                    break;
                 }
 
                 /*
-                 * All we can do is discard the frame.
+                 * Now ask the nice, brand new decoder to decode the frame.
+                 * It returns NULL for some kind of error.
+                 * The &...decoderHdr is in lieu of type casting since
+                 * the generic LLRP_Decoder_decodeMessage() takes the
+                 * generic LLRP_tSDecoder.
                  */
-                pConn->Recv.nBuffer = 0;
-                pConn->Recv.bFrameValid = FALSE;
+                pMessage = LLRP_Decoder_decodeMessage(&pDecoder->decoderHdr);
 
-                break;
+                /*
+                 * Always capture the error details even when it works.
+                 * Whatever happened, we are done with the decoder.
+                 */
+                pConn->Recv.ErrorDetails = pDecoder->decoderHdr.ErrorDetails;
+
+                /*
+                 * Bye bye and thank you li'l decoder.
+                 */
+                LLRP_Decoder_destruct(&pDecoder->decoderHdr);
+
+                /*
+                 * If NULL there was an error. Clean up the
+                 * receive state. Return the error.
+                 */
+                if(NULL == pMessage)
+                {
+                    /*
+                     * Make sure the return is not LLRP_RC_OK
+                     */
+                    if(LLRP_RC_OK == pError->eResultCode)
+                    {
+                        LLRP_Error_resultCodeAndWhatStr(pError,
+                            LLRP_RC_MiscError, "NULL message but no error");
+                    }
+
+                    /*
+                     * All we can do is discard the frame.
+                     */
+                    pConn->Recv.iFrame += pConn->Recv.FrameExtract.MessageLength;
+                    pConn->Recv.bFrameValid = FALSE;
+
+                    break;
+                }
             }
 
             /*
@@ -1134,11 +1409,10 @@ recvAdvance (
 
             /*
              * Note that the frame is valid. Consult
-             * Recv.FrameExtract.MessageLength.
-             * Clear the buffer count to be ready for next time.
+             * Recv.FrameExtract.MessageLength. It stays at
+             * Recv.iFrame until the next call moves past it.
              */
             pConn->Recv.bFrameValid = TRUE;
-            pConn->Recv.nBuffer = 0;
 
             break;
         }
@@ -1163,7 +1437,7 @@ recvAdvance (
  **
  ** Based on nMaxMS, the subscriber specified max time to
  ** await receipt of a (specific) message, determine the
- ** last time() to try.
+ ** last monotonicMS() to try.
  **
  ** The timeLimit prevents "spinning".
  ** See LLRP_Conn_recvResponse() above.
@@ -1175,42 +1449,27 @@ recvAdvance (
  **                             >0 => ms to await complete frame
  **
  ** @return     timeLimit        0 => never stop
- **                             >0 => latest time() to try
+ **                             >0 => latest monotonicMS() to try
  **
  *****************************************************************************/
 
-static time_t
+static llrp_u64_t
 calculateTimeLimit (
   int                           nMaxMS)
 {
     if(0 == nMaxMS)
     {
         /* When just peeking, try for at most one second */
-        return time(NULL) + 1;
+        return monotonicMS() + 1000u;
     }
     else if(0 < nMaxMS)
     {
         /*
-         * Try for a at most a certain period of time.
-         *
-         * timeLimit = now + ceil(nMaxMS/1000) + 1
-         *
-         * The last +1 compensates for not knowing
-         * when the next time() tick will happen.
-         *
-         * For example, if now is SECONDS.999 seconds
-         * the next tick will happen in 1 millisecond.
-         * Suppose nMaxMS is 500ms (1/2 second).
-         * Even rounding 500ms up to 1 second, the
-         * time limit without the +1 would be
-         * SECONDS+1 -- 1ms away. That's too soon.
-         *
-         * The extra +1 makes the maximum timeout
-         * longer than required. But the timeLimit
-         * is a safeguard anyway and usually the
-         * timeout will occur when the user wants.
+         * Try for at most nMaxMS. The clock ticks in
+         * milliseconds, so unlike time() there is no
+         * partial second to round for.
          */
-        return time(NULL) + ((nMaxMS + 1999u) / 1000u);
+        return monotonicMS() + (llrp_u64_t)nMaxMS;
     }
     else
     {
@@ -1218,3 +1477,26 @@ calculateTimeLimit (
         return 0;
     }
 }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Internal routine to read the monotonic clock
+ **
+ ** Time limits are kept on this clock so that changes to
+ ** the wall clock can't cut a wait short or stretch it.
+ **
+ ** @return                     Milliseconds since an arbitrary epoch
+ **
+ *****************************************************************************/
+
+static llrp_u64_t
+monotonicMS (void)
+{
+    struct timespec             ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (llrp_u64_t)ts.tv_sec * 1000u + ts.tv_nsec / 1000000u;
+}
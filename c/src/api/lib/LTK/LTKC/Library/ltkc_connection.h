@@ -33,6 +33,28 @@
 struct LLRP_SConnection;
 typedef struct LLRP_SConnection     LLRP_tSConnection;
 
+/*
+ * Connection features added since the ltkc_win32 snapshot. Code
+ * also built against that snapshot tests for them before use.
+ */
+#define LTKC_HAS_DECODE_INTO_ARENA
+#define LTKC_HAS_FRAME_HOOK
+#define LTKC_HAS_SOCKET_OPTIONS
+#define LTKC_HAS_RECV_READ_AHEAD
+#define LTKC_HAS_SEND_FRAME
+
+/**
+ ** Frame hook. Offered each complete frame before it is decoded.
+ ** Returning a message makes it stand in for the frame, which is
+ ** then not decoded. Returning NULL decodes the frame as usual.
+ ** The frame is only valid for the duration of the call.
+ */
+typedef LLRP_tSMessage *
+(*LLRP_tFrameHook) (
+  void *                        pContext,
+  const LLRP_tSFrameExtract *   pFrameExtract,
+  const unsigned char *         pFrame);
+
 
 /**
  *****************************************************************************
@@ -79,6 +101,23 @@ struct LLRP_SConnection
     /** Size of the send/recv buffers, below, specified at construct() time */
     unsigned int                nBufferSize;
 
+    /** Non-zero to decode each received message into its own arena
+     ** (LLRP_tSArena). Destructing the message then frees the whole
+     ** tree at once. Other elements of such a message must not be
+     ** destructed on their own, nor attached to another message. */
+    int                         bDecodeIntoArena;
+
+    /** Optional hook offered each received frame before decode,
+     ** and the context passed to it. See LLRP_tFrameHook. */
+    LLRP_tFrameHook             pfFrameHook;
+    void *                      pFrameHookContext;
+
+    /** Socket options applied by openConnectionToReader().
+     ** nSocketRecvBufferSize is the SO_RCVBUF to ask for, 0 leaves
+     ** the system default. bNoDelay sets TCP_NODELAY, on by default. */
+    int                         nSocketRecvBufferSize;
+    int                         bNoDelay;
+
     /** Receive state */
     struct
     {
@@ -88,6 +127,10 @@ struct LLRP_SConnection
         /** Count of bytes currently in buffer */
         unsigned int        nBuffer;
 
+        /** Offset of the current frame in the buffer. Bytes past
+         ** the end of it were read ahead and begin the next frame. */
+        unsigned int        iFrame;
+
         /** Valid boolean. TRUE means the buffer and frame summary
          ** variables are valid (usable). This is always
          ** FALSE mid receive */
@@ -109,6 +152,9 @@ struct LLRP_SConnection
         /** Count of bytes currently in buffer (from last send) */
         unsigned int        nBuffer;
 
+        /** Encoder over pBuffer, reset for each message sent */
+        LLRP_tSFrameEncoder *pEncoder;
+
         /** Details of last I/O or encoder error. */
         LLRP_tSErrorDetails ErrorDetails;
     }                           Send;
@@ -157,6 +203,13 @@ LLRP_Conn_sendMessage (
   LLRP_tSConnection *           pConn,
   LLRP_tSMessage *              pMessage);
 
+extern LLRP_tResultCode
+LLRP_Conn_sendFrame (
+  LLRP_tSConnection *           pConn,
+  const unsigned char *         pFrame,
+  unsigned int                  nFrame,
+  llrp_u32_t                    MessageID);
+
 extern const LLRP_tSErrorDetails *
 LLRP_Conn_getSendError (
   LLRP_tSConnection *           pConn);
@@ -177,3 +230,7 @@ extern const LLRP_tSErrorDetails *
 LLRP_Conn_getRecvError (
   LLRP_tSConnection *           pConn);
 
+extern int
+LLRP_Conn_hasBufferedMessage (
+  LLRP_tSConnection *           pConn);
+
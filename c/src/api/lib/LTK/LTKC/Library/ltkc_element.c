@@ -23,6 +23,194 @@
 #include "ltkc_base.h"
 
 
+/* Arena allocations are rounded up to keep 64-bit fields aligned */
+#define ARENA_ROUND(n)          (((n) + 7u) & ~7u)
+#define ARENA_MIN_CHUNK         1024u
+#define ARENA_MAX_CHUNK         (1024u * 1024u)
+
+struct LLRP_SArenaChunk
+{
+    LLRP_tSArenaChunk *         pNext;
+};
+
+struct LLRP_SArenaAdopted
+{
+    LLRP_tSArenaAdopted *       pNext;
+
+    /* Exactly one of these is set */
+    void *                      pMemory;
+    LLRP_tSElement *            pElement;
+};
+
+static unsigned char *
+arenaNewChunk (
+  LLRP_tSArena *                pArena,
+  unsigned int                  nByte)
+{
+    LLRP_tSArenaChunk *         pChunk;
+
+    pChunk = malloc(ARENA_ROUND(sizeof *pChunk) + nByte);
+    if(NULL == pChunk)
+    {
+        return NULL;
+    }
+
+    pChunk->pNext = pArena->pChunkList;
+    pArena->pChunkList = pChunk;
+    pArena->pNext = (unsigned char *) pChunk + ARENA_ROUND(sizeof *pChunk);
+    pArena->nLeft = nByte;
+
+    return pArena->pNext;
+}
+
+LLRP_tSArena *
+LLRP_Arena_construct (
+  unsigned int                  nSizeHint)
+{
+    LLRP_tSArenaChunk *         pChunk;
+    LLRP_tSArena *              pArena;
+    unsigned int                nChunk;
+
+    nChunk = ARENA_ROUND(nSizeHint);
+    if(ARENA_MIN_CHUNK > nChunk)
+    {
+        nChunk = ARENA_MIN_CHUNK;
+    }
+
+    /* The arena itself lives at the start of its first chunk */
+    pChunk = malloc(ARENA_ROUND(sizeof *pChunk) + nChunk);
+    if(NULL == pChunk)
+    {
+        return NULL;
+    }
+    pChunk->pNext = NULL;
+
+    pArena = (LLRP_tSArena *)
+                ((unsigned char *) pChunk + ARENA_ROUND(sizeof *pChunk));
+    memset(pArena, 0, sizeof *pArena);
+
+    pArena->pChunkList = pChunk;
+    pArena->pNext = (unsigned char *) pArena + ARENA_ROUND(sizeof *pArena);
+    pArena->nLeft = nChunk - ARENA_ROUND(sizeof *pArena);
+    pArena->nNextChunkSize = nChunk * 2u;
+
+    return pArena;
+}
+
+void
+LLRP_Arena_destruct (
+  LLRP_tSArena *                pArena)
+{
+    LLRP_tSArenaAdopted *       pAdopted;
+    LLRP_tSArenaChunk *         pChunk;
+    LLRP_tSArenaChunk *         pNextChunk;
+
+    if(NULL == pArena)
+    {
+        return;
+    }
+
+    for(pAdopted = pArena->pAdoptedList;
+        NULL != pAdopted;
+        pAdopted = pAdopted->pNext)
+    {
+        if(NULL != pAdopted->pElement)
+        {
+            LLRP_Element_destruct(pAdopted->pElement);
+        }
+        else
+        {
+            free(pAdopted->pMemory);
+        }
+    }
+
+    /* The last chunk freed holds the arena itself */
+    for(pChunk = pArena->pChunkList; NULL != pChunk; pChunk = pNextChunk)
+    {
+        pNextChunk = pChunk->pNext;
+        free(pChunk);
+    }
+}
+
+void *
+LLRP_Arena_alloc (
+  LLRP_tSArena *                pArena,
+  unsigned int                  nByte)
+{
+    void *                      pMemory;
+
+    nByte = ARENA_ROUND(nByte);
+    if(nByte > pArena->nLeft)
+    {
+        unsigned int            nChunk = pArena->nNextChunkSize;
+
+        if(nByte > nChunk)
+        {
+            nChunk = nByte;
+        }
+        if(NULL == arenaNewChunk(pArena, nChunk))
+        {
+            return NULL;
+        }
+        if(ARENA_MAX_CHUNK > pArena->nNextChunkSize)
+        {
+            pArena->nNextChunkSize *= 2u;
+        }
+    }
+
+    pMemory = pArena->pNext;
+    pArena->pNext += nByte;
+    pArena->nLeft -= nByte;
+
+    return pMemory;
+}
+
+LLRP_tResultCode
+LLRP_Arena_adoptMemory (
+  LLRP_tSArena *                pArena,
+  void *                        pMemory)
+{
+    LLRP_tSArenaAdopted *       pAdopted;
+
+    if(NULL == pMemory)
+    {
+        return LLRP_RC_OK;
+    }
+
+    pAdopted = LLRP_Arena_alloc(pArena, sizeof *pAdopted);
+    if(NULL == pAdopted)
+    {
+        return LLRP_RC_FieldAllocationFailed;
+    }
+
+    pAdopted->pMemory = pMemory;
+    pAdopted->pElement = NULL;
+    pAdopted->pNext = pArena->pAdoptedList;
+    pArena->pAdoptedList = pAdopted;
+
+    return LLRP_RC_OK;
+}
+
+LLRP_tResultCode
+LLRP_Arena_adoptElement (
+  LLRP_tSArena *                pArena,
+  LLRP_tSElement *              pElement)
+{
+    LLRP_tSArenaAdopted *       pAdopted;
+
+    pAdopted = LLRP_Arena_alloc(pArena, sizeof *pAdopted);
+    if(NULL == pAdopted)
+    {
+        return LLRP_RC_ParameterAllocationFailed;
+    }
+
+    pAdopted->pMemory = NULL;
+    pAdopted->pElement = pElement;
+    pAdopted->pNext = pArena->pAdoptedList;
+    pArena->pAdoptedList = pAdopted;
+
+    return LLRP_RC_OK;
+}
 
 
 LLRP_tSElement *
@@ -42,6 +230,41 @@ LLRP_Element_construct (
     return pElement;
 }
 
+LLRP_tSElement *
+LLRP_Element_constructInArena (
+  const LLRP_tSTypeDescriptor * pTypeDescriptor,
+  LLRP_tSArena *                pArena)
+{
+    LLRP_tSElement *            pElement;
+
+    if(NULL == pArena)
+    {
+        return LLRP_Element_construct(pTypeDescriptor);
+    }
+
+    pElement = LLRP_Arena_alloc(pArena, pTypeDescriptor->nSizeBytes);
+    if(NULL != pElement)
+    {
+        memset(pElement, 0, pTypeDescriptor->nSizeBytes);
+
+        pElement->pType = pTypeDescriptor;
+        pElement->pArena = pArena;
+    }
+
+    return pElement;
+}
+
+/* Called by the generated destructors for elements held in an arena */
+void
+LLRP_Element_arenaDestruct (
+  LLRP_tSElement *              pElement)
+{
+    if(pElement->pArena->pRoot == pElement)
+    {
+        LLRP_Arena_destruct(pElement->pArena);
+    }
+}
+
 void
 LLRP_Element_destruct (
   LLRP_tSElement *              pElement)
@@ -66,19 +289,23 @@ LLRP_Element_addSubParameterToAllList (
   LLRP_tSElement *              pElement,
   LLRP_tSParameter *            pParameter)
 {
-    LLRP_tSParameter **         ppParameter;
-    LLRP_tSParameter *          pNextParameter;
-
-    for(
-        ppParameter = &pElement->listAllSubParameters;
-        NULL != *ppParameter;
-        ppParameter = &pNextParameter->pNextAllSubParameters)
+    pParameter->pNextAllSubParameters = NULL;
+    if(NULL == pElement->listAllSubParameters)
+    {
+        pParameter->pPrevAllSubParameters = NULL;
+        pElement->listAllSubParameters = pParameter;
+    }
+    else
     {
-        pNextParameter = *ppParameter;
+        pParameter->pPrevAllSubParameters = pElement->pLastAllSubParameter;
+        pElement->pLastAllSubParameter->pNextAllSubParameters = pParameter;
     }
+    pElement->pLastAllSubParameter = pParameter;
 
-    pParameter->pNextAllSubParameters = NULL;
-    *ppParameter = pParameter;
+    if(NULL != pElement->pArena && NULL == pParameter->elementHdr.pArena)
+    {
+        LLRP_Arena_adoptElement(pElement->pArena, &pParameter->elementHdr);
+    }
 }
 
 void
@@ -86,26 +313,39 @@ LLRP_Element_removeSubParameterFromAllList (
   LLRP_tSElement *              pElement,
   LLRP_tSParameter *            pParameter)
 {
-    LLRP_tSParameter **         ppParameter;
-    LLRP_tSParameter *          pNextParameter;
+    if(NULL == pParameter->pPrevAllSubParameters &&
+       pElement->listAllSubParameters != pParameter)
+    {
+        /* Not on this element's list */
+        return;
+    }
 
-    for(
-        ppParameter = &pElement->listAllSubParameters;
-        NULL != *ppParameter;
-        )
+    if(NULL == pParameter->pPrevAllSubParameters)
     {
-        pNextParameter = *ppParameter;
-        if(pNextParameter == pParameter)
-        {
-            *ppParameter = pNextParameter->pNextAllSubParameters;
-        }
-        else
-        {
-            ppParameter = &pNextParameter->pNextAllSubParameters;
-        }
+        pElement->listAllSubParameters = pParameter->pNextAllSubParameters;
+    }
+    else
+    {
+        pParameter->pPrevAllSubParameters->pNextAllSubParameters =
+                pParameter->pNextAllSubParameters;
+    }
+    if(NULL == pParameter->pNextAllSubParameters)
+    {
+        pElement->pLastAllSubParameter = pParameter->pPrevAllSubParameters;
+    }
+    else
+    {
+        pParameter->pNextAllSubParameters->pPrevAllSubParameters =
+                pParameter->pPrevAllSubParameters;
+    }
+    if(pElement->pLastListEntry == pParameter)
+    {
+        pElement->ppLastListHead = NULL;
+        pElement->pLastListEntry = NULL;
     }
 
     pParameter->pNextAllSubParameters = NULL;
+    pParameter->pPrevAllSubParameters = NULL;
 }
 
 void
@@ -120,6 +360,9 @@ LLRP_Element_clearSubParameterAllList (
                 pParameter->pNextAllSubParameters;
         LLRP_Element_destruct(&pParameter->elementHdr);
     }
+    pElement->pLastAllSubParameter = NULL;
+    pElement->ppLastListHead = NULL;
+    pElement->pLastListEntry = NULL;
 }
 
 void
@@ -131,7 +374,11 @@ LLRP_Element_setSubParameterPtr (
     if(NULL != *ppPtr)
     {
         LLRP_Element_removeSubParameterFromAllList(pElement, *ppPtr);
-        LLRP_Element_destruct((LLRP_tSElement *) *ppPtr);
+        /* The arena releases whatever was attached to its elements */
+        if(NULL == pElement->pArena)
+        {
+            LLRP_Element_destruct((LLRP_tSElement *) *ppPtr);
+        }
     }
     *ppPtr = pValue;
     if(NULL != *ppPtr)
@@ -150,12 +397,21 @@ LLRP_Element_addToSubParameterList (
 
     if(NULL != pValue)
     {
-        while(NULL != *ppCur)
+        if(ppListHead == pElement->ppLastListHead &&
+           NULL != *ppListHead &&
+           NULL == pElement->pLastListEntry->pNextSubParameter)
         {
-            ppCur = &(*ppCur)->pNextSubParameter;
+            /* Appending to the same list as last time */
+            ppCur = &pElement->pLastListEntry->pNextSubParameter;
+        }
+        else
+        {
+            ppCur = LLRP_Element_findSubParameterListTail(ppListHead);
         }
         pValue->pNextSubParameter = NULL;
         *ppCur = pValue;
+        pElement->ppLastListHead = ppListHead;
+        pElement->pLastListEntry = pValue;
 
         LLRP_Element_addSubParameterToAllList(pElement, pValue);
     }
@@ -179,6 +435,21 @@ LLRP_Element_attachToSubParameterList (
     }
 }
 
+/* The link to store a new entry at the end of a sub-parameter list */
+LLRP_tSParameter **
+LLRP_Element_findSubParameterListTail (
+  LLRP_tSParameter **           ppListHead)
+{
+    LLRP_tSParameter **         ppCur = ppListHead;
+
+    while(NULL != *ppCur)
+    {
+        ppCur = &(*ppCur)->pNextSubParameter;
+    }
+
+    return ppCur;
+}
+
 void
 LLRP_Element_clearSubParameterList (
   LLRP_tSElement *              pElement,
@@ -187,12 +458,21 @@ LLRP_Element_clearSubParameterList (
     LLRP_tSParameter **         ppCur = ppListHead;
     LLRP_tSParameter *          pValue;
 
+    if(pElement->ppLastListHead == ppListHead)
+    {
+        pElement->ppLastListHead = NULL;
+        pElement->pLastListEntry = NULL;
+    }
+
     while (NULL != (pValue = *ppCur))
     {
         *ppCur = pValue->pNextSubParameter;
 
         LLRP_Element_removeSubParameterFromAllList(pElement, pValue);
-        LLRP_Element_destruct((LLRP_tSElement *) pValue);
+        if(NULL == pElement->pArena)
+        {
+            LLRP_Element_destruct((LLRP_tSElement *) pValue);
+        }
     }
 }
 
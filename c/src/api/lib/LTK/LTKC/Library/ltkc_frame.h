@@ -61,8 +61,40 @@ struct LLRP_SFrameDecoder
     unsigned int                iNext;
     unsigned int                BitFieldBuffer;
     unsigned int                nBitFieldResid;
+
+    /* If set, the message is decoded into this arena and the
+     * decoded message takes ownership of it */
+    LLRP_tSArena *              pArena;
+
+    /* If set, fields are always decoded through the decoder
+     * stream ops, never by the generated frame field decoders */
+    llrp_bool_t                 bDecodeFieldsByStream;
 };
 
+/*
+ * Big-endian reads for the generated frame field decoders.
+ * The caller has already checked the bytes are there.
+ */
+#define LLRP_FRAME_GET_U16(p)                                       \
+    ((llrp_u16_t)(((unsigned int)(p)[0] << 8u) | (p)[1]))
+#define LLRP_FRAME_GET_U32(p)                                       \
+    (((llrp_u32_t)(p)[0] << 24u) | ((llrp_u32_t)(p)[1] << 16u) |    \
+     ((llrp_u32_t)(p)[2] << 8u) | (llrp_u32_t)(p)[3])
+#define LLRP_FRAME_GET_U64(p)                                       \
+    (((llrp_u64_t)LLRP_FRAME_GET_U32(p) << 32u) |                   \
+     LLRP_FRAME_GET_U32((p) + 4))
+
+extern void *
+LLRP_FrameDecoder_allocVector (
+  LLRP_tSFrameDecoder *         pDecoder,
+  unsigned int                  nByte);
+
+extern llrp_bool_t
+LLRP_FrameDecoder_skipReserved (
+  const unsigned char **        ppNext,
+  unsigned int *                pnBitFieldResid,
+  unsigned int                  nBit);
+
 extern LLRP_tSFrameExtract
 LLRP_FrameExtract (
   const unsigned char *         pBuffer,
@@ -112,3 +144,7 @@ extern LLRP_tSFrameEncoder *
 LLRP_FrameEncoder_construct (
   unsigned char *               pBuffer,
   unsigned int                  nBuffer);
+
+extern void
+LLRP_FrameEncoder_reset (
+  LLRP_tSFrameEncoder *         pEncoder);
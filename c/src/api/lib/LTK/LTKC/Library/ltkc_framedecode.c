@@ -223,6 +223,11 @@ static LLRP_tSParameter *
 decodeParameter (
   LLRP_tSFrameDecoderStream *   pDecoderStream);
 
+static LLRP_tSElement *
+constructAndDecodeFields (
+  LLRP_tSFrameDecoderStream *   pDecoderStream,
+  const LLRP_tSTypeDescriptor * pTypeDescriptor);
+
 static unsigned int
 getRemainingByteCount (
   LLRP_tSFrameDecoderStream *   pDecoderStream);
@@ -250,6 +255,11 @@ verifyVectorAllocation (
   const void *                  pValue,
   const LLRP_tSFieldDescriptor *pFieldDescriptor);
 
+static void *
+allocVector (
+  LLRP_tSFrameDecoderStream *   pDecoderStream,
+  unsigned int                  nByte);
+
 /*
  * END forward decls
  */
@@ -338,6 +348,9 @@ decoderDestruct (
 {
     LLRP_tSFrameDecoder *       pDecoder = (LLRP_tSFrameDecoder*)pBaseDecoder;
 
+    /* Still set if decoding failed */
+    LLRP_Arena_destruct(pDecoder->pArena);
+
     free(pDecoder);
 }
 
@@ -355,6 +368,12 @@ topDecodeMessage (
 
     pMessage = decodeMessage(&DecoderStream);
 
+    if(NULL != pMessage && NULL != pDecoder->pArena)
+    {
+        pDecoder->pArena->pRoot = &pMessage->elementHdr;
+        pDecoder->pArena = NULL;
+    }
+
     return pMessage;
 }
 
@@ -496,7 +515,12 @@ get_u8v (
     {
         if(checkAvailable(pDecoderStream, 1u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_u8v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -531,7 +555,12 @@ get_s8v (
     {
         if(checkAvailable(pDecoderStream, 1u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_s8v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -610,7 +639,12 @@ get_u16v (
     {
         if(checkAvailable(pDecoderStream, 2u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_u16v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -645,7 +679,12 @@ get_s16v (
     {
         if(checkAvailable(pDecoderStream, 2u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_s16v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -724,7 +763,12 @@ get_u32v (
     {
         if(checkAvailable(pDecoderStream, 4u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_u32v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -759,7 +803,12 @@ get_s32v (
     {
         if(checkAvailable(pDecoderStream, 4u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_s32v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -838,7 +887,12 @@ get_u64v (
     {
         if(checkAvailable(pDecoderStream, 8u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_u64v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -873,7 +927,12 @@ get_s64v (
     {
         if(checkAvailable(pDecoderStream, 8u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_s64v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -925,7 +984,12 @@ get_u1v (
 
         if(checkAvailable(pDecoderStream, nByte, pFieldDescriptor))
         {
-            Value = LLRP_u1v_construct(nBit);
+            Value.pValue = allocVector(pDecoderStream,
+                                nByte);
+            if(NULL != Value.pValue)
+            {
+                Value.nBit = nBit;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -1002,7 +1066,12 @@ get_utf8v (
     {
         if(checkAvailable(pDecoderStream, 1u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_utf8v_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -1037,7 +1106,12 @@ get_bytesToEnd (
     {
         if(checkAvailable(pDecoderStream, 1u * nValue, pFieldDescriptor))
         {
-            Value = LLRP_bytesToEnd_construct(nValue);
+            Value.pValue = allocVector(pDecoderStream,
+                                nValue * sizeof Value.pValue[0]);
+            if(NULL != Value.pValue)
+            {
+                Value.nValue = nValue;
+            }
             if(verifyVectorAllocation(pDecoderStream, Value.pValue,
                                 pFieldDescriptor))
             {
@@ -1348,7 +1422,7 @@ decodeMessage (
 
     pDecoderStream->pRefType = pTypeDescriptor;
 
-    pElement = LLRP_Element_construct(pTypeDescriptor);
+    pElement = constructAndDecodeFields(pDecoderStream, pTypeDescriptor);
 
     if(NULL == pElement)
     {
@@ -1363,8 +1437,6 @@ decodeMessage (
     pMessage = (LLRP_tSMessage *) pElement;
     pMessage->MessageID = MessageID;
 
-    pTypeDescriptor->pfDecodeFields(pElement, pBaseDecoderStream);
-
     if(LLRP_RC_OK != pError->eResultCode)
     {
         LLRP_Element_destruct(pElement);
@@ -1576,7 +1648,7 @@ decodeParameter (
 
     pDecoderStream->pRefType = pTypeDescriptor;
 
-    pElement = LLRP_Element_construct(pTypeDescriptor);
+    pElement = constructAndDecodeFields(pDecoderStream, pTypeDescriptor);
 
     if(NULL == pElement)
     {
@@ -1590,8 +1662,6 @@ decodeParameter (
 
     pParameter = (LLRP_tSParameter *) pElement;
 
-    pTypeDescriptor->pfDecodeFields(pElement, pBaseDecoderStream);
-
     if(LLRP_RC_OK != pError->eResultCode)
     {
         LLRP_Element_destruct(pElement);
@@ -1660,6 +1730,62 @@ decodeParameter (
     return pParameter;
 }
 
+/*
+ * Make an element of the type and decode its fields. The generated
+ * frame field decoder, if the type has one, reads them straight from
+ * the buffer. If it finds anything amiss the element is thrown away
+ * and the fields are decoded again, field by field, through the
+ * stream ops, so the error is reported the same way either way.
+ * Returns NULL only if the element could not be allocated.
+ */
+static LLRP_tSElement *
+constructAndDecodeFields (
+  LLRP_tSFrameDecoderStream *   pDecoderStream,
+  const LLRP_tSTypeDescriptor * pTypeDescriptor)
+{
+    LLRP_tSFrameDecoder *       pDecoder = pDecoderStream->pDecoder;
+    LLRP_tSElement *            pElement;
+    unsigned int                iBegin;
+
+    pElement = LLRP_Element_constructInArena(pTypeDescriptor,
+                                                pDecoder->pArena);
+
+    if(NULL == pElement)
+    {
+        return NULL;
+    }
+
+    if(NULL != pTypeDescriptor->pfDecodeFrameFields &&
+       !pDecoder->bDecodeFieldsByStream &&
+       0 == pDecoder->nBitFieldResid &&
+       LLRP_RC_OK == pDecoder->decoderHdr.ErrorDetails.eResultCode)
+    {
+        iBegin = pDecoder->iNext;
+
+        if(pTypeDescriptor->pfDecodeFrameFields(pElement, pDecoder,
+                                                pDecoderStream->iLimit))
+        {
+            return pElement;
+        }
+
+        LLRP_Element_destruct(pElement);
+        pDecoder->iNext = iBegin;
+
+        pElement = LLRP_Element_constructInArena(pTypeDescriptor,
+                                                    pDecoder->pArena);
+
+        if(NULL == pElement)
+        {
+            return NULL;
+        }
+    }
+
+    pTypeDescriptor->pfDecodeFields(pElement,
+                                    &pDecoderStream->decoderStreamHdr);
+
+    return pElement;
+}
+
 static unsigned int
 getRemainingByteCount (
   LLRP_tSFrameDecoderStream *   pDecoderStream)
@@ -1798,3 +1924,73 @@ verifyVectorAllocation (
     }
 }
 
+static void *
+allocVector (
+  LLRP_tSFrameDecoderStream *   pDecoderStream,
+  unsigned int                  nByte)
+{
+    return LLRP_FrameDecoder_allocVector(pDecoderStream->pDecoder, nByte);
+}
+
+/*
+ * Memory for a decoded vector field, from the message's arena if
+ * there is one
+ */
+void *
+LLRP_FrameDecoder_allocVector (
+  LLRP_tSFrameDecoder *         pDecoder,
+  unsigned int                  nByte)
+{
+    LLRP_tSArena *              pArena = pDecoder->pArena;
+
+    if(NULL != pArena)
+    {
+        return LLRP_Arena_alloc(pArena, nByte);
+    }
+    else
+    {
+        return malloc(nByte);
+    }
+}
+
+/*
+ * Skip reserved bits for a generated frame field decoder, as
+ * get_reserved() does. The caller has already checked the bytes
+ * are there. Returns FALSE if the bits are not aligned the way
+ * get_reserved() requires.
+ */
+llrp_bool_t
+LLRP_FrameDecoder_skipReserved (
+  const unsigned char **        ppNext,
+  unsigned int *                pnBitFieldResid,
+  unsigned int                  nBit)
+{
+    while(0 < nBit)
+    {
+        unsigned int            Step = 7u & nBit;
+
+        if(0 != *pnBitFieldResid)
+        {
+            if(Step != *pnBitFieldResid)
+            {
+                return FALSE;
+            }
+
+            nBit -= Step;
+            *pnBitFieldResid = 0;
+        }
+        else
+        {
+            if(0 != Step)
+            {
+                return FALSE;
+            }
+
+            (*ppNext)++;
+            nBit -= 8;
+        }
+    }
+
+    return TRUE;
+}
+
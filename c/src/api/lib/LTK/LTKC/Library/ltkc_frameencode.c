@@ -380,6 +380,21 @@ LLRP_FrameEncoder_construct (
     return pEncoder;
 }
 
+/*
+ * Ready an encoder to encode another message into the
+ * start of the same buffer, as if it were just constructed.
+ */
+void
+LLRP_FrameEncoder_reset (
+  LLRP_tSFrameEncoder *         pEncoder)
+{
+    LLRP_Error_clear(&pEncoder->encoderHdr.ErrorDetails);
+
+    pEncoder->iNext          = 0;
+    pEncoder->BitFieldBuffer = 0;
+    pEncoder->nBitFieldResid = 0;
+}
+
 static void
 encoderDestruct (
   LLRP_tSEncoder *              pBaseEncoder)
@@ -36,6 +36,18 @@
             (LLRP_tSParameter**)&pThis->MEMBER,		\
             (LLRP_tSParameter*)(VALUE))
 
+/* Appends a run of entries; ppTail from SUBPARAM_LIST_TAIL() */
+#define SUBPARAM_LIST_TAIL(MEMBER)			\
+        LLRP_Element_findSubParameterListTail(		\
+            (LLRP_tSParameter**)&pThis->MEMBER)
+
+#define SUBPARAM_APPEND(PPTAIL,VALUE)			\
+        do {						\
+            (VALUE)->pNextSubParameter = NULL;		\
+            *(PPTAIL) = (VALUE);			\
+            (PPTAIL) = &(VALUE)->pNextSubParameter;	\
+        } while(0)
+
 #define SUBPARAM_CLEAR(MEMBER)				\
         LLRP_Element_clearSubParameterList(		\
             (LLRP_tSElement *)pThis,			\
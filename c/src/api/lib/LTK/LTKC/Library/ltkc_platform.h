@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include <stdlib.h>         /* malloc() */
 #include <string.h>         /* memcpy() */
+#include <stdio.h>          /* FILE */
 
 #define FALSE       0
 #define TRUE        1
@@ -51,6 +51,132 @@ LLRP_TypeRegistry_destruct (
     free(pTypeRegistry);
 }
 
+/*
+ * Hash helpers for the registry indexes. Index sizes are powers
+ * of two; collisions probe linearly to the next slot.
+ */
+static unsigned int
+hashCode (
+  unsigned int                  VendorID,
+  unsigned int                  SubTypeNum)
+{
+    return (VendorID * 0x9E3779B1u) ^ (SubTypeNum * 0x85EBCA77u);
+}
+
+static unsigned int
+hashName (
+  const char *                  pName,
+  unsigned int                  nName)
+{
+    unsigned int                h = 2166136261u;
+    unsigned int                i;
+
+    for(i = 0; i < nName; i++)
+    {
+        h = (h ^ (unsigned char) pName[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+/* Insert into a code index unless the vendor and subtype are already there */
+static void
+indexCode (
+  const LLRP_tSTypeDescriptor **apIndex,
+  unsigned int                  nIndex,
+  const LLRP_tSTypeDescriptor * pTypeDescriptor)
+{
+    unsigned int                VendorID;
+    unsigned int                ix;
+
+    VendorID = pTypeDescriptor->pVendorDescriptor->VendorID;
+    ix = hashCode(VendorID, pTypeDescriptor->TypeNum) & (nIndex - 1u);
+    while(NULL != apIndex[ix])
+    {
+        if(VendorID == apIndex[ix]->pVendorDescriptor->VendorID &&
+           pTypeDescriptor->TypeNum == apIndex[ix]->TypeNum)
+        {
+            /* First enrolled wins, as with the old sequential search */
+            return;
+        }
+        ix = (ix + 1u) & (nIndex - 1u);
+    }
+    apIndex[ix] = pTypeDescriptor;
+}
+
+static const LLRP_tSTypeDescriptor *
+findCode (
+  const LLRP_tSTypeDescriptor * const *apIndex,
+  unsigned int                  nIndex,
+  unsigned int                  VendorID,
+  unsigned int                  SubTypeNum)
+{
+    unsigned int                ix;
+
+    ix = hashCode(VendorID, SubTypeNum) & (nIndex - 1u);
+    while(NULL != apIndex[ix])
+    {
+        if(VendorID == apIndex[ix]->pVendorDescriptor->VendorID &&
+           SubTypeNum == apIndex[ix]->TypeNum)
+        {
+            return apIndex[ix];
+        }
+        ix = (ix + 1u) & (nIndex - 1u);
+    }
+
+    return NULL;
+}
+
+/*
+ * A standard type in the name index is stale once another
+ * descriptor has been enrolled under its type number.
+ */
+static int
+isCurrent (
+  const LLRP_tSTypeRegistry *   pTypeRegistry,
+  const LLRP_tSTypeDescriptor * pTypeDescriptor)
+{
+    if(NULL != pTypeDescriptor->pVendorDescriptor)
+    {
+        return 1;
+    }
+    if(pTypeDescriptor->bIsMessage)
+    {
+        return pTypeRegistry->apStdMessageTypeDescriptors[
+                    pTypeDescriptor->TypeNum] == pTypeDescriptor;
+    }
+    return pTypeRegistry->apStdParameterTypeDescriptors[
+                pTypeDescriptor->TypeNum] == pTypeDescriptor;
+}
+
+static void
+indexName (
+  LLRP_tSTypeRegistry *         pTypeRegistry,
+  const LLRP_tSTypeDescriptor * pTypeDescriptor)
+{
+    const LLRP_tSTypeDescriptor **apIndex = pTypeRegistry->apNameIndex;
+    unsigned int                ix;
+
+    ix = hashName(pTypeDescriptor->pName, strlen(pTypeDescriptor->pName)) &
+            (LTKC_NAME_INDEX_SIZE - 1u);
+    while(NULL != apIndex[ix])
+    {
+        if(pTypeDescriptor == apIndex[ix])
+        {
+            return;
+        }
+        if(!isCurrent(pTypeRegistry, apIndex[ix]) &&
+           0 == strcmp(pTypeDescriptor->pName, apIndex[ix]->pName))
+        {
+            /* Re-enrolled under the same name; reuse the slot */
+            apIndex[ix] = pTypeDescriptor;
+            return;
+        }
+        ix = (ix + 1u) & (LTKC_NAME_INDEX_SIZE - 1u);
+    }
+    apIndex[ix] = pTypeDescriptor;
+}
+
 /* Add a type descriptor to the registry */
 LLRP_tResultCode
 LLRP_TypeRegistry_enroll (
@@ -87,20 +213,36 @@ LLRP_TypeRegistry_enroll (
         {
             unsigned int        ix;
 
+            if(LTKC_MAX_CUSTOM_MESSAGE <=
+                    pTypeRegistry->nCustMessageTypeDescriptors)
+            {
+                return LLRP_RC_EnrollBadTypeNumber;
+            }
             ix = pTypeRegistry->nCustMessageTypeDescriptors++;
             pTypeRegistry->apCustMessageTypeDescriptors[ix] =
                         pTypeDescriptor;
+            indexCode(pTypeRegistry->apCustMessageIndex,
+                      LTKC_CUSTOM_MESSAGE_INDEX_SIZE, pTypeDescriptor);
         }
         else
         {
             unsigned int        ix;
 
+            if(LTKC_MAX_CUSTOM_PARAMETER <=
+                    pTypeRegistry->nCustParameterTypeDescriptors)
+            {
+                return LLRP_RC_EnrollBadTypeNumber;
+            }
             ix = pTypeRegistry->nCustParameterTypeDescriptors++;
             pTypeRegistry->apCustParameterTypeDescriptors[ix] =
                         pTypeDescriptor;
+            indexCode(pTypeRegistry->apCustParameterIndex,
+                      LTKC_CUSTOM_PARAMETER_INDEX_SIZE, pTypeDescriptor);
         }
     }
-    
+
+    indexName(pTypeRegistry, pTypeDescriptor);
+
     return LLRP_RC_OK;
 }
 
@@ -139,20 +281,9 @@ LLRP_TypeRegistry_lookupCustomMessage (
   unsigned int                  VendorID,
   unsigned int                  MessageSubTypeNum)
 {
-    const LLRP_tSTypeDescriptor *pTypeDescriptor;
-    unsigned int                ix;
-
-    for(ix = 0; ix < pTypeRegistry->nCustMessageTypeDescriptors; ix++)
-    {
-        pTypeDescriptor = pTypeRegistry->apCustMessageTypeDescriptors[ix];
-        if(VendorID == pTypeDescriptor->pVendorDescriptor->VendorID &&
-           MessageSubTypeNum == pTypeDescriptor->TypeNum)
-        {
-            return pTypeDescriptor;
-        }
-    }
-
-    return NULL;
+    return findCode(pTypeRegistry->apCustMessageIndex,
+                    LTKC_CUSTOM_MESSAGE_INDEX_SIZE,
+                    VendorID, MessageSubTypeNum);
 }
 
 /* Lookup a custom parameter type descriptor. NULL=>not found */
@@ -162,62 +293,73 @@ LLRP_TypeRegistry_lookupCustomParameter (
   unsigned int                  VendorID,
   unsigned int                  ParameterSubTypeNum)
 {
-    const LLRP_tSTypeDescriptor *pTypeDescriptor;
-    unsigned int                ix;
-
-    for(ix = 0; ix < pTypeRegistry->nCustParameterTypeDescriptors; ix++)
-    {
-        pTypeDescriptor = pTypeRegistry->apCustParameterTypeDescriptors[ix];
-        if(VendorID == pTypeDescriptor->pVendorDescriptor->VendorID &&
-           ParameterSubTypeNum == pTypeDescriptor->TypeNum)
-        {
-            return pTypeDescriptor;
-        }
-    }
-
-    return NULL;
+    return findCode(pTypeRegistry->apCustParameterIndex,
+                    LTKC_CUSTOM_PARAMETER_INDEX_SIZE,
+                    VendorID, ParameterSubTypeNum);
 }
 
-/* Lookup a type descriptor by name. NULL=>not found */
+/*
+ * Lookup a type descriptor by name. NULL=>not found
+ *
+ * A bare name finds a standard type first, then a custom type of
+ * that name. "prefix:Name", as the XML encoder writes custom types,
+ * finds the type of that name in the namespace with that prefix.
+ */
 const LLRP_tSTypeDescriptor *
 LLRP_TypeRegistry_lookupByName (
   const LLRP_tSTypeRegistry *   pTypeRegistry,
   const char *                  pElementName)
 {
-    unsigned int                i;
     const LLRP_tSTypeDescriptor *pTypeDescriptor;
+    const LLRP_tSTypeDescriptor *pCustom = NULL;
+    const char *                pName;
+    const char *                pColon;
+    unsigned int                nPrefix = 0;
+    unsigned int                ix;
 
-    for(i = 0; i < 1024u; i++)
+    pName = pElementName;
+    pColon = strchr(pElementName, ':');
+    if(NULL != pColon)
     {
-        pTypeDescriptor = pTypeRegistry->apStdMessageTypeDescriptors[i];
-        if(NULL == pTypeDescriptor)
-        {
-            continue;
-        }
-
-        if(0 == strcmp(pTypeDescriptor->pName, pElementName))
-        {
-            return pTypeDescriptor;
-        }
+        nPrefix = (unsigned int)(pColon - pElementName);
+        pName = pColon + 1;
     }
 
-    for(i = 0; i < 1024u; i++)
+    ix = hashName(pName, strlen(pName)) & (LTKC_NAME_INDEX_SIZE - 1u);
+    while(NULL != (pTypeDescriptor = pTypeRegistry->apNameIndex[ix]))
     {
-        pTypeDescriptor = pTypeRegistry->apStdParameterTypeDescriptors[i];
-        if(NULL == pTypeDescriptor)
+        ix = (ix + 1u) & (LTKC_NAME_INDEX_SIZE - 1u);
+
+        if(0 != strcmp(pTypeDescriptor->pName, pName) ||
+           !isCurrent(pTypeRegistry, pTypeDescriptor))
         {
             continue;
         }
 
-        if(0 == strcmp(pTypeDescriptor->pName, pElementName))
+        if(NULL != pColon)
+        {
+            const char *        pPrefix;
+
+            if(NULL == pTypeDescriptor->pNamespaceDescriptor)
+            {
+                continue;
+            }
+            pPrefix = pTypeDescriptor->pNamespaceDescriptor->pPrefix;
+            if(strlen(pPrefix) == nPrefix &&
+               0 == strncmp(pPrefix, pElementName, nPrefix))
+            {
+                return pTypeDescriptor;
+            }
+        }
+        else if(NULL == pTypeDescriptor->pVendorDescriptor)
         {
             return pTypeDescriptor;
         }
+        else if(NULL == pCustom)
+        {
+            pCustom = pTypeDescriptor;
+        }
     }
 
-    /* TODO: custom messages */
-    /* TODO: custom parameters */
-
-    return NULL;
+    return pCustom;
 }
-
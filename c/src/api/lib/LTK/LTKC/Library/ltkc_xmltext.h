@@ -31,6 +31,12 @@ typedef struct LLRP_SXMLTextDecoderStream   LLRP_tSXMLTextDecoderStream;
 typedef struct LLRP_SXMLTextEncoder         LLRP_tSXMLTextEncoder;
 typedef struct LLRP_SXMLTextEncoderStream   LLRP_tSXMLTextEncoderStream;
 
+/*
+ * Encoder features added since the ltkc_win32 snapshot. Code
+ * also built against that snapshot tests for them before use.
+ */
+#define LTKC_HAS_XML_GROWABLE
+
 
 struct LLRP_SXMLTextDecoder
 {
@@ -87,6 +93,22 @@ struct LLRP_SXMLTextEncoder
     unsigned int                iNext;
 
     int                         bOverflow;
+
+    /** Non-zero to realloc() pBuffer as the text grows, up to
+     ** nMaxBuffer bytes (no limit if 0). The caller takes pBuffer
+     ** and nBuffer back after encoding and frees pBuffer. */
+    int                         bGrowable;
+    unsigned int                nMaxBuffer;
+
+    /** Streaming encoders write the text to pFile, or to fd when
+     ** pFile is NULL. pBuffer is then the encoder's own write
+     ** buffer, flushed when full and after each element. */
+    FILE *                      pFile;
+    int                         fd;
+
+    /** Non-zero for compact text: no indentation, and each element
+     ** on a single line */
+    int                         bCompact;
 };
 
 struct LLRP_SXMLTextEncoderStream
@@ -103,3 +125,22 @@ extern LLRP_tSXMLTextEncoder *
 LLRP_XMLTextEncoder_construct (
   unsigned char *               pBuffer,
   unsigned int                  nBuffer);
+
+extern LLRP_tSXMLTextEncoder *
+LLRP_XMLTextEncoder_constructGrowable (
+  unsigned char *               pBuffer,
+  unsigned int                  nBuffer,
+  unsigned int                  nMaxBuffer);
+
+extern LLRP_tSXMLTextEncoder *
+LLRP_XMLTextEncoder_constructFile (
+  FILE *                        pFile);
+
+extern LLRP_tSXMLTextEncoder *
+LLRP_XMLTextEncoder_constructFd (
+  int                           fd);
+
+extern void
+LLRP_XMLTextEncoder_setCompact (
+  LLRP_tSXMLTextEncoder *       pEncoder,
+  int                           bCompact);
@@ -1662,7 +1662,7 @@ decodeElement (
     }
 
     pTypeDescriptor = LLRP_TypeRegistry_lookupByName(pRegistry,
-                        pDecoder->apTagArg[0]);
+                        (const char *) pDecoder->apTagArg[0]);
 
     if(NULL == pTypeDescriptor)
     {
@@ -22,6 +22,8 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <time.h>
+#include <unistd.h>
+#include <errno.h>
 
 #include "ltkc_platform.h"
 #include "ltkc_base.h"
@@ -279,6 +281,14 @@ indent (
   LLRP_tSXMLTextEncoderStream * pEncoderStream,
   int                           adjust);
 
+static void
+appendNewline (
+  LLRP_tSXMLTextEncoderStream * pEncoderStream);
+
+static void
+appendAttributeBreak (
+  LLRP_tSXMLTextEncoderStream * pEncoderStream);
+
 static void
 appendOpenTag (
   LLRP_tSXMLTextEncoderStream * pEncoderStream,
@@ -299,10 +309,25 @@ appendFormat (
   LLRP_tSXMLTextEncoderStream * pEncoderStream,
   char *                        pFmtStr,
                                 ...);
+
+static int
+makeRoom (
+  LLRP_tSXMLTextEncoder *       pEncoder,
+  unsigned int                  nRoom);
+
+static int
+flushStream (
+  LLRP_tSXMLTextEncoder *       pEncoder);
 /*
  * END forward declarations
  */
 
+/*
+ * Write buffer of the streaming encoders. Text is formatted
+ * straight into it and written out when it fills up.
+ */
+#define XML_STREAM_BUFFER_SIZE  4096u
+
 /*
  * Structures used by discoverNamespaces() and putElement().
  */
@@ -390,10 +415,122 @@ LLRP_XMLTextEncoder_construct (
     pEncoder->nBuffer = nBuffer;
     pEncoder->iNext   = 0;
     pEncoder->bOverflow = 0;
+    pEncoder->pFile   = NULL;
+    pEncoder->fd      = -1;
+
+    return pEncoder;
+}
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Construct an XML encoder whose buffer grows with the text
+ **
+ ** pBuffer is NULL or comes from malloc(). The encoder realloc()s it
+ ** as needed, so after encoding the caller must take pBuffer and
+ ** nBuffer back from the encoder, and eventually free pBuffer. Reusing
+ ** the buffer for the next element saves growing it again.
+ **
+ ** @param[in]  pBuffer         Initial buffer, or NULL
+ ** @param[in]  nBuffer         Size of pBuffer
+ ** @param[in]  nMaxBuffer      Size the buffer may grow to, 0 for no limit
+ **
+ *****************************************************************************/
+
+LLRP_tSXMLTextEncoder *
+LLRP_XMLTextEncoder_constructGrowable (
+  unsigned char *               pBuffer,
+  unsigned int                  nBuffer,
+  unsigned int                  nMaxBuffer)
+{
+    LLRP_tSXMLTextEncoder *     pEncoder;
+
+    pEncoder = LLRP_XMLTextEncoder_construct(pBuffer, nBuffer);
+    if(NULL != pEncoder)
+    {
+        pEncoder->bGrowable  = 1;
+        pEncoder->nMaxBuffer = nMaxBuffer;
+    }
+
+    return pEncoder;
+}
+
+static LLRP_tSXMLTextEncoder *
+constructStream (
+  FILE *                        pFile,
+  int                           fd)
+{
+    LLRP_tSXMLTextEncoder *     pEncoder;
+    unsigned char *             pBuffer;
+
+    pBuffer = malloc(XML_STREAM_BUFFER_SIZE);
+    if(NULL == pBuffer)
+    {
+        return NULL;
+    }
+
+    pEncoder = LLRP_XMLTextEncoder_construct(pBuffer, XML_STREAM_BUFFER_SIZE);
+    if(NULL == pEncoder)
+    {
+        free(pBuffer);
+        return NULL;
+    }
+    pEncoder->pFile = pFile;
+    pEncoder->fd    = fd;
 
     return pEncoder;
 }
 
+/**
+ *****************************************************************************
+ **
+ ** @brief  Construct an XML encoder that writes the text to a FILE
+ **
+ ** There is no limit on the size of the text. The file is not closed
+ ** when the encoder is destructed.
+ **
+ *****************************************************************************/
+
+LLRP_tSXMLTextEncoder *
+LLRP_XMLTextEncoder_constructFile (
+  FILE *                        pFile)
+{
+    return constructStream(pFile, -1);
+}
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Construct an XML encoder that writes the text to a descriptor
+ **
+ ** Writes are buffered, with one write() per buffer full and one at
+ ** the end of each element. The descriptor is not closed when the
+ ** encoder is destructed.
+ **
+ *****************************************************************************/
+
+LLRP_tSXMLTextEncoder *
+LLRP_XMLTextEncoder_constructFd (
+  int                           fd)
+{
+    return constructStream(NULL, fd);
+}
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Select compact text: no indentation, one line per element
+ **
+ *****************************************************************************/
+
+void
+LLRP_XMLTextEncoder_setCompact (
+  LLRP_tSXMLTextEncoder *       pEncoder,
+  int                           bCompact)
+{
+    pEncoder->bCompact = bCompact;
+}
+
 static void
 encoderDestruct (
   LLRP_tSEncoder *              pBaseEncoder)
@@ -401,6 +538,11 @@ encoderDestruct (
     LLRP_tSXMLTextEncoder *     pEncoder =
                                     (LLRP_tSXMLTextEncoder *) pBaseEncoder;
 
+    if(NULL != pEncoder->pFile || 0 <= pEncoder->fd)
+    {
+        flushStream(pEncoder);
+        free(pEncoder->pBuffer);
+    }
     free(pEncoder);
 }
 
@@ -421,6 +563,17 @@ encodeElement (
     streamConstruct_outermost(&EncoderStream, pEncoder);
 
     putElement(&EncoderStream, pElement);
+
+    if(pEncoder->bCompact)
+    {
+        /* End the element's line */
+        appendFormat(&EncoderStream, "\n");
+    }
+
+    if(NULL != pEncoder->pFile || 0 <= pEncoder->fd)
+    {
+        flushStream(pEncoder);
+    }
 }
 
 static void
@@ -1265,7 +1418,8 @@ put_reserved (
                             (LLRP_tSXMLTextEncoderStream *) pBaseEncoderStream;
 
     indent(pEncoderStream, 0);
-    appendFormat(pEncoderStream, "<!-- reserved %d bits -->\n", nBits);
+    appendFormat(pEncoderStream, "<!-- reserved %d bits -->", nBits);
+    appendNewline(pEncoderStream);
 }
 
 static void
@@ -1340,8 +1494,7 @@ putElement (
         {
             pNamespaceDescriptor = NamespaceList.apNamespaceDescriptor[iNSD];
 
-            appendFormat(pEncoderStream, "\n");
-            indent(pEncoderStream, 0);
+            appendAttributeBreak(pEncoderStream);
             appendFormat(pEncoderStream, "xmlns:%s='%s'",
                 pNamespaceDescriptor->pPrefix,
                 pNamespaceDescriptor->pURI);
@@ -1350,14 +1503,14 @@ putElement (
              */
             if(0 == strcmp(pNamespaceDescriptor->pPrefix, "llrp"))
             {
-                appendFormat(pEncoderStream, "\n");
-                indent(pEncoderStream, 0);
+                appendAttributeBreak(pEncoderStream);
                 appendFormat(pEncoderStream, "xmlns='%s'",
                     pNamespaceDescriptor->pURI);
             }
         }
     }
-    appendFormat(pEncoderStream, ">\n");
+    appendFormat(pEncoderStream, ">");
+    appendNewline(pEncoderStream);
 
     pRefType->pfEncode(pElement, &pEncoderStream->encoderStreamHdr);
 
@@ -1423,12 +1576,46 @@ indent (
     int                         n = pEncoderStream->nDepth + adjust;
     int                         i;
 
+    if(pEncoderStream->pEncoder->bCompact)
+    {
+        return;
+    }
+
     for(i = 0; i < n; i++)
     {
         appendFormat(pEncoderStream, "  ");
     }
 }
 
+static void
+appendNewline (
+  LLRP_tSXMLTextEncoderStream * pEncoderStream)
+{
+    if(!pEncoderStream->pEncoder->bCompact)
+    {
+        appendFormat(pEncoderStream, "\n");
+    }
+}
+
+/*
+ * Separate the attributes of the outermost element, one per
+ * line unless the text is compact.
+ */
+static void
+appendAttributeBreak (
+  LLRP_tSXMLTextEncoderStream * pEncoderStream)
+{
+    if(pEncoderStream->pEncoder->bCompact)
+    {
+        appendFormat(pEncoderStream, " ");
+    }
+    else
+    {
+        appendFormat(pEncoderStream, "\n");
+        indent(pEncoderStream, 0);
+    }
+}
+
 static void
 appendOpenTag (
   LLRP_tSXMLTextEncoderStream * pEncoderStream,
@@ -1447,7 +1634,8 @@ appendCloseTag (
 {
     appendFormat(pEncoderStream, "</");
     appendPrefixedTagName(pEncoderStream, pName);
-    appendFormat(pEncoderStream, ">\n");
+    appendFormat(pEncoderStream, ">");
+    appendNewline(pEncoderStream);
 }
 
 static void
@@ -1476,8 +1664,8 @@ appendFormat (
                                 ...)
 {
     LLRP_tSXMLTextEncoder *     pEncoder = pEncoderStream->pEncoder;
-    char                        aHoldBuf[256u];
-    int                         nHoldBuf;
+    unsigned int                nRoom;
+    int                         nText;
     va_list                     ap;
 
     /* If overflow already detected, bail */
@@ -1486,21 +1674,147 @@ appendFormat (
         return;
     }
 
-    va_start(ap, pFmtStr);
-    vsnprintf(aHoldBuf, sizeof aHoldBuf, pFmtStr, ap);
-    va_end(ap);
+    /*
+     * Format straight into the buffer. If the text (and its
+     * terminating NUL) doesn't fit, make room and format again.
+     */
+    for(;;)
+    {
+        nRoom = pEncoder->nBuffer - pEncoder->iNext;
+
+        va_start(ap, pFmtStr);
+        nText = vsnprintf(
+            (0 == nRoom) ? NULL : (char *)&pEncoder->pBuffer[pEncoder->iNext],
+            nRoom, pFmtStr, ap);
+        va_end(ap);
+
+        if(0 > nText)
+        {
+            pEncoder->bOverflow = 1;
+            return;
+        }
+        if((unsigned int)nText < nRoom)
+        {
+            break;
+        }
+        if(!makeRoom(pEncoder, nText + 1u))
+        {
+            pEncoder->bOverflow = 1;
+            return;
+        }
+    }
+
+    pEncoder->iNext += nText;
+}
 
-    nHoldBuf = strlen(aHoldBuf);
+/*
+ * Make sure nRoom bytes are free past iNext: write out a streaming
+ * encoder's buffer, or grow a growable one. Returns zero when the
+ * text can't go anywhere.
+ */
+static int
+makeRoom (
+  LLRP_tSXMLTextEncoder *       pEncoder,
+  unsigned int                  nRoom)
+{
+    unsigned char *             pGrown;
+    unsigned int                nGrown;
+    int                         bStream;
+
+    bStream = (NULL != pEncoder->pFile || 0 <= pEncoder->fd);
 
-    if(pEncoder->iNext + nHoldBuf >= pEncoder->nBuffer)
+    if(bStream)
     {
-        pEncoder->bOverflow = 1;
-        return;
+        if(!flushStream(pEncoder))
+        {
+            return 0;
+        }
+        if(nRoom <= pEncoder->nBuffer)
+        {
+            return 1;
+        }
+    }
+    else if(!pEncoder->bGrowable)
+    {
+        return 0;
+    }
+
+    nGrown = (0 == pEncoder->nBuffer) ? 256u : pEncoder->nBuffer;
+    while(nGrown - pEncoder->iNext < nRoom)
+    {
+        nGrown *= 2u;
+    }
+    if(!bStream && 0 != pEncoder->nMaxBuffer && nGrown > pEncoder->nMaxBuffer)
+    {
+        nGrown = pEncoder->nMaxBuffer;
+        if(nGrown <= pEncoder->iNext || nGrown - pEncoder->iNext < nRoom)
+        {
+            return 0;
+        }
+    }
+
+    pGrown = realloc(pEncoder->pBuffer, nGrown);
+    if(NULL == pGrown)
+    {
+        return 0;
+    }
+    pEncoder->pBuffer = pGrown;
+    pEncoder->nBuffer = nGrown;
+
+    return 1;
+}
+
+/*
+ * Write out what a streaming encoder has buffered. On failure the
+ * error is recorded in the encoder and zero returned.
+ */
+static int
+flushStream (
+  LLRP_tSXMLTextEncoder *       pEncoder)
+{
+    unsigned int                iSent = 0;
+    ssize_t                     nSent;
+
+    if(0 == pEncoder->iNext)
+    {
+        return 1;
+    }
+
+    if(NULL != pEncoder->pFile)
+    {
+        if(pEncoder->iNext != fwrite(pEncoder->pBuffer, 1u, pEncoder->iNext,
+                                     pEncoder->pFile))
+        {
+            goto fail;
+        }
+    }
+    else
+    {
+        while(iSent < pEncoder->iNext)
+        {
+            nSent = write(pEncoder->fd, &pEncoder->pBuffer[iSent],
+                          pEncoder->iNext - iSent);
+            if(0 > nSent)
+            {
+                if(EINTR == errno)
+                {
+                    continue;
+                }
+                goto fail;
+            }
+            iSent += nSent;
+        }
     }
 
-    strcpy((char *)&pEncoder->pBuffer[pEncoder->iNext], aHoldBuf);
+    pEncoder->iNext = 0;
+    return 1;
 
-    pEncoder->iNext += nHoldBuf;
+  fail:
+    pEncoder->iNext = 0;
+    pEncoder->bOverflow = 1;
+    LLRP_Error_resultCodeAndWhatStr(&pEncoder->encoderHdr.ErrorDetails,
+        LLRP_RC_MiscError, "XML text write failed");
+    return 0;
 }
 
 
@@ -1595,3 +1909,56 @@ LLRP_toXMLString (
     return LLRP_RC_OK;
 }
 
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Write an element as XML text to a FILE
+ **
+ ** Unlike LLRP_toXMLString() there is no limit on the size of the
+ ** text. Compact text puts the whole element on one line, which
+ ** suits logging every message of a busy connection.
+ **
+ ** @param[in]  pElement        Pointer to message/parameter to format
+ ** @param[in]  pFile           Where to write the text
+ ** @param[in]  bCompact        Non-zero for compact text
+ **
+ ** @return     LLRP_tResultCode
+ **
+ *****************************************************************************/
+
+LLRP_tResultCode
+LLRP_toXMLFile (
+  const LLRP_tSElement *        pElement,
+  FILE *                        pFile,
+  int                           bCompact)
+{
+    LLRP_tSXMLTextEncoder *     pXMLEncoder;
+    LLRP_tSEncoder *            pEncoder;
+    LLRP_tResultCode            eResultCode;
+
+    if(NULL == pElement)
+    {
+        return LLRP_RC_MiscError;
+    }
+
+    pXMLEncoder = LLRP_XMLTextEncoder_constructFile(pFile);
+    if(NULL == pXMLEncoder)
+    {
+        return LLRP_RC_MiscError;
+    }
+    LLRP_XMLTextEncoder_setCompact(pXMLEncoder, bCompact);
+
+    pEncoder = &pXMLEncoder->encoderHdr;
+    LLRP_Encoder_encodeElement(pEncoder, pElement);
+
+    eResultCode = pEncoder->ErrorDetails.eResultCode;
+    if(LLRP_RC_OK == eResultCode && pXMLEncoder->bOverflow)
+    {
+        eResultCode = LLRP_RC_MiscError;
+    }
+
+    LLRP_Encoder_destruct(pEncoder);
+
+    return eResultCode;
+}
@@ -70,20 +70,47 @@ extern bool isPerAntennaEnabled;
 extern bool isStandaloneTagop;
 extern uint32_t currentInventorySpecID;
 
+static void
+TMR_LLRP_setTxRxMapFromPorts(TMR_Reader *reader, const TMR_LLRP_PortDetect *ports,
+                             uint8_t numPorts)
+{
+  uint8_t i;
+  TMR_LLRP_LlrpReader *lr;
+
+  lr = &reader->u.llrpReader;
+
+  lr->portMask = 0;
+  for (i = 0; i < numPorts; i ++)
+  {
+    lr->portMask |= 1 << (ports[i].port - 1);
+    lr->staticTxRxMapData[i].antenna = (uint8_t)ports[i].port;
+    lr->staticTxRxMapData[i].txPort  = (uint8_t)ports[i].port;
+    lr->staticTxRxMapData[i].rxPort  = (uint8_t)ports[i].port;
+
+    if (0 == reader->tagOpParams.antenna && ports[i].connected)
+    {
+      reader->tagOpParams.antenna = (uint8_t)ports[i].port;
+    }
+  }
+
+  lr->staticTxRxMap.max = TMR_SR_MAX_ANTENNA_PORTS;
+  lr->staticTxRxMap.len = numPorts;
+  lr->staticTxRxMap.list = lr->staticTxRxMapData;
+  lr->txRxMap = &lr->staticTxRxMap;
+}
+
 static TMR_Status
 TMR_LLRP_initTxRxMapFromPorts(TMR_Reader *reader)
 {
   TMR_Status ret;
   TMR_LLRP_PortDetect ports[TMR_SR_MAX_ANTENNA_PORTS];
-  uint8_t numPorts, i;
-  TMR_LLRP_LlrpReader *lr;
+  uint8_t numPorts;
 
   if (NULL == reader)
   {
     return TMR_ERROR_INVALID;
   }
   numPorts = numberof(ports);
-  lr = &reader->u.llrpReader;
 
   /* Need number of ports to set up Tx-Rx map */
   ret = TMR_LLRP_cmdAntennaDetect(reader, &numPorts, ports);
@@ -92,34 +119,408 @@ TMR_LLRP_initTxRxMapFromPorts(TMR_Reader *reader)
     return ret;
   }
 
-  lr->portMask = 0;
-  for (i = 0; i < numPorts; i ++)
+  TMR_LLRP_setTxRxMapFromPorts(reader, ports, numPorts);
+  return TMR_SUCCESS;
+}
+
+/* First word of a capability cache file */
+#define TMR_LLRP_CAPABILITY_CACHE_MAGIC 0x544D4332u
+/* No cached response comes anywhere near this long */
+#define TMR_LLRP_CAPABILITY_CACHE_MAX_FRAME (1u << 20)
+/* Number of responses in a capability cache file */
+#define TMR_LLRP_CAPABILITY_CACHE_FRAMES 2
+
+/**
+ * Responses just queried from the reader, to be written to the
+ * capability cache once both have been handled successfully.
+ * frame[0] is the reader capabilities, frame[1] the protocols.
+ **/
+typedef struct TMR_LLRP_CapabilityCacheEntry
+{
+  /* Cache file, NULL when there is nothing to write */
+  char *path;
+  TMR_String serial;
+  TMR_String firmware;
+  char serialBuf[64];
+  char firmwareBuf[128];
+  uint32_t region;
+  uint8_t *frame[TMR_LLRP_CAPABILITY_CACHE_FRAMES];
+  uint32_t length[TMR_LLRP_CAPABILITY_CACHE_FRAMES];
+}TMR_LLRP_CapabilityCacheEntry;
+
+/**
+ * Send the connect-time queries cmds[first..first+count-1],
+ * pipelined unless TMR_LLRP_CONNECT_PIPELINE is off, record how long
+ * each took and free the commands
+ **/
+static void
+TMR_LLRP_sendConnectQueries(TMR_Reader *reader, TMR_LLRP_PipelinedCommand *cmds,
+                            int first, int count, int timeoutMs)
+{
+  int i;
+
+#if TMR_LLRP_CONNECT_PIPELINE
+  TMR_LLRP_sendPipelined(reader, &cmds[first], count, timeoutMs);
+#else
+  for (i = first; i < first + count; i++)
   {
-    lr->portMask |= 1 << (ports[i].port - 1);
-    lr->staticTxRxMapData[i].antenna = (uint8_t)ports[i].port;
-    lr->staticTxRxMapData[i].txPort  = (uint8_t)ports[i].port;
-    lr->staticTxRxMapData[i].rxPort  = (uint8_t)ports[i].port;
+    TMR_LLRP_sendPipelined(reader, &cmds[i], 1, timeoutMs);
+  }
+#endif
+  for (i = first; i < first + count; i++)
+  {
+    if (NULL != cmds[i].pCmd)
+    {
+      reader->u.llrpReader.connectTimings.stepMs[i] = cmds[i].elapsedMs;
+      TMR_LLRP_freeMessage(cmds[i].pCmd);
+      cmds[i].pCmd = NULL;
+    }
+  }
+}
 
-    if (0 == reader->tagOpParams.antenna && ports[i].connected)
+/**
+ * Name of the capability cache file of a reader serial number,
+ * firmware version and region, for the caller to free. Characters
+ * that might not be safe in a file name are replaced.
+ **/
+static char *
+TMR_LLRP_capabilityCachePath(TMR_Reader *reader, const char *serial, const char *firmware,
+                             uint32_t region)
+{
+  const char *dir;
+  char *path, *c;
+  size_t dirLength;
+
+  dir = reader->u.llrpReader.capabilityCacheDir;
+  dirLength = strlen(dir);
+  path = malloc(dirLength + strlen(serial) + strlen(firmware) +
+                sizeof("/--4294967295.llrpcaps"));
+  if (NULL == path)
+  {
+    return NULL;
+  }
+  sprintf(path, "%s/%s-%s-%lu", dir, serial, firmware, (unsigned long)region);
+  for (c = path + dirLength + 1; '\0' != *c; c++)
+  {
+    if (!(('0' <= *c && *c <= '9') || ('a' <= *c && *c <= 'z') ||
+          ('A' <= *c && *c <= 'Z') || ('.' == *c) || ('-' == *c)))
     {
-      reader->tagOpParams.antenna = (uint8_t)ports[i].port;
+      *c = '_';
     }
   }
+  strcat(path, ".llrpcaps");
+  return path;
+}
 
-  lr->staticTxRxMap.max = TMR_SR_MAX_ANTENNA_PORTS;
-  lr->staticTxRxMap.len = numPorts;
-  lr->staticTxRxMap.list = lr->staticTxRxMapData;
-  lr->txRxMap = &lr->staticTxRxMap;
+static bool
+TMR_LLRP_readCacheBlock(FILE *fp, uint8_t **data, uint32_t *length)
+{
+  *data = NULL;
+  if ((1 != fread(length, sizeof(*length), 1, fp)) ||
+      (TMR_LLRP_CAPABILITY_CACHE_MAX_FRAME < *length))
+  {
+    return false;
+  }
+  *data = malloc(*length + 1);
+  if ((NULL == *data) || (*length != fread(*data, 1, *length, fp)))
+  {
+    free(*data);
+    *data = NULL;
+    return false;
+  }
+  (*data)[*length] = 0;
+  return true;
+}
 
-  return TMR_SUCCESS;
+static bool
+TMR_LLRP_writeCacheBlock(FILE *fp, const void *data, uint32_t length)
+{
+  return (1 == fwrite(&length, sizeof(length), 1, fp)) &&
+         (length == fwrite(data, 1, length, fp));
 }
 
+/**
+ * Read the responses of a capability cache file. The file names the
+ * serial number, firmware version and region it was written for, so
+ * names made alike by TMR_LLRP_capabilityCachePath() can't be confused.
+ *
+ * @param reader Reader pointer
+ * @param path Cache file
+ * @param serial Serial number of the reader
+ * @param firmware Firmware version of the reader
+ * @param region Current region of the reader
+ * @param[out] pRsp The decoded responses, for the caller to free
+ */
+static TMR_Status
+TMR_LLRP_readCapabilityCache(TMR_Reader *reader, const char *path,
+                             const char *serial, const char *firmware, uint32_t region,
+                             LLRP_tSMessage *pRsp[TMR_LLRP_CAPABILITY_CACHE_FRAMES])
+{
+  TMR_Status ret;
+  FILE *fp;
+  uint32_t magic, length;
+  uint8_t *data;
+  int i;
+
+  for (i = 0; i < TMR_LLRP_CAPABILITY_CACHE_FRAMES; i++)
+  {
+    pRsp[i] = NULL;
+  }
+  fp = fopen(path, "rb");
+  if (NULL == fp)
+  {
+    return TMR_ERROR_NOT_FOUND;
+  }
+
+  ret = TMR_ERROR_NOT_FOUND;
+  if ((1 != fread(&magic, sizeof(magic), 1, fp)) ||
+      (TMR_LLRP_CAPABILITY_CACHE_MAGIC != magic))
+  {
+    goto out;
+  }
+  if (!TMR_LLRP_readCacheBlock(fp, &data, &length))
+  {
+    goto out;
+  }
+  i = strcmp((char *)data, serial);
+  free(data);
+  if (0 != i)
+  {
+    goto out;
+  }
+  if (!TMR_LLRP_readCacheBlock(fp, &data, &length))
+  {
+    goto out;
+  }
+  i = strcmp((char *)data, firmware);
+  free(data);
+  if (0 != i)
+  {
+    goto out;
+  }
+  if (!TMR_LLRP_readCacheBlock(fp, &data, &length))
+  {
+    goto out;
+  }
+  i = (sizeof(region) == length) ? memcmp(data, &region, sizeof(region)) : 1;
+  free(data);
+  if (0 != i)
+  {
+    goto out;
+  }
+
+  for (i = 0; i < TMR_LLRP_CAPABILITY_CACHE_FRAMES; i++)
+  {
+    if (!TMR_LLRP_readCacheBlock(fp, &data, &length))
+    {
+      goto out;
+    }
+    TMR_LLRP_decodeMessage(reader, data, length, &pRsp[i]);
+    free(data);
+    if ((NULL == pRsp[i]) ||
+        (&LLRP_tdGET_READER_CAPABILITIES_RESPONSE != pRsp[i]->elementHdr.pType))
+    {
+      goto out;
+    }
+  }
+  ret = TMR_SUCCESS;
+
+out:
+  fclose(fp);
+  if (TMR_SUCCESS != ret)
+  {
+    for (i = 0; i < TMR_LLRP_CAPABILITY_CACHE_FRAMES; i++)
+    {
+      TMR_LLRP_freeMessage(pRsp[i]);
+      pRsp[i] = NULL;
+    }
+  }
+  return ret;
+}
+
+/**
+ * Write a capability cache file. It is written under another name
+ * and then renamed, so that a reader of the cache never sees half a
+ * file. Failing to write it is not an error to the caller.
+ **/
+static void
+TMR_LLRP_writeCapabilityCache(TMR_LLRP_CapabilityCacheEntry *entry)
+{
+  FILE *fp;
+  char *tmpPath;
+  uint32_t magic;
+  bool ok;
+  int i;
+
+  tmpPath = malloc(strlen(entry->path) + sizeof(".tmp"));
+  if (NULL == tmpPath)
+  {
+    return;
+  }
+  sprintf(tmpPath, "%s.tmp", entry->path);
+  fp = fopen(tmpPath, "wb");
+  if (NULL == fp)
+  {
+    free(tmpPath);
+    return;
+  }
+
+  magic = TMR_LLRP_CAPABILITY_CACHE_MAGIC;
+  ok = (1 == fwrite(&magic, sizeof(magic), 1, fp)) &&
+       TMR_LLRP_writeCacheBlock(fp, entry->serial.value,
+                                (uint32_t)strlen(entry->serial.value)) &&
+       TMR_LLRP_writeCacheBlock(fp, entry->firmware.value,
+                                (uint32_t)strlen(entry->firmware.value)) &&
+       TMR_LLRP_writeCacheBlock(fp, &entry->region, sizeof(entry->region));
+  for (i = 0; ok && (i < TMR_LLRP_CAPABILITY_CACHE_FRAMES); i++)
+  {
+    ok = TMR_LLRP_writeCacheBlock(fp, entry->frame[i], entry->length[i]);
+  }
+  ok = (0 == fclose(fp)) && ok;
+
+  if (ok && (0 != rename(tmpPath, entry->path)))
+  {
+    /* rename() does not replace an existing file everywhere */
+    remove(entry->path);
+    ok = (0 == rename(tmpPath, entry->path));
+  }
+  if (!ok)
+  {
+    remove(tmpPath);
+  }
+  free(tmpPath);
+}
+
+static void
+TMR_LLRP_freeCapabilityCacheEntry(TMR_LLRP_CapabilityCacheEntry *entry)
+{
+  int i;
+
+  free(entry->path);
+  entry->path = NULL;
+  for (i = 0; i < TMR_LLRP_CAPABILITY_CACHE_FRAMES; i++)
+  {
+    free(entry->frame[i]);
+    entry->frame[i] = NULL;
+  }
+}
+
+/**
+ * Remove the capability cache file of the connected reader, once
+ * something it holds has been changed
+ **/
+static void
+TMR_LLRP_dropCapabilityCache(TMR_Reader *reader)
+{
+  if (NULL != reader->u.llrpReader.capabilityCachePath)
+  {
+    remove(reader->u.llrpReader.capabilityCachePath);
+  }
+}
+
+/**
+ * Fill in the responses of the capabilities and protocols steps of
+ * the connect, from the capability cache when it has the reader's
+ * serial number, firmware version and region, from the reader
+ * otherwise. Responses queried from the reader are set aside in
+ * entry, to be written to the cache when they turn out to be good.
+ *
+ * @param reader Reader pointer
+ * @param cmds The connect steps, the identity step already answered
+ * @param regionOk Whether the region of the reader is known
+ * @param timeoutMs Timeout of the queries
+ * @param[out] entry What to write to the cache
+ */
+static void
+TMR_LLRP_getCachedCapabilities(TMR_Reader *reader, TMR_LLRP_PipelinedCommand *cmds,
+                               bool regionOk, int timeoutMs,
+                               TMR_LLRP_CapabilityCacheEntry *entry)
+{
+  static const TMR_LLRP_ConnectStep steps[TMR_LLRP_CAPABILITY_CACHE_FRAMES] =
+  {
+    TMR_LLRP_CONNECT_STEP_CAPABILITIES,
+    TMR_LLRP_CONNECT_STEP_PROTOCOLS,
+  };
+  TMR_LLRP_PipelinedCommand *cmd;
+  LLRP_tSMessage *pRsp[TMR_LLRP_CAPABILITY_CACHE_FRAMES];
+  TMR_Status ret;
+  int i;
+
+  memset(entry, 0, sizeof(*entry));
+  entry->serial.value = entry->serialBuf;
+  entry->serial.max = sizeof(entry->serialBuf);
+  entry->firmware.value = entry->firmwareBuf;
+  entry->firmware.max = sizeof(entry->firmwareBuf);
+  entry->region = (uint32_t)reader->u.llrpReader.regionId;
+  free(reader->u.llrpReader.capabilityCachePath);
+  reader->u.llrpReader.capabilityCachePath = NULL;
+
+  cmd = &cmds[TMR_LLRP_CONNECT_STEP_IDENTITY];
+  ret = cmd->status;
+  if (TMR_SUCCESS == ret)
+  {
+    ret = TMR_LLRP_handleGetTMDeviceInformationCapabilitiesResponse(reader, cmd->pRsp,
+            TMR_PARAM_VERSION_SERIAL, &entry->serial, &entry->firmware);
+    cmd->pRsp = NULL;
+  }
+  if ((TMR_SUCCESS == ret) && regionOk)
+  {
+    entry->path = TMR_LLRP_capabilityCachePath(reader, entry->serial.value,
+                                               entry->firmware.value, entry->region);
+  }
+  if (NULL != entry->path)
+  {
+    reader->u.llrpReader.capabilityCachePath = malloc(strlen(entry->path) + 1);
+    if (NULL != reader->u.llrpReader.capabilityCachePath)
+    {
+      strcpy(reader->u.llrpReader.capabilityCachePath, entry->path);
+    }
+  }
+  if ((NULL != entry->path) &&
+      (TMR_SUCCESS == TMR_LLRP_readCapabilityCache(reader, entry->path, entry->serial.value,
+                                                   entry->firmware.value, entry->region, pRsp)))
+  {
+    for (i = 0; i < TMR_LLRP_CAPABILITY_CACHE_FRAMES; i++)
+    {
+      cmds[steps[i]].pRsp = pRsp[i];
+      cmds[steps[i]].status = TMR_SUCCESS;
+    }
+    reader->u.llrpReader.connectTimings.capabilitiesCached = true;
+    free(entry->path);
+    entry->path = NULL;
+    return;
+  }
+
+  /* Not cached, so query the reader after all */
+  TMR_LLRP_msgGetReaderCapabilities(reader, &cmds[TMR_LLRP_CONNECT_STEP_CAPABILITIES].pCmd);
+  TMR_LLRP_msgGetTMDeviceProtocolCapabilities(reader, &cmds[TMR_LLRP_CONNECT_STEP_PROTOCOLS].pCmd);
+  TMR_LLRP_sendConnectQueries(reader, cmds, TMR_LLRP_CONNECT_STEP_CAPABILITIES,
+                              TMR_LLRP_CAPABILITY_CACHE_FRAMES, timeoutMs);
+
+  /* The handlers free the responses, so keep their frames now */
+  for (i = 0; (NULL != entry->path) && (i < TMR_LLRP_CAPABILITY_CACHE_FRAMES); i++)
+  {
+    cmd = &cmds[steps[i]];
+    if ((TMR_SUCCESS != cmd->status) ||
+        (TMR_SUCCESS != TMR_LLRP_encodeMessage(reader, cmd->pRsp,
+                                               &entry->frame[i], &entry->length[i])))
+    {
+      TMR_LLRP_freeCapabilityCacheEntry(entry);
+    }
+  }
+}
 
 static TMR_Status
 TMR_LLRP_boot(TMR_Reader *reader)
 {
   TMR_Status ret;
   TMR_LLRP_LlrpReader *lr;
+  TMR_LLRP_PipelinedCommand cmds[TMR_LLRP_CONNECT_STEPS];
+  TMR_LLRP_PipelinedCommand *cmd;
+  TMR_LLRP_CapabilityCacheEntry cacheEntry;
+  bool dataPort, useCache, regionOk, capabilitiesOk, protocolsOk;
+  uint64_t start;
+  int timeoutMs;
 
   int i;
 
@@ -129,8 +530,18 @@ TMR_LLRP_boot(TMR_Reader *reader)
   }
   ret = TMR_SUCCESS;
   lr = &reader->u.llrpReader;
+  dataPort = (TMR_LLRP_READER_DEFAULT_PORT == reader->u.llrpReader.portNum);
+  useCache = (NULL != lr->capabilityCacheDir);
+  cacheEntry.path = NULL;
+  capabilitiesOk = false;
+  protocolsOk = false;
 
-  if (TMR_LLRP_READER_DEFAULT_PORT == reader->u.llrpReader.portNum)
+  /**
+   * None of the queries below needs the answer to another, so they are
+   * sent back to back, and their responses handled once all are in.
+   **/
+  memset(cmds, 0, sizeof(cmds));
+  if (dataPort)
   {
   /**
      * Default port is used for data operations. If the connection
@@ -140,28 +551,53 @@ TMR_LLRP_boot(TMR_Reader *reader)
     /**
      * Set HoldEventsAndReports to true on connect.  
      **/
-    ret = TMR_LLRP_setHoldEventsAndReportsStatus(reader, 1);
-    if (TMR_SUCCESS != ret)
-    {
-      /**
-       * Not Fatal, moving forward
-       **/ 
-    }
+    TMR_LLRP_msgSetHoldEventsAndReportsStatus(reader, 1,
+                                              &cmds[TMR_LLRP_CONNECT_STEP_HOLD_EVENTS].pCmd);
 
     /**
-     * Stop any active ROSpecs running on reader
+     * Get the ROSpecs, to stop any active ones running on reader
      **/
-    ret = TMR_LLRP_stopActiveROSpecs(reader);
-    if (TMR_SUCCESS != ret)
-    {
-      return ret;
-    }
+    cmds[TMR_LLRP_CONNECT_STEP_ROSPECS].pCmd = &LLRP_GET_ROSPECS_construct()->hdr;
+
+    /**
+     * Keep alives are needed only if the connection is made on default
+     * data port. Keep alives are not supported on other ports from reader end.
+     * Set Keep alive messages to pulse reader heart beat
+     **/
+    TMR_LLRP_msgSetKeepAlive(reader, &cmds[TMR_LLRP_CONNECT_STEP_KEEPALIVE].pCmd);
+  }
+  /* Current region */
+  TMR_LLRP_msgGetRegion(reader, &cmds[TMR_LLRP_CONNECT_STEP_REGION].pCmd);
+  if (useCache)
+  {
+    /* Serial number and firmware version, to look the capabilities up by */
+    TMR_LLRP_msgGetTMDeviceInformationCapabilities(reader, &cmds[TMR_LLRP_CONNECT_STEP_IDENTITY].pCmd);
   }
+  else
+  {
+    /* Reader capabilities */
+    TMR_LLRP_msgGetReaderCapabilities(reader, &cmds[TMR_LLRP_CONNECT_STEP_CAPABILITIES].pCmd);
+    /* Supported protocols */
+    TMR_LLRP_msgGetTMDeviceProtocolCapabilities(reader, &cmds[TMR_LLRP_CONNECT_STEP_PROTOCOLS].pCmd);
+  }
+  /* Antennas, for the txrxmap */
+  TMR_LLRP_msgAntennaDetect(reader, &cmds[TMR_LLRP_CONNECT_STEP_ANTENNAS].pCmd);
+
+  timeoutMs = lr->commandTimeout + lr->transportTimeout;
+  TMR_LLRP_sendConnectQueries(reader, cmds, 0, numberof(cmds), timeoutMs);
 
   /**
-   * Get current region and cache it
+   * Get current region and cache it. The capabilities depend on it,
+   * so it is part of the capability cache key.
    **/
-  ret = TMR_LLRP_cmdGetRegion(reader, &reader->u.llrpReader.regionId);
+  cmd = &cmds[TMR_LLRP_CONNECT_STEP_REGION];
+  ret = cmd->status;
+  if (TMR_SUCCESS == ret)
+  {
+    ret = TMR_LLRP_handleGetRegionResponse(reader, cmd->pRsp, &reader->u.llrpReader.regionId);
+    cmd->pRsp = NULL;
+  }
+  regionOk = (TMR_SUCCESS == ret);
   if (TMR_SUCCESS != ret)
   {
     /**
@@ -171,10 +607,53 @@ TMR_LLRP_boot(TMR_Reader *reader)
     reader->u.llrpReader.regionId = TMR_REGION_NA;
   }
 
+  if (useCache)
+  {
+    TMR_LLRP_getCachedCapabilities(reader, cmds, regionOk, timeoutMs, &cacheEntry);
+  }
+
+  if (dataPort)
+  {
+    cmd = &cmds[TMR_LLRP_CONNECT_STEP_HOLD_EVENTS];
+    if (TMR_SUCCESS == cmd->status)
+    {
+      /**
+       * Not Fatal, moving forward
+       **/ 
+      TMR_LLRP_handleSetReaderConfigResponse(reader, cmd->pRsp);
+      cmd->pRsp = NULL;
+    }
+
+    /**
+     * Stop any active ROSpecs running on reader
+     **/
+    cmd = &cmds[TMR_LLRP_CONNECT_STEP_ROSPECS];
+    ret = cmd->status;
+    if (TMR_SUCCESS == ret)
+    {
+      start = tmr_gettime();
+      ret = TMR_LLRP_handleGetROSpecsResponse(reader, cmd->pRsp);
+      cmd->pRsp = NULL;
+      lr->connectTimings.stepMs[TMR_LLRP_CONNECT_STEP_ROSPECS] += (uint32_t)(tmr_gettime() - start);
+    }
+    if (TMR_SUCCESS != ret)
+    {
+      goto out;
+    }
+  }
+
   /**
    * Get reader capabilities and cache it
    **/
-  ret = TMR_LLRP_cmdGetReaderCapabilities(reader, &reader->u.llrpReader.capabilities);
+  cmd = &cmds[TMR_LLRP_CONNECT_STEP_CAPABILITIES];
+  ret = cmd->status;
+  if (TMR_SUCCESS == ret)
+  {
+    ret = TMR_LLRP_handleGetReaderCapabilitiesResponse(reader, cmd->pRsp,
+                                                       &reader->u.llrpReader.capabilities);
+    cmd->pRsp = NULL;
+  }
+  capabilitiesOk = (TMR_SUCCESS == ret);
   if (TMR_SUCCESS != ret)
   {
     uint8_t length = (uint8_t)strlen("NOT AVAILABLE");
@@ -266,6 +745,7 @@ TMR_LLRP_boot(TMR_Reader *reader)
   BITSET(lr->paramPresent, TMR_PARAM_METADATAFLAG);
   BITSET(lr->paramPresent, TMR_PARAM_READER_STATS_ENABLE);
   BITSET(lr->paramPresent, TMR_PARAM_READER_STATS);
+  BITSET(lr->paramPresent, TMR_PARAM_LLRP_REPORTSPEC);
  
   for (i = 0; i < TMR_PARAMWORDS; i++)
   {
@@ -281,7 +761,14 @@ TMR_LLRP_boot(TMR_Reader *reader)
   TMR_TagProtocol protocol[5];
    TMR_TagProtocolList protocolList;
    protocolList.list = protocol;
-   ret = TMR_LLRP_cmdGetTMDeviceProtocolCapabilities(reader, &protocolList);
+   cmd = &cmds[TMR_LLRP_CONNECT_STEP_PROTOCOLS];
+   ret = cmd->status;
+   if (TMR_SUCCESS == ret)
+   {
+     ret = TMR_LLRP_handleGetTMDeviceProtocolCapabilitiesResponse(reader, cmd->pRsp, &protocolList);
+     cmd->pRsp = NULL;
+   }
+   protocolsOk = (TMR_SUCCESS == ret);
    if (TMR_SUCCESS != ret)
    {
   /**
@@ -294,22 +781,43 @@ TMR_LLRP_boot(TMR_Reader *reader)
   /**
    * Initialize txrxmap
    **/
-  ret = TMR_LLRP_initTxRxMapFromPorts(reader);
-  if (TMR_SUCCESS != ret)
   {
-    /**
-     * Not Fatal, moving forward
-     **/
+    TMR_LLRP_PortDetect ports[TMR_SR_MAX_ANTENNA_PORTS];
+    uint8_t numPorts;
+
+    numPorts = numberof(ports);
+    cmd = &cmds[TMR_LLRP_CONNECT_STEP_ANTENNAS];
+    ret = cmd->status;
+    if (TMR_SUCCESS == ret)
+    {
+      ret = TMR_LLRP_handleAntennaDetectResponse(reader, cmd->pRsp, &numPorts, ports);
+      cmd->pRsp = NULL;
+    }
+    if (TMR_SUCCESS == ret)
+    {
+      TMR_LLRP_setTxRxMapFromPorts(reader, ports, numPorts);
+    }
+    else
+    {
+      /**
+       * Not Fatal, moving forward
+       **/
+    }
   }
 
-  if (TMR_LLRP_READER_DEFAULT_PORT == reader->u.llrpReader.portNum)
+  if (dataPort)
   {
-    /**
-     * Keep alives are needed only if the connection is made on default
-     * data port. Keep alives are not supported on other ports from reader end.
-     * Set Keep alive messages to pulse reader heart beat
-     **/
-    ret = TMR_LLRP_setKeepAlive(reader);
+    cmd = &cmds[TMR_LLRP_CONNECT_STEP_KEEPALIVE];
+    ret = cmd->status;
+    if (TMR_SUCCESS == ret)
+    {
+      ret = TMR_LLRP_handleSetReaderConfigResponse(reader, cmd->pRsp);
+      cmd->pRsp = NULL;
+    }
+    if (TMR_SUCCESS == ret)
+    {
+      ret = TMR_LLRP_startBackgroundReceiver(reader);
+    }
     if (TMR_SUCCESS != ret)
     {
       /**
@@ -318,6 +826,19 @@ TMR_LLRP_boot(TMR_Reader *reader)
     }
   }
 
+out:
+  for (i = 0; i < (int)numberof(cmds); i++)
+  {
+    TMR_LLRP_freeMessage(cmds[i].pRsp);
+  }
+  if ((NULL != cacheEntry.path) && capabilitiesOk && protocolsOk)
+  {
+    TMR_LLRP_writeCapabilityCache(&cacheEntry);
+  }
+  if (useCache)
+  {
+    TMR_LLRP_freeCapabilityCacheEntry(&cacheEntry);
+  }
   return ret;
 }
 
@@ -489,6 +1010,32 @@ TMR_LLRP_paramSet(struct TMR_Reader *reader, TMR_Param key, const void *value)
         break;
       }
 
+    case TMR_PARAM_LLRP_REPORTSPEC:
+      {
+        const TMR_LLRP_ReportSpec *spec = (const TMR_LLRP_ReportSpec *)value;
+
+        if (((unsigned)TMR_LLRP_REPORT_TRIGGER_N_TAGS_OR_END_OF_AISPEC < (unsigned)spec->trigger) ||
+            (spec->content & ~TMR_LLRP_REPORT_CONTENT_ALL))
+        {
+          ret = TMR_ERROR_ILLEGAL_VALUE;
+        }
+        else if ((TMR_LLRP_REPORT_TRIGGER_DEFAULT != spec->trigger) &&
+                 (0 == spec->n) && (0 == spec->periodMs))
+        {
+          /**
+           * The ROSpec and AISpecs of a continuous read need not
+           * end, so with no N and no period the tags might never
+           * be reported.
+           **/
+          ret = TMR_ERROR_ILLEGAL_VALUE;
+        }
+        else
+        {
+          lr->reportSpec = *spec;
+        }
+        break;
+      }
+
     case TMR_PARAM_GEN2_ACCESSPASSWORD:
       {
         lr->gen2AccessPassword = *(TMR_GEN2_Password *)value;
@@ -1065,6 +1612,11 @@ TMR_LLRP_paramSet(struct TMR_Reader *reader, TMR_Param key, const void *value)
           break;
         }
         ret = TMR_LLRP_cmdSetThingMagicRegionHoptable(reader, u32List);
+        if (TMR_SUCCESS == ret)
+        {
+          /* The cached capabilities hold the old hop table */
+          TMR_LLRP_dropCapabilityCache(reader);
+        }
         break;
       }
 
@@ -1518,6 +2070,12 @@ TMR_LLRP_paramGet(struct TMR_Reader *reader, TMR_Param key, void *value)
         break;
       }
 
+    case TMR_PARAM_LLRP_REPORTSPEC:
+      {
+        *(TMR_LLRP_ReportSpec *)value = lr->reportSpec;
+        break;
+      }
+
     case TMR_PARAM_TAGREADDATA_RECORDHIGHESTRSSI:
     case TMR_PARAM_TAGREADDATA_UNIQUEBYANTENNA:
     case TMR_PARAM_TAGREADDATA_UNIQUEBYDATA:
@@ -2078,10 +2636,34 @@ TMR_LLRP_LlrpReader_init(TMR_Reader *reader)
   reader->u.llrpReader.receiverEnabled = false;
   reader->u.llrpReader.numOfROSpecEvents = 0;
   reader->u.llrpReader.bufResponse = NULL;
+  reader->u.llrpReader.receiverWake[0] = -1;
+  reader->u.llrpReader.receiverWake[1] = -1;
 
   /* Initialize llrp transmitter thread params */
   pthread_mutex_init(&reader->u.llrpReader.transmitterLock, NULL);
 
+  /* Transport listener XML is rendered only once a listener needs it */
+  reader->u.llrpReader.xmlBuf = NULL;
+  reader->u.llrpReader.xmlBufSize = 0;
+  pthread_mutex_init(&reader->u.llrpReader.xmlLock, NULL);
+  reader->u.llrpReader.streamedFrames = NULL;
+  pthread_mutex_init(&reader->u.llrpReader.streamedLock, NULL);
+  reader->u.llrpReader.keepAliveAck.length = 0;
+  reader->u.llrpReader.getReport.length = 0;
+  reader->u.llrpReader.roSpecCache.frame = NULL;
+  reader->u.llrpReader.roSpecCache.length = 0;
+  reader->u.llrpReader.roSpecCache.roSpecId = 0;
+  reader->u.llrpReader.roSpecCache.enabled = false;
+  reader->u.llrpReader.roSpecCache.reused = false;
+  reader->u.llrpReader.reportSpec.trigger = TMR_LLRP_REPORT_TRIGGER_DEFAULT;
+  reader->u.llrpReader.reportSpec.n = 1;
+  reader->u.llrpReader.reportSpec.periodMs = 0;
+  reader->u.llrpReader.reportSpec.content = TMR_LLRP_REPORT_CONTENT_ALL;
+  reader->u.llrpReader.reportRequestedAt = 0;
+  reader->u.llrpReader.paramBatch = NULL;
+  reader->u.llrpReader.capabilityCacheDir = NULL;
+  reader->u.llrpReader.capabilityCachePath = NULL;
+
   /* Initialize keep alive params */
   reader->u.llrpReader.ka_start = 0;
   reader->u.llrpReader.ka_now   = 0;
@@ -2191,6 +2773,22 @@ TMR_LLRP_openConnectionToReader(TMR_Reader *reader, LLRP_tSConnection *pConn)
     return TMR_ERROR_LLRP_CONNECTIONFAILED;
   }
 
+  /*
+   * Size the receive buffer before connecting so the window
+   * scale offered in the SYN can cover it. Best effort.
+   */
+#ifdef LTKC_HAS_SOCKET_OPTIONS
+  if (0 < pConn->nSocketRecvBufferSize)
+  {
+    flag = pConn->nSocketRecvBufferSize;
+#if defined(WIN32)|| defined(WINCE)  /* WIN32 or WINCE */
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char*)&flag, sizeof flag);
+#else                                /* linux */
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (void*)&flag, sizeof flag);
+#endif                               /* WIN32 or WINCE */
+  }
+#endif
+
   /*
    * Connect the socket to reader. This can stall.
    */
@@ -2224,13 +2822,18 @@ TMR_LLRP_openConnectionToReader(TMR_Reader *reader, LLRP_tSConnection *pConn)
    * Best effort to set no delay. If this doesn't work
    * (no reason it shouldn't) we do not declare defeat.
    */
-  flag = 1;
+#ifdef LTKC_HAS_SOCKET_OPTIONS
+  if (pConn->bNoDelay)
+#endif
+  {
+    flag = 1;
 
 #if defined(WIN32)|| defined(WINCE)  /* WIN32 or WINCE */
     setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&flag, sizeof flag);
 #else                                /* linux */
     setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void*)&flag, sizeof flag);
 #endif                               /* WIN32 or WINCE */
+  }
   /*
    * Record the socket in the connection instance
    */
@@ -2248,24 +2851,50 @@ TMR_LLRP_connect(TMR_Reader *reader)
   LLRP_tSReaderEventNotificationData *pNtfData;
   LLRP_tSConnectionAttemptEvent *pEvent;
   LLRP_tSConnection *pConn;
+  uint64_t start;
 
   if (NULL == reader)
   {
     return TMR_ERROR_INVALID;
   }
   ret = TMR_SUCCESS;
+  start = tmr_gettime();
+  memset(&reader->u.llrpReader.connectTimings, 0,
+         sizeof(reader->u.llrpReader.connectTimings));
+  /* Nothing is known about the ROSpecs on a newly connected reader */
+  TMR_LLRP_clearROSpecCache(reader);
   /*
    * Construct a connection (LLRP_tSConnection).
-   * Using a 32kb max frame size for send/recv.
+   * Using the default 128kb buffers for send/recv; the
+   * receiver reads several frames into its buffer at once.
    * The connection object is ready for business
    * but not actually connected to the reader yet.
    */
-  reader->u.llrpReader.pConn = LLRP_Conn_construct(reader->u.llrpReader.pTypeRegistry, 32u*1024u);
+  reader->u.llrpReader.pConn = LLRP_Conn_construct(reader->u.llrpReader.pTypeRegistry, 0);
   if(NULL == reader->u.llrpReader.pConn)
   {
     sprintf(reader->u.llrpReader.errMsg, "Error: Connection initialization failed");
     return TMR_ERROR_LLRP_CONNECTIONFAILED;
   }
+  /*
+   * Decode each received message into its own arena. Reports are
+   * only read and then freed with TMR_LLRP_freeMessage(), which
+   * releases the whole tree at once.
+   */
+#ifdef LTKC_HAS_DECODE_INTO_ARENA
+  reader->u.llrpReader.pConn->bDecodeIntoArena = 1;
+#endif
+#ifdef LTKC_HAS_SOCKET_OPTIONS
+  reader->u.llrpReader.pConn->nSocketRecvBufferSize = TMR_LLRP_SOCKET_RCVBUF;
+#endif
+#if defined(TMR_ENABLE_BACKGROUND_READS) && defined(LTKC_HAS_FRAME_HOOK)
+  /*
+   * Tag reports received while reading continuously are parsed
+   * straight from their frames instead.
+   */
+  reader->u.llrpReader.pConn->pfFrameHook = TMR_LLRP_streamReportFrame;
+  reader->u.llrpReader.pConn->pFrameHookContext = reader;
+#endif
 
   /*
    * Open the connection to the reader
@@ -2341,8 +2970,11 @@ TMR_LLRP_connect(TMR_Reader *reader)
    * Free the message
    */
   TMR_LLRP_freeMessage(pMsg);
+  reader->u.llrpReader.connectTimings.stepMs[TMR_LLRP_CONNECT_STEP_OPEN] =
+    (uint32_t)(tmr_gettime() - start);
   reader->connected = true;
   ret = TMR_LLRP_boot(reader);
+  reader->u.llrpReader.connectTimings.totalMs = (uint32_t)(tmr_gettime() - start);
 
   /* At this point we will have the software version.
    * Check for available features as per software version.
@@ -2365,7 +2997,6 @@ TMR_Status
 TMR_LLRP_destroy(TMR_Reader *reader)
 {
   LLRP_tSMessage *pRspMsg = NULL;
-  uint8_t i;
 
   if (NULL == reader)
   {
@@ -2398,10 +3029,13 @@ TMR_LLRP_destroy(TMR_Reader *reader)
   reader->u.llrpReader.receiverEnabled = true;
   pthread_cond_broadcast(&reader->u.llrpReader.receiverCond);
   pthread_mutex_unlock(&reader->u.llrpReader.receiverLock);
+  /* It may also be waiting on the socket */
+  TMR_LLRP_wakeBackgroundReceiver(reader);
 
   /** wait for the thread to exit */
   pthread_join(reader->u.llrpReader.llrpReceiver, NULL);
   reader->u.llrpReader.threadCancel = false;
+  TMR_LLRP_closeBackgroundReceiverWake(reader);
 
   pthread_mutex_lock(&reader->u.llrpReader.receiverLock);
   if (true == reader->u.llrpReader.receiverSetup)
@@ -2421,16 +3055,10 @@ TMR_LLRP_destroy(TMR_Reader *reader)
 #endif
 
   /** May not freeed before, free it now */
-  if (NULL != reader->u.llrpReader.bufResponse)
-  {
-    /* free this before leaking the memory */
-    for (i = 0; i < reader->u.llrpReader.bufPointer; i++)
-    {
-      TMR_LLRP_freeMessage(reader->u.llrpReader.bufResponse[i]);
-    }
-    free(reader->u.llrpReader.bufResponse);
-    reader->u.llrpReader.bufResponse=NULL;
-  }
+  TMR_LLRP_releaseResponses(reader);
+  free(reader->u.llrpReader.bufResponse);
+  reader->u.llrpReader.bufResponse = NULL;
+  reader->u.llrpReader.bufCapacity = 0;
 
   if (true == reader->connected)
   {
@@ -2466,6 +3094,20 @@ TMR_LLRP_destroy(TMR_Reader *reader)
     reader->u.llrpReader.pTypeRegistry=NULL;
   }
   reader->connected = false;
+  free(reader->u.llrpReader.xmlBuf);
+  reader->u.llrpReader.xmlBuf = NULL;
+  reader->u.llrpReader.xmlBufSize = 0;
+#ifdef TMR_ENABLE_BACKGROUND_READS
+  TMR_LLRP_dropStreamedFrames(reader);
+#endif
+  TMR_LLRP_clearROSpecCache(reader);
+  free(reader->u.llrpReader.capabilityCacheDir);
+  reader->u.llrpReader.capabilityCacheDir = NULL;
+  free(reader->u.llrpReader.capabilityCachePath);
+  reader->u.llrpReader.capabilityCachePath = NULL;
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  TMR_stopTransportCapture(reader);
+#endif
   }
 
   return TMR_SUCCESS;
@@ -2609,10 +3251,18 @@ TMR_LLRP_read_internal(TMR_Reader *reader,
     /**
      * Prepare the reader to perform Read operation
      **/
-    lr->roSpecId++;
-    if (TMR_LLRP_SYNC_MAX_ROSPECS <= lr->roSpecId)
+    if (lr->roSpecCache.enabled && (NULL != lr->roSpecCache.frame))
     {
-      lr->roSpecId = 1;
+      /* Rebuild the ROSpec under the cached ID so the two compare */
+      lr->roSpecId = lr->roSpecCache.roSpecId;
+    }
+    else
+    {
+      lr->roSpecId++;
+      if (TMR_LLRP_SYNC_MAX_ROSPECS <= lr->roSpecId)
+      {
+        lr->roSpecId = 1;
+      }
     }
     lr->readPlanProtocol[lr->roSpecId].rospecProtocol = rp->u.simple.protocol;
     lr->readPlanProtocol[lr->roSpecId].rospecID = (uint8_t)lr->roSpecId;
@@ -2727,12 +3377,47 @@ TMR_LLRP_read_internal(TMR_Reader *reader,
   }
 }
 
+/**
+ * Whether a read may leave its ROSpec on the reader for the next
+ * one to start again. Only sync reads that install a single ROSpec
+ * and no AccessSpec qualify.
+ */
+static bool
+TMR_LLRP_isROSpecCacheable(TMR_Reader *reader, TMR_ReadPlan *rp)
+{
+  uint8_t i;
+
+  if (reader->continuousReading)
+  {
+    return false;
+  }
+  if (TMR_READ_PLAN_TYPE_SIMPLE == rp->type)
+  {
+    return (NULL == rp->u.simple.tagop);
+  }
+  if ((TMR_READ_PLAN_TYPE_MULTI == rp->type) &&
+      (reader->u.llrpReader.featureFlags & TMMP_READER_FEATURES_FLAG_PERANTENNA_ONTIME))
+  {
+    /* One ROSpec with an InventoryParameterSpec per sub plan */
+    for (i = 0; i < rp->u.multi.planCount; i++)
+    {
+      if (NULL != rp->u.multi.plans[i]->u.simple.tagop)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
 TMR_Status
 TMR_LLRP_read(TMR_Reader *reader, uint32_t timeoutMs, int32_t *tagCount)
 {
   TMR_Status ret;
   TMR_ReadPlan *rp;
-  uint8_t i;
+  TMR_LLRP_ROSpecCache *cache;
+  bool cacheable;
 
   if (NULL == reader)
   {
@@ -2740,6 +3425,8 @@ TMR_LLRP_read(TMR_Reader *reader, uint32_t timeoutMs, int32_t *tagCount)
   }
   rp = reader->readParams.readPlan;
   ret = TMR_SUCCESS;
+  cache = &reader->u.llrpReader.roSpecCache;
+  cacheable = TMR_LLRP_isROSpecCacheable(reader, rp);
 
   if (tagCount)
   {
@@ -2747,26 +3434,20 @@ TMR_LLRP_read(TMR_Reader *reader, uint32_t timeoutMs, int32_t *tagCount)
   }
 
   /**
-   * Allocate memory for bufResponse, to atleast hold one RO_ACCESS_REPORT,
-   * Depending on number of reports received, can be reallocated later.
+   * Free reports left from an earlier read and make sure bufResponse
+   * holds at least one RO_ACCESS_REPORT. It grows as reports arrive.
    **/
-  if (NULL != reader->u.llrpReader.bufResponse)
+  TMR_LLRP_releaseResponses(reader);
+  reader->u.llrpReader.tagsRemaining = 0;
+  ret = TMR_LLRP_reserveResponses(reader, 1);
+  if (TMR_SUCCESS != ret)
   {
-    /* free this before leaking the memory */
-    for (i = 0; i < reader->u.llrpReader.bufPointer; i++)
-    {
-      TMR_LLRP_freeMessage(reader->u.llrpReader.bufResponse[i]);
-    }
-    free(reader->u.llrpReader.bufResponse);
-    reader->u.llrpReader.bufResponse=NULL;
+    return ret;
   }
-
-  reader->u.llrpReader.tagsRemaining = 0;
-  reader->u.llrpReader.bufPointer = 0;
-  reader->u.llrpReader.bufIndex = 0;
- 
-  reader->u.llrpReader.bufResponse = (LLRP_tSMessage **) malloc( 1 * sizeof(LLRP_tSMessage *));
+  reader->u.llrpReader.bufResponse[0] = NULL;
   reader->u.llrpReader.pTagReportData = NULL;
+  /* The first reportSpec.periodMs window starts with the read */
+  reader->u.llrpReader.reportRequestedAt = tmr_gettime();
 
   ret = TMR_LLRP_cmdGetTMMetadataFlag(reader, (uint16_t *)&reader->u.llrpReader.metadata);
   if (TMR_SUCCESS != ret)
@@ -2790,27 +3471,35 @@ TMR_LLRP_read(TMR_Reader *reader, uint32_t timeoutMs, int32_t *tagCount)
   }
 
   /**
-   * DELETE_ROSPECs
-   * Delete all ROSpecs, so we don't have to worry about the reader's
-   * prior configuration
+   * A sync read that repeats the previous one keeps the ROSpec
+   * that read left on the reader; TMR_LLRP_cmdAddROSpec() clears
+   * the reader itself if the plan turns out to have changed.
    **/
-  ret = TMR_LLRP_cmdDeleteAllROSpecs(reader, true);
-  /*FIXME:
-   * If there are no rospecs on reader, it will throw an exception
-   * Do we really need to care about the error here?
-  if (TMR_SUCCESS != ret)
+  if ((false == cacheable) || (NULL == cache->frame))
   {
-    return ret;
-  }*/
-  /**
-   * DELETE_ACCESSSPECs
-   * Delete all AccessSpecs, so we don't have to worry about reader's
-   * prior configuration
-   **/
-  ret = TMR_LLRP_cmdDeleteAllAccessSpecs(reader);
-  /**
-   * FIXME: do we really need to care about the error here?
-   **/
+    /**
+     * DELETE_ROSPECs
+     * Delete all ROSpecs, so we don't have to worry about the reader's
+     * prior configuration
+     **/
+    ret = TMR_LLRP_cmdDeleteAllROSpecs(reader, true);
+    /*FIXME:
+     * If there are no rospecs on reader, it will throw an exception
+     * Do we really need to care about the error here?
+    if (TMR_SUCCESS != ret)
+    {
+      return ret;
+    }*/
+    /**
+     * DELETE_ACCESSSPECs
+     * Delete all AccessSpecs, so we don't have to worry about reader's
+     * prior configuration
+     **/
+    ret = TMR_LLRP_cmdDeleteAllAccessSpecs(reader);
+    /**
+     * FIXME: do we really need to care about the error here?
+     **/
+  }
 
   if (!reader->continuousReading)
   {
@@ -2831,7 +3520,22 @@ TMR_LLRP_read(TMR_Reader *reader, uint32_t timeoutMs, int32_t *tagCount)
    **/
   reader->u.llrpReader.numOfROSpecEvents = 1;
 
+  cache->enabled = cacheable;
+  cache->reused = false;
   ret = TMR_LLRP_read_internal(reader, timeoutMs, rp);
+  if ((TMR_SUCCESS != ret) && cache->reused)
+  {
+    /**
+     * The reader no longer has the cached ROSpec (rebooted, or
+     * another client cleared it). Install it afresh.
+     **/
+    TMR_LLRP_cmdDeleteAllROSpecs(reader, true);
+    TMR_LLRP_cmdDeleteAllAccessSpecs(reader);
+    reader->u.llrpReader.numOfROSpecEvents = 1;
+    cache->reused = false;
+    ret = TMR_LLRP_read_internal(reader, timeoutMs, rp);
+  }
+  cache->enabled = false;
   if (TMR_SUCCESS != ret)
   {
     return ret;
@@ -2846,6 +3550,8 @@ TMR_LLRP_read(TMR_Reader *reader, uint32_t timeoutMs, int32_t *tagCount)
     ret = TMR_LLRP_verifyReadOperation(reader, tagCount);
     if (TMR_SUCCESS != ret)
     {
+      /* The ROSpec may not have finished; don't start it blindly */
+      TMR_LLRP_clearROSpecCache(reader);
 #ifdef TMR_ENABLE_BACKGROUND_READS      
       notify_exception_listeners(reader, ret);
 #endif
@@ -2888,6 +3594,28 @@ TMR_LLRP_hasMoreTags(TMR_Reader *reader)
 
     timeout = lr->searchTimeoutMs;
 
+    if (0 != lr->reportSpec.periodMs)
+    {
+      uint64_t now, due;
+
+      /**
+       * Ask for the tags the reader holds once every period, and
+       * wait no longer than the rest of the current one.
+       **/
+      now = tmr_gettime();
+      due = lr->reportRequestedAt + lr->reportSpec.periodMs;
+      if (now >= due)
+      {
+        lr->get_report = true;
+        lr->reportRequestedAt = now;
+        due = now + lr->reportSpec.periodMs;
+      }
+      if ((uint64_t)timeout > due - now)
+      {
+        timeout = (int)(due - now);
+      }
+    }
+
     if (true == reader->u.llrpReader.get_report)
     {
     /**
@@ -3096,27 +3824,16 @@ TMR_LLRP_hasMoreTags(TMR_Reader *reader)
         pReport = (LLRP_tSRO_ACCESS_REPORT *)lr->bufResponse[lr->bufIndex];
         lr->pTagReportData = pReport->listTagReportData;
           lr->bufIndex ++;
-        }
-    }
-    else
-    {
-      /**
-       * At this point it is assured that all tags in all RO_ACCESS_REPORTS
-       * are processed. Free RO_ACCESS_REPORTS that were buffered.
-       **/
-      uint8_t i;
-
-      for (i = 0; i < lr->bufIndex; i ++)
-      {
-        TMR_LLRP_freeMessage(lr->bufResponse[i]);
-      }
-      
+        }
+    }
+    else
+    {
       /**
-       * No more RO_ACCESS_REPORTS left, safe to free the bufResponse array
-       * which was allocated in TMR_LLRP_read().
+       * At this point it is assured that all tags in all RO_ACCESS_REPORTS
+       * are processed. Free RO_ACCESS_REPORTS that were buffered, the
+       * array is kept for the next read.
        **/
-      free(lr->bufResponse);
-      lr->bufResponse = NULL;
+      TMR_LLRP_releaseResponses(reader);
     }
   }
     return ret;
@@ -3182,6 +3899,213 @@ TMR_LLRP_getNextTag(TMR_Reader *reader, TMR_TagReadData *data)
   return ret;
 }
 
+/**
+ * Whether a tag operation command failed because the reader does not
+ * know the ROSpec it names, as when the cached ROSpec is gone.
+ *
+ * @param pRspMsg Response to ADD_ACCESSSPEC, ENABLE_ACCESSSPEC or START_ROSPEC
+ */
+static bool
+TMR_LLRP_isROSpecMissing(LLRP_tSMessage *pRspMsg)
+{
+  LLRP_tSLLRPStatus *pLLRPStatus;
+
+  if (&LLRP_tdADD_ACCESSSPEC_RESPONSE == pRspMsg->elementHdr.pType)
+  {
+    pLLRPStatus = ((LLRP_tSADD_ACCESSSPEC_RESPONSE *)pRspMsg)->pLLRPStatus;
+  }
+  else if (&LLRP_tdSTART_ROSPEC_RESPONSE == pRspMsg->elementHdr.pType)
+  {
+    pLLRPStatus = ((LLRP_tSSTART_ROSPEC_RESPONSE *)pRspMsg)->pLLRPStatus;
+  }
+  else
+  {
+    return false;
+  }
+  if (NULL == pLLRPStatus)
+  {
+    return false;
+  }
+
+  /* An unknown ROSpecID is an invalid field value */
+  return (LLRP_StatusCode_A_Invalid == pLLRPStatus->eStatusCode) ||
+         ((NULL != pLLRPStatus->pFieldError) &&
+          (LLRP_StatusCode_A_Invalid == pLLRPStatus->pFieldError->eErrorCode));
+}
+
+/**
+ * Send tag operation commands and check their responses. The commands
+ * are freed.
+ *
+ * @param reader Reader pointer
+ * @param cmds Commands to send
+ * @param count Number of commands
+ * @param[out] roSpecMissing Set when a command failed for want of the ROSpec
+ * @return TMR_SUCCESS, or the first failure
+ */
+static TMR_Status
+TMR_LLRP_sendTagOpCommands(TMR_Reader *reader, TMR_LLRP_PipelinedCommand *cmds,
+                           int count, bool *roSpecMissing)
+{
+  TMR_Status ret;
+  int timeoutMs;
+  int i;
+
+  ret = TMR_SUCCESS;
+  timeoutMs = reader->u.llrpReader.commandTimeout + reader->u.llrpReader.transportTimeout;
+#if TMR_LLRP_TAGOP_PIPELINE
+  TMR_LLRP_sendPipelined(reader, cmds, count, timeoutMs);
+#endif
+  for (i = 0; i < count; i++)
+  {
+#if !TMR_LLRP_TAGOP_PIPELINE
+    /* One at a time, stopping at the first failure */
+    if (TMR_SUCCESS == ret)
+    {
+      TMR_LLRP_sendPipelined(reader, &cmds[i], 1, timeoutMs);
+    }
+#endif
+    if (NULL != cmds[i].pRsp)
+    {
+      if (TMR_LLRP_isROSpecMissing(cmds[i].pRsp))
+      {
+        *roSpecMissing = true;
+      }
+      cmds[i].status = TMR_LLRP_handleTagOpSpecResponse(reader, cmds[i].pRsp);
+      cmds[i].pRsp = NULL;
+    }
+    if (TMR_SUCCESS == ret)
+    {
+      ret = cmds[i].status;
+    }
+    TMR_LLRP_freeMessage(cmds[i].pCmd);
+  }
+
+  return ret;
+}
+
+/**
+ * Set off a standalone tag operation: install its ROSpec and
+ * AccessSpec and start the ROSpec.
+ *
+ * The ROSpec goes through the ROSpec cache, so when it is the one the
+ * previous tag operation used (same filter, antenna and protocol) it is
+ * still enabled on the reader and is not sent again. The AccessSpec
+ * stops after one operation, so every tag operation adds its own; its
+ * ADD_ACCESSSPEC and ENABLE_ACCESSSPEC go back to back. START_ROSPEC
+ * follows only once both have succeeded, so the ROSpec never runs
+ * without the AccessSpec.
+ *
+ * A tag operation that reuses the ROSpec thus costs two round trips
+ * before the reader looks for the tag: the AccessSpec pair, then
+ * START_ROSPEC. One that does not costs six: DELETE_ROSPEC,
+ * DELETE_ACCESSSPEC, ADD_ROSPEC and ENABLE_ROSPEC one at a time, then
+ * the same two. Sending START_ROSPEC along with the AccessSpec pair
+ * would save a round trip, but a failed AccessSpec would then leave
+ * the ROSpec running without it.
+ *
+ * @param reader Reader pointer
+ * @param tagop Pointer to the TMR_TagOp to execute
+ * @param filter Tag Filter to be used
+ * @param protocol Protocol to use
+ * @param antennaList The antenna to operate on
+ * @param[out] roSpecMissing Set when the reader did not know the ROSpec
+ */
+static TMR_Status
+TMR_LLRP_startTagOp(TMR_Reader *reader, TMR_TagOp *tagop, TMR_TagFilter *filter,
+                    TMR_TagProtocol protocol, TMR_uint8List *antennaList,
+                    bool *roSpecMissing)
+{
+  TMR_Status ret;
+  TMR_LLRP_LlrpReader *lr;
+  TMR_LLRP_ROSpecCache *cache;
+  TMR_LLRP_PipelinedCommand cmds[2];
+  TMR_LLRP_PipelinedCommand start;
+  LLRP_tSENABLE_ACCESSSPEC *pEnable;
+  LLRP_tSSTART_ROSPEC *pStart;
+
+  lr = &reader->u.llrpReader;
+  cache = &lr->roSpecCache;
+  *roSpecMissing = false;
+
+  /**
+   * 1. Reset Reader
+   * Delete all ROSpec and AccessSpecs on the reader, so that
+   * we don't have to worry about the prior configuration
+   * No need to verify the error status.
+   *
+   * A ROSpec left by an earlier operation is kept;
+   * TMR_LLRP_cmdAddROSpec() clears the reader itself if this
+   * operation needs a different one.
+   **/
+  if (NULL == cache->frame)
+  {
+    TMR_LLRP_cmdDeleteAllROSpecs(reader, true);
+    TMR_LLRP_cmdDeleteAllAccessSpecs(reader);
+    lr->roSpecId ++;
+  }
+  else
+  {
+    lr->roSpecId = cache->roSpecId;
+  }
+
+  /**
+   * 2. Add ROSpec
+   * 3. Enable ROSpec
+   * These two are performed by TMR_LLRP_cmdPrepareROSpec method
+   **/
+  cache->enabled = true;
+  cache->reused = false;
+  /* timeout = 0, as it has no significance in this case */
+  ret = TMR_LLRP_cmdPrepareROSpec(reader, 0, antennaList, filter, protocol);
+  cache->enabled = false;
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
+  /**
+   * 4. Add AccessSpec
+   **/
+  memset(cmds, 0, sizeof(cmds));
+  lr->accessSpecId ++;
+  /**
+   * Filter is still sent as NULL, as there is no support for it
+   * and the filter sent as part of ROSpec is considered.
+   *
+   * isStandalone is set to true, since it is standalone tag operation
+   **/
+  ret = TMR_LLRP_msgAddAccessSpec(reader, protocol, NULL, lr->roSpecId,
+                                  tagop, true, &cmds[0].pCmd);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
+  /**
+   * 5. Enable AccessSpec
+   **/
+  pEnable = LLRP_ENABLE_ACCESSSPEC_construct();
+  LLRP_ENABLE_ACCESSSPEC_setAccessSpecID(pEnable, lr->accessSpecId);
+  cmds[1].pCmd = &pEnable->hdr;
+
+  ret = TMR_LLRP_sendTagOpCommands(reader, cmds, numberof(cmds), roSpecMissing);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
+  /**
+   * 6. Start ROSpec
+   **/
+  memset(&start, 0, sizeof(start));
+  pStart = LLRP_START_ROSPEC_construct();
+  LLRP_START_ROSPEC_setROSpecID(pStart, lr->roSpecId);
+  start.pCmd = &pStart->hdr;
+
+  return TMR_LLRP_sendTagOpCommands(reader, &start, 1, roSpecMissing);
+}
+
 /**
  * Execute Individual tag operation
  * 
@@ -3205,8 +4129,11 @@ TMR_LLRP_executeTagOp(TMR_Reader *reader, TMR_TagOp *tagop,
   TMR_Status ret;
   TMR_LLRP_LlrpReader *lr;
   TMR_TagProtocol protocol;
+  uint8_t antenna[1];
+  TMR_uint8List antennaList;
   int timeout;
   uint64_t start, end, difftime;
+  bool roSpecMissing;
 
   if (NULL == reader)
   {
@@ -3224,18 +4151,16 @@ TMR_LLRP_executeTagOp(TMR_Reader *reader, TMR_TagOp *tagop,
   ret = TMR_SUCCESS;
   isStandaloneTagop = true;
  
-  reader->u.llrpReader.bufPointer = 0;
   /**
-   * Allocate memory for bufResponse, to atleast hold one RO_ACCESS_REPORT,
+   * Make sure bufResponse holds at least one RO_ACCESS_REPORT,
    * We only expect one RO_ACCESS_REPORT in case of standalone tag operation.
    **/
-  if (NULL != reader->u.llrpReader.bufResponse)
+  TMR_LLRP_releaseResponses(reader);
+  ret = TMR_LLRP_reserveResponses(reader, 1);
+  if (TMR_SUCCESS != ret)
   {
-    /* free this before leaking the memory */
-    free(reader->u.llrpReader.bufResponse);
-    reader->u.llrpReader.bufResponse=NULL;
+    return ret;
   }
-  reader->u.llrpReader.bufResponse = (LLRP_tSMessage **) malloc(1 * sizeof(LLRP_tSMessage *));
 
 
   /**
@@ -3252,91 +4177,45 @@ TMR_LLRP_executeTagOp(TMR_Reader *reader, TMR_TagOp *tagop,
    **/
 
   /**
-   * 1. Reset Reader
-   * Delete all ROSpec and AccessSpecs on the reader, so that
-   * we don't have to worry about the prior configuration
-   * No need to verify the error status.
+   * prepare antennaList
+   * The operation has to be performed on the antenna specified
+   * in the /reader/tagop/antenna parameter
    **/
-  TMR_LLRP_cmdDeleteAllROSpecs(reader, true);
-  TMR_LLRP_cmdDeleteAllAccessSpecs(reader);
-
+  antenna[0] = reader->tagOpParams.antenna;
+  antennaList.len = 1;
+  antennaList.max = 1;
+  antennaList.list = antenna;
   /**
-   * 2. Add ROSpec
-   * 3. Enable ROSpec
-   * These two are performed by TMR_LLRP_cmdPrepareROSpec method
+   * Protocol to use is specified in /reader/tagop/protocol
    **/
-  {
-    uint8_t antenna[1];
-    TMR_uint8List antennaList;
-
-    /**
-     * prepare antennaList
-     * The operation has to be performed on the antenna specified
-     * in the /reader/tagop/antenna parameter
-     **/
-    antenna[0] = reader->tagOpParams.antenna;
-    antennaList.len = 1;
-    antennaList.max = 1;
-    antennaList.list = antenna;
-    /**
-     * Protocol to use is specified in /reader/tagop/protocol
-     **/
 #ifdef TMR_ENABLE_ISO180006B
-    if ((TMR_TAGOP_ISO180006B_READDATA == tagop->type) || (TMR_TAGOP_ISO180006B_WRITEDATA == tagop->type)
-                                          ||(TMR_TAGOP_ISO180006B_LOCK == tagop->type))
-    {
-      protocol = TMR_TAG_PROTOCOL_ISO180006B;
-    }
-    else
-#endif /* TMR_ENABLE_ISO180006B */
-    {
-      protocol = reader->tagOpParams.protocol;
-    }
-
-    /**
-     * Prepare ROSpec
-     **/
-    lr->roSpecId ++;
-    /* timeout = 0, as it has no significance in this case */
-    ret = TMR_LLRP_cmdPrepareROSpec(reader, 0, &antennaList, filter, protocol);
-    if (TMR_SUCCESS != ret)
-    {
-      return ret;
-    }
+  if ((TMR_TAGOP_ISO180006B_READDATA == tagop->type) || (TMR_TAGOP_ISO180006B_WRITEDATA == tagop->type)
+                                        ||(TMR_TAGOP_ISO180006B_LOCK == tagop->type))
+  {
+    protocol = TMR_TAG_PROTOCOL_ISO180006B;
   }
-
-  /**
-   * 4. Add AccessSpec
-   **/
-  lr->accessSpecId ++;
-  /**
-   * Filter is still sent as NULL, as there is no support for it
-   * and the filter sent as part of ROSpec is considered.
-   *
-   * isStandalone is set to true, since it is standalone tag operation
-   **/
-  ret = TMR_LLRP_cmdAddAccessSpec(reader, protocol, NULL,
-                                lr->roSpecId, tagop, true);
-  if (TMR_SUCCESS != ret)
+  else
+#endif /* TMR_ENABLE_ISO180006B */
   {
-    return ret;
+    protocol = reader->tagOpParams.protocol;
   }
 
   /**
-   * 5. Enable AccessSpec
+   * Steps 1 to 6 are performed by TMR_LLRP_startTagOp
    **/
-  ret = TMR_LLRP_cmdEnableAccessSpec(reader, lr->accessSpecId);
-  if (TMR_SUCCESS != ret)
+  ret = TMR_LLRP_startTagOp(reader, tagop, filter, protocol, &antennaList, &roSpecMissing);
+  if ((TMR_SUCCESS != ret) && lr->roSpecCache.reused && roSpecMissing)
   {
-    return ret;
+    /**
+     * The reader no longer has the cached ROSpec (rebooted, or
+     * another client cleared it). Install it afresh.
+     **/
+    TMR_LLRP_clearROSpecCache(reader);
+    ret = TMR_LLRP_startTagOp(reader, tagop, filter, protocol, &antennaList, &roSpecMissing);
   }
-
-  /**
-   * 6. Start ROSpec
-   **/
-  ret = TMR_LLRP_cmdStartROSpec(reader, lr->roSpecId);
   if (TMR_SUCCESS != ret)
   {
+    TMR_LLRP_clearROSpecCache(reader);
     return ret;
   }
 
@@ -3366,7 +4245,9 @@ TMR_LLRP_executeTagOp(TMR_Reader *reader, TMR_TagOp *tagop,
        * We have waited for enough time, but still the message
        * isn't received. There could be some problem with the network.
        * We can't wait forever, throw timeout error to the user
+       * The ROSpec may not have finished; don't start it blindly.
        **/
+      TMR_LLRP_clearROSpecCache(reader);
       return TMR_ERROR_TIMEOUT;
     }
   }
@@ -3398,6 +4279,7 @@ TMR_LLRP_executeTagOp(TMR_Reader *reader, TMR_TagOp *tagop,
          * Tag operation is failed to execute.
          * Return the error.
          **/
+        TMR_LLRP_clearROSpecCache(reader);
         return ret;
       }
       /**
@@ -3408,20 +4290,16 @@ TMR_LLRP_executeTagOp(TMR_Reader *reader, TMR_TagOp *tagop,
         TMR_LLRP_parseTagOpSpecData(pOpSpec, data);
       }
     }
+    else
+    {
+      /* No tag found, the AccessSpec is still on the reader */
+      TMR_LLRP_clearROSpecCache(reader);
+    }
 
     /**
      * Done with the response. Free allocated memory
      **/
-    {
-      uint8_t i;
-
-      for (i = 0; i < lr->bufPointer; i ++)
-      {
-        TMR_LLRP_freeMessage(lr->bufResponse[i]);
-      }
-      free(lr->bufResponse);
-      lr->bufResponse = NULL;
-    }
+    TMR_LLRP_releaseResponses(reader);
   }
   return ret;
 }
@@ -3535,6 +4413,168 @@ TMR_LLRP_reboot(TMR_Reader *reader)
   return ret;
 }
 
+TMR_Status
+TMR_LLRP_getConnectTimings(struct TMR_Reader *reader, TMR_LLRP_ConnectTimings *timings)
+{
+  if ((NULL == reader) || (NULL == timings) || (TMR_READER_TYPE_LLRP != reader->readerType))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  *timings = reader->u.llrpReader.connectTimings;
+  return TMR_SUCCESS;
+}
+
+TMR_Status
+TMR_LLRP_setCapabilityCacheDir(struct TMR_Reader *reader, const char *dir)
+{
+  char *copy;
+
+  if ((NULL == reader) || (TMR_READER_TYPE_LLRP != reader->readerType))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  copy = NULL;
+  if ((NULL != dir) && ('\0' != dir[0]))
+  {
+    copy = malloc(strlen(dir) + 1);
+    if (NULL == copy)
+    {
+      return TMR_ERROR_OUT_OF_MEMORY;
+    }
+    strcpy(copy, dir);
+  }
+  free(reader->u.llrpReader.capabilityCacheDir);
+  reader->u.llrpReader.capabilityCacheDir = copy;
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+TMR_LLRP_runParam(TMR_Reader *reader, TMR_Param key, void *getValue, const void *setValue)
+{
+  if (NULL != setValue)
+  {
+    return TMR_paramSet(reader, key, setValue);
+  }
+  return TMR_paramGet(reader, key, getValue);
+}
+
+/**
+ * Get or set several parameters, as TMR_paramGet() or TMR_paramSet()
+ * on each in turn would, but with their commands sent back to back.
+ *
+ * Each parameter is run twice. The first run only collects the first
+ * command it would send; its outcome is thrown away, and so is what it
+ * made of the parameters the reader supports. TMR_LLRP_exchangeParamBatch()
+ * then has the collected commands answered in one round trip, and the
+ * second run takes the responses. A parameter that needs more than one
+ * command sends the rest as usual. When setting, the parameters after
+ * the first one that reads its value from the reader are not batched,
+ * so that each reads what the one before it set.
+ *
+ * @param reader The reader
+ * @param count Number of parameters
+ * @param keys The parameters
+ * @param getValues Values to get, or NULL when setting
+ * @param setValues Values to set, or NULL when getting
+ * @param status Status of each parameter, or NULL
+ */
+static TMR_Status
+TMR_LLRP_paramMany(TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                   void *getValues[], const void *setValues[], TMR_Status status[])
+{
+  TMR_LLRP_LlrpReader *lr;
+  TMR_LLRP_ParamBatch batch;
+  uint32_t paramConfirmed[TMR_PARAMWORDS];
+  uint32_t paramPresent[TMR_PARAMWORDS];
+  TMR_Status ret, paramRet;
+  uint32_t i;
+
+  if ((NULL == reader) || (TMR_READER_TYPE_LLRP != reader->readerType))
+  {
+    return TMR_ERROR_INVALID;
+  }
+  if ((0 < count) && ((NULL == keys) || ((NULL == getValues) && (NULL == setValues))))
+  {
+    return TMR_ERROR_INVALID;
+  }
+  lr = &reader->u.llrpReader;
+  ret = TMR_SUCCESS;
+  memset(&batch, 0, sizeof(batch));
+
+  /**
+   * While reading, the background receiver is taking messages too;
+   * the parameters go one at a time, as TMR_LLRP_sendPipelined()
+   * would send them anyway.
+   **/
+  if ((false == reader->continuousReading) && (1 < count))
+  {
+    batch.params = calloc(count, sizeof(*batch.params));
+    batch.cmds = calloc(count, sizeof(*batch.cmds));
+    if ((NULL == batch.params) || (NULL == batch.cmds))
+    {
+      free(batch.params);
+      free(batch.cmds);
+      return TMR_ERROR_OUT_OF_MEMORY;
+    }
+    batch.count = count;
+    batch.setting = (NULL != setValues);
+    batch.batched = count;
+    batch.collecting = true;
+
+    memcpy(paramConfirmed, lr->paramConfirmed, sizeof(paramConfirmed));
+    memcpy(paramPresent, lr->paramPresent, sizeof(paramPresent));
+    lr->paramBatch = &batch;
+    for (i = 0; i < count; i++)
+    {
+      batch.current = i;
+      TMR_LLRP_runParam(reader, keys[i], (NULL != getValues) ? getValues[i] : NULL,
+                        (NULL != setValues) ? setValues[i] : NULL);
+    }
+    memcpy(lr->paramConfirmed, paramConfirmed, sizeof(paramConfirmed));
+    memcpy(lr->paramPresent, paramPresent, sizeof(paramPresent));
+
+    /* Failures are handed to the parameters whose commands failed */
+    TMR_LLRP_exchangeParamBatch(reader, &batch);
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    batch.current = i;
+    paramRet = TMR_LLRP_runParam(reader, keys[i], (NULL != getValues) ? getValues[i] : NULL,
+                                 (NULL != setValues) ? setValues[i] : NULL);
+    if (NULL != status)
+    {
+      status[i] = paramRet;
+    }
+    if (TMR_SUCCESS == ret)
+    {
+      ret = paramRet;
+    }
+  }
+
+  lr->paramBatch = NULL;
+  TMR_LLRP_freeParamBatch(&batch);
+  free(batch.params);
+  free(batch.cmds);
+  return ret;
+}
+
+TMR_Status
+TMR_LLRP_paramGetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                      void *values[], TMR_Status status[])
+{
+  return TMR_LLRP_paramMany(reader, count, keys, values, NULL, status);
+}
+
+TMR_Status
+TMR_LLRP_paramSetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                      const void *values[], TMR_Status status[])
+{
+  return TMR_LLRP_paramMany(reader, count, keys, NULL, values, status);
+}
+
 #if 0
 TMR_Status
 TMR_LLRP_resetHoptable(TMR_Reader *reader)
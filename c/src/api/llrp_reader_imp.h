@@ -135,6 +135,60 @@ typedef struct TMR_LLRP_PortDetect
   int16_t gain;
 }TMR_LLRP_PortDetect;
 
+/**
+ * One command of a TMR_LLRP_sendPipelined() exchange.
+ **/
+typedef struct TMR_LLRP_PipelinedCommand
+{
+  /** Command to send, NULL to skip. Left for the caller to free. */
+  LLRP_tSMessage *pCmd;
+  /** Response, for the caller to free. NULL when status is not TMR_SUCCESS. */
+  LLRP_tSMessage *pRsp;
+  /** TMR_SUCCESS once the response has arrived */
+  TMR_Status status;
+  /** Milliseconds from sending the command to its response */
+  uint32_t elapsedMs;
+}TMR_LLRP_PipelinedCommand;
+
+/**
+ * The command a parameter of a TMR_LLRP_ParamBatch sent first.
+ **/
+typedef struct TMR_LLRP_BatchedCommand
+{
+  /** The command, encoded. NULL if the parameter sent none. */
+  uint8_t *frame;
+  /** Frame length */
+  uint32_t length;
+  /** Parameter whose command was sent for this one, an earlier one for a repeat */
+  uint32_t sentBy;
+  /** On the parameter whose command was sent: how many have yet to take the response */
+  uint32_t users;
+  /** Whether the parameter has taken its response */
+  bool taken;
+}TMR_LLRP_BatchedCommand;
+
+/**
+ * Parameters got or set together by TMR_LLRP_paramGetMany() or
+ * TMR_LLRP_paramSetMany(). See TMR_LLRP_takeBatchedCommand().
+ **/
+typedef struct TMR_LLRP_ParamBatch
+{
+  /** True while collecting the commands, false once they are answered */
+  bool collecting;
+  /** Parameter being got or set */
+  uint32_t current;
+  /** Number of parameters */
+  uint32_t count;
+  /** True for TMR_LLRP_paramSetMany() */
+  bool setting;
+  /** Parameters from this one on send their commands as usual */
+  uint32_t batched;
+  /** First command of each parameter */
+  TMR_LLRP_BatchedCommand *params;
+  /** The exchange, indexed as params. pCmd is NULL for a parameter whose command was not sent. */
+  TMR_LLRP_PipelinedCommand *cmds;
+}TMR_LLRP_ParamBatch;
+
 /**
  * This struture is returned from ThingMagicDeDuplication
  **/
@@ -174,14 +228,29 @@ typedef struct TMR_LLRP_TMReaderConfiguration
 
 TMR_Status TMR_LLRP_notifyTransportListener(TMR_Reader *reader, LLRP_tSMessage *pMsg, bool tx, int timeout);
 TMR_Status TMR_LLRP_sendMessage(TMR_Reader *reader, LLRP_tSMessage *pMsg, int timeoutMs);
+TMR_Status TMR_LLRP_sendEncoded(TMR_Reader *reader, TMR_LLRP_EncodedCommand *cmd,
+                                const LLRP_tSTypeDescriptor *pType, int timeoutMs);
 TMR_Status TMR_LLRP_receiveMessage(TMR_Reader *reader, LLRP_tSMessage **pMsg, int timeoutMs);
 TMR_Status TMR_LLRP_sendTimeout(TMR_Reader *reader, LLRP_tSMessage *pMsg, LLRP_tSMessage **pRsp, int timeoutMs);
 TMR_Status TMR_LLRP_send(TMR_Reader *reader, LLRP_tSMessage *pMsg, LLRP_tSMessage **pRsp);
+TMR_Status TMR_LLRP_sendPipelined(TMR_Reader *reader, TMR_LLRP_PipelinedCommand *cmds,
+                                  uint32_t count, int timeoutMs);
+TMR_Status TMR_LLRP_exchangeParamBatch(TMR_Reader *reader, TMR_LLRP_ParamBatch *batch);
+void TMR_LLRP_freeParamBatch(TMR_LLRP_ParamBatch *batch);
+TMR_Status TMR_LLRP_encodeMessage(TMR_Reader *reader, LLRP_tSMessage *pCmdMsg,
+                                  uint8_t **frame, uint32_t *length);
+TMR_Status TMR_LLRP_decodeMessage(TMR_Reader *reader, uint8_t *frame, uint32_t length,
+                                  LLRP_tSMessage **pMsg);
 void TMR_LLRP_freeMessage(LLRP_tSMessage *pMsg);
 TMR_Status TMR_LLRP_checkLLRPStatus(LLRP_tSLLRPStatus *pLLRPStatus);
 
 TMR_Status TMR_LLRP_cmdGetRegion(TMR_Reader *reader, TMR_Region *region);
+TMR_Status TMR_LLRP_msgGetRegion(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg);
+TMR_Status TMR_LLRP_handleGetRegionResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg, TMR_Region *region);
 TMR_Status TMR_LLRP_cmdAntennaDetect(TMR_Reader *reader, uint8_t *count, TMR_LLRP_PortDetect *ports);
+TMR_Status TMR_LLRP_msgAntennaDetect(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg);
+TMR_Status TMR_LLRP_handleAntennaDetectResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                                uint8_t *count, TMR_LLRP_PortDetect *ports);
 TMR_Status TMR_LLRP_cmdGetTMAsyncOffTime(TMR_Reader *reader, uint32_t *offtime);
 TMR_Status TMR_LLRP_cmdGetTMAsyncOnTime(TMR_Reader *reader, uint32_t *ontime);
 TMR_Status TMR_LLRP_cmdGetTMMetadataFlag(TMR_Reader *reader, uint16_t *metadata);
@@ -192,6 +261,9 @@ TMR_Status TMR_LLRP_cmdGetGPIState(TMR_Reader *reader, uint8_t *count, TMR_GpioP
 TMR_Status TMR_LLRP_cmdSetGPOState(TMR_Reader *reader, uint8_t count, const TMR_GpioPin state[]);
 
 TMR_Status TMR_LLRP_cmdGetReaderCapabilities(TMR_Reader *reader, TMR_LLRP_ReaderCapabilities *capabilities);
+TMR_Status TMR_LLRP_msgGetReaderCapabilities(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg);
+TMR_Status TMR_LLRP_handleGetReaderCapabilitiesResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                                        TMR_LLRP_ReaderCapabilities *capabilities);
 TMR_Status TMR_LLRP_cmdGetRegulatoryCapabilities(TMR_Reader *reader,  TMR_uint32List *table);
 
 TMR_Status TMR_LLRP_cmdGetReadTransmitPowerList(TMR_Reader *reader, TMR_PortValueList *pPortValueList);
@@ -200,6 +272,10 @@ TMR_Status TMR_LLRP_cmdSetReadTransmitPowerList(TMR_Reader *reader, TMR_PortValu
 TMR_Status TMR_LLRP_cmdGetWriteTransmitPowerList(TMR_Reader *reader, TMR_PortValueList *pPortValueList);
 TMR_Status TMR_LLRP_cmdSetWriteTransmitPowerList(TMR_Reader *reader, TMR_PortValueList *pPortValueList);
 TMR_Status TMR_LLRP_cmdGetTMDeviceInformationCapabilities(TMR_Reader *reader, int param, TMR_String  *version);
+TMR_Status TMR_LLRP_msgGetTMDeviceInformationCapabilities(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg);
+TMR_Status TMR_LLRP_handleGetTMDeviceInformationCapabilitiesResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                                                     int param, TMR_String *version,
+                                                                     TMR_String *firmware);
 TMR_Status TMR_LLRP_cmdGetTMDeviceInformationIDs(TMR_Reader *reader, int param, uint16_t *id);
 TMR_Status TMR_LLRP_cmdGetActiveRFControl(TMR_Reader *reader, TMR_LLRP_RFControl *rfControl);
 TMR_Status TMR_LLRP_cmdSetActiveRFControl(TMR_Reader *reader, TMR_LLRP_RFControl *rfControl);
@@ -269,6 +345,9 @@ TMR_Status TMR_LLRP_cmdGetISO18K6BLinkFrequency(TMR_Reader *reader, TMR_ISO18000
 
 /* Thingmagic Device Protocol Capabilities */
 TMR_Status TMR_LLRP_cmdGetTMDeviceProtocolCapabilities(TMR_Reader *reader, TMR_TagProtocolList * protocol);
+TMR_Status TMR_LLRP_msgGetTMDeviceProtocolCapabilities(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg);
+TMR_Status TMR_LLRP_handleGetTMDeviceProtocolCapabilitiesResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                                                  TMR_TagProtocolList *protocolList);
 
 /* Thingmagic Device Antenna Detection */
 TMR_Status TMR_LLRP_cmdGetThingMagicAntennaDetection(TMR_Reader *reader, bool *antennaport);
@@ -293,6 +372,7 @@ TMR_Status TMR_LLRP_cmdGetTMAntennaReturnloss(TMR_Reader *reader, TMR_PortValueL
 TMR_Status TMR_LLRP_cmdSetThingMagicRegionHoptable(TMR_Reader *reader, const TMR_uint32List *hopTableParam);
 
 /* Read  */
+void TMR_LLRP_clearROSpecCache(TMR_Reader *reader);
 TMR_Status TMR_LLRP_cmdPrepareROSpec(TMR_Reader *reader, uint16_t timeout, TMR_uint8List *antennaList,
             TMR_TagFilter *filter, TMR_TagProtocol protocol);
 TMR_Status TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration, TMR_uint8List *antennaList,
@@ -303,6 +383,35 @@ TMR_Status TMR_LLRP_cmdStartROSpec(TMR_Reader *reader, llrp_u32_t roSpecId);
 TMR_Status TMR_LLRP_cmdStopROSpec(TMR_Reader *reader, bool receiveResponse);
 TMR_Status TMR_LLRP_cmdDeleteAllROSpecs(TMR_Reader *reader, bool receiveResponse);
 TMR_Status TMR_LLRP_parseMetadataFromMessage(TMR_Reader *reader, TMR_TagReadData *data, LLRP_tSTagReportData *msg);
+
+/**
+ * Walks the TagReportData parameters of a raw RO_ACCESS_REPORT frame,
+ * for TMR_LLRP_reportStreamNext().
+ */
+typedef struct TMR_LLRP_ReportStream
+{
+  const uint8_t *frame;
+  uint32_t length;
+  /* Offset of the next report parameter */
+  uint32_t offset;
+  /* TagReportData parameters consumed so far */
+  uint32_t tagReports;
+  /* Whether ThingMagic custom metadata is parsed, as for TMR_LLRP_parseMetadataFromMessage() */
+  bool customMetadata;
+} TMR_LLRP_ReportStream;
+
+TMR_Status TMR_LLRP_reportStreamInit(TMR_Reader *reader, TMR_LLRP_ReportStream *stream,
+                                     const uint8_t *frame, uint32_t length);
+TMR_Status TMR_LLRP_reportStreamNext(TMR_Reader *reader, TMR_LLRP_ReportStream *stream,
+                                     TMR_TagReadData *data);
+LLRP_tSMessage *TMR_LLRP_streamReportFrame(void *context, const LLRP_tSFrameExtract *pFrameExtract,
+                                           const unsigned char *pFrame);
+void TMR_LLRP_takeStreamedFrame(TMR_Reader *reader, LLRP_tSMessage *pReport,
+                                uint8_t **frame, uint32_t *length);
+void TMR_LLRP_dropStreamedFrames(TMR_Reader *reader);
+TMR_Status TMR_LLRP_notifyStreamedTagReads(TMR_Reader *reader, const uint8_t *frame,
+                                           uint32_t length, uint32_t *streamed,
+                                           LLRP_tSMessage **pMsg);
 TMR_Status TMR_LLRP_verifyReadOperation(TMR_Reader *reader, int32_t *tagCount);
 TMR_Status TMR_LLRP_cmdStopReading(struct TMR_Reader *reader);
 void TMR_LLRP_parseCustomStatsValues(LLRP_tSCustomStatsValue *customStats, TMR_Reader_StatsValues *statsValue);
@@ -313,24 +422,37 @@ TMR_Status TMR_LLRP_cmdrebootReader(TMR_Reader *reader);
 
 /* Reset Reader */
 TMR_Status TMR_LLRP_stopActiveROSpecs(TMR_Reader *reader);
+TMR_Status TMR_LLRP_handleGetROSpecsResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg);
 
 /* Reports, Notifications and Keepalives */
 TMR_Status TMR_LLRP_setKeepAlive(TMR_Reader *reader);
+TMR_Status TMR_LLRP_msgSetKeepAlive(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg);
+TMR_Status TMR_LLRP_handleSetReaderConfigResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg);
 TMR_Status TMR_LLRP_enableEventsAndReports(TMR_Reader *reader);
 TMR_Status TMR_LLRP_setHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status);
+TMR_Status TMR_LLRP_msgSetHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status,
+                                                     LLRP_tSMessage **pCmdMsg);
 TMR_Status TMR_LLRP_handleKeepAlive(TMR_Reader *reader, LLRP_tSMessage *pMsg);
 TMR_Status TMR_LLRP_startBackgroundReceiver(TMR_Reader *reader);
 TMR_Status TMR_LLRP_cmdSetEventNotificationSpec(TMR_Reader *reader, bool state);
 TMR_Status TMR_LLRP_handleReaderEvents(TMR_Reader *reader, LLRP_tSMessage *pMsg);
 TMR_Status TMR_LLRP_processReceivedMessage(TMR_Reader *reader, LLRP_tSMessage *pMsg);
+TMR_Status TMR_LLRP_reserveResponses(TMR_Reader *reader, uint32_t count);
+void TMR_LLRP_releaseResponses(TMR_Reader *reader);
 void TMR_LLRP_setBackgroundReceiverState(TMR_Reader *reader, bool state);
+void TMR_LLRP_wakeBackgroundReceiver(TMR_Reader *reader);
+void TMR_LLRP_closeBackgroundReceiverWake(TMR_Reader *reader);
 
 /* Access Spec */
 TMR_Status TMR_LLRP_cmdEnableAccessSpec(TMR_Reader *reader, llrp_u32_t accessSpecId);
 TMR_Status TMR_LLRP_msgPrepareAccessCommand(TMR_Reader *reader, LLRP_tSAccessCommand *pAccessCommand,
                                                               TMR_TagFilter *filter, TMR_TagOp *tagop);
+TMR_Status TMR_LLRP_msgAddAccessSpec(TMR_Reader *reader, TMR_TagProtocol protocol, TMR_TagFilter *filter,
+                                     llrp_u32_t roSpecId, TMR_TagOp *tagop, bool isStandalone,
+                                     LLRP_tSMessage **pCmdMsg);
 TMR_Status TMR_LLRP_cmdAddAccessSpec(TMR_Reader *reader, TMR_TagProtocol protocol, TMR_TagFilter *filter,
                                             llrp_u32_t roSpecId, TMR_TagOp *tagop, bool isStandalone);
+TMR_Status TMR_LLRP_handleTagOpSpecResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg);
 TMR_Status TMR_LLRP_verifyOpSpecResultStatus(TMR_Reader *reader, LLRP_tSParameter *pParameter);
 TMR_Status TMR_LLRP_cmdDeleteAllAccessSpecs(TMR_Reader *reader);
 
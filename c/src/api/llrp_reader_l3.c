@@ -45,6 +45,12 @@
 #include <string.h>
 #if !defined(WIN32) && !defined(WINCE)
 #include <sys/select.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
 #endif
 
 #include <time.h>	
@@ -57,8 +63,45 @@
 #define TMMP_CUSTOM_TAGOP_RESPONSE 216
 #define TMMPD_CUSTOM_GPIO_STATUS   224
 #define TMMPD_CUSTOM_GEN2          226
+#define TMMPD_CUSTOM_GPIO_PIN      225
+#define TMMPD_CUSTOM_GEN2_Q        227
+#define TMMPD_CUSTOM_GEN2_LF       228
+#define TMMPD_CUSTOM_GEN2_TARGET   229
+
+/* LLRP parameter types inside TagReportData, for the report streamer */
+#define TMR_LLRP_TV_ANTENNAID                  1
+#define TMR_LLRP_TV_FIRSTSEENTIMESTAMPUTC      2
+#define TMR_LLRP_TV_FIRSTSEENTIMESTAMPUPTIME   3
+#define TMR_LLRP_TV_LASTSEENTIMESTAMPUTC       4
+#define TMR_LLRP_TV_LASTSEENTIMESTAMPUPTIME    5
+#define TMR_LLRP_TV_PEAKRSSI                   6
+#define TMR_LLRP_TV_CHANNELINDEX               7
+#define TMR_LLRP_TV_TAGSEENCOUNT               8
+#define TMR_LLRP_TV_ROSPECID                   9
+#define TMR_LLRP_TV_INVENTORYPARAMETERSPECID  10
+#define TMR_LLRP_TV_C1G2_CRC                  11
+#define TMR_LLRP_TV_C1G2_PC                   12
+#define TMR_LLRP_TV_EPC_96                    13
+#define TMR_LLRP_TV_SPECINDEX                 14
+#define TMR_LLRP_TV_ACCESSSPECID              16
+#define TMR_LLRP_TLV_TAGREPORTDATA           240
+#define TMR_LLRP_TLV_EPCDATA                 241
+#define TMR_LLRP_TLV_CUSTOM                 1023
+
+/*
+ * The last frame received, and whether more were read ahead of it.
+ * An LTKC without read-ahead keeps the frame at the buffer start.
+ */
+#ifdef LTKC_HAS_RECV_READ_AHEAD
+#define TMR_LLRP_RECV_FRAME(pConn) (&(pConn)->Recv.pBuffer[(pConn)->Recv.iFrame])
+#define TMR_LLRP_HAS_BUFFERED_MESSAGE(pConn) LLRP_Conn_hasBufferedMessage(pConn)
+#else
+#define TMR_LLRP_RECV_FRAME(pConn) ((pConn)->Recv.pBuffer)
+#define TMR_LLRP_HAS_BUFFERED_MESSAGE(pConn) 0
+#endif
 
-void process_async_response(TMR_Reader *reader);
+TMR_Status process_async_llrp_response(TMR_Reader *reader, LLRP_tSMessage *pMsg,
+                                       bool isStatusResponse);
 
 uint8_t TMR_LLRP_gpiListSargas[] = {0,1};
 uint8_t TMR_LLRP_gpoListSargas[] = {2,3};
@@ -163,10 +206,85 @@ TMR_LLRP_tmToLlrpGpo(uint32_t model, uint8_t tmNum, llrp_u16_t *llrpNum)
   }
 }
 
+/* Transport listener XML buffer: first allocation, and the size it may grow to */
+#ifdef LTKC_HAS_XML_GROWABLE
+#define TMR_LLRP_XML_BUFFER_INITIAL (16 * 1024)
+#define TMR_LLRP_XML_BUFFER_MAX (16 * 1024 * 1024)
+#else
+/* An LTKC that can't grow the buffer gets the fixed size used before */
+#define TMR_LLRP_XML_BUFFER_INITIAL (150 * 1024)
+#endif
+
+/**
+ * Render a message as XML into the reader's listener buffer in a
+ * single pass, the encoder growing the buffer as the text needs.
+ * Called with xmlLock held.
+ */
+static TMR_Status
+TMR_LLRP_renderXML(TMR_LLRP_LlrpReader *lr, LLRP_tSMessage *pMsg)
+{
+  LLRP_tSXMLTextEncoder *pXMLEncoder;
+  LLRP_tResultCode rc;
+  TMR_Status ret;
+
+  if (NULL == lr->xmlBuf)
+  {
+    lr->xmlBuf = malloc(TMR_LLRP_XML_BUFFER_INITIAL);
+    if (NULL == lr->xmlBuf)
+    {
+      return TMR_ERROR_OUT_OF_MEMORY;
+    }
+    lr->xmlBufSize = TMR_LLRP_XML_BUFFER_INITIAL;
+  }
+
+#ifdef LTKC_HAS_XML_GROWABLE
+  pXMLEncoder = LLRP_XMLTextEncoder_constructGrowable((unsigned char *)lr->xmlBuf,
+                                                      lr->xmlBufSize, TMR_LLRP_XML_BUFFER_MAX);
+#else
+  pXMLEncoder = LLRP_XMLTextEncoder_construct((unsigned char *)lr->xmlBuf, lr->xmlBufSize);
+#endif
+  if (NULL == pXMLEncoder)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+#ifdef LTKC_HAS_XML_GROWABLE
+  LLRP_XMLTextEncoder_setCompact(pXMLEncoder, TMR_LLRP_TRANSPORT_XML_COMPACT);
+#endif
+  LLRP_Encoder_encodeElement(&pXMLEncoder->encoderHdr, &pMsg->elementHdr);
+
+  /* The buffer may have moved while the text grew */
+  lr->xmlBuf = (char *)pXMLEncoder->pBuffer;
+  lr->xmlBufSize = pXMLEncoder->nBuffer;
+
+  ret = TMR_SUCCESS;
+  rc = pXMLEncoder->encoderHdr.ErrorDetails.eResultCode;
+  if (LLRP_RC_OK != rc)
+  {
+    /* Listeners get the reason in place of the text, as LLRP_toXMLString() reports it */
+    snprintf(lr->xmlBuf, lr->xmlBufSize, "ERROR: %s XML text failed, %s\n",
+             pMsg->elementHdr.pType->pName,
+             pXMLEncoder->encoderHdr.ErrorDetails.pWhatStr ?
+             pXMLEncoder->encoderHdr.ErrorDetails.pWhatStr : "no reason given");
+    ret = TMR_ERROR_LLRP_MSG_PARSE_ERROR;
+  }
+  else if (pXMLEncoder->bOverflow)
+  {
+    snprintf(lr->xmlBuf, lr->xmlBufSize, "ERROR: Buffer overflow\n");
+    ret = TMR_ERROR_LLRP_MSG_PARSE_ERROR;
+  }
+  LLRP_Encoder_destruct(&pXMLEncoder->encoderHdr);
+
+  return ret;
+}
+
 /**
  * Notify transport listener,
  * Called from SendMessage and ReceiveMessage
  *
+ * Listeners added with TMR_addTransportListener() get the message as
+ * XML, rendered only when one is registered. Raw listeners are served
+ * from the encoded frame by the callers.
+ *
  * @param reader The reader
  * @param pMsg Pointer to Message to send (of type LLRP_tSMessage * for llrp reader)
  * @param tx True if called from SendMessage, false if called from ReceiveMessage
@@ -175,17 +293,44 @@ TMR_LLRP_tmToLlrpGpo(uint32_t model, uint8_t tmNum, llrp_u16_t *llrpNum)
 TMR_Status
 TMR_LLRP_notifyTransportListener(TMR_Reader *reader, LLRP_tSMessage *pMsg, bool tx, int timeout)
 {
-  char buf[150*1024];
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  TMR_Status ret;
+
+  if (NULL == reader->transportListeners)
+  {
+    return TMR_SUCCESS;
+  }
 
-  if (LLRP_RC_OK != LLRP_toXMLString(&pMsg->elementHdr, buf, sizeof(buf)))
+  pthread_mutex_lock(&lr->xmlLock);
+  ret = TMR_LLRP_renderXML(lr, pMsg);
+  if (TMR_ERROR_OUT_OF_MEMORY != ret)
   {
-    TMR__notifyTransportListeners(reader, tx, 0, (uint8_t *)buf, timeout);
-    return TMR_ERROR_LLRP_MSG_PARSE_ERROR; 
+    TMR__notifyTransportListenerList(reader->transportListeners, tx, 0, (uint8_t *)lr->xmlBuf, timeout);
   }
+  pthread_mutex_unlock(&lr->xmlLock);
 
-  TMR__notifyTransportListeners(reader, tx, 0, (uint8_t *)buf, timeout);
+  return ret;
+}
 
-  return TMR_SUCCESS;
+/**
+ * Hand the frame just sent, still in the connection's send
+ * buffer, to transport capture and the raw transport listeners.
+ */
+static void
+TMR_LLRP_notifySentFrame(TMR_Reader *reader, LLRP_tSConnection *pConn, int timeoutMs)
+{
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  if (NULL != reader->transportCapture)
+  {
+    TMR__captureTransportFrame(reader, true, TMR_CAPTURE_PROTOCOL_LLRP,
+                               pConn->Send.nBuffer, pConn->Send.pBuffer);
+  }
+#endif
+  if (NULL != reader->rawTransportListeners)
+  {
+    TMR__notifyTransportListenerList(reader->rawTransportListeners, true,
+                                     pConn->Send.nBuffer, pConn->Send.pBuffer, timeoutMs);
+  }
 }
 
 /**
@@ -212,10 +357,7 @@ TMR_LLRP_sendMessage(TMR_Reader *reader, LLRP_tSMessage *pMsg, int timeoutMs)
 
   pMsg->MessageID = reader->u.llrpReader.msgId ++;
 
-  if (NULL != reader->transportListeners)
-  {
-    TMR_LLRP_notifyTransportListener(reader, pMsg, true, timeoutMs);
-  }
+  TMR_LLRP_notifyTransportListener(reader, pMsg, true, timeoutMs);
   /*
    * If LLRP_Conn_sendMessage() returns other than LLRP_RC_OK
    * then there was an error.
@@ -227,6 +369,10 @@ TMR_LLRP_sendMessage(TMR_Reader *reader, LLRP_tSMessage *pMsg, int timeoutMs)
   }
 
   Ret = LLRP_Conn_sendMessage(pConn, pMsg);
+  if (LLRP_RC_OK == Ret)
+  {
+    TMR_LLRP_notifySentFrame(reader, pConn, timeoutMs);
+  }
   
   if(true == tx_mutex_lock_enabled)
   {
@@ -247,6 +393,117 @@ Error_TMR_LLRP_send:
   return retTMR;
 }
 
+/**
+ * Send a command that has no fields of its own, such as KEEPALIVE_ACK,
+ * from a frame encoded on first use. Later sends only patch in the
+ * MessageID, so no message is built or encoded.
+ *
+ * @param reader The reader
+ * @param cmd Frame of the command, encoded here if its length is 0
+ * @param pType Type of the command
+ * @param timeoutMs Timeout value.
+ */
+TMR_Status
+TMR_LLRP_sendEncoded(TMR_Reader *reader, TMR_LLRP_EncodedCommand *cmd,
+                     const LLRP_tSTypeDescriptor *pType, int timeoutMs)
+{
+  LLRP_tSConnection *pConn = reader->u.llrpReader.pConn;
+#ifdef LTKC_HAS_SEND_FRAME
+  llrp_u32_t msgId;
+#else
+  LLRP_tSMessage *pMsg;
+  TMR_Status ret;
+#endif
+
+  if (NULL == pConn)
+  {
+    return TMR_ERROR_LLRP_SENDIO_ERROR;
+  }
+#ifndef LTKC_HAS_SEND_FRAME
+  /* Without LLRP_Conn_sendFrame() the command is built and encoded each time */
+  pMsg = (LLRP_tSMessage *)pType->pfConstruct();
+  if (NULL == pMsg)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  ret = TMR_LLRP_sendMessage(reader, pMsg, timeoutMs);
+  TMR_LLRP_freeMessage(pMsg);
+  return ret;
+#else
+  timeoutMs += reader->u.llrpReader.transportTimeout;
+
+  if (0 == cmd->length)
+  {
+    LLRP_tSElement *pElement;
+    LLRP_tSFrameEncoder *pEncoder;
+    LLRP_tResultCode rc;
+
+    pElement = pType->pfConstruct();
+    pEncoder = LLRP_FrameEncoder_construct(cmd->frame, sizeof cmd->frame);
+    if ((NULL == pElement) || (NULL == pEncoder))
+    {
+      if (NULL != pElement)
+      {
+        LLRP_Element_destruct(pElement);
+      }
+      return TMR_ERROR_OUT_OF_MEMORY;
+    }
+    LLRP_Encoder_encodeElement(&pEncoder->encoderHdr, pElement);
+    rc = pEncoder->encoderHdr.ErrorDetails.eResultCode;
+    cmd->length = (LLRP_RC_OK == rc) ? pEncoder->iNext : 0;
+    LLRP_Encoder_destruct(&pEncoder->encoderHdr);
+    LLRP_Element_destruct(pElement);
+    if (LLRP_RC_OK != rc)
+    {
+      return TMR_ERROR_LLRP;
+    }
+  }
+
+  msgId = reader->u.llrpReader.msgId ++;
+
+  if (NULL != reader->transportListeners)
+  {
+    LLRP_tSFrameDecoder *pDecoder;
+    LLRP_tSMessage *pMsg;
+
+    /* Listeners get the same XML as for a message built to send */
+    pDecoder = LLRP_FrameDecoder_construct(reader->u.llrpReader.pTypeRegistry,
+                                           cmd->frame, cmd->length);
+    if (NULL != pDecoder)
+    {
+      pMsg = LLRP_Decoder_decodeMessage(&pDecoder->decoderHdr);
+      LLRP_Decoder_destruct(&pDecoder->decoderHdr);
+      if (NULL != pMsg)
+      {
+        pMsg->MessageID = msgId;
+        TMR_LLRP_notifyTransportListener(reader, pMsg, true, timeoutMs);
+        TMR_LLRP_freeMessage(pMsg);
+      }
+    }
+  }
+
+  if(true == reader->continuousReading)
+  {
+    pthread_mutex_lock(&reader->u.llrpReader.transmitterLock);
+    tx_mutex_lock_enabled = true;
+  }
+
+  if (LLRP_RC_OK == LLRP_Conn_sendFrame(pConn, cmd->frame, cmd->length, msgId))
+  {
+    TMR_LLRP_notifySentFrame(reader, pConn, timeoutMs);
+  }
+
+  if(true == tx_mutex_lock_enabled)
+  {
+    pthread_mutex_unlock(&reader->u.llrpReader.transmitterLock);
+    tx_mutex_lock_enabled = false;
+  }
+
+  /* Send errors are let go, as in TMR_LLRP_sendMessage() */
+  return TMR_SUCCESS;
+#endif
+}
+
 /**
  * Receive a response.
  *
@@ -283,12 +540,150 @@ TMR_LLRP_receiveMessage(TMR_Reader *reader, LLRP_tSMessage **pMsg, int timeoutMs
     
     return TMR_ERROR_LLRP_RECEIVEIO_ERROR;
   }
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  if ((NULL != reader->transportCapture) && (pConn->Recv.bFrameValid) &&
+      ((*pMsg)->MessageID == pConn->Recv.FrameExtract.MessageID))
+  {
+    /* The raw frame is still in the connection's receive buffer */
+    TMR__captureTransportFrame(reader, false, TMR_CAPTURE_PROTOCOL_LLRP,
+                               pConn->Recv.FrameExtract.MessageLength,
+                               TMR_LLRP_RECV_FRAME(pConn));
+  }
+#endif
+  if ((NULL != reader->rawTransportListeners) && (pConn->Recv.bFrameValid) &&
+      ((*pMsg)->MessageID == pConn->Recv.FrameExtract.MessageID))
+  {
+    TMR__notifyTransportListenerList(reader->rawTransportListeners, false,
+                                     pConn->Recv.FrameExtract.MessageLength,
+                                     TMR_LLRP_RECV_FRAME(pConn),
+                                     timeoutMs);
+  }
 #ifndef WINCE
   TMR_LLRP_notifyTransportListener(reader, *pMsg, false, timeoutMs);
 #endif
   return TMR_SUCCESS;
 }
 
+/**
+ * Whether a command only reads from the reader.
+ *
+ * @param pMsg The command
+ */
+static bool
+TMR_LLRP_isReadCommand(LLRP_tSMessage *pMsg)
+{
+  const LLRP_tSTypeDescriptor *pType;
+
+  pType = pMsg->elementHdr.pType;
+  return ((&LLRP_tdGET_READER_CONFIG == pType) ||
+          (&LLRP_tdGET_READER_CAPABILITIES == pType) ||
+          (&LLRP_tdGET_ROSPECS == pType) ||
+          (&LLRP_tdGET_ACCESSSPECS == pType));
+}
+
+/**
+ * Give a command to the TMR_paramGetMany()/TMR_paramSetMany() batch
+ * in progress instead of exchanging it with the reader.
+ *
+ * While the batch collects, the first command of each parameter is
+ * kept, encoded, and nothing is sent. Once TMR_LLRP_exchangeParamBatch()
+ * has had the commands answered, the same command from the same
+ * parameter takes the response the reader gave. Any other command is
+ * left to be sent as usual.
+ *
+ * When setting, the parameters after the first that reads from the
+ * reader are not batched: each sets what it read, so the next one has
+ * to read again, after it. The reader answers the batch in order, so
+ * the parameters before it and its first read still are.
+ *
+ * @param reader The reader
+ * @param pMsg The command
+ * @param[out] pRsp The response
+ * @param[out] ret Status of the command
+ * @return true if the batch took the command
+ */
+static bool
+TMR_LLRP_takeBatchedCommand(TMR_Reader *reader, LLRP_tSMessage *pMsg,
+                            LLRP_tSMessage **pRsp, TMR_Status *ret)
+{
+  TMR_LLRP_ParamBatch *batch;
+  TMR_LLRP_BatchedCommand *param, *sender;
+  TMR_LLRP_PipelinedCommand *cmd;
+  uint8_t *frame;
+  uint32_t length;
+  bool same;
+
+  batch = reader->u.llrpReader.paramBatch;
+  if ((NULL == batch) || (batch->current >= batch->count))
+  {
+    return false;
+  }
+  param = &batch->params[batch->current];
+
+  if (batch->collecting)
+  {
+    if (batch->current >= batch->batched)
+    {
+      /* Left to be sent on the second run */
+    }
+    else if (NULL == param->frame)
+    {
+      if (batch->setting && TMR_LLRP_isReadCommand(pMsg))
+      {
+        batch->batched = batch->current + 1;
+      }
+      /* A command that can't be encoded is just not batched */
+      TMR_LLRP_encodeMessage(reader, pMsg, &param->frame, &param->length);
+    }
+    /* Nothing reaches the reader while collecting */
+    *pRsp = NULL;
+    *ret = TMR_ERROR_LLRP;
+    return true;
+  }
+
+  if ((batch->current >= batch->batched) || (NULL == param->frame) || param->taken)
+  {
+    return false;
+  }
+  if (TMR_SUCCESS != TMR_LLRP_encodeMessage(reader, pMsg, &frame, &length))
+  {
+    return false;
+  }
+  same = (length == param->length) && (0 == memcmp(frame, param->frame, length));
+  free(frame);
+  if (false == same)
+  {
+    /**
+     * Built from a value that another parameter of the batch
+     * has changed since. Send it as it is now.
+     **/
+    return false;
+  }
+
+  param->taken = true;
+  sender = &batch->params[param->sentBy];
+  cmd = &batch->cmds[param->sentBy];
+  sender->users --;
+  *pRsp = NULL;
+  *ret = cmd->status;
+  if (TMR_SUCCESS == cmd->status)
+  {
+    if (0 < sender->users)
+    {
+      /* Others repeated this command; each gets a response to free */
+      TMR_LLRP_encodeMessage(reader, cmd->pRsp, &frame, &length);
+      *ret = TMR_LLRP_decodeMessage(reader, frame, length, pRsp);
+      free(frame);
+    }
+    else
+    {
+      *pRsp = cmd->pRsp;
+      cmd->pRsp = NULL;
+    }
+  }
+  return true;
+}
+
 /**
  * Send a message and receive a response with timeout.
  *
@@ -304,6 +699,12 @@ TMR_LLRP_sendTimeout(TMR_Reader *reader, LLRP_tSMessage *pMsg, LLRP_tSMessage **
   bool rx_mutex_lock_enabled = false;
   bool backGroundReceiverDisabled = false;
 
+  if ((NULL != reader->u.llrpReader.paramBatch) &&
+      TMR_LLRP_takeBatchedCommand(reader, pMsg, pRsp, &ret))
+  {
+    return ret;
+  }
+
   if (false == reader->continuousReading)
   {
     /**
@@ -401,104 +802,332 @@ TMR_LLRP_send(TMR_Reader *reader, LLRP_tSMessage *pMsg, LLRP_tSMessage **pRsp)
 }
 
 /**
- * Free LLRP message
+ * Send several commands back to back, then collect their responses,
+ * matching each to its command by MessageID. Over a slow link this
+ * costs about one round trip instead of one per command. Messages
+ * that answer none of the commands are handled as TMR_LLRP_sendTimeout()
+ * handles them.
  *
- * @param pMsg Message to free
- */
-void
-TMR_LLRP_freeMessage(LLRP_tSMessage *pMsg)
-{
-  /* Free only if the message is not null */
-  if (NULL != pMsg)
-  {
-  LLRP_Element_destruct(&pMsg->elementHdr);
-    pMsg = NULL;
-  }
-}
-
-/**
- * Check LLRP Message status
- * When a message is received, call this function
- * to check the LLRP message status
+ * While reading continuously, the commands go one at a time through
+ * TMR_LLRP_sendTimeout() instead.
  *
- * @param pLLRPStatus Pointer to LLRP status parameter in LLRP message
+ * @param reader The reader
+ * @param cmds Commands to send, in order. Each gets its response and status.
+ * @param count Number of commands
+ * @param timeoutMs How long to wait for each response after the previous one
+ * @return TMR_SUCCESS when every command got its response, else the
+ * error that ended the exchange
  */
 TMR_Status
-TMR_LLRP_checkLLRPStatus(LLRP_tSLLRPStatus *pLLRPStatus)
+TMR_LLRP_sendPipelined(TMR_Reader *reader, TMR_LLRP_PipelinedCommand *cmds,
+                       uint32_t count, int timeoutMs)
 {
-  if (LLRP_StatusCode_M_Success != pLLRPStatus->eStatusCode)
+  TMR_Status ret;
+  uint64_t *sentAt;
+  uint32_t i, pending;
+
+  /* A command whose response has not arrived yet is marked TMR_ERROR_TIMEOUT */
+
+  ret = TMR_SUCCESS;
+  for (i = 0; i < count; i++)
   {
-    return TMR_ERROR_LLRP;
+    cmds[i].pRsp = NULL;
+    cmds[i].status = TMR_ERROR_TIMEOUT;
+    cmds[i].elapsedMs = 0;
   }
-  else
+
+  if (true == reader->continuousReading)
   {
-    return TMR_SUCCESS;
+    for (i = 0; i < count; i++)
+    {
+      if (NULL != cmds[i].pCmd)
+      {
+        uint64_t start = tmr_gettime();
+
+        cmds[i].status = TMR_LLRP_sendTimeout(reader, cmds[i].pCmd, &cmds[i].pRsp, timeoutMs);
+        cmds[i].elapsedMs = (uint32_t)(tmr_gettime() - start);
+        if (TMR_SUCCESS != cmds[i].status)
+        {
+          ret = cmds[i].status;
+          cmds[i].pRsp = NULL;
+        }
+      }
+    }
+    return ret;
   }
-}
 
-/**
- * Command to get region id
- *
- * @param reader Reader pointer
- * @param[out] region Pointer to TMR_Region object to hold the region value
- */
-TMR_Status
-TMR_LLRP_cmdGetRegion(TMR_Reader *reader, TMR_Region *region)
-{
-  TMR_Status ret;
-  LLRP_tSGET_READER_CONFIG              *pCmd;
-  LLRP_tSMessage                        *pCmdMsg;
-  LLRP_tSMessage                        *pRspMsg;
-  LLRP_tSGET_READER_CONFIG_RESPONSE     *pRsp;
-  LLRP_tSThingMagicDeviceControlConfiguration  *pTMRegionConfig;
-  LLRP_tSParameter                      *pCustParam;
+  sentAt = malloc(count * sizeof(*sentAt));
+  if (NULL == sentAt)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
 
-  ret = TMR_SUCCESS;
-  /**
-   * Initialize the GET_READER_CONFIG message
-   **/
-  pCmd = LLRP_GET_READER_CONFIG_construct();
-  LLRP_GET_READER_CONFIG_setRequestedData(pCmd, LLRP_GetReaderConfigRequestedData_Identification);
+  /* The responses are ours to receive */
+  TMR_LLRP_setBackgroundReceiverState(reader, false);
 
-  /**
-   * "/reader/region/id" is a custom parameter. And is available as part of
-   * ThingMagicDeviceControlConfiguration.
-   * Initialize the custom parameter
-   **/
-  pTMRegionConfig = LLRP_ThingMagicDeviceControlConfiguration_construct();
-  if (NULL == pTMRegionConfig)
+  pending = 0;
+  for (i = 0; i < count; i++)
   {
-    TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
-    return TMR_ERROR_LLRP;
+    if (NULL == cmds[i].pCmd)
+    {
+      continue;
+    }
+    sentAt[i] = tmr_gettime();
+    cmds[i].status = TMR_LLRP_sendMessage(reader, cmds[i].pCmd, timeoutMs);
+    if (TMR_SUCCESS == cmds[i].status)
+    {
+      cmds[i].status = TMR_ERROR_TIMEOUT;
+      pending++;
+    }
   }
 
-  /**
-   * Set the requested data (i.e., region configuration)
-   * And add to GET_READER_CONFIG message.
+  while (0 < pending)
+  {
+    LLRP_tSMessage *pRsp;
+
+    ret = TMR_LLRP_receiveMessage(reader, &pRsp, timeoutMs);
+    if (TMR_SUCCESS != ret)
+    {
+      break;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+      if ((NULL != cmds[i].pCmd) && (TMR_ERROR_TIMEOUT == cmds[i].status) &&
+          (cmds[i].pCmd->MessageID == pRsp->MessageID) &&
+          ((cmds[i].pCmd->elementHdr.pType->pResponseType == pRsp->elementHdr.pType) ||
+           (&LLRP_tdERROR_MESSAGE == pRsp->elementHdr.pType)))
+      {
+        break;
+      }
+    }
+    if (i == count)
+    {
+      /**
+       * Not the response to any of our commands, could be an event
+       * or a keepalive. Handle it and go back to receive.
+       **/
+      TMR_LLRP_processReceivedMessage(reader, pRsp);
+      continue;
+    }
+
+    cmds[i].elapsedMs = (uint32_t)(tmr_gettime() - sentAt[i]);
+    if (&LLRP_tdERROR_MESSAGE == pRsp->elementHdr.pType)
+    {
+      /* The reader could not parse the command */
+      TMR_LLRP_freeMessage(pRsp);
+      cmds[i].status = TMR_ERROR_LLRP;
+    }
+    else
+    {
+      cmds[i].pRsp = pRsp;
+      cmds[i].status = TMR_SUCCESS;
+    }
+    pending--;
+  }
+
+  TMR_LLRP_setBackgroundReceiverState(reader, true);
+  free(sentAt);
+
+  /* Commands left without a response failed the way the exchange did */
+  for (i = 0; i < count; i++)
+  {
+    if (NULL == cmds[i].pCmd)
+    {
+      continue;
+    }
+    if ((TMR_ERROR_TIMEOUT == cmds[i].status) && (TMR_SUCCESS != ret))
+    {
+      cmds[i].status = ret;
+    }
+    if (TMR_SUCCESS != cmds[i].status)
+    {
+      return cmds[i].status;
+    }
+  }
+
+  return TMR_SUCCESS;
+}
+
+/**
+ * Send the commands a TMR_LLRP_ParamBatch collected with
+ * TMR_LLRP_sendPipelined(). A command that repeats an earlier one,
+ * frame for frame, is sent only once and its response shared.
+ *
+ * @param reader The reader
+ * @param batch The batch, done collecting
+ * @return TMR_SUCCESS when every command got its response, else the
+ * error that ended the exchange
+ */
+TMR_Status
+TMR_LLRP_exchangeParamBatch(TMR_Reader *reader, TMR_LLRP_ParamBatch *batch)
+{
+  TMR_LLRP_BatchedCommand *param;
+  TMR_Status ret;
+  uint32_t i, j;
+
+  for (i = 0; i < batch->count; i++)
+  {
+    param = &batch->params[i];
+    if (NULL == param->frame)
+    {
+      continue;
+    }
+    for (j = 0; j < i; j++)
+    {
+      if ((j == batch->params[j].sentBy) && (NULL != batch->params[j].frame) &&
+          (param->length == batch->params[j].length) &&
+          (0 == memcmp(param->frame, batch->params[j].frame, param->length)))
+      {
+        break;
+      }
+    }
+    param->sentBy = j;
+    batch->params[j].users ++;
+    if ((j == i) &&
+        (TMR_SUCCESS != TMR_LLRP_decodeMessage(reader, param->frame, param->length,
+                                               &batch->cmds[i].pCmd)))
+    {
+      /* Left to be sent on its own */
+      free(param->frame);
+      param->frame = NULL;
+      param->users = 0;
+    }
+  }
+
+  /* These go to the reader */
+  reader->u.llrpReader.paramBatch = NULL;
+  ret = TMR_LLRP_sendPipelined(reader, batch->cmds, batch->count,
+                               reader->u.llrpReader.commandTimeout
+                               + reader->u.llrpReader.transportTimeout);
+  reader->u.llrpReader.paramBatch = batch;
+  for (i = 0; i < batch->count; i++)
+  {
+    TMR_LLRP_freeMessage(batch->cmds[i].pCmd);
+    batch->cmds[i].pCmd = NULL;
+  }
+  batch->collecting = false;
+  return ret;
+}
+
+/**
+ * Free what a TMR_LLRP_ParamBatch holds: the collected frames and the
+ * responses no parameter took.
+ *
+ * @param batch The batch
+ */
+void
+TMR_LLRP_freeParamBatch(TMR_LLRP_ParamBatch *batch)
+{
+  uint32_t i;
+
+  for (i = 0; i < batch->count; i++)
+  {
+    free(batch->params[i].frame);
+    batch->params[i].frame = NULL;
+    TMR_LLRP_freeMessage(batch->cmds[i].pCmd);
+    batch->cmds[i].pCmd = NULL;
+    TMR_LLRP_freeMessage(batch->cmds[i].pRsp);
+    batch->cmds[i].pRsp = NULL;
+  }
+}
+
+/**
+ * Free LLRP message
+ *
+ * @param pMsg Message to free
+ */
+void
+TMR_LLRP_freeMessage(LLRP_tSMessage *pMsg)
+{
+  /* Free only if the message is not null */
+  if (NULL != pMsg)
+  {
+  LLRP_Element_destruct(&pMsg->elementHdr);
+    pMsg = NULL;
+  }
+}
+
+/**
+ * Check LLRP Message status
+ * When a message is received, call this function
+ * to check the LLRP message status
+ *
+ * @param pLLRPStatus Pointer to LLRP status parameter in LLRP message
+ */
+TMR_Status
+TMR_LLRP_checkLLRPStatus(LLRP_tSLLRPStatus *pLLRPStatus)
+{
+  if (LLRP_StatusCode_M_Success != pLLRPStatus->eStatusCode)
+  {
+    return TMR_ERROR_LLRP;
+  }
+  else
+  {
+    return TMR_SUCCESS;
+  }
+}
+
+/**
+ * Build the GET_READER_CONFIG message asking for the region id
+ *
+ * @param reader Reader pointer
+ * @param[out] pCmdMsg The message, for the caller to free
+ */
+TMR_Status
+TMR_LLRP_msgGetRegion(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg)
+{
+  LLRP_tSGET_READER_CONFIG              *pCmd;
+  LLRP_tSThingMagicDeviceControlConfiguration  *pTMRegionConfig;
+
+  /**
+   * Initialize the GET_READER_CONFIG message
    **/
-  LLRP_ThingMagicDeviceControlConfiguration_setRequestedData(pTMRegionConfig, LLRP_ThingMagicControlConfiguration_ThingMagicRegionConfiguration);
-  if (LLRP_RC_OK != LLRP_GET_READER_CONFIG_addCustom(pCmd, &pTMRegionConfig->hdr))
+  pCmd = LLRP_GET_READER_CONFIG_construct();
+  LLRP_GET_READER_CONFIG_setRequestedData(pCmd, LLRP_GetReaderConfigRequestedData_Identification);
+
+  /**
+   * "/reader/region/id" is a custom parameter. And is available as part of
+   * ThingMagicDeviceControlConfiguration.
+   * Initialize the custom parameter
+   **/
+  pTMRegionConfig = LLRP_ThingMagicDeviceControlConfiguration_construct();
+  if (NULL == pTMRegionConfig)
   {
-    TMR_LLRP_freeMessage((LLRP_tSMessage *)pTMRegionConfig);
     TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
     return TMR_ERROR_LLRP;
   }
 
-  pCmdMsg       = &pCmd->hdr;
   /**
-   * Now the message is framed completely and send the message
+   * Set the requested data (i.e., region configuration)
+   * And add to GET_READER_CONFIG message.
    **/
-  ret = TMR_LLRP_send(reader, pCmdMsg, &pRspMsg);
-  /**
-   * Done with the command, free the message
-   * and check for message status
-   **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
-  if (TMR_SUCCESS != ret)
+  LLRP_ThingMagicDeviceControlConfiguration_setRequestedData(pTMRegionConfig, LLRP_ThingMagicControlConfiguration_ThingMagicRegionConfiguration);
+  if (LLRP_RC_OK != LLRP_GET_READER_CONFIG_addCustom(pCmd, &pTMRegionConfig->hdr))
   {
-    return ret;
+    TMR_LLRP_freeMessage((LLRP_tSMessage *)pTMRegionConfig);
+    TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+    return TMR_ERROR_LLRP;
   }
 
+  *pCmdMsg = &pCmd->hdr;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Extract the region id from the response to TMR_LLRP_msgGetRegion()
+ * and free the response
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ * @param[out] region Pointer to TMR_Region object to hold the region value
+ */
+TMR_Status
+TMR_LLRP_handleGetRegionResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg, TMR_Region *region)
+{
+  LLRP_tSGET_READER_CONFIG_RESPONSE     *pRsp;
+  LLRP_tSParameter                      *pCustParam;
+
   /**
    * Check response message status
    **/
@@ -528,7 +1157,43 @@ TMR_LLRP_cmdGetRegion(TMR_Reader *reader, TMR_Region *region)
    **/
   TMR_LLRP_freeMessage(pRspMsg);
 
-  return ret;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Command to get region id
+ *
+ * @param reader Reader pointer
+ * @param[out] region Pointer to TMR_Region object to hold the region value
+ */
+TMR_Status
+TMR_LLRP_cmdGetRegion(TMR_Reader *reader, TMR_Region *region)
+{
+  TMR_Status ret;
+  LLRP_tSMessage                        *pCmdMsg;
+  LLRP_tSMessage                        *pRspMsg;
+
+  ret = TMR_LLRP_msgGetRegion(reader, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
+  /**
+   * Now the message is framed completely and send the message
+   **/
+  ret = TMR_LLRP_send(reader, pCmdMsg, &pRspMsg);
+  /**
+   * Done with the command, free the message
+   * and check for message status
+   **/ 
+  TMR_LLRP_freeMessage(pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
+  return TMR_LLRP_handleGetRegionResponse(reader, pRspMsg, region);
 }
 /**
  * Command to get the read async offtime
@@ -1185,25 +1850,16 @@ TMR_LLRP_cmdGetTMAntennaReturnloss(TMR_Reader *reader, TMR_PortValueList *return
 }
 
 /**
- * Command to Detect antenna connection status
+ * Build the GET_READER_CONFIG message asking for the antenna properties
  *
  * @param reader Reader pointer
- * @param count Number of antennas detected 
- * @param ports Pointer to TMR_LLRP_PortDetect object
+ * @param[out] pCmdMsg The message, for the caller to free
  */
 TMR_Status
-TMR_LLRP_cmdAntennaDetect(TMR_Reader *reader, uint8_t *count, TMR_LLRP_PortDetect *ports)
+TMR_LLRP_msgAntennaDetect(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg)
 {
-  TMR_Status ret;
   LLRP_tSGET_READER_CONFIG              *pCmd;
-  LLRP_tSMessage                        *pCmdMsg;
-  LLRP_tSMessage                        *pRspMsg;
-  LLRP_tSGET_READER_CONFIG_RESPONSE     *pRsp;
-  LLRP_tSAntennaProperties              *pAntProps;
-  uint8_t                               i;
 
-  ret = TMR_SUCCESS;
-  i = 0;
   /**
    * /reader/antenna/connectedPortList parameter is available
    * as an LLRP standard parameter GET_READER_CONFIG_RESPONSE.AntennaProperties.AntennaConnected.
@@ -1213,20 +1869,26 @@ TMR_LLRP_cmdAntennaDetect(TMR_Reader *reader, uint8_t *count, TMR_LLRP_PortDetec
   LLRP_GET_READER_CONFIG_setRequestedData(pCmd, LLRP_GetReaderConfigRequestedData_AntennaProperties);
   LLRP_GET_READER_CONFIG_setAntennaID(pCmd, 0);
 
-  pCmdMsg       = &pCmd->hdr;
-  /**
-   * Now the message is framed completely and send the message
-   **/
-  ret = TMR_LLRP_send(reader, pCmdMsg, &pRspMsg);
-  /**
-   * Done with the command, free the message
-   * and check for message status
-   **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
-  if (TMR_SUCCESS != ret)
-  {
-    return ret;
-  }
+  *pCmdMsg = &pCmd->hdr;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Extract the antenna connection status from the response to
+ * TMR_LLRP_msgAntennaDetect() and free the response
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ * @param count Number of antennas detected 
+ * @param ports Pointer to TMR_LLRP_PortDetect object
+ */
+TMR_Status
+TMR_LLRP_handleAntennaDetectResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                     uint8_t *count, TMR_LLRP_PortDetect *ports)
+{
+  LLRP_tSGET_READER_CONFIG_RESPONSE     *pRsp;
+  LLRP_tSAntennaProperties              *pAntProps;
+  uint8_t                               i;
 
   /**
    * Check response message status
@@ -1258,32 +1920,58 @@ TMR_LLRP_cmdAntennaDetect(TMR_Reader *reader, uint8_t *count, TMR_LLRP_PortDetec
    **/
   TMR_LLRP_freeMessage(pRspMsg);
 
-  return ret;
+  return TMR_SUCCESS;
 }
 
 /**
- * Command to get thingmagic Device Information Capabilities
+ * Command to Detect antenna connection status
  *
  * @param reader Reader pointer
- * @param param type of parameter
- * @param version Pointer to TMR_String to hold the version hardware value 
+ * @param count Number of antennas detected 
+ * @param ports Pointer to TMR_LLRP_PortDetect object
  */
 TMR_Status
-TMR_LLRP_cmdGetTMDeviceInformationCapabilities(TMR_Reader *reader, int param, TMR_String *version)
+TMR_LLRP_cmdAntennaDetect(TMR_Reader *reader, uint8_t *count, TMR_LLRP_PortDetect *ports)
 {
   TMR_Status ret;
-  LLRP_tSGET_READER_CAPABILITIES              *pCmd;
-  LLRP_tSMessage                              *pCmdMsg;
-  LLRP_tSMessage                              *pRspMsg;
-  LLRP_tSGET_READER_CAPABILITIES_RESPONSE     *pRsp;
-  LLRP_tSThingMagicDeviceControlCapabilities  *pTMCaps;
-  LLRP_tSParameter                            *pCustParam;
-  llrp_utf8v_t                                 hardwareVersion;
-  llrp_utf8v_t                                 serialNumber;
-  llrp_utf8v_t                                 productGroup;
-  LLRP_tSReaderProductGroup                   *pReaderProductGroup;
+  LLRP_tSMessage                        *pCmdMsg;
+  LLRP_tSMessage                        *pRspMsg;
 
-  ret = TMR_SUCCESS;
+  ret = TMR_LLRP_msgAntennaDetect(reader, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
+  /**
+   * Now the message is framed completely and send the message
+   **/
+  ret = TMR_LLRP_send(reader, pCmdMsg, &pRspMsg);
+  /**
+   * Done with the command, free the message
+   * and check for message status
+   **/ 
+  TMR_LLRP_freeMessage(pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
+  return TMR_LLRP_handleAntennaDetectResponse(reader, pRspMsg, count, ports);
+}
+
+/**
+ * Build the GET_READER_CAPABILITIES message asking for the general
+ * device capabilities and the Thingmagic Device Information Capabilities
+ *
+ * @param reader Reader pointer
+ * @param[out] pCmdMsg The message, for the caller to free
+ */
+TMR_Status
+TMR_LLRP_msgGetTMDeviceInformationCapabilities(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg)
+{
+  LLRP_tSGET_READER_CAPABILITIES              *pCmd;
+  LLRP_tSThingMagicDeviceControlCapabilities  *pTMCaps;
 
   /**
    * Initialize GET_READER_CAPABILITIES message
@@ -1313,7 +2001,30 @@ TMR_LLRP_cmdGetTMDeviceInformationCapabilities(TMR_Reader *reader, int param, TM
     TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
     return TMR_ERROR_LLRP;
   }
-  pCmdMsg       = &pCmd->hdr;
+
+  *pCmdMsg = &pCmd->hdr;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Command to get thingmagic Device Information Capabilities
+ *
+ * @param reader Reader pointer
+ * @param param type of parameter
+ * @param version Pointer to TMR_String to hold the version hardware value 
+ */
+TMR_Status
+TMR_LLRP_cmdGetTMDeviceInformationCapabilities(TMR_Reader *reader, int param, TMR_String *version)
+{
+  TMR_Status ret;
+  LLRP_tSMessage                              *pCmdMsg;
+  LLRP_tSMessage                              *pRspMsg;
+
+  ret = TMR_LLRP_msgGetTMDeviceInformationCapabilities(reader, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
 
   /**
    * Now the message is framed completely and send the message
@@ -1323,12 +2034,42 @@ TMR_LLRP_cmdGetTMDeviceInformationCapabilities(TMR_Reader *reader, int param, TM
    * Done with the command, free the message
    * and check for message status
    **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+  TMR_LLRP_freeMessage(pCmdMsg);
   if (TMR_SUCCESS != ret)
   {
     return ret;
   }
 
+  return TMR_LLRP_handleGetTMDeviceInformationCapabilitiesResponse(reader, pRspMsg, param,
+                                                                   version, NULL);
+}
+
+/**
+ * Extract a device information value from the response to
+ * TMR_LLRP_msgGetTMDeviceInformationCapabilities() and free the response
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ * @param param type of parameter
+ * @param version Pointer to TMR_String to hold the value of param
+ * @param firmware If not NULL, pointer to TMR_String to hold the
+ *  firmware version from the general device capabilities
+ */
+TMR_Status
+TMR_LLRP_handleGetTMDeviceInformationCapabilitiesResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                                          int param, TMR_String *version,
+                                                          TMR_String *firmware)
+{
+  TMR_Status ret;
+  LLRP_tSGET_READER_CAPABILITIES_RESPONSE     *pRsp;
+  LLRP_tSParameter                            *pCustParam;
+  llrp_utf8v_t                                 hardwareVersion;
+  llrp_utf8v_t                                 serialNumber;
+  llrp_utf8v_t                                 productGroup;
+  LLRP_tSReaderProductGroup                   *pReaderProductGroup;
+
+  ret = TMR_SUCCESS;
+
   /**
    * Check response message status
    **/
@@ -1363,13 +2104,33 @@ TMR_LLRP_cmdGetTMDeviceInformationCapabilities(TMR_Reader *reader, int param, TM
       TMR_stringCopy(version, (char *)productGroup.pValue, (int)productGroup.nValue);
     }
   }
+  else if (NULL != firmware)
+  {
+    /* Without the custom parameter, there is no value for the caller */
+    ret = TMR_ERROR_LLRP;
+  }
+
+  if ((TMR_SUCCESS == ret) && (NULL != firmware))
+  {
+    LLRP_tSGeneralDeviceCapabilities *pReaderCap;
+
+    pReaderCap = LLRP_GET_READER_CAPABILITIES_RESPONSE_getGeneralDeviceCapabilities(pRsp);
+    if (NULL == pReaderCap)
+    {
+      ret = TMR_ERROR_LLRP;
+    }
+    else
+    {
+      TMR_stringCopy(firmware, (char *)pReaderCap->ReaderFirmwareVersion.pValue,
+                     (int)pReaderCap->ReaderFirmwareVersion.nValue);
+    }
+  }
   /**
    * Done with the response, free the message
    **/
   TMR_LLRP_freeMessage(pRspMsg);
 
   return ret;
-
 }
 
 /**
@@ -1505,22 +2266,15 @@ TMR_convertTari(uint16_t tari)
 }
 
 /**
- * Command to get Reader capabilities
+ * Build the GET_READER_CAPABILITIES message asking for all capabilities
  *
  * @param reader Reader pointer
- * @param capabilities Pointer to TMR_LLRP_ReaderCapabilities
+ * @param[out] pCmdMsg The message, for the caller to free
  */
 TMR_Status
-TMR_LLRP_cmdGetReaderCapabilities(TMR_Reader *reader, TMR_LLRP_ReaderCapabilities *capabilities)
+TMR_LLRP_msgGetReaderCapabilities(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg)
 {
-  TMR_Status ret;
   LLRP_tSGET_READER_CAPABILITIES          *pCmd;
-  LLRP_tSMessage                          *pCmdMsg;
-  LLRP_tSMessage                          *pRspMsg;
-  LLRP_tSGET_READER_CAPABILITIES_RESPONSE *pRsp;
-  TMR_GEN2_Tari minTari, maxTari;
-
-  ret = TMR_SUCCESS;
 
   /**
    * Retrieve all reader capabilities
@@ -1529,7 +2283,29 @@ TMR_LLRP_cmdGetReaderCapabilities(TMR_Reader *reader, TMR_LLRP_ReaderCapabilitie
   pCmd = LLRP_GET_READER_CAPABILITIES_construct();
   LLRP_GET_READER_CAPABILITIES_setRequestedData(pCmd, LLRP_GetReaderCapabilitiesRequestedData_All);
 
-  pCmdMsg = &pCmd->hdr;
+  *pCmdMsg = &pCmd->hdr;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Command to get Reader capabilities
+ *
+ * @param reader Reader pointer
+ * @param capabilities Pointer to TMR_LLRP_ReaderCapabilities
+ */
+TMR_Status
+TMR_LLRP_cmdGetReaderCapabilities(TMR_Reader *reader, TMR_LLRP_ReaderCapabilities *capabilities)
+{
+  TMR_Status ret;
+  LLRP_tSMessage                          *pCmdMsg;
+  LLRP_tSMessage                          *pRspMsg;
+
+  ret = TMR_LLRP_msgGetReaderCapabilities(reader, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
   /**
    * Now the message is framed completely and send the message
    **/
@@ -1538,12 +2314,33 @@ TMR_LLRP_cmdGetReaderCapabilities(TMR_Reader *reader, TMR_LLRP_ReaderCapabilitie
    * Done with the command, free the message
    * and check for message status
    **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+  TMR_LLRP_freeMessage(pCmdMsg);
   if (TMR_SUCCESS != ret)
   {
     return ret;
   }
 
+  return TMR_LLRP_handleGetReaderCapabilitiesResponse(reader, pRspMsg, capabilities);
+}
+
+/**
+ * Cache the reader capabilities from the response to
+ * TMR_LLRP_msgGetReaderCapabilities() and free the response
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ * @param capabilities Pointer to TMR_LLRP_ReaderCapabilities
+ */
+TMR_Status
+TMR_LLRP_handleGetReaderCapabilitiesResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                             TMR_LLRP_ReaderCapabilities *capabilities)
+{
+  TMR_Status ret;
+  LLRP_tSGET_READER_CAPABILITIES_RESPONSE *pRsp;
+  TMR_GEN2_Tari minTari, maxTari;
+
+  ret = TMR_SUCCESS;
+
   /**
    * Check response message status
    **/
@@ -2794,6 +3591,9 @@ TMR_LLRP_cmdDeleteAllROSpecs(TMR_Reader *reader, bool receiveResponse)
   /**
    * Create delete rospec message
    **/
+  /* Whatever a sync read left on the reader goes too */
+  TMR_LLRP_clearROSpecCache(reader);
+
   pCmd = LLRP_DELETE_ROSPEC_construct();
   LLRP_DELETE_ROSPEC_setROSpecID(pCmd, 0);        /* All */
 
@@ -3350,6 +4150,109 @@ TMR_LLRP_addCustomAntennaConfigPerAntenna(TMR_CustomAntConfig *customAntConfig,
   return ret;
 }
 
+/**
+ * Forget the ROSpec an earlier sync read left on the reader, so
+ * that the next read deletes and re-adds its ROSpec.
+ *
+ * @param reader Reader pointer
+ */
+void
+TMR_LLRP_clearROSpecCache(TMR_Reader *reader)
+{
+  TMR_LLRP_ROSpecCache *cache = &reader->u.llrpReader.roSpecCache;
+
+  free(cache->frame);
+  cache->frame = NULL;
+  cache->length = 0;
+  cache->roSpecId = 0;
+}
+
+/**
+ * Encode a message. A command's MessageID is not assigned until it
+ * is sent, so two frames of unsent commands are equal exactly when
+ * the commands are.
+ *
+ * @param reader Reader pointer
+ * @param pCmdMsg The message
+ * @param[out] frame Encoded frame, freed by the caller
+ * @param[out] length Frame length
+ */
+TMR_Status
+TMR_LLRP_encodeMessage(TMR_Reader *reader, LLRP_tSMessage *pCmdMsg,
+                       uint8_t **frame, uint32_t *length)
+{
+  LLRP_tSConnection *pConn = reader->u.llrpReader.pConn;
+  LLRP_tSFrameEncoder *pEncoder;
+  LLRP_tResultCode rc;
+  uint8_t *buf, *shrunk;
+
+  *frame = NULL;
+  *length = 0;
+  if (NULL == pConn)
+  {
+    return TMR_ERROR_LLRP_SENDIO_ERROR;
+  }
+
+  /* Nothing larger than the send buffer could be sent anyway */
+  buf = malloc(pConn->nBufferSize);
+  if (NULL == buf)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  pEncoder = LLRP_FrameEncoder_construct(buf, pConn->nBufferSize);
+  if (NULL == pEncoder)
+  {
+    free(buf);
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  LLRP_Encoder_encodeElement(&pEncoder->encoderHdr, &pCmdMsg->elementHdr);
+  rc = pEncoder->encoderHdr.ErrorDetails.eResultCode;
+  *length = pEncoder->iNext;
+  LLRP_Encoder_destruct(&pEncoder->encoderHdr);
+  if (LLRP_RC_OK != rc)
+  {
+    free(buf);
+    *length = 0;
+    return TMR_ERROR_LLRP;
+  }
+
+  /* Keep only what the frame needs */
+  shrunk = realloc(buf, *length);
+  if (NULL != shrunk)
+  {
+    buf = shrunk;
+  }
+  *frame = buf;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Decode a frame encoded by TMR_LLRP_encodeMessage()
+ *
+ * @param reader Reader pointer
+ * @param frame Encoded frame
+ * @param length Frame length
+ * @param[out] pMsg The message, for the caller to free
+ */
+TMR_Status
+TMR_LLRP_decodeMessage(TMR_Reader *reader, uint8_t *frame, uint32_t length,
+                       LLRP_tSMessage **pMsg)
+{
+  LLRP_tSFrameDecoder *pDecoder;
+
+  *pMsg = NULL;
+  pDecoder = LLRP_FrameDecoder_construct(reader->u.llrpReader.pTypeRegistry,
+                                         frame, length);
+  if (NULL == pDecoder)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  *pMsg = LLRP_Decoder_decodeMessage(&pDecoder->decoderHdr);
+  LLRP_Decoder_destruct(&pDecoder->decoderHdr);
+
+  return (NULL == *pMsg) ? TMR_ERROR_LLRP : TMR_SUCCESS;
+}
+
 /**
  * Command to Add an ROSpec
  *
@@ -3395,6 +4298,10 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
   LLRP_tSAntennaConfiguration     **pAntConfig = NULL;
   LLRP_tSC1G2InventoryCommand     **pInvCommand = NULL;
   uint8_t count = 0;
+  TMR_LLRP_ROSpecCache            *cache = &reader->u.llrpReader.roSpecCache;
+  const TMR_LLRP_ReportSpec       *reportSpec = &reader->u.llrpReader.reportSpec;
+  uint8_t                         *frame = NULL;
+  uint32_t                        length = 0;
   ret = TMR_SUCCESS;
 
   /**
@@ -3910,12 +4817,26 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
       if (reader->continuousReading)
       {
         /**
-         * In case of continuous Reading, report is
-         * requested for every 10 tags. (10 being the moderate value)
+         * In case of continuous Reading, a report is requested for
+         * every tag unless /reader/llrp/reportSpec batches them.
          * In case there is no report (when there are not enough tags),
          * we are supposed to GET_REPORT from reader.
          **/
-        LLRP_ROReportSpec_setN(pROReportSpec, 1);
+        switch (reportSpec->trigger)
+        {
+          case TMR_LLRP_REPORT_TRIGGER_N_TAGS_OR_END_OF_ROSPEC:
+            LLRP_ROReportSpec_setN(pROReportSpec, reportSpec->n);
+            break;
+
+          case TMR_LLRP_REPORT_TRIGGER_N_TAGS_OR_END_OF_AISPEC:
+            LLRP_ROReportSpec_setROReportTrigger(pROReportSpec, LLRP_ROReportTriggerType_Upon_N_Tags_Or_End_Of_AISpec);
+            LLRP_ROReportSpec_setN(pROReportSpec, reportSpec->n);
+            break;
+
+          default:
+            LLRP_ROReportSpec_setN(pROReportSpec, 1);
+            break;
+        }
       }
       else
       {
@@ -3927,23 +4848,30 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
       }
 
       /**
-       * Get Configured Metadata flag and cache it
+       * Get Configured Metadata flag and cache it.
+       * A sync read through TMR_LLRP_read() has just done so.
        **/
-      ret = TMR_LLRP_cmdGetTMMetadataFlag(reader, (uint16_t *)&reader->u.llrpReader.metadata);
-      if (TMR_SUCCESS != ret)
+      if (false == cache->enabled)
       {
-        /**
-         * Not Fatal, moving forward
-         * value might be changed, restore the dafult value.
-         **/
-        reader->u.llrpReader.metadata = TMR_TRD_METADATA_FLAG_ALL;
+        ret = TMR_LLRP_cmdGetTMMetadataFlag(reader, (uint16_t *)&reader->u.llrpReader.metadata);
+        if (TMR_SUCCESS != ret)
+        {
+          /**
+           * Not Fatal, moving forward
+           * value might be changed, restore the dafult value.
+           **/
+          reader->u.llrpReader.metadata = TMR_TRD_METADATA_FLAG_ALL;
+        }
       }
 
       /* Initialize and Set ReportContent selection */
       pTagReportContentSelector = LLRP_TagReportContentSelector_construct();
 
       pTagReportContentSelector->EnableROSpecID                 = 1;
-      pTagReportContentSelector->EnableSpecIndex                = 1;
+      if (reportSpec->content & TMR_LLRP_REPORT_CONTENT_SPECINDEX)
+      {
+        pTagReportContentSelector->EnableSpecIndex                = 1;
+      }
       if (reader->u.llrpReader.metadata & TMR_TRD_METADATA_FLAG_ANTENNAID)
       {
         pTagReportContentSelector->EnableAntennaID                = 1;
@@ -3974,8 +4902,10 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
         LLRP_tSC1G2EPCMemorySelector *pGen2MemSelector;
 
         pGen2MemSelector = LLRP_C1G2EPCMemorySelector_construct();
-        LLRP_C1G2EPCMemorySelector_setEnableCRC(pGen2MemSelector, 1);
-        LLRP_C1G2EPCMemorySelector_setEnablePCBits(pGen2MemSelector, 1);
+        LLRP_C1G2EPCMemorySelector_setEnableCRC(pGen2MemSelector,
+            (reportSpec->content & TMR_LLRP_REPORT_CONTENT_GEN2_CRC) ? 1 : 0);
+        LLRP_C1G2EPCMemorySelector_setEnablePCBits(pGen2MemSelector,
+            (reportSpec->content & TMR_LLRP_REPORT_CONTENT_GEN2_PC) ? 1 : 0);
 
         /* Add C1G2MemorySelector to ReportContentSelector  */
         LLRP_TagReportContentSelector_addAirProtocolEPCMemorySelector(
@@ -4122,6 +5052,40 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
   LLRP_ADD_ROSPEC_setROSpec(pCmd, pROSpec);
 
   pCmdMsg = &pCmd->hdr;
+
+  if (cache->enabled)
+  {
+    /**
+     * The encoded ROSpec stands for the whole read plan: antennas,
+     * filters, protocol, duration and every reader setting that
+     * went into it. If it matches the ROSpec left on the reader
+     * by the previous sync read, that one is simply started again.
+     **/
+    ret = TMR_LLRP_encodeMessage(reader, pCmdMsg, &frame, &length);
+    if (TMR_SUCCESS != ret)
+    {
+      TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+      return ret;
+    }
+    if ((NULL != cache->frame) && (cache->length == length) &&
+        (0 == memcmp(cache->frame, frame, length)))
+    {
+      free(frame);
+      TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+      cache->reused = true;
+      return TMR_SUCCESS;
+    }
+    if (NULL != cache->frame)
+    {
+      /**
+       * The read plan has changed. TMR_LLRP_read() kept the old
+       * ROSpec in place, so clear the reader now.
+       **/
+      TMR_LLRP_cmdDeleteAllROSpecs(reader, true);
+      TMR_LLRP_cmdDeleteAllAccessSpecs(reader);
+    }
+  }
+
   /**
    * Now the message is framed completely and send the message
    **/
@@ -4133,6 +5097,7 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
   TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
   if (TMR_SUCCESS != ret)
   {
+    free(frame);
     return ret;
   }
 
@@ -4142,6 +5107,7 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
   pRsp = (LLRP_tSADD_ROSPEC_RESPONSE *) pRspMsg;
   if (TMR_SUCCESS != TMR_LLRP_checkLLRPStatus(pRsp->pLLRPStatus))  
   {
+    free(frame);
     TMR_LLRP_freeMessage(pRspMsg);
     return TMR_ERROR_LLRP; 
   }
@@ -4151,6 +5117,15 @@ TMR_LLRP_cmdAddROSpec(TMR_Reader *reader, uint16_t readDuration,
    **/
   TMR_LLRP_freeMessage(pRspMsg);
 
+  if (NULL != frame)
+  {
+    /* Remember the installed ROSpec for the next sync read */
+    TMR_LLRP_clearROSpecCache(reader);
+    cache->frame = frame;
+    cache->length = length;
+    cache->roSpecId = reader->u.llrpReader.roSpecId;
+  }
+
   return ret;
 }
 
@@ -4437,11 +5412,21 @@ TMR_LLRP_cmdPrepareROSpec(TMR_Reader *reader, uint16_t timeout,
   {
     return ret;
   }
+  if (reader->u.llrpReader.roSpecCache.reused)
+  {
+    /* The cached ROSpec is still enabled */
+    return TMR_SUCCESS;
+  }
 
   /**
    * 2. Enable ROSpec
    **/
-  return TMR_LLRP_cmdEnableROSpec(reader);
+  ret = TMR_LLRP_cmdEnableROSpec(reader);
+  if (TMR_SUCCESS != ret)
+  {
+    TMR_LLRP_clearROSpecCache(reader);
+  }
+  return ret;
 }
 
 TMR_Status
@@ -4512,6 +5497,39 @@ TMR_LLRP_verifyReadOperation(TMR_Reader *reader, int32_t *tagCount)
   return TMR_SUCCESS;
 }
 
+/**
+ * Set the tag protocol from a ThingMagicCustomProtocolID value,
+ * leaving it alone for protocols this build does not know.
+ */
+static void
+TMR_LLRP_setCustomProtocol(TMR_TagReadData *data, llrp_u8_t protocolID)
+{
+  switch(protocolID)
+  {
+    case LLRP_ThingMagicCustomProtocol_Gen2:
+      data->tag.protocol = TMR_TAG_PROTOCOL_GEN2;
+      break;
+#ifdef TMR_ENABLE_ISO180006B
+    case LLRP_ThingMagicCustomProtocol_Iso180006b:
+      data->tag.protocol = TMR_TAG_PROTOCOL_ISO180006B;
+      break;
+#endif /* TMR_ENABLE_ISO180006B */
+#ifndef TMR_ENABLE_GEN2_ONLY
+    case LLRP_ThingMagicCustomProtocol_IPX64:
+      data->tag.protocol = TMR_TAG_PROTOCOL_IPX64;
+      break;
+    case LLRP_ThingMagicCustomProtocol_IPX256:
+      data->tag.protocol = TMR_TAG_PROTOCOL_IPX256;
+      break;
+    case LLRP_ThingMagicCustomProtocol_Ata:
+      data->tag.protocol = TMR_TAG_PROTOCOL_ATA;
+      break;
+#endif /* TMR_ENABLE_GEN2_ONLY */
+    default:
+      break;
+  }
+}
+
 /**
  * Internal method to parse metadata from LLRP Report response
  * This method constructs a TMR_TagReadData object by extracting the 
@@ -4735,30 +5753,7 @@ TMR_LLRP_parseMetadataFromMessage(TMR_Reader *reader, TMR_TagReadData *data, LLR
                   protocolID = LLRP_ThingMagicCustomProtocolID_getProtocolId(
                                           (LLRP_tSThingMagicCustomProtocolID *)pParameter);
                   /* Copy the value to tagReport */
-                  switch(protocolID)
-                  {
-                    case LLRP_ThingMagicCustomProtocol_Gen2:
-                      data->tag.protocol = TMR_TAG_PROTOCOL_GEN2;
-                      break;
-#ifdef TMR_ENABLE_ISO180006B
-                    case LLRP_ThingMagicCustomProtocol_Iso180006b:
-                      data->tag.protocol = TMR_TAG_PROTOCOL_ISO180006B;
-                      break;
-#endif /* TMR_ENABLE_ISO180006B */
-#ifndef TMR_ENABLE_GEN2_ONLY
-                    case LLRP_ThingMagicCustomProtocol_IPX64:
-                      data->tag.protocol = TMR_TAG_PROTOCOL_IPX64;
-                      break;
-                    case LLRP_ThingMagicCustomProtocol_IPX256:
-                      data->tag.protocol = TMR_TAG_PROTOCOL_IPX256;
-                      break;
-                    case LLRP_ThingMagicCustomProtocol_Ata:
-                      data->tag.protocol = TMR_TAG_PROTOCOL_ATA;
-                      break;
-#endif /* TMR_ENABLE_GEN2_ONLY */
-                    default:
-                      break;
-                  }
+                  TMR_LLRP_setCustomProtocol(data, protocolID);
                   data->metadataFlags |= TMR_TRD_METADATA_FLAG_PROTOCOL;
                 }
                   break;
@@ -4873,95 +5868,778 @@ TMR_LLRP_parseMetadataFromMessage(TMR_Reader *reader, TMR_TagReadData *data, LLR
 
     if (TMR_TAG_PROTOCOL_GEN2 == data->tag.protocol)
     {
-      LLRP_tSParameter *pParameter;
+      LLRP_tSParameter *pParameter;
+
+      /**
+       * If protocol is Gen2, extract CRC and PCBits
+       **/
+      for(pParameter = pTagReportData->listAirProtocolTagData;
+          NULL != pParameter;
+          pParameter = (LLRP_tSParameter *)pParameter->pNextSubParameter)
+      {
+        if (&LLRP_tdC1G2_PC == pParameter->elementHdr.pType)
+        {
+          llrp_u16_t pc;
+
+          pc = LLRP_C1G2_PC_getPC_Bits((LLRP_tSC1G2_PC *)pParameter);
+          data->tag.u.gen2.pc[0] = pc & 0xFF;
+          data->tag.u.gen2.pc[1] = (pc & 0xFF00) >> 8;
+
+          data->tag.u.gen2.pcByteCount = 2;
+
+          /** TODO: Add support for XPC bits */
+        }
+        else if (&LLRP_tdC1G2_CRC == pParameter->elementHdr.pType)
+        {
+          data->tag.crc = LLRP_C1G2_CRC_getCRC((LLRP_tSC1G2_CRC *)pParameter);
+        }
+      } /* End of for loop */
+    }
+
+    /**
+     * Extract OpSpecResults if any. 
+     **/
+    {
+      LLRP_tSParameter *pParameter;
+
+      for (pParameter = pTagReportData->listAccessCommandOpSpecResult;
+           NULL != pParameter;
+           pParameter = (LLRP_tSParameter *)pParameter->pNextSubParameter)
+      {
+        /**
+         * Each airProtocol's OpSpecResult is expressed as a different
+         * LLRP parameter. Verify the OpSpecResult status, if not success,
+         * then notify the exception to user.
+         **/
+        TMR_Status retVal;
+
+        retVal = TMR_LLRP_verifyOpSpecResultStatus(reader, pParameter);
+        if (TMR_SUCCESS != retVal)
+        {
+          /**
+           * The OpSpec has failed to execute, notify the execption to 
+           * user.
+           * FIXME: Notifying the error through exception listener.
+           * This is exact behavior in case of continuous reading, 
+           * How do we handle this for sync reads? We can not return
+           * Error though..
+           **/
+#ifdef TMR_ENABLE_BACKGROUND_READS
+          notify_exception_listeners(reader, retVal);
+#endif
+
+          /**
+           * Continue with next OpSpecResult parameter.
+           **/
+          continue;
+        }
+
+        /**
+         * At this point, we have verified the OpSpecResult status,
+         * and it is success.
+         * But currently, only for ReadData (i.e., C1G2ReadOpSpecResult),
+         * we extract the read data and place it in TMR_TagReadData->data
+         * TODO: For other tag operations which return tagop data,
+         * where do we store that?
+         **/
+        if (NULL != &data->data)
+        {
+          TMR_LLRP_parseTagOpSpecData(pParameter, &data->data);
+          data->metadataFlags |= TMR_TRD_METADATA_FLAG_DATA;
+        }
+      } /* End of for loop */
+    } /* End of parsing OpSpecResults */
+  }
+  else
+  {
+    return TMR_ERROR_LLRP;
+  }
+
+  return ret;
+}
+
+/**
+ * Whether TagReportData custom parameters are parsed into metadata:
+ * some of the metadata they carry must be enabled, and the reader
+ * firmware must be 4.17 or newer to send them.
+ */
+static bool
+TMR_LLRP_hasCustomMetadata(TMR_Reader *reader)
+{
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+
+  if (0 == (lr->metadata & (TMR_TRD_METADATA_FLAG_PHASE | TMR_TRD_METADATA_FLAG_PROTOCOL |
+                            TMR_TRD_METADATA_FLAG_DATA | TMR_TRD_METADATA_FLAG_GPIO_STATUS |
+                            TMR_TRD_METADATA_FLAG_GEN2_Q | TMR_TRD_METADATA_FLAG_GEN2_LF |
+                            TMR_TRD_METADATA_FLAG_GEN2_TARGET)))
+  {
+    return false;
+  }
+  return (((atoi(&lr->capabilities.softwareVersion[0]) == 4)
+           && (atoi(&lr->capabilities.softwareVersion[2]) >= 17))
+          || (atoi(&lr->capabilities.softwareVersion[0]) > 4));
+}
+
+/**
+ * Parse the ThingMagic custom parameters of a GPIO or Gen2 metadata
+ * parameter, i.e., those nested within p[offset..end).
+ *
+ * @return TMR_ERROR_UNSUPPORTED if the parameter is not one the report
+ * streamer handles, else TMR_SUCCESS
+ */
+static TMR_Status
+TMR_LLRP_parseStreamedCustomMetadata(TMR_Reader *reader, TMR_TagReadData *data, uint32_t subtype,
+                                     const uint8_t *p, uint32_t offset, uint32_t end)
+{
+  TMR_TRD_MetadataFlag metadata = reader->u.llrpReader.metadata;
+  TMR_TRD_MetadataFlag found = 0;
+  uint32_t length;
+  uint8_t gpioCount = 0;
+
+  for (; offset < end; offset += length)
+  {
+    if ((offset + 12 > end) || (p[offset] & 0x80))
+    {
+      return TMR_ERROR_UNSUPPORTED;
+    }
+    length = GETU16AT(p, offset + 2);
+    if ((length < 12) || (offset + length > end) ||
+        (TMR_LLRP_TLV_CUSTOM != (GETU16AT(p, offset) & 0x3FF)))
+    {
+      return TMR_ERROR_UNSUPPORTED;
+    }
+    /* Custom parameters from anyone else are left alone, as LTKC does */
+    if (TM_MANUFACTURER_ID != GETU32AT(p, offset + 4))
+    {
+      continue;
+    }
+
+    switch (GETU32AT(p, offset + 8))
+    {
+      case TMMPD_CUSTOM_GPIO_PIN:
+        if ((TMMPD_CUSTOM_GPIO_STATUS != subtype) || (length < 14) ||
+            (gpioCount >= sizeof(data->gpio) / sizeof(data->gpio[0])))
+        {
+          return TMR_ERROR_UNSUPPORTED;
+        }
+        /* id, then Status and Direction in the top two bits */
+        data->gpio[gpioCount].id = p[offset + 12];
+        data->gpio[gpioCount].high = (p[offset + 13] >> 7) & 1;
+        data->gpio[gpioCount].output = (p[offset + 13] >> 6) & 1;
+        gpioCount++;
+        break;
+      case TMMPD_CUSTOM_GEN2_Q:
+        if ((TMMPD_CUSTOM_GEN2 != subtype) || (length < 13))
+        {
+          return TMR_ERROR_UNSUPPORTED;
+        }
+        data->u.gen2.q.u.staticQ.initialQ = p[offset + 12];
+        found |= TMR_TRD_METADATA_FLAG_GEN2_Q;
+        break;
+      case TMMPD_CUSTOM_GEN2_LF:
+        if ((TMMPD_CUSTOM_GEN2 != subtype) || (length < 14))
+        {
+          return TMR_ERROR_UNSUPPORTED;
+        }
+        data->u.gen2.lf = (TMR_GEN2_LinkFrequency)GETU16AT(p, offset + 12);
+        found |= TMR_TRD_METADATA_FLAG_GEN2_LF;
+        break;
+      case TMMPD_CUSTOM_GEN2_TARGET:
+        if ((TMMPD_CUSTOM_GEN2 != subtype) || (length < 13))
+        {
+          return TMR_ERROR_UNSUPPORTED;
+        }
+        data->u.gen2.target = (TMR_GEN2_Target)p[offset + 12];
+        found |= TMR_TRD_METADATA_FLAG_GEN2_TARGET;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (TMMPD_CUSTOM_GPIO_STATUS == subtype)
+  {
+    data->gpioCount = gpioCount;
+    data->metadataFlags |= TMR_TRD_METADATA_FLAG_GPIO_STATUS;
+  }
+  else
+  {
+    metadata &= (TMR_TRD_METADATA_FLAG_GEN2_Q | TMR_TRD_METADATA_FLAG_GEN2_LF |
+                 TMR_TRD_METADATA_FLAG_GEN2_TARGET);
+    /* Leave a Gen2 response lacking some enabled value to the full decode */
+    if (metadata != (found & metadata))
+    {
+      return TMR_ERROR_UNSUPPORTED;
+    }
+    data->metadataFlags |= metadata;
+  }
+
+  return TMR_SUCCESS;
+}
+
+/**
+ * Parse one TagReportData parameter, p[0..length), straight from the
+ * frame. This follows TMR_LLRP_parseMetadataFromMessage() field for
+ * field.
+ *
+ * @return TMR_ERROR_UNSUPPORTED if the parameter holds something the
+ * report streamer does not handle, such as OpSpec results; TMR_ERROR_LLRP
+ * if enabled metadata is missing; else TMR_SUCCESS
+ */
+static TMR_Status
+TMR_LLRP_parseStreamedTagReportData(TMR_Reader *reader, TMR_LLRP_ReportStream *stream,
+                                    const uint8_t *p, uint32_t length, TMR_TagReadData *data)
+{
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  TMR_TRD_MetadataFlag found = 0;
+  TMR_Status ret;
+  uint32_t i, paramLength, roSpecId = 0, vendor, subtype;
+  uint64_t lastSeen = 0;
+  uint16_t antennaId = 0, tagCount = 0, channelIndex = 0, pc = 0, crc = 0;
+  int8_t peakRssi = 0;
+  llrp_u8_t protocolID = 0;
+  bool epc = false, roSpec = false, hasPC = false, hasCRC = false, hasProtocolID = false;
+
+  for (i = 4; i < length; i += paramLength)
+  {
+    if (p[i] & 0x80)
+    {
+      /* TV parameter: the type fixes the length */
+      switch (p[i] & 0x7F)
+      {
+        case TMR_LLRP_TV_PEAKRSSI:
+          paramLength = 2;
+          break;
+        case TMR_LLRP_TV_ANTENNAID:
+        case TMR_LLRP_TV_CHANNELINDEX:
+        case TMR_LLRP_TV_TAGSEENCOUNT:
+        case TMR_LLRP_TV_INVENTORYPARAMETERSPECID:
+        case TMR_LLRP_TV_C1G2_CRC:
+        case TMR_LLRP_TV_C1G2_PC:
+        case TMR_LLRP_TV_SPECINDEX:
+          paramLength = 3;
+          break;
+        case TMR_LLRP_TV_ROSPECID:
+        case TMR_LLRP_TV_ACCESSSPECID:
+          paramLength = 5;
+          break;
+        case TMR_LLRP_TV_FIRSTSEENTIMESTAMPUTC:
+        case TMR_LLRP_TV_FIRSTSEENTIMESTAMPUPTIME:
+        case TMR_LLRP_TV_LASTSEENTIMESTAMPUTC:
+        case TMR_LLRP_TV_LASTSEENTIMESTAMPUPTIME:
+          paramLength = 9;
+          break;
+        case TMR_LLRP_TV_EPC_96:
+          paramLength = 13;
+          break;
+        default:
+          return TMR_ERROR_UNSUPPORTED;
+      }
+      if (i + paramLength > length)
+      {
+        return TMR_ERROR_UNSUPPORTED;
+      }
+
+      switch (p[i] & 0x7F)
+      {
+        case TMR_LLRP_TV_EPC_96:
+          data->tag.epcByteCount = 12;
+          memcpy(data->tag.epc, &p[i + 1], data->tag.epcByteCount);
+          epc = true;
+          break;
+        case TMR_LLRP_TV_LASTSEENTIMESTAMPUTC:
+          lastSeen = ((uint64_t)GETU32AT(p, i + 1) << 32) | GETU32AT(p, i + 5);
+          found |= TMR_TRD_METADATA_FLAG_TIMESTAMP;
+          break;
+        case TMR_LLRP_TV_ANTENNAID:
+          antennaId = GETU16AT(p, i + 1);
+          found |= TMR_TRD_METADATA_FLAG_ANTENNAID;
+          break;
+        case TMR_LLRP_TV_TAGSEENCOUNT:
+          tagCount = GETU16AT(p, i + 1);
+          found |= TMR_TRD_METADATA_FLAG_READCOUNT;
+          break;
+        case TMR_LLRP_TV_PEAKRSSI:
+          peakRssi = (int8_t)p[i + 1];
+          found |= TMR_TRD_METADATA_FLAG_RSSI;
+          break;
+        case TMR_LLRP_TV_CHANNELINDEX:
+          channelIndex = GETU16AT(p, i + 1);
+          found |= TMR_TRD_METADATA_FLAG_FREQUENCY;
+          break;
+        case TMR_LLRP_TV_ROSPECID:
+          roSpecId = GETU32AT(p, i + 1);
+          roSpec = true;
+          break;
+        case TMR_LLRP_TV_C1G2_PC:
+          pc = GETU16AT(p, i + 1);
+          hasPC = true;
+          break;
+        case TMR_LLRP_TV_C1G2_CRC:
+          crc = GETU16AT(p, i + 1);
+          hasCRC = true;
+          break;
+        default:
+          /* Not used as metadata */
+          break;
+      }
+      continue;
+    }
+
+    /* TLV parameter */
+    if (i + 4 > length)
+    {
+      return TMR_ERROR_UNSUPPORTED;
+    }
+    paramLength = GETU16AT(p, i + 2);
+    if ((paramLength < 4) || (i + paramLength > length))
+    {
+      return TMR_ERROR_UNSUPPORTED;
+    }
+
+    switch (GETU16AT(p, i) & 0x3FF)
+    {
+      case TMR_LLRP_TLV_EPCDATA:
+        {
+          uint16_t byteCount;
+
+          if (paramLength < 6)
+          {
+            return TMR_ERROR_UNSUPPORTED;
+          }
+          byteCount = (GETU16AT(p, i + 4) + 7u) / 8u;
+          if ((6u + byteCount != paramLength) || (byteCount > TMR_MAX_EPC_BYTE_COUNT))
+          {
+            return TMR_ERROR_UNSUPPORTED;
+          }
+          data->tag.epcByteCount = byteCount;
+          memcpy(data->tag.epc, &p[i + 6], byteCount);
+          epc = true;
+        }
+        break;
+
+      case TMR_LLRP_TLV_CUSTOM:
+        if (false == stream->customMetadata)
+        {
+          /* Not looked at, as in TMR_LLRP_parseMetadataFromMessage() */
+          break;
+        }
+        if (paramLength < 12)
+        {
+          return TMR_ERROR_UNSUPPORTED;
+        }
+        vendor = GETU32AT(p, i + 4);
+        subtype = GETU32AT(p, i + 8);
+
+        if (false == isPerAntennaEnabled)
+        {
+          /* Every custom parameter is taken as the RF phase */
+          if ((TM_MANUFACTURER_ID != vendor) || (TMMP_CUSTOM_RFPHASE != subtype) ||
+              (paramLength < 14))
+          {
+            return TMR_ERROR_UNSUPPORTED;
+          }
+          data->phase = GETU16AT(p, i + 12);
+          break;
+        }
+        if (TM_MANUFACTURER_ID != vendor)
+        {
+          break;
+        }
+
+        switch (subtype)
+        {
+          case TMMP_CUSTOM_RFPHASE:
+            if (lr->metadata & TMR_TRD_METADATA_FLAG_PHASE)
+            {
+              if (paramLength < 14)
+              {
+                return TMR_ERROR_UNSUPPORTED;
+              }
+              data->phase = GETU16AT(p, i + 12);
+              data->metadataFlags |= TMR_TRD_METADATA_FLAG_PHASE;
+            }
+            break;
+          case TMMP_CUSTOM_PROTOCOL_ID:
+            if (lr->metadata & TMR_TRD_METADATA_FLAG_PROTOCOL)
+            {
+              if (paramLength < 13)
+              {
+                return TMR_ERROR_UNSUPPORTED;
+              }
+              /* Applied after the ROSpec's protocol, below */
+              protocolID = p[i + 12];
+              hasProtocolID = true;
+            }
+            break;
+          case TMMP_CUSTOM_TAGOP_RESPONSE:
+            if (lr->metadata & TMR_TRD_METADATA_FLAG_DATA)
+            {
+              return TMR_ERROR_UNSUPPORTED;
+            }
+            break;
+          case TMMPD_CUSTOM_GPIO_STATUS:
+            if (lr->metadata & TMR_TRD_METADATA_FLAG_GPIO_STATUS)
+            {
+              ret = TMR_LLRP_parseStreamedCustomMetadata(reader, data, subtype, p, i + 12, i + paramLength);
+              if (TMR_SUCCESS != ret)
+              {
+                return ret;
+              }
+            }
+            break;
+          case TMMPD_CUSTOM_GEN2:
+            if (lr->metadata & (TMR_TRD_METADATA_FLAG_GEN2_Q | TMR_TRD_METADATA_FLAG_GEN2_LF |
+                                TMR_TRD_METADATA_FLAG_GEN2_TARGET))
+            {
+              ret = TMR_LLRP_parseStreamedCustomMetadata(reader, data, subtype, p, i + 12, i + paramLength);
+              if (TMR_SUCCESS != ret)
+              {
+                return ret;
+              }
+            }
+            break;
+          default:
+            break;
+        }
+        break;
+
+      default:
+        /* OpSpec results and anything else go to the full decode */
+        return TMR_ERROR_UNSUPPORTED;
+    }
+  }
+
+  if ((false == epc) || (false == roSpec) ||
+      ((lr->metadata & found) != (lr->metadata & (TMR_TRD_METADATA_FLAG_TIMESTAMP |
+                                                  TMR_TRD_METADATA_FLAG_ANTENNAID |
+                                                  TMR_TRD_METADATA_FLAG_READCOUNT |
+                                                  TMR_TRD_METADATA_FLAG_RSSI |
+                                                  TMR_TRD_METADATA_FLAG_FREQUENCY))))
+  {
+    return TMR_ERROR_LLRP;
+  }
+  if (roSpecId >= sizeof(lr->readPlanProtocol) / sizeof(lr->readPlanProtocol[0]))
+  {
+    return TMR_ERROR_UNSUPPORTED;
+  }
+
+  if (lr->metadata & TMR_TRD_METADATA_FLAG_TIMESTAMP)
+  {
+    uint64_t msSinceEpoch = lastSeen / 1000;
+    data->dspMicros = (uint32_t)(msSinceEpoch % 1000);
+    data->timestampHigh = (uint32_t)(msSinceEpoch>>32) & 0xFFFFFFFF;
+    data->timestampLow  = (uint32_t)(msSinceEpoch>> 0) & 0xFFFFFFFF;
+    data->metadataFlags |= TMR_TRD_METADATA_FLAG_TIMESTAMP;
+  }
+  if (lr->metadata & TMR_TRD_METADATA_FLAG_ANTENNAID)
+  {
+    data->antenna = (uint8_t)antennaId;
+    data->metadataFlags |= TMR_TRD_METADATA_FLAG_ANTENNAID;
+  }
+  if (lr->metadata & TMR_TRD_METADATA_FLAG_READCOUNT)
+  {
+    data->readCount = tagCount;
+    data->metadataFlags |= TMR_TRD_METADATA_FLAG_READCOUNT;
+  }
+  if (lr->metadata & TMR_TRD_METADATA_FLAG_RSSI)
+  {
+    data->rssi = peakRssi;
+    data->metadataFlags |= TMR_TRD_METADATA_FLAG_RSSI;
+  }
+  if ((lr->metadata & TMR_TRD_METADATA_FLAG_FREQUENCY) &&
+      (NULL != lr->capabilities.freqTable.list) && (0 != channelIndex))
+  {
+    data->frequency = lr->capabilities.freqTable.list[channelIndex - 1];
+    data->metadataFlags |= TMR_TRD_METADATA_FLAG_FREQUENCY;
+  }
+
+  data->tag.protocol = lr->readPlanProtocol[roSpecId].rospecProtocol;
+  data->metadataFlags |= TMR_TRD_METADATA_FLAG_PROTOCOL;
+  if (hasProtocolID)
+  {
+    TMR_LLRP_setCustomProtocol(data, protocolID);
+  }
+
+  if (TMR_TAG_PROTOCOL_GEN2 == data->tag.protocol)
+  {
+    if (hasPC)
+    {
+      data->tag.u.gen2.pc[0] = pc & 0xFF;
+      data->tag.u.gen2.pc[1] = (pc & 0xFF00) >> 8;
+      data->tag.u.gen2.pcByteCount = 2;
+    }
+    if (hasCRC)
+    {
+      data->tag.crc = crc;
+    }
+  }
+
+  return TMR_SUCCESS;
+}
+
+/**
+ * Start streaming tag reads from a raw RO_ACCESS_REPORT frame.
+ *
+ * @param reader Reader pointer
+ * @param stream The stream to set up
+ * @param frame The frame, which must outlive the stream
+ * @param length Length of the frame in bytes
+ * @return TMR_ERROR_UNSUPPORTED if the frame is not an RO_ACCESS_REPORT
+ */
+TMR_Status
+TMR_LLRP_reportStreamInit(TMR_Reader *reader, TMR_LLRP_ReportStream *stream,
+                          const uint8_t *frame, uint32_t length)
+{
+  if ((length < 10) || (GETU32AT(frame, 2) != length) ||
+      (LLRP_tdRO_ACCESS_REPORT.TypeNum != (GETU16AT(frame, 0) & 0x3FF)))
+  {
+    return TMR_ERROR_UNSUPPORTED;
+  }
+
+  stream->frame = frame;
+  stream->length = length;
+  stream->offset = 10;
+  stream->tagReports = 0;
+  stream->customMetadata = TMR_LLRP_hasCustomMetadata(reader);
+
+  return TMR_SUCCESS;
+}
+
+/**
+ * Parse the next TagReportData of a report stream into a
+ * TMR_TagReadData, as TMR_LLRP_parseMetadataFromMessage() does for
+ * a decoded one, without building an LTKC element tree.
+ *
+ * @param reader Reader pointer
+ * @param stream The stream, set up by TMR_LLRP_reportStreamInit()
+ * @param data TMR_TagReadData to fill, already initialized
+ * @return TMR_SUCCESS when data holds the next tag read;
+ * TMR_ERROR_LLRP when that TagReportData lacks enabled metadata and is
+ * skipped; TMR_ERROR_NO_TAGS at the end of the report; or
+ * TMR_ERROR_UNSUPPORTED at a parameter the stream does not handle, which
+ * is left for a full decode. stream->tagReports counts the TagReportData
+ * parameters before it.
+ */
+TMR_Status
+TMR_LLRP_reportStreamNext(TMR_Reader *reader, TMR_LLRP_ReportStream *stream,
+                          TMR_TagReadData *data)
+{
+  const uint8_t *p;
+  uint32_t length;
+  TMR_Status ret;
+
+  if (stream->offset >= stream->length)
+  {
+    return TMR_ERROR_NO_TAGS;
+  }
+  if (stream->offset + 4 > stream->length)
+  {
+    return TMR_ERROR_UNSUPPORTED;
+  }
+
+  p = &stream->frame[stream->offset];
+  length = GETU16AT(p, 2);
+  if ((p[0] & 0x80) || (TMR_LLRP_TLV_TAGREPORTDATA != (GETU16AT(p, 0) & 0x3FF)) ||
+      (length < 4) || (stream->offset + length > stream->length))
+  {
+    /* RFSurveyReportData and custom parameters included */
+    return TMR_ERROR_UNSUPPORTED;
+  }
+
+  ret = TMR_LLRP_parseStreamedTagReportData(reader, stream, p, length, data);
+  if (TMR_ERROR_UNSUPPORTED != ret)
+  {
+    stream->offset += length;
+    stream->tagReports++;
+  }
+
+  return ret;
+}
+
+#ifdef TMR_ENABLE_BACKGROUND_READS
+/**
+ * LTKC frame hook (see LLRP_tFrameHook) that streams tag reports
+ * during continuous reading. It keeps a copy of the raw
+ * RO_ACCESS_REPORT frame for the parser thread and hands LTKC an
+ * empty RO_ACCESS_REPORT to stand in for it, so the frame is never
+ * decoded into an element tree.
+ *
+ * Reports are decoded as usual when anything wants the decoded
+ * message: transport listeners render it, capture matches frames to
+ * it, and a report led by RFSurveyReportData is a stats response.
+ */
+LLRP_tSMessage *
+TMR_LLRP_streamReportFrame(void *context, const LLRP_tSFrameExtract *pFrameExtract,
+                           const unsigned char *pFrame)
+{
+  TMR_Reader *reader = context;
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  LLRP_tSRO_ACCESS_REPORT *pReport;
+  TMR_LLRP_StreamedFrame *entry, **prev;
+  uint32_t length = pFrameExtract->MessageLength;
+  uint8_t *frame;
+
+  if ((false == reader->continuousReading) ||
+      (LLRP_tdRO_ACCESS_REPORT.TypeNum != pFrameExtract->MessageType) ||
+      TMR__hasTransportListeners(reader))
+  {
+    return NULL;
+  }
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  if (NULL != reader->transportCapture)
+  {
+    return NULL;
+  }
+#endif
+  if ((length >= 14) &&
+      ((pFrame[10] & 0x80) || (TMR_LLRP_TLV_TAGREPORTDATA != (GETU16AT(pFrame, 10) & 0x3FF))))
+  {
+    return NULL;
+  }
+
+  frame = malloc(length);
+  entry = malloc(sizeof(*entry));
+  pReport = LLRP_RO_ACCESS_REPORT_construct();
+  if ((NULL == frame) || (NULL == entry) || (NULL == pReport))
+  {
+    free(frame);
+    free(entry);
+    TMR_LLRP_freeMessage((LLRP_tSMessage *)pReport);
+    return NULL;
+  }
+  memcpy(frame, pFrame, length);
+  pReport->hdr.MessageID = pFrameExtract->MessageID;
+  entry->report = &pReport->hdr;
+  entry->frame = frame;
+  entry->length = length;
+
+  pthread_mutex_lock(&lr->streamedLock);
+  /**
+   * An entry for the same address belongs to a report that was freed
+   * without being queued. Drop it so it can't be taken for this one.
+   **/
+  for (prev = &lr->streamedFrames; NULL != *prev; prev = &(*prev)->next)
+  {
+    if ((*prev)->report == entry->report)
+    {
+      TMR_LLRP_StreamedFrame *stale = *prev;
 
-      /**
-       * If protocol is Gen2, extract CRC and PCBits
-       **/
-      for(pParameter = pTagReportData->listAirProtocolTagData;
-          NULL != pParameter;
-          pParameter = (LLRP_tSParameter *)pParameter->pNextSubParameter)
-      {
-        if (&LLRP_tdC1G2_PC == pParameter->elementHdr.pType)
-        {
-          llrp_u16_t pc;
+      *prev = stale->next;
+      free(stale->frame);
+      free(stale);
+      break;
+    }
+  }
+  entry->next = lr->streamedFrames;
+  lr->streamedFrames = entry;
+  pthread_mutex_unlock(&lr->streamedLock);
 
-          pc = LLRP_C1G2_PC_getPC_Bits((LLRP_tSC1G2_PC *)pParameter);
-          data->tag.u.gen2.pc[0] = pc & 0xFF;
-          data->tag.u.gen2.pc[1] = (pc & 0xFF00) >> 8;
+  return &pReport->hdr;
+}
 
-          data->tag.u.gen2.pcByteCount = 2;
+/**
+ * Take the raw frame TMR_LLRP_streamReportFrame() kept for a report.
+ * The caller owns the frame from then on.
+ *
+ * @param reader Reader pointer
+ * @param pReport The report about to be queued
+ * @param[out] frame The frame, or NULL if the report was decoded as usual
+ * @param[out] length Length of the frame in bytes, 0 without one
+ */
+void
+TMR_LLRP_takeStreamedFrame(TMR_Reader *reader, LLRP_tSMessage *pReport,
+                           uint8_t **frame, uint32_t *length)
+{
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  TMR_LLRP_StreamedFrame *entry, **prev;
 
-          /** TODO: Add support for XPC bits */
-        }
-        else if (&LLRP_tdC1G2_CRC == pParameter->elementHdr.pType)
-        {
-          data->tag.crc = LLRP_C1G2_CRC_getCRC((LLRP_tSC1G2_CRC *)pParameter);
-        }
-      } /* End of for loop */
+  *frame = NULL;
+  *length = 0;
+  pthread_mutex_lock(&lr->streamedLock);
+  for (prev = &lr->streamedFrames; NULL != *prev; prev = &(*prev)->next)
+  {
+    if ((*prev)->report == pReport)
+    {
+      entry = *prev;
+      *prev = entry->next;
+      *frame = entry->frame;
+      *length = entry->length;
+      free(entry);
+      break;
     }
+  }
+  pthread_mutex_unlock(&lr->streamedLock);
+}
 
-    /**
-     * Extract OpSpecResults if any. 
-     **/
-    {
-      LLRP_tSParameter *pParameter;
+/**
+ * Free the frames of streamed reports that were never queued.
+ *
+ * @param reader Reader pointer
+ */
+void
+TMR_LLRP_dropStreamedFrames(TMR_Reader *reader)
+{
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  TMR_LLRP_StreamedFrame *entry;
 
-      for (pParameter = pTagReportData->listAccessCommandOpSpecResult;
-           NULL != pParameter;
-           pParameter = (LLRP_tSParameter *)pParameter->pNextSubParameter)
-      {
-        /**
-         * Each airProtocol's OpSpecResult is expressed as a different
-         * LLRP parameter. Verify the OpSpecResult status, if not success,
-         * then notify the exception to user.
-         **/
-        TMR_Status retVal;
+  pthread_mutex_lock(&lr->streamedLock);
+  while (NULL != lr->streamedFrames)
+  {
+    entry = lr->streamedFrames;
+    lr->streamedFrames = entry->next;
+    free(entry->frame);
+    free(entry);
+  }
+  pthread_mutex_unlock(&lr->streamedLock);
+}
 
-        retVal = TMR_LLRP_verifyOpSpecResultStatus(reader, pParameter);
-        if (TMR_SUCCESS != retVal)
-        {
-          /**
-           * The OpSpec has failed to execute, notify the execption to 
-           * user.
-           * FIXME: Notifying the error through exception listener.
-           * This is exact behavior in case of continuous reading, 
-           * How do we handle this for sync reads? We can not return
-           * Error though..
-           **/
-#ifdef TMR_ENABLE_BACKGROUND_READS
-          notify_exception_listeners(reader, retVal);
-#endif
+/**
+ * Notify the read listeners of each tag read streamed from a raw
+ * RO_ACCESS_REPORT frame.
+ *
+ * @param reader Reader pointer
+ * @param frame The frame
+ * @param length Length of the frame in bytes
+ * @param[out] streamed Count of TagReportData parameters handled
+ * @param[out] pMsg NULL when the whole report was streamed. Otherwise the
+ * report, fully decoded, for the caller to handle past the first *streamed
+ * TagReportData parameters.
+ * @return TMR_SUCCESS, or the error that kept the frame from being decoded;
+ * the tag reads past *streamed are then lost.
+ */
+TMR_Status
+TMR_LLRP_notifyStreamedTagReads(TMR_Reader *reader, const uint8_t *frame,
+                                uint32_t length, uint32_t *streamed,
+                                LLRP_tSMessage **pMsg)
+{
+  TMR_LLRP_ReportStream stream;
+  TMR_Status ret;
 
-          /**
-           * Continue with next OpSpecResult parameter.
-           **/
-          continue;
-        }
+  *streamed = 0;
+  *pMsg = NULL;
+  ret = TMR_LLRP_reportStreamInit(reader, &stream, frame, length);
+  while ((TMR_SUCCESS == ret) || (TMR_ERROR_LLRP == ret))
+  {
+    TMR_TagReadData trd;
 
-        /**
-         * At this point, we have verified the OpSpecResult status,
-         * and it is success.
-         * But currently, only for ReadData (i.e., C1G2ReadOpSpecResult),
-         * we extract the read data and place it in TMR_TagReadData->data
-         * TODO: For other tag operations which return tagop data,
-         * where do we store that?
-         **/
-        if (NULL != &data->data)
-        {
-          TMR_LLRP_parseTagOpSpecData(pParameter, &data->data);
-          data->metadataFlags |= TMR_TRD_METADATA_FLAG_DATA;
-        }
-      } /* End of for loop */
-    } /* End of parsing OpSpecResults */
+    TMR_TRD_init(&trd);
+    ret = TMR_LLRP_reportStreamNext(reader, &stream, &trd);
+    if (TMR_SUCCESS == ret)
+    {
+      trd.reader = reader;
+      notify_read_listeners(reader, &trd);
+    }
+    *streamed = stream.tagReports;
   }
-  else
+  if (TMR_ERROR_NO_TAGS == ret)
   {
-    return TMR_ERROR_LLRP;
+    return TMR_SUCCESS;
   }
 
-  return ret;
+  return TMR_LLRP_decodeMessage(reader, (uint8_t *)frame, length, pMsg);
 }
+#endif /* TMR_ENABLE_BACKGROUND_READS */
 
 /**
  * Internal method to parse TagOp data from TagOpSpecResult parameter
@@ -6778,26 +8456,17 @@ TMR_LLRP_cmdGetThingMagicGEN2ProtocolExtension(TMR_Reader *reader, uint8_t *prot
 }
 
 /**
- * Command to get Thingmagic Device Protocol Capabilities
+ * Build the GET_READER_CAPABILITIES message asking for the
+ * Thingmagic Device Protocol Capabilities
  *
  * @param reader Reader pointer
- * @param protocolList Pointer to TMR_TagProtocolList  to
- *  hold the value of Thingmagic Device protocol Capabilities
+ * @param[out] pCmdMsg The message, for the caller to free
  */
 TMR_Status
-TMR_LLRP_cmdGetTMDeviceProtocolCapabilities(TMR_Reader *reader, TMR_TagProtocolList *protocolList)
+TMR_LLRP_msgGetTMDeviceProtocolCapabilities(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg)
 {
-  TMR_Status ret;
   LLRP_tSGET_READER_CAPABILITIES              *pCmd;
-  LLRP_tSMessage                              *pCmdMsg;
-  LLRP_tSMessage                              *pRspMsg;
-  LLRP_tSGET_READER_CAPABILITIES_RESPONSE     *pRsp;
   LLRP_tSThingMagicDeviceControlCapabilities  *pTMCaps;
-  LLRP_tSParameter                            *pCustParam;
-  LLRP_tSSupportedProtocols                   *pSupportedProtocols;
-  uint8_t                                     i;
-
-  ret = TMR_SUCCESS;
 
   /**
    * Initialize GET_READER_CAPABILITIES message
@@ -6827,7 +8496,30 @@ TMR_LLRP_cmdGetTMDeviceProtocolCapabilities(TMR_Reader *reader, TMR_TagProtocolL
     TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
     return TMR_ERROR_LLRP;
   }
-  pCmdMsg       = &pCmd->hdr;
+
+  *pCmdMsg = &pCmd->hdr;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Command to get Thingmagic Device Protocol Capabilities
+ *
+ * @param reader Reader pointer
+ * @param protocolList Pointer to TMR_TagProtocolList  to
+ *  hold the value of Thingmagic Device protocol Capabilities
+ */
+TMR_Status
+TMR_LLRP_cmdGetTMDeviceProtocolCapabilities(TMR_Reader *reader, TMR_TagProtocolList *protocolList)
+{
+  TMR_Status ret;
+  LLRP_tSMessage                              *pCmdMsg;
+  LLRP_tSMessage                              *pRspMsg;
+
+  ret = TMR_LLRP_msgGetTMDeviceProtocolCapabilities(reader, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
 
   /**
    * Now the message is framed completely and send the message
@@ -6837,12 +8529,36 @@ TMR_LLRP_cmdGetTMDeviceProtocolCapabilities(TMR_Reader *reader, TMR_TagProtocolL
    * Done with the command, free the message
    * and check for message status
    **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+  TMR_LLRP_freeMessage(pCmdMsg);
   if (TMR_SUCCESS != ret)
   {
     return ret;
   }
 
+  return TMR_LLRP_handleGetTMDeviceProtocolCapabilitiesResponse(reader, pRspMsg, protocolList);
+}
+
+/**
+ * Extract the supported protocols from the response to
+ * TMR_LLRP_msgGetTMDeviceProtocolCapabilities() and free the response
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ * @param protocolList Pointer to TMR_TagProtocolList  to
+ *  hold the value of Thingmagic Device protocol Capabilities
+ */
+TMR_Status
+TMR_LLRP_handleGetTMDeviceProtocolCapabilitiesResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg,
+                                                       TMR_TagProtocolList *protocolList)
+{
+  TMR_Status ret;
+  LLRP_tSGET_READER_CAPABILITIES_RESPONSE     *pRsp;
+  LLRP_tSParameter                            *pCustParam;
+  LLRP_tSSupportedProtocols                   *pSupportedProtocols;
+  uint8_t                                     i;
+
+  ret = TMR_SUCCESS;
+
   /**
    * Check response message status
    **/
@@ -10193,8 +11909,6 @@ TMR_LLRP_stopActiveROSpecs(TMR_Reader *reader)
   LLRP_tSGET_ROSPECS                    *pCmd;
   LLRP_tSMessage                        *pCmdMsg;
   LLRP_tSMessage                        *pRspMsg;
-  LLRP_tSGET_ROSPECS_RESPONSE           *pRsp;
-  LLRP_tSROSpec                         *pROSpec;
 
   ret = TMR_SUCCESS;
   /**
@@ -10217,6 +11931,24 @@ TMR_LLRP_stopActiveROSpecs(TMR_Reader *reader)
     return ret;
   }
 
+  return TMR_LLRP_handleGetROSpecsResponse(reader, pRspMsg);
+}
+
+/**
+ * Stop the ROSpecs that the response to GET_ROSPECS shows running
+ * or periodic, and free the response
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ */
+TMR_Status
+TMR_LLRP_handleGetROSpecsResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg)
+{
+  TMR_Status ret;
+  LLRP_tSGET_ROSPECS_RESPONSE           *pRsp;
+  LLRP_tSROSpec                         *pROSpec;
+
+  ret = TMR_SUCCESS;
   /**
    * Check response message status
    **/
@@ -10291,17 +12023,18 @@ TMR_LLRP_enableEventsAndReports(TMR_Reader *reader)
   return ret;
 }
 
+/**
+ * Build the SET_READER_CONFIG message setting HoldEventsAndReportsUponReconnect
+ *
+ * @param reader Reader pointer
+ * @param[out] pCmdMsg The message, for the caller to free
+ */
 TMR_Status
-TMR_LLRP_setHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status)
+TMR_LLRP_msgSetHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status, LLRP_tSMessage **pCmdMsg)
 {
-  TMR_Status ret;
   LLRP_tSSET_READER_CONFIG                *pCmd;
-  LLRP_tSMessage                          *pCmdMsg;
-  LLRP_tSMessage                          *pRspMsg;
-  LLRP_tSSET_READER_CONFIG_RESPONSE       *pRsp;
   LLRP_tSEventsAndReports                 *pEvents;
 
-  ret = TMR_SUCCESS;
   /**
    * EventsAndReports can be set through SET_READER_CONFIG
    * Initialize SET_READER_CONFIG
@@ -10316,7 +12049,23 @@ TMR_LLRP_setHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status)
   /* Add EventsAndReports to SET_READER_CONFIG*/
   LLRP_SET_READER_CONFIG_setEventsAndReports(pCmd, pEvents);
 
-  pCmdMsg = &pCmd->hdr;
+  *pCmdMsg = &pCmd->hdr;
+  return TMR_SUCCESS;
+}
+
+TMR_Status
+TMR_LLRP_setHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status)
+{
+  TMR_Status ret;
+  LLRP_tSMessage                          *pCmdMsg;
+  LLRP_tSMessage                          *pRspMsg;
+
+  ret = TMR_LLRP_msgSetHoldEventsAndReportsStatus(reader, status, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
   /**
    * Now the message is framed completely and send the message
    **/
@@ -10325,12 +12074,26 @@ TMR_LLRP_setHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status)
    * Done with the command, free the message
    * and check for message status
    **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+  TMR_LLRP_freeMessage(pCmdMsg);
   if (TMR_SUCCESS != ret)
   {
     return ret;
   }
 
+  return TMR_LLRP_handleSetReaderConfigResponse(reader, pRspMsg);
+}
+
+/**
+ * Check the status of a SET_READER_CONFIG_RESPONSE and free it
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ */
+TMR_Status
+TMR_LLRP_handleSetReaderConfigResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg)
+{
+  LLRP_tSSET_READER_CONFIG_RESPONSE       *pRsp;
+
   /**
    * Check response message status
    **/
@@ -10346,21 +12109,22 @@ TMR_LLRP_setHoldEventsAndReportsStatus(TMR_Reader *reader, llrp_u1_t status)
    **/
   TMR_LLRP_freeMessage(pRspMsg);
 
-  return ret;
+  return TMR_SUCCESS;
 }
 
 
+/**
+ * Build the SET_READER_CONFIG message asking for periodic keepalives
+ *
+ * @param reader Reader pointer
+ * @param[out] pCmdMsg The message, for the caller to free
+ */
 TMR_Status
-TMR_LLRP_setKeepAlive(TMR_Reader *reader)
+TMR_LLRP_msgSetKeepAlive(TMR_Reader *reader, LLRP_tSMessage **pCmdMsg)
 {
-  TMR_Status ret;
   LLRP_tSSET_READER_CONFIG                *pCmd;
-  LLRP_tSMessage                          *pCmdMsg;
-  LLRP_tSMessage                          *pRspMsg;
-  LLRP_tSSET_READER_CONFIG_RESPONSE       *pRsp;
   LLRP_tSKeepaliveSpec                    *pKeepAlive;
 
-  ret = TMR_SUCCESS;
   /**
    * Keep alive can be set through SET_READER_CONFIG
    * Initialize SET_READER_CONFIG
@@ -10376,7 +12140,23 @@ TMR_LLRP_setKeepAlive(TMR_Reader *reader)
   /* Add KeepaliveSpec to SET_READER_CONFIG*/
   LLRP_SET_READER_CONFIG_setKeepaliveSpec(pCmd, pKeepAlive);
 
-  pCmdMsg = &pCmd->hdr;
+  *pCmdMsg = &pCmd->hdr;
+  return TMR_SUCCESS;
+}
+
+TMR_Status
+TMR_LLRP_setKeepAlive(TMR_Reader *reader)
+{
+  TMR_Status ret;
+  LLRP_tSMessage                          *pCmdMsg;
+  LLRP_tSMessage                          *pRspMsg;
+
+  ret = TMR_LLRP_msgSetKeepAlive(reader, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
   /**
    * Now the message is framed completely and send the message
    **/
@@ -10385,27 +12165,18 @@ TMR_LLRP_setKeepAlive(TMR_Reader *reader)
    * Done with the command, free the message
    * and check for message status
    **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+  TMR_LLRP_freeMessage(pCmdMsg);
   if (TMR_SUCCESS != ret)
   {
     return ret;
   }
 
-  /**
-   * Check response message status
-   **/
-  pRsp = (LLRP_tSSET_READER_CONFIG_RESPONSE *) pRspMsg;
-  if (TMR_SUCCESS != TMR_LLRP_checkLLRPStatus(pRsp->pLLRPStatus)) 
-  {
-    TMR_LLRP_freeMessage(pRspMsg);
-    return TMR_ERROR_LLRP;
+  ret = TMR_LLRP_handleSetReaderConfigResponse(reader, pRspMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
   }
 
-  /**
-   * Done with the response, free the message
-   **/
-  TMR_LLRP_freeMessage(pRspMsg);
-
   /**
    * Start LLRP background receiver
    **/
@@ -10474,8 +12245,6 @@ TMR_Status
 TMR_LLRP_handleKeepAlive(TMR_Reader *reader, LLRP_tSMessage *pMsg)
 {
   TMR_Status ret;
-  LLRP_tSMessage                          *pCmdMsg;
-  LLRP_tSKEEPALIVE_ACK                    *pAck;
 
   ret = TMR_SUCCESS;
 
@@ -10488,26 +12257,208 @@ TMR_LLRP_handleKeepAlive(TMR_Reader *reader, LLRP_tSMessage *pMsg)
   /**
    * Send keep alive acknowledgement
    **/
-  pAck = LLRP_KEEPALIVE_ACK_construct();
-  pCmdMsg = &pAck->hdr;
-  /**
-   * Now the message is framed completely and send the message
-   **/
-  ret = TMR_LLRP_sendMessage(reader, pCmdMsg,
-                reader->u.llrpReader.transportTimeout);
+  ret = TMR_LLRP_sendEncoded(reader, &reader->u.llrpReader.keepAliveAck,
+                             &LLRP_tdKEEPALIVE_ACK,
+                             reader->u.llrpReader.transportTimeout);
   if (TMR_SUCCESS != ret)
   {
     return ret;
   }
 
-  /*
-   * Response is success, and done with the command
-   */
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pAck);
-
   return TMR_SUCCESS;
 }
 
+#if defined(WIN32) || defined(WINCE)
+/**
+ * Wait for a message from the reader. Windows has no wake descriptor,
+ * so the wait is cut to BACKGROUND_RECEIVER_LOOP_PERIOD and the caller
+ * sees control changes on its next pass.
+ *
+ * @param lr LLRP reader, or NULL
+ * @param pConn Connection to wait on, or NULL to just sleep
+ * @param timeoutMs Longest wait
+ * @return 1 when a message is ready, 0 when the wait timed out
+ */
+static int
+TMR_LLRP_waitReceiver(TMR_LLRP_LlrpReader *lr, LLRP_tSConnection *pConn, int timeoutMs)
+{
+  struct timeval tv;
+  fd_set set;
+
+  if (NULL == pConn)
+  {
+    tmr_sleep(timeoutMs);
+    return 0;
+  }
+  /* Frames already read ahead don't show up on the socket */
+  if (TMR_LLRP_HAS_BUFFERED_MESSAGE(pConn))
+  {
+    return 1;
+  }
+  if ((NULL != lr) && (BACKGROUND_RECEIVER_LOOP_PERIOD < timeoutMs))
+  {
+    timeoutMs = BACKGROUND_RECEIVER_LOOP_PERIOD;
+  }
+  FD_ZERO(&set);
+  FD_SET(pConn->fd, &set);
+  tv.tv_sec = timeoutMs / 1000;
+  tv.tv_usec = (timeoutMs % 1000) * 1000;
+  return (0 < select(-1, &set, NULL, NULL, &tv)) ? 1 : 0;
+}
+#else
+/**
+ * Open the descriptor that wakes the background receiver.
+ * Without one, the receiver falls back to polling the socket
+ * every BACKGROUND_RECEIVER_LOOP_PERIOD.
+ */
+static void
+TMR_LLRP_openBackgroundReceiverWake(TMR_LLRP_LlrpReader *lr)
+{
+#if defined(__linux__)
+  lr->receiverWake[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  lr->receiverWake[1] = lr->receiverWake[0];
+#else
+  if (0 != pipe(lr->receiverWake))
+  {
+    lr->receiverWake[0] = -1;
+    lr->receiverWake[1] = -1;
+    return;
+  }
+  fcntl(lr->receiverWake[0], F_SETFL, O_NONBLOCK);
+  fcntl(lr->receiverWake[1], F_SETFL, O_NONBLOCK);
+  fcntl(lr->receiverWake[0], F_SETFD, FD_CLOEXEC);
+  fcntl(lr->receiverWake[1], F_SETFD, FD_CLOEXEC);
+#endif
+}
+
+/**
+ * Wait for a message from the reader, or for the receiver to be woken.
+ *
+ * @param lr LLRP reader whose wake descriptor ends the wait, or NULL
+ * @param pConn Connection to wait on, or NULL to wait for a wake only
+ * @param timeoutMs Longest wait
+ * @return 1 when a message is ready, 0 when the wait timed out,
+ * -1 when the receiver was woken
+ */
+static int
+TMR_LLRP_waitReceiver(TMR_LLRP_LlrpReader *lr, LLRP_tSConnection *pConn, int timeoutMs)
+{
+  struct pollfd fds[2];
+  nfds_t nfds = 0;
+  int wakeIndex = -1;
+
+  /* Frames already read ahead don't show up on the socket */
+  if ((NULL != pConn) && TMR_LLRP_HAS_BUFFERED_MESSAGE(pConn))
+  {
+    return 1;
+  }
+  if (NULL != pConn)
+  {
+    fds[nfds].fd = pConn->fd;
+    fds[nfds].events = POLLIN;
+    nfds++;
+  }
+  if (NULL != lr)
+  {
+    if (-1 != lr->receiverWake[0])
+    {
+      wakeIndex = nfds;
+      fds[nfds].fd = lr->receiverWake[0];
+      fds[nfds].events = POLLIN;
+      nfds++;
+    }
+    else if (BACKGROUND_RECEIVER_LOOP_PERIOD < timeoutMs)
+    {
+      timeoutMs = BACKGROUND_RECEIVER_LOOP_PERIOD;
+    }
+  }
+
+  if (0 >= poll(fds, nfds, timeoutMs))
+  {
+    return 0;
+  }
+  if ((-1 != wakeIndex) && (0 != fds[wakeIndex].revents))
+  {
+    uint64_t count;
+
+    while (0 < read(lr->receiverWake[0], &count, sizeof(count)))
+    {
+    }
+    return -1;
+  }
+  return ((NULL != pConn) && (0 != fds[0].revents)) ? 1 : 0;
+}
+#endif
+
+/**
+ * Wake the background receiver if it is waiting on the socket,
+ * so that it sees a change to receiverEnabled or threadCancel.
+ */
+void
+TMR_LLRP_wakeBackgroundReceiver(TMR_Reader *reader)
+{
+#if !defined(WIN32) && !defined(WINCE)
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  uint64_t one = 1;
+
+  if (-1 != lr->receiverWake[1])
+  {
+    /* A full pipe or counter already has a wake pending */
+    if (write(lr->receiverWake[1], &one, sizeof(one)))
+    {
+    }
+  }
+#endif
+}
+
+/**
+ * Close the wake descriptor once the background receiver has exited.
+ */
+void
+TMR_LLRP_closeBackgroundReceiverWake(TMR_Reader *reader)
+{
+#if !defined(WIN32) && !defined(WINCE)
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+
+  if (-1 != lr->receiverWake[0])
+  {
+    close(lr->receiverWake[0]);
+  }
+  if ((-1 != lr->receiverWake[1]) && (lr->receiverWake[1] != lr->receiverWake[0]))
+  {
+    close(lr->receiverWake[1]);
+  }
+  lr->receiverWake[0] = -1;
+  lr->receiverWake[1] = -1;
+#endif
+}
+
+/**
+ * How long the background receiver may wait for a message before it
+ * next has to count a missed keepalive.
+ */
+static int
+TMR_LLRP_keepAliveWait(TMR_LLRP_LlrpReader *lr)
+{
+  uint64_t elapsed, deadline;
+
+  elapsed = tmr_gettime() - lr->ka_start;
+  if (lr->keepAliveAckMissCnt < MAX_KEEP_ALIVE_ACK_MISSES)
+  {
+    deadline = (uint64_t)TMR_LLRP_KEEP_ALIVE_TIMEOUT * (lr->keepAliveAckMissCnt + 1);
+  }
+  else
+  {
+    deadline = (uint64_t)TMR_LLRP_KEEP_ALIVE_TIMEOUT * 4;
+  }
+  if (elapsed > deadline)
+  {
+    return 0;
+  }
+  /* The miss is counted once the deadline has strictly passed */
+  return (int)(deadline - elapsed) + 1;
+}
+
 static void *
 llrp_receiver_thread(void *arg)
 {
@@ -10516,13 +12467,11 @@ llrp_receiver_thread(void *arg)
   TMR_LLRP_LlrpReader *lr;
   LLRP_tSMessage *pMsg;
   LLRP_tSConnection *pConn;
-  struct timeval tv;
-  fd_set set;
   bool ka_start_flag = true;
   bool receive_failed = false;
-  static bool mutex_lock_enabled = false;
+  bool continuous;
+  int ready;
 
-  ret = TMR_SUCCESS;
   reader = arg;
   lr = &reader->u.llrpReader;
 
@@ -10532,6 +12481,7 @@ llrp_receiver_thread(void *arg)
    **/
   while (true)
   {
+    receive_failed = false;
     pConn = reader->u.llrpReader.pConn;
     if (NULL != pConn)
     {
@@ -10541,29 +12491,39 @@ llrp_receiver_thread(void *arg)
       while (false == lr->receiverEnabled)
       {
         pthread_cond_wait(&lr->receiverCond, &lr->receiverLock);
+        /* Keepalives are not watched while disabled */
+        ka_start_flag = true;
       }
     
       lr->receiverRunning = true;
       pthread_mutex_unlock(&lr->receiverLock);
 
-      FD_ZERO(&set);
-      FD_SET(pConn->fd, &set);
-      tv.tv_sec = 0;
-      tv.tv_usec = BACKGROUND_RECEIVER_LOOP_PERIOD * 1000;
-	  {
-#if defined(WIN32)|| defined(WINCE)
-        int nfds = -1;
-#else
-        int nfds = pConn->fd + 1;
-#endif
-        ret = select(nfds, &set, NULL, NULL, &tv);
-	  }
-      if (0 < ret)
+      if (ka_start_flag)
+      {
+        lr->ka_start = tmr_gettime();
+        pthread_mutex_lock(&lr->receiverLock);
+        lr->keepAliveAckMissCnt = 0;
+        pthread_mutex_unlock(&lr->receiverLock);
+        ka_start_flag = false;
+      }
+
+      /**
+       * Sleep until a message arrives, the receiver is woken to be
+       * disabled or stopped, or a keepalive falls due.
+       **/
+      ready = TMR_LLRP_waitReceiver(lr, pConn, TMR_LLRP_keepAliveWait(lr));
+      if (0 < ready)
       {
-        if(true == reader->continuousReading)
+        continuous = reader->continuousReading;
+        if (true == continuous)
         {
-          pthread_mutex_lock(&reader->u.llrpReader.receiverLock);
-          mutex_lock_enabled = true;
+          pthread_mutex_lock(&lr->receiverLock);
+          /* A command may have taken the message while we waited for the lock */
+          if (0 >= TMR_LLRP_waitReceiver(NULL, pConn, 0))
+          {
+            pthread_mutex_unlock(&lr->receiverLock);
+            goto next;
+          }
         }
         /* check for new message in Inbox */
         ret = TMR_LLRP_receiveMessage(reader, &pMsg, lr->transportTimeout);
@@ -10572,35 +12532,35 @@ llrp_receiver_thread(void *arg)
           /**
            * If not success, then could be that no message
            * has been arrived yet, lets wait for some more time.
-           * Do nothing here
            **/
           receive_failed = true;
-          if(true == mutex_lock_enabled)
+          if (true == continuous)
           {
-            pthread_mutex_unlock(&reader->u.llrpReader.receiverLock);
-            mutex_lock_enabled = false;
+            pthread_mutex_unlock(&lr->receiverLock);
           }
+          /* Don't spin on a socket that stays readable but yields nothing */
+          TMR_LLRP_waitReceiver(lr, NULL, BACKGROUND_RECEIVER_LOOP_PERIOD);
         }
         else
         {
           /**
            * Ahaa!! New message has arrived
            * process received Message.
+           * Queuing a report can wait for the parser thread, so
+           * receiverLock goes first; commands need not wait too.
            **/
-          ret = TMR_LLRP_processReceivedMessage(reader, pMsg);
-          ka_start_flag = true;
-          receive_failed = false;
-          if((true == reader->continuousReading) || (true == mutex_lock_enabled))
+          if (true == continuous)
           {
-            pthread_mutex_unlock(&reader->u.llrpReader.receiverLock);
-            mutex_lock_enabled = false;
+            pthread_mutex_unlock(&lr->receiverLock);
           }
+          TMR_LLRP_processReceivedMessage(reader, pMsg);
+          ka_start_flag = true;
         }
       }
-      else
+      else if (0 == ready)
       {
         /**
-         * The select call returns 0. Could be that there is no data
+         * The wait timed out. Could be that there is no data
          * to read because of connection problem.
          **/
         receive_failed = true;
@@ -10616,7 +12576,7 @@ llrp_receiver_thread(void *arg)
     if(true == receive_failed)
     {
       /**
-       * The select call has failed. Could be that there is no data
+       * The wait has failed. Could be that there is no data
        * to read because of connection problem. Wait to see if
        * the connection recovers back.
        **/
@@ -10667,6 +12627,7 @@ llrp_receiver_thread(void *arg)
       }
     }
 
+next:
     if (true == reader->u.llrpReader.threadCancel)
     {
       /** Time to exit */
@@ -10676,6 +12637,69 @@ llrp_receiver_thread(void *arg)
   return NULL;
 }
 
+/**
+ * Make room for at least count message pointers in bufResponse.
+ * The array doubles whenever it fills up, so buffering n reports
+ * copies O(n) pointers in all, and it is kept for later reads.
+ *
+ * @param reader Reader pointer
+ * @param count Number of entries needed
+ */
+TMR_Status
+TMR_LLRP_reserveResponses(TMR_Reader *reader, uint32_t count)
+{
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  LLRP_tSMessage **newResponse;
+  uint32_t capacity;
+
+  if (NULL == lr->bufResponse)
+  {
+    lr->bufCapacity = 0;
+  }
+  if (count <= lr->bufCapacity)
+  {
+    return TMR_SUCCESS;
+  }
+
+  capacity = (0 == lr->bufCapacity) ? TMR_LLRP_MIN_RESPONSES : lr->bufCapacity;
+  while (capacity < count)
+  {
+    capacity *= 2;
+  }
+  newResponse = realloc(lr->bufResponse, capacity * sizeof(lr->bufResponse[0]));
+  if (NULL == newResponse)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  lr->bufResponse = newResponse;
+  lr->bufCapacity = capacity;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Free the messages buffered in bufResponse and start it over
+ * empty. The array itself is kept.
+ *
+ * @param reader Reader pointer
+ */
+void
+TMR_LLRP_releaseResponses(TMR_Reader *reader)
+{
+  TMR_LLRP_LlrpReader *lr = &reader->u.llrpReader;
+  uint32_t i;
+
+  if (NULL != lr->bufResponse)
+  {
+    for (i = 0; i < lr->bufPointer; i++)
+    {
+      TMR_LLRP_freeMessage(lr->bufResponse[i]);
+      lr->bufResponse[i] = NULL;
+    }
+  }
+  lr->bufPointer = 0;
+  lr->bufIndex = 0;
+}
+
 TMR_Status
 TMR_LLRP_processReceivedMessage(TMR_Reader *reader, LLRP_tSMessage *pMsg)
 {
@@ -10705,47 +12729,43 @@ TMR_LLRP_processReceivedMessage(TMR_Reader *reader, LLRP_tSMessage *pMsg)
      * We receive RO_ACCESS_REPORTS here only incase of sync read.
      * Buffer the message pointer, so that it can be used later.
      **/
+    if (reader->continuousReading)
+    {
+      LLRP_tSParameter *pFirst = pMsg->elementHdr.listAllSubParameters;
+
+      /**
+       * Queued straight from here, leaving bufResponse to the
+       * thread in TMR_LLRP_hasMoreTags(), as this may run outside
+       * receiverLock. A report led by RFSurveyReportData is stats.
+       **/
+      return process_async_llrp_response(reader, pMsg,
+               (NULL != pFirst) && (&LLRP_tdRFSurveyReportData == pFirst->elementHdr.pType));
+    }
     if (NULL == lr->bufResponse)
     {
-      /* We haven't had opportunity to allocate the buffer yet, so allocate the
-       * first
-       */
-      lr->bufResponse = (LLRP_tSMessage **) malloc( 1 * sizeof(LLRP_tSMessage *));
+      /* We haven't had opportunity to allocate the buffer yet */
       lr->bufPointer = 0;
     }
-    lr->bufResponse[lr->bufPointer ] = pMsg;
 
     /**
-     * Reallocate the memory for bufResponse, so that it can hold the
-     * pointer to next RO_ACCESS_REPORT in case if it is received.
+     * Keep room for this report and the next one, as
+     * TMR_LLRP_getNextTag() looks at bufResponse[bufIndex] even
+     * when bufIndex has caught up with bufPointer.
      **/
+    ret = TMR_LLRP_reserveResponses(reader, lr->bufPointer + 2);
+    if (TMR_SUCCESS != ret)
     {
-      LLRP_tSMessage **newResponse;
-
-      newResponse = realloc(lr->bufResponse, (lr->bufPointer + 2) * sizeof(lr->bufResponse[0]));
-      if (NULL == newResponse)
-      {
-        /**
-         * FIXME: How to handle this error. This would'nt happen
-         * in general, but can expect when running on reader.
-         * How to handle this.
-         **/
-      }
-      lr->bufResponse = newResponse;
+      /* Nowhere to keep the report, it is lost */
+      TMR_LLRP_freeMessage(pMsg);
+      return ret;
     }
+    lr->bufResponse[lr->bufPointer] = pMsg;
 
-    if(reader->continuousReading)
-    {
-       process_async_response(reader);
-    }
     /**
      * Do not free pMsg here. We hold that memory for further
      * processing of tagReads, and will be freed later.
      **/
-    else
-    {
-        lr->bufPointer += 1;
-    }
+    lr->bufPointer += 1;
   }
 
   /**
@@ -10788,6 +12808,7 @@ TMR_LLRP_setBackgroundReceiverState(TMR_Reader *reader, bool state)
        **/
       pthread_mutex_lock(&reader->u.llrpReader.receiverLock);
       reader->u.llrpReader.receiverEnabled = false;
+      TMR_LLRP_wakeBackgroundReceiver(reader);
       while (true == reader->u.llrpReader.receiverRunning)
       {
         pthread_cond_wait(&reader->u.llrpReader.receiverCond, &reader->u.llrpReader.receiverLock);
@@ -10818,6 +12839,12 @@ TMR_LLRP_startBackgroundReceiver(TMR_Reader *reader)
   /* Initialize background llrp receiver */
   pthread_mutex_lock(&lr->receiverLock);
 
+#if !defined(WIN32) && !defined(WINCE)
+  if (-1 == lr->receiverWake[0])
+  {
+    TMR_LLRP_openBackgroundReceiverWake(lr);
+  }
+#endif
   ret = pthread_create(&lr->llrpReceiver, NULL,
                       llrp_receiver_thread, reader);
   if (0 != ret)
@@ -13901,7 +15928,7 @@ PREPARE_COMMAND:
 }
 
 /**
- * Command to Add an AccessSpec
+ * Build the ADD_ACCESSSPEC message for an AccessSpec
  *
  * @param reader Reader pointer
  * @param protocol Protocol to be used
@@ -13911,20 +15938,19 @@ PREPARE_COMMAND:
  * @param isStandalone Boolean variable to indicate whether a standalone
  *        or embedded operation.
  *        true = standalone operation, false = embedded operation.
+ * @param[out] pCmdMsg The message, for the caller to free
  */ 
 TMR_Status
-TMR_LLRP_cmdAddAccessSpec(TMR_Reader *reader, 
+TMR_LLRP_msgAddAccessSpec(TMR_Reader *reader, 
                           TMR_TagProtocol protocol,
                           TMR_TagFilter *filter,
                           llrp_u32_t roSpecId,
                           TMR_TagOp *tagop,
-                          bool isStandalone)
+                          bool isStandalone,
+                          LLRP_tSMessage **pCmdMsg)
 {
   TMR_Status ret;
   LLRP_tSADD_ACCESSSPEC               *pCmd;
-  LLRP_tSMessage                      *pCmdMsg;
-  LLRP_tSMessage                      *pRspMsg;
-  LLRP_tSADD_ACCESSSPEC_RESPONSE      *pRsp;
 
   LLRP_tSAccessSpec                   *pAccessSpec;
   LLRP_tSAccessSpecStopTrigger        *pAccessSpecStopTrigger;
@@ -14099,7 +16125,41 @@ TMR_LLRP_cmdAddAccessSpec(TMR_Reader *reader,
   /* Now AccessSpec is fully framed, add to ADD_ACCESSSPEC message */
   LLRP_ADD_ACCESSSPEC_setAccessSpec(pCmd, pAccessSpec);
 
-  pCmdMsg = &pCmd->hdr;
+  *pCmdMsg = &pCmd->hdr;
+  return ret;
+}
+
+/**
+ * Command to Add an AccessSpec
+ *
+ * @param reader Reader pointer
+ * @param protocol Protocol to be used
+ * @param filter Pointer to Tag filter
+ * @param roSpecId ROSpecID with which this AccessSpec need to be associated
+ * @param tagop Pointer to TMR_TagOp
+ * @param isStandalone Boolean variable to indicate whether a standalone
+ *        or embedded operation.
+ *        true = standalone operation, false = embedded operation.
+ */ 
+TMR_Status
+TMR_LLRP_cmdAddAccessSpec(TMR_Reader *reader, 
+                          TMR_TagProtocol protocol,
+                          TMR_TagFilter *filter,
+                          llrp_u32_t roSpecId,
+                          TMR_TagOp *tagop,
+                          bool isStandalone)
+{
+  TMR_Status ret;
+  LLRP_tSMessage                      *pCmdMsg;
+  LLRP_tSMessage                      *pRspMsg;
+
+  ret = TMR_LLRP_msgAddAccessSpec(reader, protocol, filter, roSpecId,
+                                  tagop, isStandalone, &pCmdMsg);
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
+  }
+
   /**
    * Now the message is framed completely and send the message
    **/
@@ -14109,17 +16169,50 @@ TMR_LLRP_cmdAddAccessSpec(TMR_Reader *reader,
    * Done with the command, free the message
    * and check for message status
    **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+  TMR_LLRP_freeMessage(pCmdMsg);
   if (TMR_SUCCESS != ret)
   {
     return ret;
   }
 
+  return TMR_LLRP_handleTagOpSpecResponse(reader, pRspMsg);
+}
+
+/**
+ * Check the status of the response to an ADD_ACCESSSPEC,
+ * ENABLE_ACCESSSPEC or START_ROSPEC, the commands that set off a
+ * tag operation, and free it
+ *
+ * @param reader Reader pointer
+ * @param pRspMsg The response
+ */
+TMR_Status
+TMR_LLRP_handleTagOpSpecResponse(TMR_Reader *reader, LLRP_tSMessage *pRspMsg)
+{
+  LLRP_tSLLRPStatus *pLLRPStatus;
+
+  if (&LLRP_tdADD_ACCESSSPEC_RESPONSE == pRspMsg->elementHdr.pType)
+  {
+    pLLRPStatus = ((LLRP_tSADD_ACCESSSPEC_RESPONSE *)pRspMsg)->pLLRPStatus;
+  }
+  else if (&LLRP_tdENABLE_ACCESSSPEC_RESPONSE == pRspMsg->elementHdr.pType)
+  {
+    pLLRPStatus = ((LLRP_tSENABLE_ACCESSSPEC_RESPONSE *)pRspMsg)->pLLRPStatus;
+  }
+  else if (&LLRP_tdSTART_ROSPEC_RESPONSE == pRspMsg->elementHdr.pType)
+  {
+    pLLRPStatus = ((LLRP_tSSTART_ROSPEC_RESPONSE *)pRspMsg)->pLLRPStatus;
+  }
+  else
+  {
+    pLLRPStatus = NULL;
+  }
+
   /**
    * Check response message status
    **/
-  pRsp = (LLRP_tSADD_ACCESSSPEC_RESPONSE *) pRspMsg;
-  if (TMR_SUCCESS != TMR_LLRP_checkLLRPStatus(pRsp->pLLRPStatus))  
+  if ((NULL == pLLRPStatus) ||
+      (TMR_SUCCESS != TMR_LLRP_checkLLRPStatus(pLLRPStatus)))
   {
     TMR_LLRP_freeMessage(pRspMsg);
     return TMR_ERROR_LLRP; 
@@ -14130,7 +16223,7 @@ TMR_LLRP_cmdAddAccessSpec(TMR_Reader *reader,
    **/
   TMR_LLRP_freeMessage(pRspMsg);
 
-  return ret;
+  return TMR_SUCCESS;
 }
 
 /**
@@ -15277,29 +17370,17 @@ TMR_Status
 TMR_LLRP_cmdGetReport(TMR_Reader *reader)
 {
   TMR_Status ret;
-  LLRP_tSGET_REPORT *pCmd;
-  LLRP_tSMessage    *pCmdMsg;
 
   ret = TMR_SUCCESS;
 
-  /**
-   * Initialize GET_REPORT message
-   **/
-  pCmd = LLRP_GET_REPORT_construct();
-  pCmdMsg = &pCmd->hdr;
- 
   /**
    * Response to GET_REPORT message will be RO_ACCESS_REPORTs,
    * which needs to be processed in other place.
    * Here we just send the message.
    **/
-  ret = TMR_LLRP_sendMessage(reader, pCmdMsg, 
-          reader->u.llrpReader.transportTimeout);
-  /**
-   * Done with the command, free the message
-   * and check for message status
-   **/ 
-  TMR_LLRP_freeMessage((LLRP_tSMessage *)pCmd);
+  ret = TMR_LLRP_sendEncoded(reader, &reader->u.llrpReader.getReport,
+                             &LLRP_tdGET_REPORT,
+                             reader->u.llrpReader.transportTimeout);
   if (TMR_SUCCESS != ret)
   {
     return ret;
@@ -144,3 +144,32 @@ deviceDetection: ../samples/deviceDetection.o $(LIB)
 ../samples/passThrough.o: $(HEADERS) $(LIB)
 passThrough: ../samples/passThrough.o $(LIB)
 	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS)	
+
+../samples/capturedecode.o: $(HEADERS) $(LIB)
+capturedecode: ../samples/capturedecode.o $(LIB)
+	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS)
+
+../samples/transportbench.o: $(HEADERS) $(LIB)
+transportbench: ../samples/transportbench.o $(LIB)
+	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS) \
+	  -Wl,--wrap=read,--wrap=write,--wrap=poll,--wrap=recv,--wrap=sendmsg,--wrap=syscall
+
+../samples/simread.o: $(HEADERS) $(LIB)
+simread: ../samples/simread.o $(LIB)
+	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS)
+
+../samples/replaybench.o: $(HEADERS) $(LIB)
+replaybench: ../samples/replaybench.o $(LIB)
+	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS)
+
+../samples/llrpdecodebench.o: $(HEADERS) $(LIB)
+llrpdecodebench: ../samples/llrpdecodebench.o $(LIB)
+	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS) -Wl,--wrap=malloc
+
+../samples/llrpfielddecodebench.o: $(HEADERS) $(LIB)
+llrpfielddecodebench: ../samples/llrpfielddecodebench.o $(LIB)
+	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS)
+
+../samples/llrpreportbench.o: $(HEADERS) $(LIB)
+llrpreportbench: ../samples/llrpreportbench.o $(LIB)
+	$(CC) $(CFLAGS) -o $@ $^ -lpthread $(LTKC_LIBS)
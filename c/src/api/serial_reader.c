@@ -278,6 +278,7 @@ TMR_SR_getVersion(TMR_Reader* reader)
     }
   }
 
+  reader->u.serialReader.pushbackLen = 0;
   ret = transport->flush(transport);
   if ((TMR_SUCCESS != ret) && (TMR_ERROR_UNIMPLEMENTED != ret))
   {
@@ -389,6 +390,7 @@ TMR_SR_cmdProbeBaudRate(TMR_Reader *reader, uint32_t *currentBaudRate)
       }
     }
 
+    reader->u.serialReader.pushbackLen = 0;
     ret = transport->flush(transport);
     if ((TMR_SUCCESS != ret) && (TMR_ERROR_UNIMPLEMENTED != ret))
     {
@@ -561,6 +563,11 @@ TMR_SR_destroy(TMR_Reader *reader)
   cleanup_background_threads(reader);
 #endif
 
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  /* Only now that no thread can be in the transport any more */
+  TMR_stopTransportCapture(reader);
+#endif
+
   return TMR_SUCCESS;
 }
 
@@ -5076,6 +5083,10 @@ TMR_SR_SerialReader_init(TMR_Reader *reader)
   reader->u.serialReader.powerMode = TMR_SR_POWER_MODE_INVALID;
   reader->u.serialReader.transportTimeout = 5000;
   reader->u.serialReader.commandTimeout = 1000;
+  reader->u.serialReader.consecutiveFailures = 0;
+  reader->u.serialReader.pendingRecovery = NULL;
+  reader->u.serialReader.pushbackLen = 0;
+  memset(&reader->u.serialReader.recoveryStats, 0, sizeof(reader->u.serialReader.recoveryStats));
   reader->u.serialReader.regionId = TMR_REGION_NONE;
   reader->u.serialReader.tagsRemaining = 0;
   reader->u.serialReader.tagsRemainingInBuffer = 0;
@@ -5083,6 +5094,8 @@ TMR_SR_SerialReader_init(TMR_Reader *reader)
 #ifdef TMR_ENABLE_UHF
 #if TMR_ENABLE_WAKE_PREAMBLES
   reader->u.serialReader.supportsPreamble = false;
+  reader->u.serialReader.lastTrafficTime = 0;
+  memset(&reader->u.serialReader.preambleStats, 0, sizeof(reader->u.serialReader.preambleStats));
 #endif /* TMR_ENABLE_WAKE_PREAMBLES */
   reader->u.serialReader.extendedEPC = false;
   reader->u.serialReader.gen2AccessPassword = 0;
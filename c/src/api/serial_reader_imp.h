@@ -227,12 +227,15 @@ typedef enum TMR_SR_EndOfSelect
 }TMR_SR_EndOfSelect;
 #endif /* TMR_ENABLE_UHF */
 
+uint16_t tm_crc(uint8_t *u8Buf, uint8_t len);
+uint8_t parseEBVdata(uint8_t* msg, uint8_t *ebvValue, uint8_t *idx);
 TMR_Status TMR_SR_sendTimeout(TMR_Reader *reader, uint8_t *data,
                               uint32_t timeoutMs);
 TMR_Status TMR_SR_send(TMR_Reader *reader, uint8_t *data);
 TMR_Status TMR_SR_sendCmd(TMR_Reader *reader, uint8_t *data, uint8_t i);
 TMR_Status TMR_SR_sendMessage(TMR_Reader *reader, uint8_t *data,
                               uint8_t *opcode, uint32_t timeoutMs);
+TMR_Status TMR_SR_recoverTransport(TMR_Reader *reader, TMR_Status error);
 TMR_Status TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data,
                                  uint8_t opcode, uint32_t timeoutMs);
 TMR_Status TMR_SR_receiveAutonomousReading(struct TMR_Reader *reader, TMR_TagReadData *trd, TMR_Reader_StatsValues *stats);
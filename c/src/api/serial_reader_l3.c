@@ -94,7 +94,7 @@ static uint16_t crctable[] =
   0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
 };
 
-static uint16_t
+uint16_t
 tm_crc(uint8_t *u8Buf, uint8_t len)
 {
   uint16_t crc;
@@ -144,10 +144,16 @@ TMR_SR_sendBytes(TMR_Reader *reader, uint8_t len, uint8_t *data, uint32_t timeou
 
   transport = &reader->u.serialReader.transport;
 
-  if (NULL != reader->transportListeners)
+  if (TMR__hasTransportListeners(reader))
   {
     TMR__notifyTransportListeners(reader, true, len, data, timeoutMs);
   }
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  if (NULL != reader->transportCapture)
+  {
+    TMR__captureTransportFrame(reader, true, TMR_CAPTURE_PROTOCOL_EAPI, len, data);
+  }
+#endif
 
   ret = transport->sendBytes(transport, len, data, timeoutMs);
   return ret;
@@ -179,6 +185,7 @@ TMR_flush(struct TMR_Reader* rp)
   }
 
   /* Flush the host driver buffer. */
+  rp->u.serialReader.pushbackLen = 0;
   if (NULL != transport->flush)
   {
     ret = transport->flush(transport);
@@ -191,6 +198,409 @@ TMR_flush(struct TMR_Reader* rp)
   return ret;
 }
 
+/**
+ * Note a receive error and start timing its recovery.
+ *
+ * @param sr The serial reader
+ * @param counters The counters of the error class
+ */
+static void
+TMR_SR_startRecovery(TMR_SR_SerialReader *sr, TMR_SR_RecoveryCounters *counters)
+{
+  counters->errors++;
+  if (NULL == sr->pendingRecovery)
+  {
+    sr->pendingRecovery = counters;
+    sr->recoveryStartTime = tmr_gettime();
+  }
+}
+
+/**
+ * A valid frame was received; account the time since the first
+ * unrecovered error, if any.
+ *
+ * @param sr The serial reader
+ */
+static void
+TMR_SR_endRecovery(TMR_SR_SerialReader *sr)
+{
+  uint32_t elapsed;
+
+  sr->consecutiveFailures = 0;
+  if (NULL != sr->pendingRecovery)
+  {
+    elapsed = (uint32_t)(tmr_gettime() - sr->recoveryStartTime);
+    sr->pendingRecovery->totalMs += elapsed;
+    if (elapsed > sr->pendingRecovery->maxMs)
+    {
+      sr->pendingRecovery->maxMs = elapsed;
+    }
+    sr->pendingRecovery = NULL;
+  }
+}
+
+/**
+ * Recover the transport after a receive error.
+ *
+ * Stale input is discarded so that the next receive starts on a frame
+ * boundary. Only after TMR_SR_FULL_FLUSH_THRESHOLD consecutive failures
+ * is the slow TMR_flush() used to flush the module side as well.
+ *
+ * @param reader The reader
+ * @param error The error that was returned by the receive
+ */
+TMR_Status
+TMR_SR_recoverTransport(TMR_Reader *reader, TMR_Status error)
+{
+  TMR_SR_SerialReader *sr = &reader->u.serialReader;
+
+  sr->pushbackLen = 0;
+  if (++sr->consecutiveFailures < TMR_SR_FULL_FLUSH_THRESHOLD)
+  {
+    return sr->transport.flush(&sr->transport);
+  }
+
+  sr->consecutiveFailures = 0;
+  if (TMR_ERROR_CRC_ERROR == error)
+  {
+    sr->recoveryStats.crc.fullFlushes++;
+  }
+  else
+  {
+    sr->recoveryStats.timeout.fullFlushes++;
+  }
+  return TMR_flush(reader);
+}
+
+TMR_Status
+TMR_SR_getRecoveryStats(struct TMR_Reader *reader, TMR_SR_RecoveryStats *stats)
+{
+  if ((NULL == reader) || (NULL == stats) || (TMR_READER_TYPE_SERIAL != reader->readerType))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  *stats = reader->u.serialReader.recoveryStats;
+  return TMR_SUCCESS;
+}
+
+/**
+ * Receive bytes, first from the bytes pushed back by a resynchronisation,
+ * then from the transport.
+ *
+ * @param reader The reader
+ * @param length Number of bytes to receive.
+ * @param[out] messageLength Number of bytes received.
+ * @param message Buffer for the bytes.
+ * @param timeoutMs Timeout value.
+ * @param[in,out] pushedBack Incremented by the number of bytes taken
+ *  from the pushback, which come before those from the transport.
+ */
+static TMR_Status
+TMR_SR_receiveBytes(TMR_Reader *reader, uint32_t length, uint32_t *messageLength,
+                    uint8_t *message, uint32_t timeoutMs, uint32_t *pushedBack)
+{
+  TMR_SR_SerialReader *sr = &reader->u.serialReader;
+  TMR_SR_SerialTransport *transport = &sr->transport;
+  uint32_t taken, got;
+  TMR_Status ret;
+
+  taken = (length < sr->pushbackLen) ? length : sr->pushbackLen;
+  if (0 < taken)
+  {
+    memcpy(message, sr->pushback, taken);
+    sr->pushbackLen -= (uint16_t)taken;
+    memmove(sr->pushback, sr->pushback + taken, sr->pushbackLen);
+    *pushedBack += taken;
+  }
+  *messageLength = taken;
+  if (taken == length)
+  {
+    return TMR_SUCCESS;
+  }
+
+  got = 0;
+  ret = transport->receiveBytes(transport, length - taken, &got, message + taken, timeoutMs);
+  *messageLength += got;
+  return ret;
+}
+
+/**
+ * Hand bytes received from the transport to the transport listeners
+ * and the capture.
+ *
+ * @param reader The reader
+ * @param length Number of bytes.
+ * @param data The bytes.
+ * @param timeoutMs Timeout value.
+ */
+static void
+TMR_SR_reportReceived(TMR_Reader *reader, uint32_t length, uint8_t *data, uint32_t timeoutMs)
+{
+  if (0 == length)
+  {
+    return;
+  }
+  if (TMR__hasTransportListeners(reader))
+  {
+    TMR__notifyTransportListeners(reader, false, length, data, timeoutMs);
+  }
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  if (NULL != reader->transportCapture)
+  {
+    TMR__captureTransportFrame(reader, false, TMR_CAPTURE_PROTOCOL_EAPI,
+                               length, data);
+  }
+#endif
+}
+
+/**
+ * Receive more bytes for TMR_SR_resyncFrame() and report those that
+ * came from the transport; the ones from the pushback were reported
+ * when they were first read.
+ */
+static TMR_Status
+TMR_SR_resyncReceive(TMR_Reader *reader, uint32_t length, uint32_t *messageLength,
+                     uint8_t *message, uint32_t timeoutMs)
+{
+  uint32_t pushedBack = 0;
+  TMR_Status ret;
+
+  ret = TMR_SR_receiveBytes(reader, length, messageLength, message, timeoutMs, &pushedBack);
+  TMR_SR_reportReceived(reader, *messageLength - pushedBack, message + pushedBack, timeoutMs);
+  return ret;
+}
+
+/**
+ * Find the next valid frame after a CRC error.
+ *
+ * The bytes of the corrupt frame usually contain the start of the
+ * next one (a dropped byte makes the length field swallow it), so scan
+ * them for the next SOH with a plausible length and opcode, complete
+ * that frame from the transport and check its CRC. Gives up once
+ * TMR_SR_RESYNC_MAX_BYTES have been skipped or the buffered bytes hold
+ * no further SOH, leaving a full flush to the caller.
+ *
+ * The bytes past the recovered frame belong to the frames after it, so
+ * they are pushed back for the next receive.
+ *
+ * @param reader The reader
+ * @param data Buffer holding the corrupt frame; receives the recovered frame.
+ * @param have Number of bytes in data.
+ * @param opcode Opcode the response must match.
+ * @param timeoutMs Timeout value.
+ */
+static TMR_Status
+TMR_SR_resyncFrame(TMR_Reader *reader, uint8_t *data, uint32_t have,
+                   uint8_t opcode, uint32_t timeoutMs)
+{
+  TMR_SR_SerialReader *sr = &reader->u.serialReader;
+  uint32_t skipped = 0;
+  uint32_t i, need, got;
+  uint16_t crc;
+  TMR_Status ret;
+
+  while (skipped < TMR_SR_RESYNC_MAX_BYTES)
+  {
+    /* Skip the current SOH and look for the next plausible header */
+    for (i = 1; i < have; i++)
+    {
+      if ((0xFF == data[i]) &&
+          (((i + 1) >= have) || (data[i + 1] <= 0xF8)) &&
+          (((i + 2) >= have) || (data[i + 2] == opcode) ||
+           (data[i + 2] == 0x22) || (data[i + 2] == 0x2F)))
+      {
+        break;
+      }
+    }
+    if (i >= have)
+    {
+      return TMR_ERROR_CRC_ERROR;
+    }
+    skipped += i;
+    have -= i;
+    memmove(data, data + i, have);
+
+    /* Complete the header, then the body */
+    if (have < 7)
+    {
+      ret = TMR_SR_resyncReceive(reader, 7 - have, &got, data + have, timeoutMs);
+      have += got;
+      if (TMR_SUCCESS != ret)
+      {
+        return ret;
+      }
+    }
+    need = data[1] + 7;
+    if (need > TMR_SR_MAX_PACKET_SIZE)
+    {
+      continue;
+    }
+    if (have < need)
+    {
+      ret = TMR_SR_resyncReceive(reader, need - have, &got, data + have, timeoutMs);
+      have += got;
+      if (TMR_SUCCESS != ret)
+      {
+        return ret;
+      }
+    }
+
+    crc = tm_crc(&data[1], data[1] + 4);
+    if ((data[need - 2] == (crc >> 8)) && (data[need - 1] == (crc & 0xff)))
+    {
+      /*
+       * Bytes are only taken from the transport once the pushback is
+       * empty, so the leftover goes in front of whatever is still in it
+       * and the two always fit.
+       */
+      memmove(sr->pushback + (have - need), sr->pushback, sr->pushbackLen);
+      memcpy(sr->pushback, data + need, have - need);
+      sr->pushbackLen += (uint16_t)(have - need);
+      return TMR_SUCCESS;
+    }
+  }
+
+  return TMR_ERROR_CRC_ERROR;
+}
+
+#ifdef TMR_ENABLE_UHF
+#if TMR_ENABLE_WAKE_PREAMBLES
+/**
+ * Ask the module for its power mode with a short timeout. Used when
+ * the power mode is not cached yet, to find out whether the module is
+ * awake without paying for a full wake-up preamble.
+ *
+ * It runs in the middle of TMR_SR_sendMessage(), so the frame is built
+ * here and goes straight to TMR_SR_sendBytes(); going through
+ * TMR_SR_sendMessage() again would reset the length check of the
+ * command being sent.
+ *
+ * @param reader The reader
+ */
+static TMR_Status
+TMR_SR_probePowerMode(TMR_Reader *reader)
+{
+  TMR_SR_SerialReader *sr = &reader->u.serialReader;
+  uint8_t msg[TMR_SR_MAX_PACKET_SIZE];
+  uint32_t transportTimeout;
+  uint16_t crc;
+  uint8_t i;
+  TMR_Status ret;
+
+  /* FF 00 68 CRCHI CRCLO */
+  i = 2;
+  SETU8(msg, i, TMR_SR_OPCODE_GET_POWER_MODE);
+  msg[0] = 0xff;
+  msg[1] = i - 3;
+  crc = tm_crc(&msg[1], 2);
+  msg[3] = crc >> 8;
+  msg[4] = crc & 0xff;
+
+  /* The probe must not inherit the (long) transport timeout */
+  transportTimeout = sr->transportTimeout;
+  sr->transportTimeout = 0;
+  sr->preambleStats.probes++;
+
+  ret = TMR_SR_sendBytes(reader, 5, msg, TMR_SR_WAKE_PROBE_TIMEOUT_MS);
+  if (TMR_SUCCESS == ret)
+  {
+    ret = TMR_SR_receiveMessage(reader, msg, TMR_SR_OPCODE_GET_POWER_MODE,
+                                TMR_SR_WAKE_PROBE_TIMEOUT_MS);
+  }
+
+  sr->transportTimeout = transportTimeout;
+
+  if (TMR_SUCCESS == ret)
+  {
+    sr->powerMode = (TMR_SR_PowerMode)GETU8AT(msg, 5);
+  }
+  return ret;
+}
+
+/**
+ * Wake up the module before a command, sending only as much preamble
+ * as needed.
+ *
+ * A module that responded within the last TMR_SR_WAKE_IDLE_MS is still
+ * awake and needs nothing. A module whose power mode is not known yet
+ * gets a single preamble block and a short power mode probe; only if
+ * the probe fails, or the module is known to be in sleep mode and has
+ * been idle, is the full preamble sent.
+ *
+ * @param reader The reader
+ * @param timeoutMs Timeout value.
+ */
+static void
+TMR_SR_wakeModule(TMR_Reader *reader, uint32_t timeoutMs)
+{
+  TMR_SR_SerialReader *sr = &reader->u.serialReader;
+  uint8_t flushBytes[] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+  uint64_t start;
+  uint32_t blocksSent;
+
+  if (false == sr->supportsPreamble)
+  {
+    return;
+  }
+  if ((sr->powerMode != TMR_SR_POWER_MODE_INVALID) &&
+      (sr->powerMode != TMR_SR_POWER_MODE_SLEEP))
+  {
+    return;
+  }
+
+  start = tmr_gettime();
+  if ((0 != sr->lastTrafficTime) && ((start - sr->lastTrafficTime) < TMR_SR_WAKE_IDLE_MS))
+  {
+    return;
+  }
+
+  if ((sr->powerMode == TMR_SR_POWER_MODE_INVALID) && (false == reader->continuousReading))
+  {
+    /* One block is enough to wake a module that is only dozing */
+    TMR_SR_sendBytes(reader, sizeof(flushBytes)/sizeof(uint8_t), flushBytes, timeoutMs);
+    sr->preambleStats.blocks++;
+
+    if (TMR_SUCCESS == TMR_SR_probePowerMode(reader))
+    {
+      sr->preambleStats.timeMs += (uint32_t)(tmr_gettime() - start);
+      return;
+    }
+    /* Drop whatever part of the probe response made it through */
+    sr->pushbackLen = 0;
+    sr->transport.flush(&sr->transport);
+  }
+
+  /* Wake up processor from deep sleep.  Tickle the RS-232 line, then
+   * wait a fixed delay while the processor spins up communications again. */
+  TMR_SR_sendBytes(reader, sizeof(flushBytes)/sizeof(uint8_t), flushBytes, timeoutMs);
+  for (blocksSent = 1; blocksSent < TMR_SR_WAKE_PREAMBLE_BLOCKS; blocksSent++)
+  {
+    tmr_sleep(TMR_SR_WAKE_PREAMBLE_DELAY_MS);
+    TMR_SR_sendBytes(reader, sizeof(flushBytes)/sizeof(uint8_t), flushBytes, timeoutMs);
+  }
+  /* Give the processor time to spin up before the command follows */
+  tmr_sleep(TMR_SR_WAKE_PREAMBLE_DELAY_MS);
+
+  sr->preambleStats.preambles++;
+  sr->preambleStats.blocks += blocksSent;
+  sr->preambleStats.timeMs += (uint32_t)(tmr_gettime() - start);
+}
+
+TMR_Status
+TMR_SR_getWakePreambleStats(struct TMR_Reader *reader, TMR_SR_WakePreambleStats *stats)
+{
+  if ((NULL == reader) || (NULL == stats) || (TMR_READER_TYPE_SERIAL != reader->readerType))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  *stats = reader->u.serialReader.preambleStats;
+  return TMR_SUCCESS;
+}
+#endif /* TMR_ENABLE_WAKE_PREAMBLES */
+#endif /* TMR_ENABLE_UHF */
+
 /**
  * Send a message to the reader
  *
@@ -212,30 +622,7 @@ TMR_SR_sendMessage(TMR_Reader *reader, uint8_t *data, uint8_t *opcode, uint32_t
 
 #ifdef TMR_ENABLE_UHF
 #if TMR_ENABLE_WAKE_PREAMBLES
-  /* Wake up processor from deep sleep.  Tickle the RS-232 line, then
-   * wait a fixed delay while the processor spins up communications again. */
-  if (sr->supportsPreamble && ((sr->powerMode == TMR_SR_POWER_MODE_INVALID) ||
-                              (sr->powerMode == TMR_SR_POWER_MODE_SLEEP)) )
-  {
-    uint8_t flushBytes[] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
-
-    TMR_SR_sendBytes(reader, sizeof(flushBytes)/sizeof(uint8_t), flushBytes, timeoutMs);
-    {
-      //uint32_t bytesper100ms;
-      uint32_t bytesSent;
-
-      /* Calculate fixed delay in terms of byte-lengths at current speed */
-      /* @todo Optimize delay length.  This value (100 bytes at 9600bps) is taken
-       * directly from arbser, which was itself using a hastily-chosen value. */
-      //bytesper100ms = sr->baudRate / 50;
-      for (bytesSent=0; bytesSent < 24; bytesSent++)
-      {
-        TMR_SR_sendBytes(reader, sizeof(flushBytes)/sizeof(uint8_t), flushBytes, timeoutMs);
-        /* Introducing 25 ms delay between each Iteration */
-        tmr_sleep(9); 
-      }
-    }
-  }    
+  TMR_SR_wakeModule(reader, timeoutMs);
 #endif /* TMR_ENABLE_WAKE_PREAMBLES */
 #endif /* TMR_ENABLE_UHF */
 
@@ -318,6 +705,8 @@ TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data, uint8_t opcode, uint32_
   TMR_SR_SerialTransport *transport;
   uint8_t retryCount = 0;
   bool sohFound = false;
+  /* Leading bytes of data taken from the pushback, already reported */
+  uint32_t pushedBack = 0;
 
   transport = &reader->u.serialReader.transport;
   timeoutMs += reader->u.serialReader.transportTimeout;
@@ -352,9 +741,20 @@ TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data, uint8_t opcode, uint32_
   do
   {
     /* Pull at least receiveBytesLen bytes on first serial receive */
-    ret = transport->receiveBytes(transport, (receiveBytesLen - inlen), &rxcount, (data + inlen), timeoutMs);
+    ret = TMR_SR_receiveBytes(reader, (receiveBytesLen - inlen), &rxcount, (data + inlen), timeoutMs,
+                              &pushedBack);
     if (TMR_SUCCESS != ret)
     {
+      if (TMR_ERROR_TIMEOUT == ret)
+      {
+        TMR_SR_startRecovery(&reader->u.serialReader, &reader->u.serialReader.recoveryStats.timeout);
+      }
+#ifdef TMR_ENABLE_UHF
+#if TMR_ENABLE_WAKE_PREAMBLES
+      /* No answer; the module may have gone back to sleep */
+      reader->u.serialReader.lastTrafficTime = 0;
+#endif /* TMR_ENABLE_WAKE_PREAMBLES */
+#endif /* TMR_ENABLE_UHF */
       /* @todo Figure out how many bytes were actually obtained in a failed receive */
       return ret;
     }
@@ -392,6 +792,12 @@ TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data, uint8_t opcode, uint32_
     {
       /* Update inlen with correct length after discarding invalid bytes. */
       inlen = receiveBytesLen - sohIndex;
+      if (sohIndex > pushedBack)
+      {
+        /* The discarded bytes were still read from the transport */
+        TMR_SR_reportReceived(reader, sohIndex - pushedBack, data + pushedBack, timeoutMs);
+      }
+      pushedBack = (pushedBack > sohIndex) ? (pushedBack - sohIndex) : 0;
       /* Now, copy the inlen number of bytes to data buffer at 0th index. */
       memmove(data, data+sohIndex, inlen);
     }
@@ -399,6 +805,7 @@ TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data, uint8_t opcode, uint32_
 
   if (retryCount >= 20)
   {
+    TMR_SR_startRecovery(&reader->u.serialReader, &reader->u.serialReader.recoveryStats.timeout);
     return TMR_ERROR_TIMEOUT;
   }
 
@@ -425,16 +832,17 @@ TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data, uint8_t opcode, uint32_
   }
   else
   {
-    ret = transport->receiveBytes(transport, len, &inlen, data + receiveBytesLen, timeoutMs);
+    ret = TMR_SR_receiveBytes(reader, len, &inlen, data + receiveBytesLen, timeoutMs, &pushedBack);
   }
 
-  if (NULL != reader->transportListeners)
-  {
-    TMR__notifyTransportListeners(reader, false, inlen + receiveBytesLen, data, timeoutMs);
-  }
+  TMR_SR_reportReceived(reader, inlen + receiveBytesLen - pushedBack, data + pushedBack, timeoutMs);
 
   if (TMR_SUCCESS != ret)
   {
+    if (TMR_ERROR_TIMEOUT == ret)
+    {
+      TMR_SR_startRecovery(&reader->u.serialReader, &reader->u.serialReader.recoveryStats.timeout);
+    }
     /* before we can actually process the message, we have to properly receive the message */
     return ret;
   }
@@ -451,9 +859,23 @@ TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data, uint8_t opcode, uint32_
     if ((data[len + 5] != (crc >> 8)) ||
         (data[len + 6] != (crc & 0xff)))
     {
-      return TMR_ERROR_CRC_ERROR;
+      TMR_SR_startRecovery(&reader->u.serialReader, &reader->u.serialReader.recoveryStats.crc);
+      ret = TMR_SR_resyncFrame(reader, data, inlen + receiveBytesLen, opcode, timeoutMs);
+      if (TMR_SUCCESS != ret)
+      {
+        return TMR_ERROR_CRC_ERROR;
+      }
+      reader->u.serialReader.recoveryStats.crc.resyncs++;
+      len = data[1];
     }
   }
+  TMR_SR_endRecovery(&reader->u.serialReader);
+
+#ifdef TMR_ENABLE_UHF
+#if TMR_ENABLE_WAKE_PREAMBLES
+  reader->u.serialReader.lastTrafficTime = tmr_gettime();
+#endif /* TMR_ENABLE_WAKE_PREAMBLES */
+#endif /* TMR_ENABLE_UHF */
 
   /* Check command time difference only for async command. */
   if(onFlyCmdOpcode && reader->continuousReading)
@@ -488,6 +910,7 @@ TMR_SR_receiveMessage(TMR_Reader *reader, uint8_t *data, uint8_t opcode, uint32_
     else if(data[2] == 0x04)      // Boot response received.
     {
       /* Need to flush the response of command which was sent earlier. */
+      reader->u.serialReader.pushbackLen = 0;
       ret = transport->flush(transport); 
       if (ret == TMR_SUCCESS)
       {
@@ -29,9 +29,10 @@
  */
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/select.h>
+#include <poll.h>
 #include <fcntl.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
@@ -44,8 +45,43 @@
 #include <IOKit/serial/ioss.h>
 #endif
 
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
 #ifdef TMR_ENABLE_SERIAL_TRANSPORT_NATIVE
 
+#if defined(TMR_ENABLE_CUSTOM_BAUD_RATES) && defined(TCGETS2)
+/*
+ * The kernel's termios2 can not be pulled in from <asm/termbits.h>
+ * next to <termios.h>, so mirror its layout here.
+ */
+struct termios2
+{
+  tcflag_t c_iflag;
+  tcflag_t c_oflag;
+  tcflag_t c_cflag;
+  tcflag_t c_lflag;
+  cc_t c_line;
+  cc_t c_cc[19];
+  speed_t c_ispeed;
+  speed_t c_ospeed;
+};
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#endif /* TMR_ENABLE_CUSTOM_BAUD_RATES && TCGETS2 */
+
+/* Milliseconds on the monotonic clock, immune to wall-clock steps */
+static uint64_t
+s_monotonicMs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
 static TMR_Status
 s_open(TMR_SR_SerialTransport *this)
 {
@@ -74,16 +110,46 @@ s_open(TMR_SR_SerialTransport *this)
   t.c_cflag &= ~(CRTSCTS | CSIZE | CSTOPB | PARENB);
   t.c_cflag |= CS8 | CLOCAL | CREAD | HUPCL;
   t.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+  /* Reads never block; poll() decides when data is ready */
   t.c_cc[VMIN] = 0;
-  t.c_cc[VTIME] = 1;
+  t.c_cc[VTIME] = 0;
   ret = tcsetattr(c->handle, TCSANOW, &t);
   if (-1 == ret)
     return TMR_ERROR_COMM_ERRNO(errno);
 
+#ifdef ASYNC_LOW_LATENCY
+  {
+    struct serial_struct ss;
+
+    /*
+     * USB adapters (FTDI, CP210x) otherwise hold received bytes for
+     * their latency timer, up to 16 ms per frame. Not every driver
+     * implements this, so failures are ignored.
+     */
+    if (0 == ioctl(c->handle, TIOCGSERIAL, &ss))
+    {
+      ss.flags |= ASYNC_LOW_LATENCY;
+      ioctl(c->handle, TIOCSSERIAL, &ss);
+    }
+  }
+#endif /* ASYNC_LOW_LATENCY */
+
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+  c->rxHead = c->rxTail = 0;
+#endif
+
   ret = flock(c->handle, LOCK_SH | LOCK_NB);
   if ( -1 == ret)
     return TMR_ERROR_COMM_ERRNO(errno);
 
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  /* Any failure leaves c->uring NULL, and reads go through poll() */
+  if (c->uringWanted)
+  {
+    TMR_SR_uringAttach(c, false);
+  }
+#endif
+
   return TMR_SUCCESS;
 }
 
@@ -117,34 +183,86 @@ s_sendBytes(TMR_SR_SerialTransport *this, uint32_t length,
   return TMR_SUCCESS;
 }
 
-static TMR_Status
-s_receiveBytes(TMR_SR_SerialTransport *this, uint32_t length, 
-               uint32_t *messageLength, uint8_t* message, const uint32_t timeoutMs)
+/**
+ * Buffered, deadline-bounded receive shared by the native serial and
+ * TCP transports. The handle may be a tty or a socket.
+ */
+TMR_Status
+TMR_SR_nativeReceiveBytes(TMR_SR_SerialPortNativeContext *c, uint32_t length,
+                          uint32_t *messageLength, uint8_t *message, uint32_t timeoutMs)
 {
-  TMR_SR_SerialPortNativeContext *c;
+  struct pollfd pfd;
+  uint64_t deadline, now;
   int ret;
-  struct timeval tv;
-  fd_set set;
   int status = 0;
 
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  if (NULL != c->uring)
+  {
+    return TMR_SR_uringReceiveBytes(c, length, messageLength, message, timeoutMs);
+  }
+#endif
+
   *messageLength = 0;
-  c = this->cookie;
 
-  do
+  /* The timeout covers the whole receive, however the bytes trickle in */
+  deadline = s_monotonicMs() + timeoutMs;
+
+  while (length > 0)
   {
-    FD_ZERO(&set);
-    FD_SET(c->handle, &set);
-    tv.tv_sec = timeoutMs / 1000;
-    tv.tv_usec = (timeoutMs % 1000) * 1000;
-    /* Ideally should reset this timeout value every time through */
-    ret = select(c->handle + 1, &set, NULL, NULL, &tv);
-    if (ret < 1)
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+    if (c->rxHead != c->rxTail)
+    {
+      uint32_t avail = c->rxTail - c->rxHead;
+
+      if (avail > length)
+      {
+        avail = length;
+      }
+      memcpy(message, c->rxBuf + c->rxHead, avail);
+      c->rxHead += avail;
+      length -= avail;
+      *messageLength += avail;
+      message += avail;
+      continue;
+    }
+#endif
+
+    now = s_monotonicMs();
+    if (now >= deadline)
     {
       return TMR_ERROR_TIMEOUT;
     }
+
+    pfd.fd = c->handle;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    ret = poll(&pfd, 1, (int)(deadline - now));
+    if (ret < 0)
+    {
+      if (EINTR == errno)
+      {
+        continue;
+      }
+      return TMR_ERROR_COMM_ERRNO(errno);
+    }
+    if (0 == ret)
+    {
+      return TMR_ERROR_TIMEOUT;
+    }
+
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+    /* Take everything the driver has, not just what was asked for */
+    ret = read(c->handle, c->rxBuf, sizeof(c->rxBuf));
+#else
     ret = read(c->handle, message, length);
+#endif
     if (ret == -1)
     {
+      if ((EAGAIN == errno) || (EINTR == errno))
+      {
+        continue;
+      }
       if (ENXIO == errno)
       {
         return TMR_ERROR_TIMEOUT; 
@@ -158,7 +276,7 @@ s_receiveBytes(TMR_SR_SerialTransport *this, uint32_t length,
     if (0 == ret)
     {
       /**
-       * We should not be here, coming here means the select()
+       * We should not be here, coming here means the poll()
        * is success , but we are not able to read the data.
        * check the serial port connection status.
        **/
@@ -166,26 +284,43 @@ s_receiveBytes(TMR_SR_SerialTransport *this, uint32_t length,
       if (-1 == ret)
       {
         /* not success. check for errno */
-        if (EIO == errno)
+        if ((EIO == errno) || (ENOTTY == errno))
         {
           /**
-           * EIO means I/O error, may serial port got disconnected,
-           * throw the error.
+           * EIO means I/O error, may serial port got disconnected.
+           * ENOTTY means the handle is a socket and the peer closed
+           * the connection. Throw the error.
            **/
           return TMR_ERROR_TIMEOUT;
         }
       }
+      if (pfd.revents & (POLLHUP | POLLERR))
+      {
+        return TMR_ERROR_TIMEOUT;
+      }
+      continue;
     }
 
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+    c->rxHead = 0;
+    c->rxTail = (uint16_t)ret;
+#else
     length -= ret;
     *messageLength += ret;
     message += ret;
+#endif
   }
-  while (length > 0);
 
   return TMR_SUCCESS;
 }
 
+static TMR_Status
+s_receiveBytes(TMR_SR_SerialTransport *this, uint32_t length, 
+               uint32_t *messageLength, uint8_t* message, const uint32_t timeoutMs)
+{
+  return TMR_SR_nativeReceiveBytes(this->cookie, length, messageLength, message, timeoutMs);
+}
+
 static TMR_Status
 s_setBaudRate(TMR_SR_SerialTransport *this, uint32_t rate)
 {
@@ -229,7 +364,28 @@ s_setBaudRate(TMR_SR_SerialTransport *this, uint32_t rate)
       BCASE(&t, 921600);
 #endif
     default:
+#if defined(TMR_ENABLE_CUSTOM_BAUD_RATES) && defined(TCGETS2)
+      {
+        struct termios2 t2;
+
+        /* No Bxxx constant; ask the driver for the exact rate */
+        if (ioctl(c->handle, TCGETS2, &t2) == -1)
+        {
+          return TMR_ERROR_INVALID;
+        }
+        t2.c_cflag &= ~CBAUD;
+        t2.c_cflag |= BOTHER;
+        t2.c_ispeed = rate;
+        t2.c_ospeed = rate;
+        if (ioctl(c->handle, TCSETS2, &t2) == -1)
+        {
+          return TMR_ERROR_INVALID;
+        }
+        return TMR_SUCCESS;
+      }
+#else
       return TMR_ERROR_INVALID;
+#endif
     }
 #undef BCASE
     if (tcsetattr(c->handle, TCSANOW, &t) != 0)
@@ -249,6 +405,9 @@ s_shutdown(TMR_SR_SerialTransport *this)
 
   c = this->cookie;
 
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  TMR_SR_uringDetach(c);
+#endif
   close(c->handle);
   /* What, exactly, would be the point of checking for an error here? */
 
@@ -262,7 +421,17 @@ s_flush(TMR_SR_SerialTransport *this)
 
   c = this->cookie;
 
-  if (tcflush(c->handle, TCOFLUSH) == -1)
+  /* Drop unsent output and any stale input still in the driver */
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+  c->rxHead = c->rxTail = 0;
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  if (NULL != c->uring)
+  {
+    TMR_SR_uringFlush(c);
+  }
+#endif
+  if (tcflush(c->handle, TCIOFLUSH) == -1)
   {
     return TMR_ERROR_COMM_ERRNO(errno);
   }
@@ -298,8 +467,29 @@ TMR_SR_SerialTransportNativeInit(TMR_SR_SerialTransport *transport,
   transport->setBaudRate = s_setBaudRate;
   transport->shutdown = s_shutdown;
   transport->flush = s_flush;
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  context->uring = NULL;
+  context->uringWanted = false;
+#endif
 
   return TMR_SUCCESS;
 }
 
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+TMR_Status
+TMR_SR_SerialTransportNativeUringInit(TMR_SR_SerialTransport *transport,
+                                      TMR_SR_SerialPortNativeContext *context,
+                                      const char *device)
+{
+  TMR_Status ret;
+
+  ret = TMR_SR_SerialTransportNativeInit(transport, context, device);
+  if (TMR_SUCCESS == ret)
+  {
+    context->uringWanted = true;
+  }
+  return ret;
+}
+#endif
+
 #endif
@@ -0,0 +1,758 @@
+/**
+ *  @file serial_transport_replay.c
+ *  @brief Mercury API - serial transport that replays a transport capture
+ *
+ *  Answers the commands of the serial reader with the responses held in
+ *  a capture file written by TMR_startTransportCapture(), so traffic
+ *  recorded at a site can be fed through the API again. Commands are
+ *  matched against the recorded ones by opcode, in recording order, and
+ *  the recorded responses are delivered either with their original
+ *  spacing or as fast as the host reads them.
+ */
+
+/*
+ * Copyright (c) 2023 Novanta, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tm_reader.h"
+#include "serial_reader_imp.h"
+
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_REPLAY
+
+/* Status sent back for a command the recording has no answer for */
+#define REPLAY_STATUS_UNMATCHED 0x0101
+
+/* Continuous reading sub-options of the multi-protocol opcode */
+#define REPLAY_STREAM_START 0x01
+#define REPLAY_STREAM_STOP 0x02
+#define REPLAY_STREAM_EMBEDDED 0x04
+
+typedef struct ReplayRecord
+{
+  /* Capture time in microseconds */
+  uint64_t timeUs;
+  const uint8_t *data;
+  uint16_t len;
+  bool tx;
+} ReplayRecord;
+
+typedef struct ReplaySession
+{
+  pthread_mutex_t lock;
+  /* Signalled when a command schedules new responses */
+  pthread_cond_t cond;
+
+  /* The capture file, and the EAPI frames found in it */
+  uint8_t *file;
+  ReplayRecord *records;
+  uint32_t count;
+
+  /* Options */
+  bool originalTiming;
+  bool loop;
+
+  /* Next recorded command to match against */
+  uint32_t cursor;
+
+  /*
+   * Responses being delivered: records [next, end) taken in order.
+   * A response is due at its capture time relative to @c anchorUs,
+   * shifted to the host clock at @c hostUs.
+   */
+  uint32_t next, end;
+  uint64_t anchorUs;
+  uint64_t hostUs;
+
+  /* Continuous reading: tag frames come from [streamFirst, end) */
+  bool streaming;
+  uint32_t streamFirst;
+
+  /* Answer to a command embedded in the stream, sent ahead of it */
+  const ReplayRecord *urgent;
+
+  /* Frame being handed out, and how much of it has gone */
+  const uint8_t *frame;
+  uint16_t frameLen, framePos;
+  uint8_t synth[7];
+
+  /* Partially received command */
+  uint8_t in[TMR_SR_MAX_PACKET_SIZE];
+  uint32_t inLen;
+
+  uint32_t unmatched;
+} ReplaySession;
+
+static uint64_t
+replay_nowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static uint64_t
+replay_getLe(const uint8_t *p, int bytes)
+{
+  uint64_t value = 0;
+
+  while (bytes-- > 0)
+  {
+    value = (value << 8) | p[bytes];
+  }
+  return value;
+}
+
+/*
+ * Split "path?key=value&key=value" into the capture path and the
+ * options. Understood: timing=original|fast (default fast) and loop=0|1.
+ */
+static TMR_Status
+replay_parseOptions(ReplaySession *replay, char *device)
+{
+  char *opt = strchr(device, '?');
+
+  replay->originalTiming = false;
+  replay->loop = false;
+  if (NULL == opt)
+  {
+    return TMR_SUCCESS;
+  }
+  *opt++ = '\0';
+
+  while ('\0' != *opt)
+  {
+    char *end = opt + strcspn(opt, "&,");
+    char sep = *end;
+
+    *end = '\0';
+    if (0 == strcmp(opt, "timing=original"))
+    {
+      replay->originalTiming = true;
+    }
+    else if (0 == strcmp(opt, "timing=fast"))
+    {
+      replay->originalTiming = false;
+    }
+    else if (0 == strcmp(opt, "loop=1"))
+    {
+      replay->loop = true;
+    }
+    else if (0 == strcmp(opt, "loop=0"))
+    {
+      replay->loop = false;
+    }
+    else
+    {
+      return TMR_ERROR_INVALID;
+    }
+    opt = ('\0' == sep) ? end : end + 1;
+  }
+  return TMR_SUCCESS;
+}
+
+/*
+ * Read the capture file and index its EAPI frames. Transmitted bytes
+ * that are not a command frame (wake-up preambles, flush bytes) are left
+ * out so they can't get in the way of matching.
+ */
+static TMR_Status
+replay_load(ReplaySession *replay, const char *path)
+{
+  FILE *f;
+  long size;
+  uint32_t pos, max = 0;
+
+  f = fopen(path, "rb");
+  if (NULL == f)
+  {
+    return TMR_ERROR_COMM_ERRNO(errno);
+  }
+  if ((0 != fseek(f, 0, SEEK_END)) || (0 > (size = ftell(f))) ||
+      (0 != fseek(f, 0, SEEK_SET)))
+  {
+    fclose(f);
+    return TMR_ERROR_COMM_ERRNO(errno);
+  }
+  if (TMR_CAPTURE_FILE_HEADER_SIZE > size)
+  {
+    fclose(f);
+    return TMR_ERROR_INVALID;
+  }
+  replay->file = malloc(size);
+  if (NULL == replay->file)
+  {
+    fclose(f);
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  if ((size_t)size != fread(replay->file, 1, size, f))
+  {
+    fclose(f);
+    return TMR_ERROR_COMM_ERRNO(EIO);
+  }
+  fclose(f);
+
+  if ((0 != memcmp(replay->file, TMR_CAPTURE_MAGIC, 8)) ||
+      (TMR_CAPTURE_VERSION != replay_getLe(replay->file + 8, 4)) ||
+      (TMR_READER_TYPE_SERIAL != replay_getLe(replay->file + 12, 4)))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  for (pos = TMR_CAPTURE_FILE_HEADER_SIZE;
+       pos + TMR_CAPTURE_RECORD_HEADER_SIZE <= (uint32_t)size; )
+  {
+    const uint8_t *hdr = replay->file + pos;
+    uint32_t len = (uint32_t)replay_getLe(hdr + 8, 4);
+    uint8_t flags = hdr[12];
+    const uint8_t *data = hdr + TMR_CAPTURE_RECORD_HEADER_SIZE;
+    bool tx = (0 != (flags & TMR_CAPTURE_FLAG_TX));
+
+    if ((uint32_t)size - pos - TMR_CAPTURE_RECORD_HEADER_SIZE < len)
+    {
+      /* Truncated last record; the writer was cut short */
+      break;
+    }
+    pos += TMR_CAPTURE_RECORD_HEADER_SIZE + len;
+
+    if ((TMR_CAPTURE_PROTOCOL_EAPI != ((flags & TMR_CAPTURE_PROTOCOL_MASK) >> 1)) ||
+        (0 == len) || (TMR_SR_MAX_PACKET_SIZE < len) ||
+        (tx && ((5 > len) || (0xFF != data[0]) || ((uint32_t)data[1] + 5 != len))))
+    {
+      continue;
+    }
+
+    if (replay->count == max)
+    {
+      ReplayRecord *grown;
+
+      max = max ? 2 * max : 1024;
+      grown = realloc(replay->records, max * sizeof(*grown));
+      if (NULL == grown)
+      {
+        return TMR_ERROR_OUT_OF_MEMORY;
+      }
+      replay->records = grown;
+    }
+    replay->records[replay->count].timeUs = replay_getLe(hdr, 8);
+    replay->records[replay->count].data = data;
+    replay->records[replay->count].len = (uint16_t)len;
+    replay->records[replay->count].tx = tx;
+    replay->count++;
+  }
+
+  return (0 == replay->count) ? TMR_ERROR_INVALID : TMR_SUCCESS;
+}
+
+/*
+ * Whether recorded command @a rec is the same request as @a cmd: same
+ * opcode, and for the multi-protocol opcode the same sub-option (and
+ * inner opcode, for commands embedded in a stream).
+ */
+static bool
+replay_sameCommand(const ReplayRecord *rec, const uint8_t *cmd)
+{
+  const uint8_t *data = rec->data;
+
+  if (!rec->tx || (data[2] != cmd[2]))
+  {
+    return false;
+  }
+  if (TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP == cmd[2])
+  {
+    if ((6 > rec->len) || (6 > cmd[1] + 5) || (data[5] != cmd[5]))
+    {
+      return false;
+    }
+    if (REPLAY_STREAM_EMBEDDED == cmd[5])
+    {
+      return (8 <= rec->len) && (8 <= cmd[1] + 5) && (data[7] == cmd[7]);
+    }
+  }
+  return true;
+}
+
+/*
+ * Whether recorded bytes @a rec start a response to @a opcode. Bytes
+ * read while resynchronising after a corrupt frame are recorded as they
+ * came, so a record need not start on a frame.
+ */
+static bool
+replay_isResponse(const ReplayRecord *rec, uint8_t opcode)
+{
+  return (3 <= rec->len) && (0xFF == rec->data[0]) && (opcode == rec->data[2]);
+}
+
+/* Index of the next recorded command like @a cmd, or count if none */
+static uint32_t
+replay_find(ReplaySession *replay, const uint8_t *cmd)
+{
+  uint32_t i;
+
+  for (i = replay->cursor; i < replay->count; i++)
+  {
+    if (replay_sameCommand(&replay->records[i], cmd))
+    {
+      return i;
+    }
+  }
+  /* Start over from the top, for API sequences that repeat */
+  for (i = 0; i < replay->cursor; i++)
+  {
+    if (replay_sameCommand(&replay->records[i], cmd))
+    {
+      return i;
+    }
+  }
+  return replay->count;
+}
+
+/* First recorded command after @a from, or count if none */
+static uint32_t
+replay_nextCommand(ReplaySession *replay, uint32_t from)
+{
+  while ((from < replay->count) && !replay->records[from].tx)
+  {
+    from++;
+  }
+  return from;
+}
+
+/* Deliver the responses recorded after command @a match */
+static void
+replay_schedule(ReplaySession *replay, uint32_t match, uint32_t end, uint64_t now)
+{
+  replay->next = match + 1;
+  replay->end = end;
+  replay->anchorUs = replay->records[match].timeUs;
+  replay->hostUs = now;
+}
+
+/* Act on a complete command frame from the host */
+static void
+replay_command(ReplaySession *replay, const uint8_t *cmd)
+{
+  uint64_t now = replay_nowUs();
+  uint32_t match = replay_find(replay, cmd);
+  uint8_t option = (TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP == cmd[2]) ? cmd[5] : 0;
+
+  if (match == replay->count)
+  {
+    uint16_t crc;
+
+    /* Nothing like it was recorded; answer with an error status */
+    replay->unmatched++;
+    replay->synth[0] = 0xFF;
+    replay->synth[1] = 0;
+    replay->synth[2] = cmd[2];
+    replay->synth[3] = (uint8_t)(REPLAY_STATUS_UNMATCHED >> 8);
+    replay->synth[4] = (uint8_t)REPLAY_STATUS_UNMATCHED;
+    crc = tm_crc(replay->synth + 1, 4);
+    replay->synth[5] = (uint8_t)(crc >> 8);
+    replay->synth[6] = (uint8_t)crc;
+    replay->frame = replay->synth;
+    replay->frameLen = sizeof(replay->synth);
+    replay->framePos = 0;
+    return;
+  }
+
+  replay->cursor = match + 1;
+
+  if (replay->streaming && (REPLAY_STREAM_EMBEDDED == option))
+  {
+    uint32_t i;
+
+    /* The recorded answer is the next multi-protocol response after it */
+    for (i = match + 1; i < replay->count; i++)
+    {
+      if (!replay->records[i].tx && replay_isResponse(&replay->records[i],
+                                                      TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP))
+      {
+        replay->urgent = &replay->records[i];
+        break;
+      }
+    }
+    return;
+  }
+
+  if ((TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP == cmd[2]) && (REPLAY_STREAM_START == option))
+  {
+    uint32_t stop, i;
+    uint8_t stopCmd[6] = {0xFF, 1, TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, 0, 0, REPLAY_STREAM_STOP};
+
+    /* The stream is everything between the acknowledgement and the recorded stop */
+    stop = replay_find(replay, stopCmd);
+    if (stop <= match)
+    {
+      stop = replay->count;
+    }
+    replay->streamFirst = match + 1;
+    for (i = match + 1; i < stop; i++)
+    {
+      if (!replay->records[i].tx && replay_isResponse(&replay->records[i],
+                                                      TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP))
+      {
+        replay->streamFirst = i + 1;
+        break;
+      }
+    }
+    replay->streaming = true;
+    replay->urgent = NULL;
+    replay_schedule(replay, match, stop, now);
+    return;
+  }
+
+  /* A stop drops whatever of the stream hasn't gone out yet */
+  replay->streaming = false;
+  replay->urgent = NULL;
+  replay_schedule(replay, match, replay_nextCommand(replay, match + 1), now);
+}
+
+/*
+ * Pick the next response to hand out. Returns true with @a frame set
+ * when one is due; otherwise sets @a dueUs to when the next one is, or
+ * 0 if there is nothing left.
+ */
+static bool
+replay_nextFrame(ReplaySession *replay, uint64_t now, uint64_t *dueUs)
+{
+  *dueUs = 0;
+
+  if (NULL != replay->urgent)
+  {
+    replay->frame = replay->urgent->data;
+    replay->frameLen = replay->urgent->len;
+    replay->framePos = 0;
+    replay->urgent = NULL;
+    return true;
+  }
+
+  for (;;)
+  {
+    const ReplayRecord *rec;
+    uint64_t due;
+
+    if (replay->next >= replay->end)
+    {
+      if (replay->streaming && replay->loop && (replay->streamFirst < replay->end))
+      {
+        /* Run the stream again, carrying on from where its clock left off */
+        const ReplayRecord *first = &replay->records[replay->streamFirst];
+        const ReplayRecord *last = &replay->records[replay->end - 1];
+
+        replay->hostUs += last->timeUs - replay->anchorUs;
+        replay->anchorUs = first->timeUs;
+        replay->next = replay->streamFirst;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    rec = &replay->records[replay->next];
+    if (rec->tx || (replay->streaming && (replay->next >= replay->streamFirst) &&
+                    replay_isResponse(rec, TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP)))
+    {
+      /*
+       * Commands the host made during the stream at the time, and
+       * their answers, are not part of it
+       */
+      replay->next++;
+      continue;
+    }
+
+    if (replay->originalTiming)
+    {
+      due = replay->hostUs + (rec->timeUs - replay->anchorUs);
+      if (due > now)
+      {
+        *dueUs = due;
+        return false;
+      }
+    }
+    replay->frame = rec->data;
+    replay->frameLen = rec->len;
+    replay->framePos = 0;
+    replay->next++;
+    return true;
+  }
+}
+
+static TMR_Status
+replay_open(TMR_SR_SerialTransport *this)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  ReplaySession *replay;
+  pthread_condattr_t attr;
+  char device[TMR_MAX_READER_NAME_LENGTH];
+  TMR_Status ret;
+
+  if (NULL != c->replay)
+  {
+    return TMR_SUCCESS;
+  }
+
+  replay = calloc(1, sizeof(*replay));
+  if (NULL == replay)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  strcpy(device, c->devicename);
+  ret = replay_parseOptions(replay, device);
+  if (TMR_SUCCESS == ret)
+  {
+    ret = replay_load(replay, device);
+  }
+  if (TMR_SUCCESS != ret)
+  {
+    free(replay->records);
+    free(replay->file);
+    free(replay);
+    return ret;
+  }
+
+  pthread_mutex_init(&replay->lock, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&replay->cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  c->replay = replay;
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+replay_sendBytes(TMR_SR_SerialTransport *this, uint32_t length,
+                 uint8_t* message, const uint32_t timeoutMs)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  ReplaySession *replay = c->replay;
+  uint32_t used;
+
+  if (NULL == replay)
+  {
+    return TMR_ERROR_COMM_ERRNO(EBADF);
+  }
+
+  pthread_mutex_lock(&replay->lock);
+  while (0 < length)
+  {
+    used = sizeof(replay->in) - replay->inLen;
+    if (used > length)
+    {
+      used = length;
+    }
+    memcpy(replay->in + replay->inLen, message, used);
+    replay->inLen += used;
+    message += used;
+    length -= used;
+
+    for (;;)
+    {
+      uint32_t frameLen;
+
+      /* Drop anything that can't start a frame, such as wake-up preambles */
+      while ((0 < replay->inLen) &&
+             ((0xFF != replay->in[0]) || ((1 < replay->inLen) && (0xF8 < replay->in[1]))))
+      {
+        memmove(replay->in, replay->in + 1, --replay->inLen);
+      }
+      if (3 > replay->inLen)
+      {
+        break;
+      }
+      frameLen = replay->in[1] + 5;
+      if (replay->inLen < frameLen)
+      {
+        break;
+      }
+      replay_command(replay, replay->in);
+      replay->inLen -= frameLen;
+      memmove(replay->in, replay->in + frameLen, replay->inLen);
+    }
+  }
+  pthread_cond_broadcast(&replay->cond);
+  pthread_mutex_unlock(&replay->lock);
+
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+replay_receiveBytes(TMR_SR_SerialTransport *this, uint32_t length,
+                    uint32_t* messageLength, uint8_t* message, const uint32_t timeoutMs)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  ReplaySession *replay = c->replay;
+  uint64_t deadline, now, due;
+  TMR_Status ret = TMR_SUCCESS;
+
+  *messageLength = 0;
+  if (NULL == replay)
+  {
+    return TMR_ERROR_COMM_ERRNO(EBADF);
+  }
+
+  deadline = replay_nowUs() + (uint64_t)timeoutMs * 1000;
+  pthread_mutex_lock(&replay->lock);
+  while (*messageLength < length)
+  {
+    if ((NULL != replay->frame) && (replay->framePos < replay->frameLen))
+    {
+      uint32_t avail = replay->frameLen - replay->framePos;
+
+      if (avail > length - *messageLength)
+      {
+        avail = length - *messageLength;
+      }
+      memcpy(message + *messageLength, replay->frame + replay->framePos, avail);
+      replay->framePos += (uint16_t)avail;
+      *messageLength += avail;
+      continue;
+    }
+
+    now = replay_nowUs();
+    if (replay_nextFrame(replay, now, &due))
+    {
+      continue;
+    }
+    if (now >= deadline)
+    {
+      ret = TMR_ERROR_TIMEOUT;
+      break;
+    }
+    if ((0 == due) || (due > deadline))
+    {
+      due = deadline;
+    }
+    {
+      struct timespec ts;
+
+      ts.tv_sec = (time_t)(due / 1000000);
+      ts.tv_nsec = (long)((due % 1000000) * 1000);
+      pthread_cond_timedwait(&replay->cond, &replay->lock, &ts);
+    }
+  }
+  pthread_mutex_unlock(&replay->lock);
+
+  return ret;
+}
+
+static TMR_Status
+replay_setBaudRate(TMR_SR_SerialTransport *this, uint32_t rate)
+{
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+replay_shutdown(TMR_SR_SerialTransport *this)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  ReplaySession *replay = c->replay;
+
+  if (NULL == replay)
+  {
+    return TMR_ERROR_INVALID;
+  }
+  c->replay = NULL;
+  pthread_cond_destroy(&replay->cond);
+  pthread_mutex_destroy(&replay->lock);
+  free(replay->records);
+  free(replay->file);
+  free(replay);
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+replay_flush(TMR_SR_SerialTransport *this)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  ReplaySession *replay = c->replay;
+
+  if (NULL == replay)
+  {
+    return TMR_ERROR_INVALID;
+  }
+  /*
+   * Like a serial port flush this only drops bytes in flight: the part
+   * of a frame not yet read. A stream being replayed carries on.
+   */
+  pthread_mutex_lock(&replay->lock);
+  replay->inLen = 0;
+  replay->frame = NULL;
+  pthread_mutex_unlock(&replay->lock);
+  return TMR_SUCCESS;
+}
+
+/**
+ * Initialize a TMR_SR_SerialTransport structure that replays a capture
+ * file written by TMR_startTransportCapture(). Start the capture before
+ * TMR_connect() so the boot sequence is recorded too. Register it for a
+ * URI scheme and pass the file in place of the device name:
+ *
+ * @code
+ * TMR_setSerialTransport("replay", &TMR_SR_SerialTransportReplayInit);
+ * TMR_create(&reader, "replay:///var/tmp/site.cap?timing=original");
+ * @endcode
+ *
+ * Each command is answered with the responses recorded after the next
+ * recorded command with the same opcode. Options: @c timing=original
+ * spaces responses as they were recorded, @c timing=fast (the default)
+ * hands them out as fast as the host reads; @c loop=1 repeats the tag
+ * stream of a continuous read until it is stopped. Corrupt frames in
+ * the capture are replayed as they are.
+ *
+ * @param transport The TMR_SR_SerialTransport structure to initialize.
+ * @param context A TMR_SR_SerialPortNativeContext structure for the callbacks to use.
+ * @param device The capture file, followed by any options
+ */
+TMR_Status
+TMR_SR_SerialTransportReplayInit(TMR_SR_SerialTransport *transport,
+                                 TMR_SR_SerialPortNativeContext *context,
+                                 const char *device)
+{
+  if (strlen(device) + 1 > sizeof(context->devicename))
+  {
+    return TMR_ERROR_INVALID;
+  }
+  strcpy(context->devicename, device);
+  context->handle = -1;
+  context->replay = NULL;
+
+  transport->cookie = context;
+  transport->open = replay_open;
+  transport->sendBytes = replay_sendBytes;
+  transport->receiveBytes = replay_receiveBytes;
+  transport->setBaudRate = replay_setBaudRate;
+  transport->shutdown = replay_shutdown;
+  transport->flush = replay_flush;
+
+  return TMR_SUCCESS;
+}
+
+#endif /* TMR_ENABLE_SERIAL_TRANSPORT_REPLAY */
@@ -0,0 +1,1707 @@
+/**
+ *  @file serial_transport_sim.c
+ *  @brief Mercury API - software emulation of an EAPI reader module
+ *
+ *  A serial transport that answers EAPI commands itself instead of
+ *  talking to hardware, so the serial reader stack can be exercised
+ *  and benchmarked without a module attached. It emulates an M6e with
+ *  a synthetic Gen2 tag population and can stream tag reads at a
+ *  configurable rate.
+ */
+
+/*
+ * Copyright (c) 2023 Novanta, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tm_reader.h"
+#include "serial_reader_imp.h"
+#include "tmr_utils.h"
+
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_SIM
+
+/* Defaults for the options accepted in the device name */
+#define SIM_DEFAULT_TAGS      100
+#define SIM_DEFAULT_EPC_BYTES 12
+#define SIM_DEFAULT_ANTENNAS  1
+#define SIM_MAX_ANTENNAS      4
+
+/* Per-tag memory */
+#define SIM_MAX_EPC_BYTES     32
+#define SIM_RESERVED_BYTES    8
+#define SIM_TID_BYTES         12
+#define SIM_USER_BYTES        32
+
+/* Room for responses waiting to be collected by receiveBytes() */
+#define SIM_OUT_SIZE          4096
+
+/* Largest payload of a response frame, see TMR_SR_receiveMessage() */
+#define SIM_MAX_DATA          (TMR_SR_MAX_PACKET_SIZE - 7)
+
+/*
+ * Response builders. The SETUxx macros of tmr_utils.h also count bytes
+ * of the command being assembled by the host side, so the emulator,
+ * which runs inside the receive path, keeps to its own.
+ */
+#define SIM_PUT8(msg, i, v) ((msg)[(i)++] = (uint8_t)(v))
+#define SIM_PUT16(msg, i, v) do {        \
+  uint16_t _v = (uint16_t)(v);           \
+  (msg)[(i)++] = (uint8_t)(_v >> 8);     \
+  (msg)[(i)++] = (uint8_t)_v;            \
+} while (0)
+#define SIM_PUT24(msg, i, v) do {        \
+  uint32_t _v = (uint32_t)(v);           \
+  (msg)[(i)++] = (uint8_t)(_v >> 16);    \
+  (msg)[(i)++] = (uint8_t)(_v >> 8);     \
+  (msg)[(i)++] = (uint8_t)_v;            \
+} while (0)
+#define SIM_PUT32(msg, i, v) do {        \
+  uint32_t _v = (uint32_t)(v);           \
+  (msg)[(i)++] = (uint8_t)(_v >> 24);    \
+  (msg)[(i)++] = (uint8_t)(_v >> 16);    \
+  (msg)[(i)++] = (uint8_t)(_v >> 8);     \
+  (msg)[(i)++] = (uint8_t)_v;            \
+} while (0)
+
+typedef struct SimTag
+{
+  uint8_t epcLen;
+  uint8_t epc[SIM_MAX_EPC_BYTES];
+  uint8_t reserved[SIM_RESERVED_BYTES];
+  uint8_t user[SIM_USER_BYTES];
+} SimTag;
+
+typedef struct SimReader
+{
+  pthread_mutex_t lock;
+  /* Signalled when a command queues a response */
+  pthread_cond_t cond;
+
+  /* Options taken from the device name */
+  uint32_t tagCount;
+  uint32_t rate;
+  uint8_t antennaCount;
+  uint32_t seed;
+
+  SimTag *tags;
+  /* Longest EPC in the population */
+  uint8_t maxEpcLen;
+
+  /* Module settings */
+  bool crc;
+  uint8_t region;
+  uint8_t protocol;
+  int16_t readPower;
+  uint8_t config[256];
+
+  /* Partially received command */
+  uint8_t in[TMR_SR_MAX_PACKET_SIZE];
+  uint32_t inLen;
+
+  /* Responses not yet collected */
+  uint8_t out[SIM_OUT_SIZE];
+  uint32_t outHead, outTail;
+
+  /* Result of the last synchronous search, fetched with 0x29 */
+  uint32_t bufferStart, bufferCount, bufferPos;
+
+  /* Continuous reading */
+  bool streaming;
+  bool multiSelect;
+  uint8_t option;
+  uint16_t searchFlags;
+  uint16_t metadataFlags;
+  uint16_t reportFlags;
+  uint32_t cycleMs;
+  uint32_t stopAfter;
+  bool stopReported;
+  uint64_t streamStart;
+  uint64_t lastReport;
+  uint64_t readsSent;
+  uint32_t cursor;
+
+  uint32_t rng;
+  uint64_t bootTime;
+  /* Responses are withheld until then, while a timed search runs */
+  uint64_t busyUntil;
+} SimReader;
+
+/* Milliseconds on the monotonic clock */
+static uint64_t
+sim_nowMs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/* xorshift32: cheap, deterministic for a given seed */
+static uint32_t
+sim_random(SimReader *sim)
+{
+  uint32_t x = sim->rng;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sim->rng = x;
+  return x;
+}
+
+/* Append @a value (below 0x4000) as an extensible bit vector */
+static void
+sim_putEBV(uint8_t *msg, uint8_t *i, uint16_t value)
+{
+  if (0x80 > value)
+  {
+    SIM_PUT8(msg, *i, value);
+  }
+  else
+  {
+    SIM_PUT16(msg, *i, 0x8000 | ((value & 0x3F80) << 1) | (value & 0x7F));
+  }
+}
+
+/*
+ * Parse "tags=N,rate=N,epc=N,antennas=N,seed=N" (',' or '&' separated)
+ * from the device name. Unknown keys are rejected so typos don't go
+ * unnoticed.
+ */
+static TMR_Status
+sim_parseOptions(SimReader *sim, const char *device)
+{
+  const char *p = device;
+  uint32_t epcLen = SIM_DEFAULT_EPC_BYTES;
+
+  sim->tagCount = SIM_DEFAULT_TAGS;
+  sim->rate = 0;
+  sim->antennaCount = SIM_DEFAULT_ANTENNAS;
+  sim->seed = 1;
+
+  while ('/' == *p)
+  {
+    p++;
+  }
+  while ('\0' != *p)
+  {
+    const char *eq = strchr(p, '=');
+    size_t keyLen;
+    unsigned long value;
+    char *end;
+
+    if (NULL == eq)
+    {
+      return TMR_ERROR_INVALID;
+    }
+    keyLen = eq - p;
+    value = strtoul(eq + 1, &end, 0);
+    if ((end == eq + 1) || (('\0' != *end) && (',' != *end) && ('&' != *end)))
+    {
+      return TMR_ERROR_INVALID;
+    }
+
+    if ((4 == keyLen) && (0 == strncmp(p, "tags", 4)))
+    {
+      sim->tagCount = (uint32_t)value;
+    }
+    else if ((4 == keyLen) && (0 == strncmp(p, "rate", 4)))
+    {
+      sim->rate = (uint32_t)value;
+    }
+    else if ((3 == keyLen) && (0 == strncmp(p, "epc", 3)))
+    {
+      epcLen = (uint32_t)value;
+    }
+    else if ((8 == keyLen) && (0 == strncmp(p, "antennas", 8)))
+    {
+      sim->antennaCount = (uint8_t)value;
+    }
+    else if ((4 == keyLen) && (0 == strncmp(p, "seed", 4)))
+    {
+      sim->seed = (uint32_t)value;
+    }
+    else
+    {
+      return TMR_ERROR_INVALID;
+    }
+
+    p = ('\0' == *end) ? end : end + 1;
+  }
+
+  if ((0 == sim->tagCount) || (0 == sim->antennaCount) ||
+      (SIM_MAX_ANTENNAS < sim->antennaCount) ||
+      (2 > epcLen) || (SIM_MAX_EPC_BYTES < epcLen) || (0 != (epcLen & 1)))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  /* Tag i carries a random prefix and its index in the last four bytes */
+  sim->tags = calloc(sim->tagCount, sizeof(SimTag));
+  if (NULL == sim->tags)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  sim->maxEpcLen = (uint8_t)epcLen;
+  sim->rng = sim->seed ? sim->seed : 1;
+  {
+    uint32_t i;
+    uint8_t j;
+
+    for (i = 0; i < sim->tagCount; i++)
+    {
+      SimTag *tag = &sim->tags[i];
+
+      tag->epcLen = (uint8_t)epcLen;
+      for (j = 0; j < epcLen; j++)
+      {
+        tag->epc[j] = (uint8_t)sim_random(sim);
+      }
+      for (j = 0; (j < 4) && (j < epcLen); j++)
+      {
+        tag->epc[epcLen - 1 - j] = (uint8_t)(i >> (8 * j));
+      }
+    }
+  }
+  return TMR_SUCCESS;
+}
+
+/** Queue a response frame */
+static void
+sim_reply(SimReader *sim, uint8_t opcode, uint16_t status,
+          const uint8_t *data, uint8_t len)
+{
+  uint8_t *frame;
+
+  if (SIM_OUT_SIZE - sim->outTail < (uint32_t)len + 7)
+  {
+    memmove(sim->out, sim->out + sim->outHead, sim->outTail - sim->outHead);
+    sim->outTail -= sim->outHead;
+    sim->outHead = 0;
+    if (SIM_OUT_SIZE - sim->outTail < (uint32_t)len + 7)
+    {
+      return;
+    }
+  }
+
+  frame = sim->out + sim->outTail;
+  frame[0] = 0xFF;
+  frame[1] = len;
+  frame[2] = opcode;
+  frame[3] = (uint8_t)(status >> 8);
+  frame[4] = (uint8_t)status;
+  memcpy(frame + 5, data, len);
+  sim->outTail += len + 5;
+  if (sim->crc)
+  {
+    uint16_t crc = tm_crc(frame + 1, len + 4);
+
+    frame[len + 5] = (uint8_t)(crc >> 8);
+    frame[len + 6] = (uint8_t)crc;
+    sim->outTail += 2;
+  }
+}
+
+static uint32_t
+sim_outSpace(SimReader *sim)
+{
+  return SIM_OUT_SIZE - (sim->outTail - sim->outHead);
+}
+
+/** Antenna a read of tag index @a n came in on, as module tx/rx nibbles */
+static uint8_t
+sim_antenna(SimReader *sim, uint64_t n)
+{
+  uint8_t port = (uint8_t)(1 + (n % sim->antennaCount));
+
+  return (uint8_t)((port << 4) | port);
+}
+
+/**
+ * Append one tag record: the metadata selected by @a flags followed by
+ * the EPC length in bits, PC word, EPC and tag CRC.
+ */
+static void
+sim_addTagRecord(SimReader *sim, uint8_t *msg, uint8_t *i, uint16_t flags,
+                 uint32_t index, uint64_t n, uint32_t timestamp)
+{
+  SimTag *tag = &sim->tags[index];
+  uint16_t crc;
+  uint8_t epcLen = tag->epcLen;
+
+  if (flags & TMR_TRD_METADATA_FLAG_READCOUNT)
+  {
+    SIM_PUT8(msg, *i, 1);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_RSSI)
+  {
+    SIM_PUT8(msg, *i, (uint8_t)(int8_t)(-40 - (int)(sim_random(sim) % 30)));
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_ANTENNAID)
+  {
+    SIM_PUT8(msg, *i, sim_antenna(sim, n));
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_FREQUENCY)
+  {
+    SIM_PUT24(msg, *i, 902750 + 500 * (uint32_t)(n % 50));
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_TIMESTAMP)
+  {
+    SIM_PUT32(msg, *i, timestamp);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_PHASE)
+  {
+    SIM_PUT16(msg, *i, (uint16_t)(sim_random(sim) % 180));
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_PROTOCOL)
+  {
+    SIM_PUT8(msg, *i, TMR_TAG_PROTOCOL_GEN2);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_DATA)
+  {
+    SIM_PUT16(msg, *i, 0);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_GPIO_STATUS)
+  {
+    SIM_PUT8(msg, *i, 0);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_GEN2_Q)
+  {
+    SIM_PUT8(msg, *i, 4);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_GEN2_LF)
+  {
+    SIM_PUT8(msg, *i, 0x02);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_GEN2_TARGET)
+  {
+    SIM_PUT8(msg, *i, 0);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_BRAND_IDENTIFIER)
+  {
+    SIM_PUT16(msg, *i, 0);
+  }
+  if (flags & TMR_TRD_METADATA_FLAG_TAGTYPE)
+  {
+    SIM_PUT8(msg, *i, 0);
+  }
+
+  SIM_PUT16(msg, *i, (uint16_t)((epcLen + 4 +
+    ((flags & TMR_TRD_METADATA_FLAG_BRAND_IDENTIFIER) ? 2 : 0)) * 8));
+  SIM_PUT8(msg, *i, (uint8_t)((epcLen / 2) << 3));
+  SIM_PUT8(msg, *i, 0);
+  memcpy(msg + *i, tag->epc, epcLen);
+  *i += epcLen;
+  if (flags & TMR_TRD_METADATA_FLAG_BRAND_IDENTIFIER)
+  {
+    SIM_PUT16(msg, *i, 0);
+  }
+  crc = tm_crc(tag->epc, epcLen);
+  SIM_PUT16(msg, *i, crc);
+}
+
+/** Worst-case size of a record written by sim_addTagRecord() */
+static uint8_t
+sim_recordSize(SimReader *sim)
+{
+  return (uint8_t)(24 + 6 + sim->maxEpcLen + 4);
+}
+
+/** Append a set of reader statistics in the 0x6C / stats stream layout */
+static void
+sim_addStats(SimReader *sim, uint8_t *msg, uint8_t *i, uint16_t flags)
+{
+  uint8_t port;
+
+  sim_putEBV(msg, i, flags);
+  if (flags & TMR_READER_STATS_FLAG_RF_ON_TIME)
+  {
+    sim_putEBV(msg, i, TMR_READER_STATS_FLAG_RF_ON_TIME);
+    SIM_PUT8(msg, *i, (uint8_t)(5 * sim->antennaCount));
+    for (port = 1; port <= sim->antennaCount; port++)
+    {
+      SIM_PUT8(msg, *i, port);
+      SIM_PUT32(msg, *i, (uint32_t)(sim_nowMs() - sim->bootTime) / sim->antennaCount);
+    }
+  }
+  if (flags & TMR_READER_STATS_FLAG_FREQUENCY)
+  {
+    sim_putEBV(msg, i, TMR_READER_STATS_FLAG_FREQUENCY);
+    SIM_PUT8(msg, *i, 3);
+    SIM_PUT24(msg, *i, 915250);
+  }
+  if (flags & TMR_READER_STATS_FLAG_TEMPERATURE)
+  {
+    sim_putEBV(msg, i, TMR_READER_STATS_FLAG_TEMPERATURE);
+    SIM_PUT8(msg, *i, 1);
+    SIM_PUT8(msg, *i, (uint8_t)(30 + sim_random(sim) % 5));
+  }
+  if (flags & TMR_READER_STATS_FLAG_PROTOCOL)
+  {
+    sim_putEBV(msg, i, TMR_READER_STATS_FLAG_PROTOCOL);
+    SIM_PUT8(msg, *i, 1);
+    SIM_PUT8(msg, *i, TMR_TAG_PROTOCOL_GEN2);
+  }
+  if (flags & TMR_READER_STATS_FLAG_ANTENNA_PORTS)
+  {
+    sim_putEBV(msg, i, TMR_READER_STATS_FLAG_ANTENNA_PORTS);
+    SIM_PUT8(msg, *i, 2);
+    SIM_PUT8(msg, *i, 1);
+    SIM_PUT8(msg, *i, 1);
+  }
+  if (flags & TMR_READER_STATS_FLAG_CONNECTED_ANTENNAS)
+  {
+    sim_putEBV(msg, i, TMR_READER_STATS_FLAG_CONNECTED_ANTENNAS);
+    SIM_PUT8(msg, *i, (uint8_t)(2 * sim->antennaCount));
+    for (port = 1; port <= sim->antennaCount; port++)
+    {
+      SIM_PUT8(msg, *i, port);
+      SIM_PUT8(msg, *i, 1);
+    }
+  }
+}
+
+/** Statistics this emulator can report */
+#define SIM_STATS_SUPPORTED (TMR_READER_STATS_FLAG_RF_ON_TIME |  \
+                             TMR_READER_STATS_FLAG_FREQUENCY |   \
+                             TMR_READER_STATS_FLAG_TEMPERATURE | \
+                             TMR_READER_STATS_FLAG_PROTOCOL |    \
+                             TMR_READER_STATS_FLAG_ANTENNA_PORTS | \
+                             TMR_READER_STATS_FLAG_CONNECTED_ANTENNAS)
+
+/**
+ * Start of a streamed 0x22 response: the singulation prefix, option,
+ * search flags and, for tag records, the metadata flags.
+ */
+static void
+sim_streamHeader(SimReader *sim, uint8_t *msg, uint8_t *i, bool tagRecord)
+{
+  if (sim->multiSelect)
+  {
+    SIM_PUT8(msg, *i, TMR_SR_TAGOP_MULTI_SELECT);
+  }
+  if (tagRecord)
+  {
+    SIM_PUT8(msg, *i, sim->option | TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA);
+    SIM_PUT16(msg, *i, sim->searchFlags);
+    SIM_PUT16(msg, *i, sim->metadataFlags);
+  }
+  else
+  {
+    SIM_PUT8(msg, *i, sim->option & ~TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA);
+    SIM_PUT16(msg, *i, sim->searchFlags);
+  }
+}
+
+/**
+ * Queue the streamed responses that are due by @a now. Returns the time
+ * the next one falls due, or 0 if streaming is idle.
+ */
+static uint64_t
+sim_stream(SimReader *sim, uint64_t now)
+{
+  uint8_t msg[TMR_SR_MAX_PACKET_SIZE];
+  uint8_t i;
+  uint64_t due, next = 0;
+
+  if (!sim->streaming)
+  {
+    return 0;
+  }
+
+  /* Stats or status report at the end of every search cycle */
+  if ((0 != sim->reportFlags) && (now - sim->lastReport >= sim->cycleMs) &&
+      (sim_outSpace(sim) > TMR_SR_MAX_PACKET_SIZE))
+  {
+    i = 0;
+    sim_streamHeader(sim, msg, &i, false);
+    SIM_PUT8(msg, i, 0x02);
+    if (sim->searchFlags & TMR_SR_SEARCH_FLAG_STATS_REPORT_STREAMING)
+    {
+      sim_addStats(sim, msg, &i, sim->reportFlags);
+    }
+    else
+    {
+      SIM_PUT16(msg, i, sim->reportFlags);
+      if (sim->reportFlags & TMR_SR_STATUS_FREQUENCY)
+      {
+        SIM_PUT24(msg, i, 915250);
+      }
+      if (sim->reportFlags & TMR_SR_STATUS_TEMPERATURE)
+      {
+        SIM_PUT8(msg, i, 32);
+      }
+      if (sim->reportFlags & TMR_SR_STATUS_ANTENNA)
+      {
+        SIM_PUT8(msg, i, (uint8_t)(1 + ((now / sim->cycleMs) % sim->antennaCount)));
+      }
+    }
+    sim_reply(sim, TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, 0, msg, i);
+    sim->lastReport = now;
+  }
+  if (0 != sim->reportFlags)
+  {
+    next = sim->lastReport + sim->cycleMs;
+  }
+
+  if (sim->stopReported)
+  {
+    return next;
+  }
+
+  if (0 == sim->rate)
+  {
+    due = UINT64_MAX;
+  }
+  else
+  {
+    due = ((now - sim->streamStart) * sim->rate) / 1000;
+  }
+
+  while ((sim->readsSent < due) && (sim_outSpace(sim) > TMR_SR_MAX_PACKET_SIZE))
+  {
+    if ((0 != sim->stopAfter) && (sim->readsSent >= sim->stopAfter))
+    {
+      /* Stop-on-N-tags: report the count and let the host stop us */
+      i = 0;
+      SIM_PUT8(msg, i, 0x01);
+      SIM_PUT16(msg, i, sim->searchFlags);
+      SIM_PUT32(msg, i, (uint32_t)sim->readsSent);
+      sim_reply(sim, TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, 0, msg, i);
+      sim->stopReported = true;
+      return next;
+    }
+
+    i = 0;
+    sim_streamHeader(sim, msg, &i, true);
+    SIM_PUT8(msg, i, 0x01);
+    sim_addTagRecord(sim, msg, &i, sim->metadataFlags, sim->cursor,
+                     sim->readsSent, (uint32_t)(now - sim->streamStart));
+    sim_reply(sim, TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, 0, msg, i);
+    sim->readsSent++;
+    sim->cursor = (sim->cursor + 1) % sim->tagCount;
+  }
+
+  if (0 != sim->rate)
+  {
+    uint64_t tagDue = sim->streamStart + ((sim->readsSent + 1) * 1000 + sim->rate - 1) / sim->rate;
+
+    if ((0 == next) || (tagDue < next))
+    {
+      next = tagDue;
+    }
+  }
+  else if (0 == next)
+  {
+    next = now;
+  }
+  return next;
+}
+
+/*
+ * Parse the fields of a 0x22 command that the emulator acts on.
+ * Returns false if the command is malformed.
+ */
+static bool
+sim_parseSearch(SimReader *sim, const uint8_t *cmd, uint8_t len, bool *multiSelect,
+                uint8_t *option, uint16_t *searchFlags, uint16_t *timeout,
+                uint16_t *metadataFlags, uint32_t *stopAfter, uint16_t *reportFlags)
+{
+  uint8_t i = 0;
+
+  *multiSelect = false;
+  *metadataFlags = 0;
+  *stopAfter = 0;
+  *reportFlags = 0;
+
+  if ((i < len) && (cmd[i] & 0x80))
+  {
+    *multiSelect = (TMR_SR_TAGOP_MULTI_SELECT == (cmd[i] & TMR_SR_TAGOP_MULTI_SELECT));
+    i++;
+  }
+  if (i + 5 > len)
+  {
+    return false;
+  }
+  *option = GETU8(cmd, i);
+  *searchFlags = GETU16(cmd, i);
+  *timeout = GETU16(cmd, i);
+  if (*searchFlags & TMR_SR_SEARCH_FLAG_TAG_STREAMING)
+  {
+    i += 2; /* async off time */
+  }
+  if (*option & TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA)
+  {
+    if (i + 2 > len)
+    {
+      return false;
+    }
+    *metadataFlags = GETU16(cmd, i);
+  }
+  if (*searchFlags & TMR_SR_SEARCH_FLAG_RETURN_ON_N_TAGS)
+  {
+    if (i + 4 > len)
+    {
+      return false;
+    }
+    *stopAfter = GETU32(cmd, i);
+  }
+  if (*searchFlags & (TMR_SR_SEARCH_FLAG_STATS_REPORT_STREAMING |
+                      TMR_SR_SEARCH_FLAG_STATUS_REPORT_STREAMING))
+  {
+    if (i + 2 > len)
+    {
+      return false;
+    }
+    *reportFlags = GETU16(cmd, i);
+    if (*searchFlags & TMR_SR_SEARCH_FLAG_STATS_REPORT_STREAMING)
+    {
+      *reportFlags &= SIM_STATS_SUPPORTED;
+    }
+    else
+    {
+      *reportFlags &= TMR_SR_STATUS_ALL;
+    }
+  }
+  return true;
+}
+
+/* Number of tags a synchronous search of @a timeout ms finds */
+static uint32_t
+sim_searchCount(SimReader *sim, uint16_t timeout)
+{
+  uint64_t count;
+
+  if (0 == sim->rate)
+  {
+    return sim->tagCount;
+  }
+  count = ((uint64_t)sim->rate * timeout) / 1000;
+  return (count < sim->tagCount) ? (uint32_t)count : sim->tagCount;
+}
+
+/* Run a synchronous search, filling the tag buffer */
+static uint32_t
+sim_search(SimReader *sim, uint16_t timeout)
+{
+  sim->bufferStart = sim->cursor;
+  sim->bufferCount = sim_searchCount(sim, timeout);
+  sim->bufferPos = 0;
+  sim->cursor = (sim->cursor + sim->bufferCount) % sim->tagCount;
+  if (0 != sim->rate)
+  {
+    /* Hold the response back for as long as the search runs */
+    sim->busyUntil = sim_nowMs() + timeout;
+  }
+  return sim->bufferCount;
+}
+
+/* Begin continuous reading as described by a 0x22 sub-command */
+static uint16_t
+sim_startStreaming(SimReader *sim, const uint8_t *cmd, uint8_t len)
+{
+  uint16_t timeout;
+
+  if ((len < 1) || (TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE != cmd[0]))
+  {
+    return 0x0109;
+  }
+  if (!sim_parseSearch(sim, cmd + 1, len - 1, &sim->multiSelect, &sim->option,
+                       &sim->searchFlags, &timeout, &sim->metadataFlags,
+                       &sim->stopAfter, &sim->reportFlags))
+  {
+    return 0x0105;
+  }
+  sim->cycleMs = timeout ? timeout : 1;
+  sim->streamStart = sim->lastReport = sim_nowMs();
+  sim->readsSent = 0;
+  sim->stopReported = false;
+  sim->streaming = true;
+  return 0;
+}
+
+/*
+ * Skip the Gen2 filter and password fields of a tag operation starting
+ * at @a i. On success @a i points past them and @a index is the tag the
+ * operation applies to: the one whose EPC matches an EPC filter, or the
+ * first tag of the population for every other filter.
+ */
+static bool
+sim_parseTarget(SimReader *sim, const uint8_t *cmd, uint8_t len, uint8_t *i,
+                uint8_t option, bool usePassword, bool multiSelect, uint32_t *index)
+{
+  uint8_t select = option & 0x07;
+  uint16_t bits;
+
+  *index = 0;
+  if (TMR_SR_GEN2_SINGULATION_OPTION_SELECT_DISABLED == select)
+  {
+    /* Neither filter nor password */
+    return true;
+  }
+  if (usePassword && (TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_LENGTH_OF_EPC != select))
+  {
+    *i += 4;
+  }
+
+  switch (select)
+  {
+  case TMR_SR_GEN2_SINGULATION_OPTION_USE_PASSWORD:
+    break;
+
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_EPC:
+    if (option & TMR_SR_GEN2_SINGULATION_OPTION_EXTENDED_DATA_LENGTH)
+    {
+      bits = GETU16(cmd, *i);
+    }
+    else
+    {
+      bits = GETU8(cmd, *i);
+    }
+    if (*i + tm_u8s_per_bits(bits) > len)
+    {
+      return false;
+    }
+    {
+      uint32_t t;
+
+      for (t = 0; t < sim->tagCount; t++)
+      {
+        if ((sim->tags[t].epcLen == tm_u8s_per_bits(bits)) &&
+            (0 == memcmp(sim->tags[t].epc, cmd + *i, sim->tags[t].epcLen)))
+        {
+          *index = t;
+          break;
+        }
+      }
+    }
+    *i += tm_u8s_per_bits(bits);
+    break;
+
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_TID:
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_USER_MEM:
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_ADDRESSED_EPC:
+    *i += 4; /* bit pointer */
+    if (option & TMR_SR_GEN2_SINGULATION_OPTION_EXTENDED_DATA_LENGTH)
+    {
+      bits = GETU16(cmd, *i);
+    }
+    else
+    {
+      bits = GETU8(cmd, *i);
+    }
+    *i += tm_u8s_per_bits(bits);
+    break;
+
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_LENGTH_OF_EPC:
+    *i += 2;
+    break;
+
+  default:
+    return false;
+  }
+
+  if (multiSelect && (TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_EPC != select))
+  {
+    *i += 3; /* target, action, end of select */
+  }
+  return (*i <= len);
+}
+
+/* Bytes of a Gen2 memory bank, or NULL if the bank is not emulated */
+static uint8_t *
+sim_bank(SimReader *sim, uint32_t index, uint8_t bank, uint8_t *scratch, uint16_t *size)
+{
+  SimTag *tag = &sim->tags[index];
+
+  switch (bank)
+  {
+  case TMR_GEN2_BANK_RESERVED:
+    *size = SIM_RESERVED_BYTES;
+    return tag->reserved;
+
+  case TMR_GEN2_BANK_EPC:
+    {
+      uint16_t crc = tm_crc(tag->epc, tag->epcLen);
+
+      scratch[0] = (uint8_t)(crc >> 8);
+      scratch[1] = (uint8_t)crc;
+      scratch[2] = (uint8_t)((tag->epcLen / 2) << 3);
+      scratch[3] = 0;
+      memcpy(scratch + 4, tag->epc, tag->epcLen);
+      *size = 4 + tag->epcLen;
+      return scratch;
+    }
+
+  case TMR_GEN2_BANK_TID:
+    scratch[0] = 0xE2;
+    scratch[1] = 0x80;
+    scratch[2] = 0x11;
+    scratch[3] = 0x05;
+    memset(scratch + 4, 0, SIM_TID_BYTES - 4);
+    scratch[SIM_TID_BYTES - 4] = (uint8_t)(index >> 24);
+    scratch[SIM_TID_BYTES - 3] = (uint8_t)(index >> 16);
+    scratch[SIM_TID_BYTES - 2] = (uint8_t)(index >> 8);
+    scratch[SIM_TID_BYTES - 1] = (uint8_t)index;
+    *size = SIM_TID_BYTES;
+    return scratch;
+
+  case TMR_GEN2_BANK_USER:
+    *size = SIM_USER_BYTES;
+    return tag->user;
+
+  default:
+    return NULL;
+  }
+}
+
+/* 0x28: read tag memory, answering with metadata followed by the words */
+static uint16_t
+sim_readTagData(SimReader *sim, const uint8_t *cmd, uint8_t len, uint8_t *rsp, uint8_t *rlen)
+{
+  uint8_t i = 3, option, bank, words, scratch[4 + SIM_MAX_EPC_BYTES];
+  uint16_t flags = 0, size;
+  uint32_t address, index;
+  uint8_t *mem;
+  bool multiSelect = false;
+
+  if ((i < len) && (cmd[i] & 0x80))
+  {
+    multiSelect = true;
+    i++;
+  }
+  if (i + 7 > len)
+  {
+    return 0x0105;
+  }
+  option = GETU8(cmd, i);
+  if (option & TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA)
+  {
+    flags = GETU16(cmd, i);
+  }
+  bank = GETU8(cmd, i);
+  address = GETU32(cmd, i);
+  words = GETU8(cmd, i);
+  if (!sim_parseTarget(sim, cmd, len, &i, option, true, multiSelect, &index))
+  {
+    return 0x0105;
+  }
+
+  mem = sim_bank(sim, index, bank, scratch, &size);
+  if (NULL == mem)
+  {
+    return 0x0109;
+  }
+  if (0 == words)
+  {
+    words = (uint8_t)((size / 2) > address ? (size / 2) - address : 0);
+  }
+  if ((address + words) * 2 > size)
+  {
+    return 0x0423;
+  }
+
+  *rlen = 0;
+  if (multiSelect)
+  {
+    SIM_PUT8(rsp, *rlen, TMR_SR_TAGOP_MULTI_SELECT);
+  }
+  SIM_PUT8(rsp, *rlen, option);
+  if (option & TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA)
+  {
+    uint8_t before;
+
+    SIM_PUT16(rsp, *rlen, flags);
+    /* Same metadata as a tag record; the EPC part is dropped again below */
+    before = *rlen;
+    sim_addTagRecord(sim, rsp, rlen, flags, index, 0, 0);
+    *rlen = before + (*rlen - before) - (6 + sim->tags[index].epcLen +
+      ((flags & TMR_TRD_METADATA_FLAG_BRAND_IDENTIFIER) ? 2 : 0));
+  }
+  if (*rlen + words * 2 > SIM_MAX_DATA)
+  {
+    return 0x0105;
+  }
+  memcpy(rsp + *rlen, mem + address * 2, words * 2);
+  *rlen += words * 2;
+  return 0;
+}
+
+/* 0x24: write tag memory */
+static uint16_t
+sim_writeTagData(SimReader *sim, const uint8_t *cmd, uint8_t len)
+{
+  uint8_t i = 3, option, bank, scratch[4 + SIM_MAX_EPC_BYTES];
+  uint16_t size, count;
+  uint32_t address, index;
+  uint8_t *mem;
+  bool multiSelect = false;
+
+  if ((i < len) && (cmd[i] & 0x80))
+  {
+    multiSelect = (TMR_SR_TAGOP_MULTI_SELECT == (cmd[i] & TMR_SR_TAGOP_MULTI_SELECT));
+    if (TMR_SR_TAGOP_READ_AFTER_WRITE == (cmd[i] & TMR_SR_TAGOP_READ_AFTER_WRITE))
+    {
+      return 0x0109;
+    }
+    i++;
+  }
+  if (i + 6 > len)
+  {
+    return 0x0105;
+  }
+  option = GETU8(cmd, i);
+  address = GETU32(cmd, i);
+  bank = GETU8(cmd, i);
+  if (!sim_parseTarget(sim, cmd, len, &i, option, true, multiSelect, &index))
+  {
+    return 0x0105;
+  }
+  count = len - i;
+
+  mem = sim_bank(sim, index, bank, scratch, &size);
+  if ((NULL == mem) || (TMR_GEN2_BANK_TID == bank))
+  {
+    return 0x0109;
+  }
+  if (address * 2 + count > size)
+  {
+    return 0x0423;
+  }
+  memcpy(mem + address * 2, cmd + i, count);
+  if (TMR_GEN2_BANK_EPC == bank)
+  {
+    /* Only the EPC words are writable; CRC and PC are derived */
+    memcpy(sim->tags[index].epc, scratch + 4, sim->tags[index].epcLen);
+  }
+  return 0;
+}
+
+/* 0x23: write a new EPC */
+static uint16_t
+sim_writeTagEpc(SimReader *sim, const uint8_t *cmd, uint8_t len)
+{
+  uint8_t i = 3, option, count;
+  uint32_t index;
+  bool multiSelect = false;
+
+  if ((i < len) && (cmd[i] & 0x80))
+  {
+    multiSelect = true;
+    i++;
+  }
+  if (i + 1 > len)
+  {
+    return 0x0105;
+  }
+  option = GETU8(cmd, i);
+  if (!sim_parseTarget(sim, cmd, len, &i, option, true, multiSelect, &index))
+  {
+    return 0x0105;
+  }
+  if (0 == option)
+  {
+    i++; /* RFU */
+  }
+  count = (i < len) ? (uint8_t)(len - i) : 0;
+  if ((0 == count) || (SIM_MAX_EPC_BYTES < count) || (count & 1))
+  {
+    return 0x0105;
+  }
+  sim->tags[index].epcLen = count;
+  if (count > sim->maxEpcLen)
+  {
+    sim->maxEpcLen = count;
+  }
+  memcpy(sim->tags[index].epc, cmd + i, count);
+  return 0;
+}
+
+/* 0x6A: get a reader configuration value */
+static void
+sim_getConfig(SimReader *sim, uint8_t key, uint8_t *rsp, uint8_t *rlen)
+{
+  *rlen = 0;
+  SIM_PUT8(rsp, *rlen, 1);
+  SIM_PUT8(rsp, *rlen, key);
+  switch (key)
+  {
+  case TMR_SR_CONFIGURATION_CURRENT_MSG_TRANSPORT:
+    SIM_PUT8(rsp, *rlen, TMR_SR_MSG_SOURCE_SERIAL);
+    break;
+  case TMR_SR_CONFIGURATION_SEND_CRC:
+    SIM_PUT8(rsp, *rlen, sim->crc ? 1 : 0);
+    break;
+  case TMR_SR_CONFIGURATION_READ_FILTER_TIMEOUT:
+    SIM_PUT32(rsp, *rlen, sim->config[key]);
+    break;
+  case TMR_SR_CONFIGURATION_PRODUCT_GROUP_ID:
+  case TMR_SR_CONFIGURATION_PRODUCT_ID:
+    SIM_PUT16(rsp, *rlen, 0);
+    break;
+  default:
+    SIM_PUT8(rsp, *rlen, sim->config[key]);
+    break;
+  }
+}
+
+/*
+ * Execute one command. The response payload goes into @a rsp; the
+ * return value is the module status word.
+ */
+static uint16_t
+sim_execute(SimReader *sim, const uint8_t *cmd, uint8_t len, uint8_t *rsp, uint8_t *rlen)
+{
+  uint8_t opcode = cmd[0];
+  uint8_t i;
+
+  *rlen = 0;
+  switch (opcode)
+  {
+  case TMR_SR_OPCODE_VERSION:
+  case TMR_SR_OPCODE_BOOT_FIRMWARE:
+    {
+      static const uint8_t version[] = {
+        0x12, 0x08, 0x01, 0x00,     /* bootloader */
+        TMR_SR_MODEL_M6E, 0x00, 0x00, 0x01,  /* hardware */
+        0x20, 0x23, 0x01, 0x01,     /* firmware date */
+        0x01, 0x0B, 0x00, 0x01,     /* firmware version */
+        0x00, 0x00, 0x00, 0x10,     /* protocols: Gen2 */
+      };
+      memcpy(rsp, version, sizeof(version));
+      *rlen = sizeof(version);
+      return 0;
+    }
+
+  case TMR_SR_OPCODE_GET_CURRENT_PROGRAM:
+    SIM_PUT8(rsp, *rlen, 0x01); /* application */
+    return 0;
+
+  case TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE:
+    {
+      bool multiSelect;
+      uint8_t option;
+      uint16_t searchFlags, timeout, metadataFlags, reportFlags;
+      uint32_t stopAfter, count;
+
+      if (!sim_parseSearch(sim, cmd + 1, len - 1, &multiSelect, &option, &searchFlags,
+                           &timeout, &metadataFlags, &stopAfter, &reportFlags))
+      {
+        return 0x0105;
+      }
+      if (searchFlags & TMR_SR_SEARCH_FLAG_EMBEDDED_COMMAND)
+      {
+        return 0x0109;
+      }
+      count = sim_search(sim, timeout);
+      if (multiSelect)
+      {
+        SIM_PUT8(rsp, *rlen, TMR_SR_TAGOP_MULTI_SELECT);
+      }
+      SIM_PUT8(rsp, *rlen, option);
+      SIM_PUT16(rsp, *rlen, searchFlags);
+      SIM_PUT32(rsp, *rlen, count);
+      return count ? 0 : 0x0400;
+    }
+
+  case TMR_SR_OPCODE_GET_TAG_ID_BUFFER:
+    if (1 == len)
+    {
+      /* Tags remaining, as read and write indexes */
+      SIM_PUT16(rsp, *rlen, (uint16_t)sim->bufferPos);
+      SIM_PUT16(rsp, *rlen, (uint16_t)sim->bufferCount);
+      return 0;
+    }
+    else
+    {
+      uint16_t flags;
+      uint8_t countAt;
+      uint8_t count = 0;
+
+      if (4 > len)
+      {
+        return 0x0105;
+      }
+      flags = GETU16AT(cmd, 1);
+      SIM_PUT16(rsp, *rlen, flags);
+      SIM_PUT8(rsp, *rlen, cmd[3]);
+      countAt = (*rlen)++;
+      while ((sim->bufferPos < sim->bufferCount) &&
+             (*rlen + sim_recordSize(sim) <= SIM_MAX_DATA))
+      {
+        sim_addTagRecord(sim, rsp, rlen, flags,
+                         (sim->bufferStart + sim->bufferPos) % sim->tagCount,
+                         sim->bufferPos, sim->bufferPos);
+        sim->bufferPos++;
+        count++;
+      }
+      rsp[countAt] = count;
+      return 0;
+    }
+
+  case TMR_SR_OPCODE_CLEAR_TAG_ID_BUFFER:
+    sim->bufferCount = sim->bufferPos = 0;
+    return 0;
+
+  case TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP:
+    {
+      uint16_t timeout;
+      uint8_t option;
+
+      if (4 > len)
+      {
+        return 0x0105;
+      }
+      timeout = GETU16AT(cmd, 1);
+      option = cmd[3];
+      if (0x01 == option)
+      {
+        /* Continuous reading: sub-opcode, search flags, [N], protocol, length, command */
+        uint16_t status;
+
+        i = 4;
+        if (i + 3 > len)
+        {
+          return 0x0105;
+        }
+        i++;
+        if (GETU16(cmd, i) & TMR_SR_SEARCH_FLAG_RETURN_ON_N_TAGS)
+        {
+          i += 4;
+        }
+        if (i + 2 > len)
+        {
+          return 0x0105;
+        }
+        i++; /* protocol */
+        status = sim_startStreaming(sim, cmd + i + 1, (uint8_t)(cmd[i] + 1));
+        SIM_PUT8(rsp, *rlen, 0x01);
+        return status;
+      }
+      else if (0x02 == option)
+      {
+        sim->streaming = false;
+        SIM_PUT8(rsp, *rlen, 0x02);
+        return 0;
+      }
+      else if (0x11 == option)
+      {
+        /* Synchronous search over one or more protocols */
+        uint32_t count = 0;
+
+        sim->bufferStart = sim->cursor;
+        count = sim_search(sim, timeout);
+        SIM_PUT16(rsp, *rlen, timeout);
+        SIM_PUT8(rsp, *rlen, option);
+        SIM_PUT8(rsp, *rlen, TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE);
+        SIM_PUT32(rsp, *rlen, count);
+        return count ? 0 : 0x0400;
+      }
+      return 0x0109;
+    }
+
+  case TMR_SR_OPCODE_READ_TAG_DATA:
+    return sim_readTagData(sim, cmd, len, rsp, rlen);
+
+  case TMR_SR_OPCODE_WRITE_TAG_DATA:
+    return sim_writeTagData(sim, cmd, len);
+
+  case TMR_SR_OPCODE_WRITE_TAG_ID:
+    return sim_writeTagEpc(sim, cmd, len);
+
+  case TMR_SR_OPCODE_LOCK_TAG:
+  case TMR_SR_OPCODE_KILL_TAG:
+    /* Accepted; the emulated tags have no access control */
+    return 0;
+
+  case TMR_SR_OPCODE_GET_ANTENNA_PORT:
+    if ((2 <= len) && (5 == cmd[1]))
+    {
+      uint8_t port;
+
+      SIM_PUT8(rsp, *rlen, 5);
+      for (port = 1; port <= sim->antennaCount; port++)
+      {
+        SIM_PUT8(rsp, *rlen, port);
+        SIM_PUT8(rsp, *rlen, 1);
+      }
+      return 0;
+    }
+    else if ((2 <= len) && (4 == cmd[1]))
+    {
+      uint8_t port;
+
+      SIM_PUT8(rsp, *rlen, 4);
+      SIM_PUT8(rsp, *rlen, (3 <= len) ? cmd[2] : 0);
+      for (port = 1; port <= sim->antennaCount; port++)
+      {
+        SIM_PUT8(rsp, *rlen, port);
+        SIM_PUT16(rsp, *rlen, (uint16_t)sim->readPower);
+        SIM_PUT16(rsp, *rlen, (uint16_t)sim->readPower);
+        SIM_PUT16(rsp, *rlen, 0);
+      }
+      return 0;
+    }
+    else
+    {
+      /* Current tx and rx ports */
+      SIM_PUT8(rsp, *rlen, 1);
+      SIM_PUT8(rsp, *rlen, 1);
+      return 0;
+    }
+
+  case TMR_SR_OPCODE_GET_READ_TX_POWER:
+  case TMR_SR_OPCODE_GET_WRITE_TX_POWER:
+    SIM_PUT8(rsp, *rlen, (2 <= len) ? cmd[1] : 0);
+    SIM_PUT16(rsp, *rlen, (uint16_t)sim->readPower);
+    if ((2 <= len) && (1 == cmd[1]))
+    {
+      SIM_PUT16(rsp, *rlen, 3000);
+      SIM_PUT16(rsp, *rlen, 500);
+    }
+    return 0;
+
+  case TMR_SR_OPCODE_GET_TAG_PROTOCOL:
+    SIM_PUT16(rsp, *rlen, sim->protocol);
+    return 0;
+
+  case TMR_SR_OPCODE_GET_REGION:
+    SIM_PUT8(rsp, *rlen, sim->region);
+    return 0;
+
+  case TMR_SR_OPCODE_GET_POWER_MODE:
+    SIM_PUT8(rsp, *rlen, 0);
+    return 0;
+
+  case TMR_SR_OPCODE_GET_READER_OPTIONAL_PARAMS:
+    if ((3 <= len) && (1 == cmd[1]))
+    {
+      sim_getConfig(sim, cmd[2], rsp, rlen);
+      return 0;
+    }
+    return 0x0105;
+
+  case TMR_SR_OPCODE_GET_PROTOCOL_PARAM:
+    for (i = 1; (i < len) && (i < 3); i++)
+    {
+      SIM_PUT8(rsp, *rlen, cmd[i]);
+    }
+    SIM_PUT32(rsp, *rlen, 0);
+    return 0;
+
+  case TMR_SR_OPCODE_GET_READER_STATS:
+    if ((2 <= len) && (TMR_SR_READER_STATS_OPTION_GET_PER_PORT == cmd[1]))
+    {
+      uint8_t flagLen = 1, ebv[8], at = 2;
+      uint16_t flags = 0;
+
+      if (3 <= len)
+      {
+        flagLen = parseEBVdata((uint8_t *)cmd, ebv, &at);
+        flags = (uint16_t)TMR_SR_convertFromEBV(ebv, flagLen);
+      }
+      SIM_PUT8(rsp, *rlen, cmd[1]);
+      sim_addStats(sim, rsp, rlen, flags & SIM_STATS_SUPPORTED);
+      return 0;
+    }
+    else if ((2 <= len) && (TMR_SR_READER_STATS_OPTION_RESET == cmd[1]))
+    {
+      return 0;
+    }
+    return 0x0109;
+
+  case TMR_SR_OPCODE_GET_AVAILABLE_PROTOCOLS:
+    SIM_PUT16(rsp, *rlen, TMR_TAG_PROTOCOL_GEN2);
+    return 0;
+
+  case TMR_SR_OPCODE_GET_AVAILABLE_REGIONS:
+    SIM_PUT8(rsp, *rlen, TMR_REGION_NA);
+    SIM_PUT8(rsp, *rlen, TMR_REGION_EU3);
+    SIM_PUT8(rsp, *rlen, TMR_REGION_OPEN);
+    return 0;
+
+  case TMR_SR_OPCODE_GET_TEMPERATURE:
+    SIM_PUT8(rsp, *rlen, 32);
+    return 0;
+
+  case TMR_SR_OPCODE_SET_TAG_PROTOCOL:
+    if (3 <= len)
+    {
+      sim->protocol = (uint8_t)GETU16AT(cmd, 1);
+    }
+    return 0;
+
+  case TMR_SR_OPCODE_SET_REGION:
+    if (2 <= len)
+    {
+      sim->region = cmd[1];
+    }
+    return 0;
+
+  case TMR_SR_OPCODE_SET_READ_TX_POWER:
+    if (3 <= len)
+    {
+      sim->readPower = (int16_t)GETU16AT(cmd, 1);
+    }
+    return 0;
+
+  case TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS:
+    if ((4 <= len) && (1 == cmd[1]))
+    {
+      sim->config[cmd[2]] = cmd[3];
+      if (TMR_SR_CONFIGURATION_SEND_CRC == cmd[2])
+      {
+        /* Takes effect from this command's response onwards */
+        sim->crc = (0 != cmd[3]);
+      }
+    }
+    return 0;
+
+  case TMR_SR_OPCODE_SET_BAUD_RATE:
+  case TMR_SR_OPCODE_SET_ANTENNA_PORT:
+  case TMR_SR_OPCODE_SET_WRITE_TX_POWER:
+  case TMR_SR_OPCODE_SET_FREQ_HOP_TABLE:
+  case TMR_SR_OPCODE_SET_USER_GPIO_OUTPUTS:
+  case TMR_SR_OPCODE_SET_POWER_MODE:
+  case TMR_SR_OPCODE_SET_USER_MODE:
+  case TMR_SR_OPCODE_SET_PROTOCOL_PARAM:
+  case TMR_SR_OPCODE_SET_USER_PROFILE:
+    return 0;
+
+  default:
+    return 0x0102;
+  }
+}
+
+/* Act on a complete, CRC-checked command frame */
+static void
+sim_dispatch(SimReader *sim, const uint8_t *frame)
+{
+  uint8_t rsp[TMR_SR_MAX_PACKET_SIZE];
+  uint8_t rlen = 0;
+  uint8_t len = frame[1];
+  const uint8_t *cmd = frame + 2;
+  uint16_t status;
+
+  if ((TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP == cmd[0]) && (5 <= len) && (0x04 == cmd[3]))
+  {
+    /* A command sent while streaming, wrapped so it rides along with the tag reads */
+    uint8_t inner[TMR_SR_MAX_PACKET_SIZE];
+    uint8_t innerLen = 0;
+    uint8_t wrapped = cmd[4];
+
+    if (wrapped + 6 > len + 1)
+    {
+      sim_reply(sim, cmd[0], 0x0105, NULL, 0);
+      return;
+    }
+    status = sim_execute(sim, cmd + 5, (uint8_t)(wrapped + 1), inner, &innerLen);
+    rsp[rlen++] = 0x04;
+    rsp[rlen++] = innerLen;
+    rsp[rlen++] = cmd[5];
+    rsp[rlen++] = (uint8_t)(status >> 8);
+    rsp[rlen++] = (uint8_t)status;
+    memcpy(rsp + rlen, inner, innerLen);
+    rlen += innerLen;
+    sim_reply(sim, cmd[0], 0, rsp, rlen);
+    return;
+  }
+
+  status = sim_execute(sim, cmd, (uint8_t)(len + 1), rsp, &rlen);
+  sim_reply(sim, cmd[0], status, rsp, rlen);
+}
+
+static TMR_Status
+sim_open(TMR_SR_SerialTransport *this)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  SimReader *sim;
+  pthread_condattr_t attr;
+  TMR_Status ret;
+
+  if (NULL != c->sim)
+  {
+    return TMR_SUCCESS;
+  }
+
+  sim = calloc(1, sizeof(*sim));
+  if (NULL == sim)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  ret = sim_parseOptions(sim, c->devicename);
+  if (TMR_SUCCESS != ret)
+  {
+    free(sim->tags);
+    free(sim);
+    return ret;
+  }
+
+  sim->crc = true;
+  sim->region = TMR_REGION_NA;
+  sim->protocol = TMR_TAG_PROTOCOL_GEN2;
+  sim->readPower = 3000;
+  sim->bootTime = sim_nowMs();
+
+  pthread_mutex_init(&sim->lock, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&sim->cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  c->sim = sim;
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+sim_sendBytes(TMR_SR_SerialTransport *this, uint32_t length,
+              uint8_t* message, const uint32_t timeoutMs)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  SimReader *sim = c->sim;
+  uint32_t used;
+
+  if (NULL == sim)
+  {
+    return TMR_ERROR_COMM_ERRNO(EBADF);
+  }
+
+  pthread_mutex_lock(&sim->lock);
+  while (0 < length)
+  {
+    used = sizeof(sim->in) - sim->inLen;
+    if (used > length)
+    {
+      used = length;
+    }
+    memcpy(sim->in + sim->inLen, message, used);
+    sim->inLen += used;
+    message += used;
+    length -= used;
+
+    for (;;)
+    {
+      uint32_t frameLen;
+
+      /* Drop anything that can't start a frame, such as wake-up preambles */
+      while ((0 < sim->inLen) &&
+             ((0xFF != sim->in[0]) || ((1 < sim->inLen) && (0xF8 < sim->in[1]))))
+      {
+        memmove(sim->in, sim->in + 1, --sim->inLen);
+      }
+      if (2 > sim->inLen)
+      {
+        break;
+      }
+      frameLen = sim->in[1] + 5;
+      if (sim->inLen < frameLen)
+      {
+        break;
+      }
+      {
+        uint16_t crc = tm_crc(sim->in + 1, sim->in[1] + 2);
+
+        if (((crc >> 8) == sim->in[frameLen - 2]) && ((crc & 0xFF) == sim->in[frameLen - 1]))
+        {
+          sim_dispatch(sim, sim->in);
+        }
+        else
+        {
+          sim_reply(sim, sim->in[2], 0x0100, NULL, 0);
+        }
+      }
+      sim->inLen -= frameLen;
+      memmove(sim->in, sim->in + frameLen, sim->inLen);
+    }
+  }
+  pthread_cond_broadcast(&sim->cond);
+  pthread_mutex_unlock(&sim->lock);
+
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+sim_receiveBytes(TMR_SR_SerialTransport *this, uint32_t length,
+                 uint32_t* messageLength, uint8_t* message, const uint32_t timeoutMs)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  SimReader *sim = c->sim;
+  uint64_t deadline, now, next;
+  TMR_Status ret = TMR_SUCCESS;
+
+  *messageLength = 0;
+  if (NULL == sim)
+  {
+    return TMR_ERROR_COMM_ERRNO(EBADF);
+  }
+
+  deadline = sim_nowMs() + timeoutMs;
+  pthread_mutex_lock(&sim->lock);
+  while (*messageLength < length)
+  {
+    uint32_t avail = sim->outTail - sim->outHead;
+
+    now = sim_nowMs();
+    if ((0 < avail) && (now >= sim->busyUntil))
+    {
+      if (avail > length - *messageLength)
+      {
+        avail = length - *messageLength;
+      }
+      memcpy(message + *messageLength, sim->out + sim->outHead, avail);
+      sim->outHead += avail;
+      *messageLength += avail;
+      if (sim->outHead == sim->outTail)
+      {
+        sim->outHead = sim->outTail = 0;
+      }
+      continue;
+    }
+
+    if (0 < avail)
+    {
+      /* A timed search is still running */
+      next = sim->busyUntil;
+    }
+    else
+    {
+      next = sim_stream(sim, now);
+      if (sim->outTail != sim->outHead)
+      {
+        continue;
+      }
+    }
+    if (now >= deadline)
+    {
+      ret = TMR_ERROR_TIMEOUT;
+      break;
+    }
+    if ((0 == next) || (next > deadline))
+    {
+      next = deadline;
+    }
+    if (next > now)
+    {
+      struct timespec ts;
+
+      ts.tv_sec = (time_t)(next / 1000);
+      ts.tv_nsec = (long)((next % 1000) * 1000000);
+      pthread_cond_timedwait(&sim->cond, &sim->lock, &ts);
+    }
+  }
+  pthread_mutex_unlock(&sim->lock);
+
+  return ret;
+}
+
+static TMR_Status
+sim_setBaudRate(TMR_SR_SerialTransport *this, uint32_t rate)
+{
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+sim_shutdown(TMR_SR_SerialTransport *this)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  SimReader *sim = c->sim;
+
+  if (NULL == sim)
+  {
+    return TMR_ERROR_INVALID;
+  }
+  c->sim = NULL;
+  pthread_cond_destroy(&sim->cond);
+  pthread_mutex_destroy(&sim->lock);
+  free(sim->tags);
+  free(sim);
+  return TMR_SUCCESS;
+}
+
+static TMR_Status
+sim_flush(TMR_SR_SerialTransport *this)
+{
+  TMR_SR_SerialPortNativeContext *c = this->cookie;
+  SimReader *sim = c->sim;
+
+  if (NULL == sim)
+  {
+    return TMR_ERROR_INVALID;
+  }
+  pthread_mutex_lock(&sim->lock);
+  sim->inLen = 0;
+  sim->outHead = sim->outTail = 0;
+  pthread_mutex_unlock(&sim->lock);
+  return TMR_SUCCESS;
+}
+
+/**
+ * Initialize a TMR_SR_SerialTransport structure with an emulated
+ * module. Register it for a URI scheme and create the reader with
+ * options in place of a device name:
+ *
+ * @code
+ * TMR_setSerialTransport("sim", &TMR_SR_SerialTransportSimInit);
+ * TMR_create(&reader, "sim:///tags=1000,rate=20000,antennas=2");
+ * @endcode
+ *
+ * Options: @c tags (population size, default 100), @c rate (tag reads
+ * per second while streaming and during timed searches; 0, the default,
+ * answers as fast as the host reads), @c epc (EPC bytes, default 12),
+ * @c antennas (1-4) and @c seed (EPC generator seed).
+ *
+ * Tag operations act on the tag matched by an EPC filter, or on the
+ * first tag of the population otherwise.
+ *
+ * @param transport The TMR_SR_SerialTransport structure to initialize.
+ * @param context A TMR_SR_SerialPortNativeContext structure for the callbacks to use.
+ * @param device The emulator options
+ */
+TMR_Status
+TMR_SR_SerialTransportSimInit(TMR_SR_SerialTransport *transport,
+                              TMR_SR_SerialPortNativeContext *context,
+                              const char *device)
+{
+  if (strlen(device) + 1 > sizeof(context->devicename))
+  {
+    return TMR_ERROR_INVALID;
+  }
+  strcpy(context->devicename, device);
+  context->handle = -1;
+  context->sim = NULL;
+
+  transport->cookie = context;
+  transport->open = sim_open;
+  transport->sendBytes = sim_sendBytes;
+  transport->receiveBytes = sim_receiveBytes;
+  transport->setBaudRate = sim_setBaudRate;
+  transport->shutdown = sim_shutdown;
+  transport->flush = sim_flush;
+
+  return TMR_SUCCESS;
+}
+
+#endif /* TMR_ENABLE_SERIAL_TRANSPORT_SIM */
@@ -29,10 +29,14 @@
  */
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
@@ -42,97 +46,231 @@
 #include "tm_reader.h"
 
 #ifdef TMR_ENABLE_SERIAL_TRANSPORT_NATIVE
+
+/* Milliseconds on the monotonic clock, immune to wall-clock steps */
+static uint64_t
+tcp_monotonicMs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/*
+ * Wait until the socket is ready for the given events or the deadline
+ * passes. Returns TMR_ERROR_TIMEOUT on expiry.
+ */
 static TMR_Status
-tcp_open(TMR_SR_SerialTransport *this)
+tcp_wait(int sock, short events, uint64_t deadline)
+{
+  struct pollfd pfd;
+  uint64_t now;
+  int rc;
+
+  for (;;)
+  {
+    now = tcp_monotonicMs();
+    if (now >= deadline)
+    {
+      return TMR_ERROR_TIMEOUT;
+    }
+    pfd.fd = sock;
+    pfd.events = events;
+    pfd.revents = 0;
+    rc = poll(&pfd, 1, (int)(deadline - now));
+    if (rc > 0)
+    {
+      return TMR_SUCCESS;
+    }
+    if (0 == rc)
+    {
+      return TMR_ERROR_TIMEOUT;
+    }
+    if (EINTR != errno)
+    {
+      return TMR_ERROR_COMM_ERRNO(errno);
+    }
+  }
+}
+
+/*
+ * Start a non-blocking connect to one address and wait for it to
+ * complete. On success *sockOut holds the connected socket. A refused
+ * or failed connect returns TMR_ERROR_INVALID, as the blocking connect
+ * did; TMR_ERROR_TIMEOUT means the deadline passed.
+ */
+static TMR_Status
+tcp_connectOne(const struct addrinfo *ai, uint64_t deadline, int *sockOut)
 {
+  TMR_Status ret;
   int sock;
-  const char *port;
+  int err;
+  socklen_t errLen;
+
+  sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+  if (0 > sock)
+  {
+    return TMR_ERROR_COMM_ERRNO(errno);
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+  fcntl(sock, F_SETFD, FD_CLOEXEC);
+
+  if (0 == connect(sock, ai->ai_addr, ai->ai_addrlen))
+  {
+    *sockOut = sock;
+    return TMR_SUCCESS;
+  }
+  if (EINPROGRESS != errno)
+  {
+    ret = TMR_ERROR_INVALID;
+  }
+  else
+  {
+    ret = tcp_wait(sock, POLLOUT, deadline);
+    if (TMR_SUCCESS == ret)
+    {
+      errLen = sizeof(err);
+      if ((0 == getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &errLen)) && (0 == err))
+      {
+        *sockOut = sock;
+        return TMR_SUCCESS;
+      }
+      ret = TMR_ERROR_INVALID;
+    }
+  }
+
+  close(sock);
+  return ret;
+}
+
+static TMR_Status
+tcp_open(TMR_SR_SerialTransport *this)
+{
+  int sock = -1;
+  const char *host, *port;
   char hostCopy[256];
-  TMR_Status ret;
-  int portNum = 0;
+  char portCopy[8];
   TMR_SR_SerialPortNativeContext *c; 
+  struct addrinfo hints;
+  struct addrinfo *hostAddress, *ai;
+  uint64_t deadline;
+  int flag;
+  TMR_Status ret;
 
   c = this->cookie;
-  port = strchr(c->devicename, ':');
-  strcpy(hostCopy, c->devicename + 1);
-  portNum = atoi(port + 1);
-  hostCopy[port - c->devicename -1 ] = '\0';
-
-  static const struct addrinfo addrInfoMask =
-  {    
-    0,   
-    AF_INET,
-    SOCK_STREAM,
-    0,                                                                                                                                                             
-    0,   
-    NULL,
-    NULL,
-    NULL 
-  };   
-  struct addrinfo *           hostAddress;
-  int                         flag;
-  struct sockaddr_in          sin; 
-  int                         rc;
 
   /*
-   * Look up host using getaddrinfo().
-   * Gethostbyname() could be configured a lot of
-   * different ways. There is /etc/hosts, DNS, NIS, etc, etc.
-   * Suffice to say it is big, bulky, and susceptible to stall.
+   * The device name is "/host:port", where host may be a name, an
+   * IPv4 address or a bracketed IPv6 address ("/[::1]:port").
    */
-  if(0 != getaddrinfo(hostCopy, NULL, &addrInfoMask, &hostAddress))
+  host = c->devicename;
+  if ('/' == *host)
   {
-    return TMR_ERROR_INVALID;
+    host++;
   }
+  if ('[' == *host)
+  {
+    const char *close = strchr(host, ']');
 
-  /*
-   * Convert the address to sockaddr_in format
-   */
-  memset(&sin, 0, sizeof sin);
-  sin.sin_family = AF_INET;
-  sin.sin_addr = ((struct sockaddr_in *)(hostAddress->ai_addr))->sin_addr;
-  sin.sin_port = htons(portNum);
+    if ((NULL == close) || (':' != close[1]))
+    {
+      return TMR_ERROR_INVALID;
+    }
+    host++;
+    port = close + 1;
+  }
+  else
+  {
+    port = strrchr(host, ':');
+  }
+  if ((NULL == port) || (port == host) || ((size_t)(port - host) >= sizeof(hostCopy)))
+  {
+    return TMR_ERROR_INVALID;
+  }
+  memcpy(hostCopy, host, port - host);
+  hostCopy[port - host] = '\0';
+  if (']' == hostCopy[port - host - 1])
+  {
+    hostCopy[port - host - 1] = '\0';
+  }
+  strncpy(portCopy, port + 1, sizeof(portCopy) - 1);
+  portCopy[sizeof(portCopy) - 1] = '\0';
+  portCopy[strcspn(portCopy, "/")] = '\0';
 
-  /*
-   * Done withe the host addrinfo
-   */
-  freeaddrinfo(hostAddress);
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_NUMERICSERV | AI_ADDRCONFIG;
 
   /*
-   * Create the socket.
+   * Look up host using getaddrinfo(). Numeric addresses resolve
+   * immediately; names may still wait on the system resolver.
    */
-  sock = socket(AF_INET, SOCK_STREAM, 0);
-  if(0 > sock)
+  if (0 != getaddrinfo(hostCopy, portCopy, &hints, &hostAddress))
   {
     return TMR_ERROR_INVALID;
   }
 
   /*
-   * Connect the socket to reader. This can stall.
+   * Try every address the name resolved to, all within one deadline,
+   * so that an unreachable reader fails in TMR_SR_TCP_CONNECT_TIMEOUT_MS
+   * rather than the kernel's TCP timeout. Once the deadline has
+   * passed the remaining addresses cannot be tried either.
    */
-  rc = connect(sock, (struct sockaddr *)&sin, sizeof sin);
-  if(0 > rc)
+  deadline = tcp_monotonicMs() + TMR_SR_TCP_CONNECT_TIMEOUT_MS;
+  ret = TMR_ERROR_INVALID;
+  for (ai = hostAddress; NULL != ai; ai = ai->ai_next)
   {
-    /* Connect failed */
-    close(sock);
-    return TMR_ERROR_INVALID;
+    ret = tcp_connectOne(ai, deadline, &sock);
+    if ((TMR_SUCCESS == ret) || (TMR_ERROR_TIMEOUT == ret))
+    {
+      break;
+    }
+  }
+  freeaddrinfo(hostAddress);
+
+  if (TMR_SUCCESS != ret)
+  {
+    return ret;
   }
 
   /*
-   * Best effort to set no delay. If this doesn't work
+   * Best effort to set no delay and keepalive. If this doesn't work
    * (no reason it shouldn't) we do not declare defeat.
    */
   flag = 1;
   setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void*)&flag, sizeof flag);
+  setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (void*)&flag, sizeof flag);
+#ifdef TCP_KEEPIDLE
+  flag = TMR_SR_TCP_KEEPALIVE_IDLE_S;
+  setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, (void*)&flag, sizeof flag);
+#endif
+#ifdef TCP_KEEPINTVL
+  flag = TMR_SR_TCP_KEEPALIVE_INTERVAL_S;
+  setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, (void*)&flag, sizeof flag);
+#endif
+#ifdef TCP_KEEPCNT
+  flag = TMR_SR_TCP_KEEPALIVE_COUNT;
+  setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, (void*)&flag, sizeof flag);
+#endif
 
   /*
    * Record the socket in the connection instance
    */
   c->handle = sock;
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+  c->rxHead = c->rxTail = 0;
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  /* Any failure leaves c->uring NULL, and reads go through poll() */
+  if (c->uringWanted)
+  {
+    TMR_SR_uringAttach(c, true);
+  }
+#endif
 
-  ret = TMR_SUCCESS;
- 
-  return ret;
+  return TMR_SUCCESS;
 }
 
 
@@ -141,20 +279,45 @@ tcp_sendBytes(TMR_SR_SerialTransport *this, uint32_t length,
                 uint8_t* message, const uint32_t timeoutMs)
 {
   TMR_SR_SerialPortNativeContext *c;
-  int ret;
+  struct iovec iov;
+  struct msghdr msg;
+  uint64_t deadline;
+  TMR_Status status;
+  ssize_t ret;
 
   c = this->cookie;
-  do 
+  deadline = tcp_monotonicMs() + timeoutMs;
+
+  memset(&msg, 0, sizeof(msg));
+  iov.iov_base = message;
+  iov.iov_len = length;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  while (iov.iov_len > 0)
   {
-    ret = write(c->handle, message, length);
+    /* MSG_NOSIGNAL: a reader that went away is an error, not a SIGPIPE */
+    ret = sendmsg(c->handle, &msg, MSG_NOSIGNAL);
     if (ret == -1)
     {
+      if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+      {
+        status = tcp_wait(c->handle, POLLOUT, deadline);
+        if (TMR_SUCCESS != status)
+        {
+          return status;
+        }
+        continue;
+      }
+      if (EINTR == errno)
+      {
+        continue;
+      }
       return TMR_ERROR_COMM_ERRNO(errno);
     }
-    length -= ret;
-    message += ret;
+    iov.iov_base = (uint8_t *)iov.iov_base + ret;
+    iov.iov_len -= ret;
   }
-  while (length > 0);
 
   return TMR_SUCCESS;
 }
@@ -164,62 +327,7 @@ static TMR_Status
 tcp_receiveBytes(TMR_SR_SerialTransport *this, uint32_t length, 
                    uint32_t* messageLength, uint8_t* message, const uint32_t timeoutMs)
 {
-  TMR_SR_SerialPortNativeContext *c;
-  int ret;
-  struct timeval tv;
-  fd_set set;
-  int status = 0;
-
-  *messageLength = 0;
-  c = this->cookie;
-
-  do
-  {
-    FD_ZERO(&set);
-    FD_SET(c->handle, &set);
-    tv.tv_sec = timeoutMs/1000;
-    tv.tv_usec = (timeoutMs % 1000) * 1000;
-    /* Ideally should reset this timeout value every time through */
-    ret = select(c->handle + 1, &set, NULL, NULL, &tv);
-    if (ret < 1)
-    {
-      return TMR_ERROR_TIMEOUT;
-    }
-    ret = read(c->handle, message, length);
-    if (ret == -1)
-    {
-      return TMR_ERROR_COMM_ERRNO(errno);
-    }
-
-    if (0 == ret)
-    {
-      /**
-       * We should not be here, coming here means the select()
-       * is success , but we are not able to read the data.
-       * check the serial port connection status.
-       **/
-      ret = ioctl(c->handle, TIOCMGET, &status);
-      if (-1 == ret)
-      {
-        /* not success. check for errno */
-        if (EIO == errno)
-        {
-          /**
-           * EIO means I/O error, may serial port got disconnected,
-           * throw the error.
-           **/
-          return TMR_ERROR_TIMEOUT;
-        }
-      }
-    }
-
-    length -= ret;
-    *messageLength += ret;
-    message += ret;
-  }
-  while (length > 0);
-
-  return TMR_SUCCESS;
+  return TMR_SR_nativeReceiveBytes(this->cookie, length, messageLength, message, timeoutMs);
 }
 
 #if 0
@@ -249,6 +357,9 @@ tcp_shutdown(TMR_SR_SerialTransport *this)
 		ret = TMR_ERROR_INVALID;
 	}
 
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+	TMR_SR_uringDetach(c);
+#endif
 	close(c->handle);
 
 	c->handle = -1;
@@ -260,11 +371,34 @@ tcp_shutdown(TMR_SR_SerialTransport *this)
 static TMR_Status
 tcp_flush(TMR_SR_SerialTransport *this)
 {
+  TMR_SR_SerialPortNativeContext *c;
+  uint8_t discard[256];
+  ssize_t rc;
 
   /* This routine should empty any input or output buffers in the
-   * communication channel. If there are no such buffers, it may do
-   * nothing.
+   * communication channel. Output can not be recalled once written to
+   * the socket, but stale input is drained without blocking.
    */
+  c = this->cookie;
+  if (0 > c->handle)
+  {
+    return TMR_SUCCESS;
+  }
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+  c->rxHead = c->rxTail = 0;
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  if (NULL != c->uring)
+  {
+    TMR_SR_uringFlush(c);
+  }
+#endif
+
+  do
+  {
+    rc = recv(c->handle, discard, sizeof(discard), MSG_DONTWAIT);
+  }
+  while (rc > 0);
 
   return TMR_SUCCESS;
 }
@@ -295,7 +429,28 @@ TMR_SR_SerialTransportTcpNativeInit(TMR_SR_SerialTransport *transport,
   transport->setBaudRate = NULL;
   transport->shutdown = tcp_shutdown;
   transport->flush = tcp_flush;
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  context->uring = NULL;
+  context->uringWanted = false;
+#endif
 
   return TMR_SUCCESS;
 }
+
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+TMR_Status
+TMR_SR_SerialTransportTcpUringInit(TMR_SR_SerialTransport *transport,
+                                   TMR_SR_SerialPortNativeContext *context,
+                                   const char *device)
+{
+  TMR_Status ret;
+
+  ret = TMR_SR_SerialTransportTcpNativeInit(transport, context, device);
+  if (TMR_SUCCESS == ret)
+  {
+    context->uringWanted = true;
+  }
+  return ret;
+}
+#endif
 #endif
@@ -0,0 +1,597 @@
+/**
+ *  @file serial_transport_uring.c
+ *  @brief Mercury API - io_uring receive path for the POSIX serial and TCP transports
+ *
+ *  Keeps one multishot read (or, on sockets, multishot recv) armed on
+ *  the transport handle, with the kernel filling buffers from a
+ *  registered buffer ring. While the module streams tag reads, the
+ *  frames are already in memory when the serial reader asks for them,
+ *  and a single io_uring_enter() both re-arms and waits when they are
+ *  not. The native transports fall back to their poll() receive path
+ *  when the kernel can not provide any of this.
+ */
+
+/*
+ * Copyright (c) 2023 Novanta, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "tm_reader.h"
+
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+
+#include <linux/io_uring.h>
+
+/*
+ * IORING_OP_READ_MULTISHOT (Linux 6.7). Kernel headers older than the
+ * running kernel lack the enum value; opcodes are a stable ABI.
+ */
+#define URING_OP_READ_MULTISHOT 49
+
+/* Provided receive buffers; the count must be a power of two */
+#define URING_BUF_COUNT 16
+#define URING_BUF_SIZE 1024
+#define URING_BUF_GROUP 0
+
+/* user_data of the receive request and of its cancellation */
+#define URING_TAG_RX 1
+#define URING_TAG_CANCEL 2
+
+/* How long shutdown waits for the kernel to retire the receive request */
+#define URING_CANCEL_TIMEOUT_MS 100
+
+typedef struct UringFilled
+{
+  uint16_t bid;
+  uint16_t off;
+  uint16_t len;
+} UringFilled;
+
+typedef struct UringSession
+{
+  int ringFd;
+  int handle;
+  bool socket;
+
+  /* Submission queue */
+  void *sqMap;
+  size_t sqMapLen;
+  unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+  struct io_uring_sqe *sqes;
+  size_t sqesLen;
+
+  /* Completion queue; shares sqMap with IORING_FEAT_SINGLE_MMAP */
+  void *cqMap;
+  size_t cqMapLen;
+  unsigned *cqHead, *cqTail, *cqMask;
+  struct io_uring_cqe *cqes;
+
+  /* Registered buffer ring, with the buffers on the following pages */
+  struct io_uring_buf_ring *bufRing;
+  uint8_t *bufs;
+  size_t bufMapLen;
+  size_t bufOffset;
+  uint16_t bufTail;
+
+  /* Buffers the kernel has filled, oldest first, not yet handed out */
+  UringFilled filled[URING_BUF_COUNT];
+  uint8_t filledHead, filledCount;
+
+  /* Whether a receive request is outstanding */
+  bool armed;
+  /* Cleared when the kernel rejects multishot receives */
+  bool multishot;
+  /* Whether the receive side reached end of file */
+  bool eof;
+  /* errno of a failed receive, reported once buffered data is gone */
+  int error;
+} UringSession;
+
+static uint64_t
+uring_monotonicMs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+static int
+uring_enter(UringSession *s, unsigned minComplete, uint64_t timeoutMs)
+{
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  unsigned toSubmit;
+
+  toSubmit = *s->sqTail - __atomic_load_n(s->sqHead, __ATOMIC_ACQUIRE);
+
+  ts.tv_sec = timeoutMs / 1000;
+  ts.tv_nsec = (timeoutMs % 1000) * 1000000;
+  memset(&arg, 0, sizeof(arg));
+  arg.ts = (uint64_t)(uintptr_t)&ts;
+
+  /* Submission and the wait for the first completion share one system call */
+  if (0 > syscall(__NR_io_uring_enter, s->ringFd, toSubmit, minComplete,
+                  IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)))
+  {
+    return errno;
+  }
+  return 0;
+}
+
+static struct io_uring_sqe *
+uring_getSqe(UringSession *s)
+{
+  unsigned tail, index;
+  struct io_uring_sqe *sqe;
+
+  tail = *s->sqTail;
+  if (tail - __atomic_load_n(s->sqHead, __ATOMIC_ACQUIRE) > *s->sqMask)
+  {
+    return NULL;
+  }
+  index = tail & *s->sqMask;
+  sqe = &s->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  s->sqArray[index] = index;
+  return sqe;
+}
+
+static void
+uring_pushSqe(UringSession *s)
+{
+  __atomic_store_n(s->sqTail, *s->sqTail + 1, __ATOMIC_RELEASE);
+}
+
+/* Hand a buffer back to the kernel */
+static void
+uring_recycle(UringSession *s, uint16_t bid)
+{
+  struct io_uring_buf *buf;
+
+  buf = &s->bufRing->bufs[s->bufTail & (URING_BUF_COUNT - 1)];
+  buf->addr = (uint64_t)(uintptr_t)(s->bufs + ((size_t)bid * URING_BUF_SIZE));
+  buf->len = URING_BUF_SIZE;
+  buf->bid = bid;
+  s->bufTail++;
+  __atomic_store_n(&s->bufRing->tail, s->bufTail, __ATOMIC_RELEASE);
+}
+
+static void
+uring_arm(UringSession *s)
+{
+  struct io_uring_sqe *sqe;
+
+  sqe = uring_getSqe(s);
+  if (NULL == sqe)
+  {
+    return;
+  }
+  sqe->fd = s->handle;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = URING_BUF_GROUP;
+  sqe->user_data = URING_TAG_RX;
+  if (s->socket)
+  {
+    sqe->opcode = IORING_OP_RECV;
+    if (s->multishot)
+    {
+      sqe->ioprio = IORING_RECV_MULTISHOT;
+    }
+  }
+  else
+  {
+    sqe->opcode = s->multishot ? URING_OP_READ_MULTISHOT : IORING_OP_READ;
+    sqe->off = (uint64_t)-1;
+    if (!s->multishot)
+    {
+      sqe->len = URING_BUF_SIZE;
+    }
+  }
+  uring_pushSqe(s);
+  s->armed = true;
+}
+
+/* Move every completion into the filled list; never blocks */
+static void
+uring_reap(UringSession *s)
+{
+  unsigned head, tail;
+
+  head = *s->cqHead;
+  tail = __atomic_load_n(s->cqTail, __ATOMIC_ACQUIRE);
+  while (head != tail)
+  {
+    struct io_uring_cqe *cqe = &s->cqes[head & *s->cqMask];
+
+    if (URING_TAG_RX == cqe->user_data)
+    {
+      if (cqe->flags & IORING_CQE_F_BUFFER)
+      {
+        uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+
+        if ((0 < cqe->res) && (URING_BUF_COUNT > s->filledCount))
+        {
+          UringFilled *f;
+
+          f = &s->filled[(s->filledHead + s->filledCount) & (URING_BUF_COUNT - 1)];
+          f->bid = bid;
+          f->off = 0;
+          f->len = (uint16_t)cqe->res;
+          s->filledCount++;
+        }
+        else
+        {
+          uring_recycle(s, bid);
+        }
+      }
+      if (0 == cqe->res)
+      {
+        s->eof = true;
+      }
+      else if ((-EINVAL == cqe->res) && s->multishot)
+      {
+        /* Kernel predates multishot reads on this kind of handle */
+        s->multishot = false;
+      }
+      else if ((0 > cqe->res) && (-ENOBUFS != cqe->res) && (-ECANCELED != cqe->res))
+      {
+        s->error = -cqe->res;
+      }
+      if (0 == (cqe->flags & IORING_CQE_F_MORE))
+      {
+        s->armed = false;
+      }
+    }
+    head++;
+  }
+  __atomic_store_n(s->cqHead, head, __ATOMIC_RELEASE);
+}
+
+static void
+uring_free(UringSession *s)
+{
+  if (0 <= s->ringFd)
+  {
+    close(s->ringFd);
+  }
+  if (NULL != s->bufRing)
+  {
+    munmap(s->bufRing, s->bufMapLen);
+  }
+  if (NULL != s->sqes)
+  {
+    munmap(s->sqes, s->sqesLen);
+  }
+  if ((NULL != s->cqMap) && (s->cqMap != s->sqMap))
+  {
+    munmap(s->cqMap, s->cqMapLen);
+  }
+  if (NULL != s->sqMap)
+  {
+    munmap(s->sqMap, s->sqMapLen);
+  }
+  free(s);
+}
+
+/**
+ * Set up io_uring receives on an open transport handle. On failure the
+ * context is left untouched and the caller keeps using poll().
+ *
+ * @param c The native context, with its handle already open.
+ * @param socket Whether the handle is a socket rather than a tty.
+ */
+TMR_Status
+TMR_SR_uringAttach(TMR_SR_SerialPortNativeContext *c, bool socket)
+{
+  UringSession *s;
+  struct io_uring_params p;
+  struct io_uring_buf_reg reg;
+  long page;
+  uint16_t i;
+  void *map;
+  int err;
+
+  /* Reopened without a shutdown in between */
+  TMR_SR_uringDetach(c);
+
+  s = calloc(1, sizeof(*s));
+  if (NULL == s)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  s->ringFd = -1;
+  s->handle = c->handle;
+  s->socket = socket;
+  s->multishot = true;
+
+  /* Room for a completion per buffer, so multishot never overflows */
+  memset(&p, 0, sizeof(p));
+  p.flags = IORING_SETUP_CQSIZE;
+  p.cq_entries = 2 * URING_BUF_COUNT;
+  s->ringFd = (int)syscall(__NR_io_uring_setup, 4, &p);
+  if (0 > s->ringFd)
+  {
+    err = errno;
+    goto fail;
+  }
+  if (0 == (p.features & IORING_FEAT_EXT_ARG))
+  {
+    err = ENOSYS;
+    goto fail;
+  }
+
+  s->sqMapLen = p.sq_off.array + (p.sq_entries * sizeof(unsigned));
+  s->cqMapLen = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    if (s->cqMapLen > s->sqMapLen)
+    {
+      s->sqMapLen = s->cqMapLen;
+    }
+    s->cqMapLen = s->sqMapLen;
+  }
+  map = mmap(NULL, s->sqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             s->ringFd, IORING_OFF_SQ_RING);
+  if (MAP_FAILED == map)
+  {
+    err = errno;
+    goto fail;
+  }
+  s->sqMap = map;
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    s->cqMap = s->sqMap;
+  }
+  else
+  {
+    map = mmap(NULL, s->cqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+               s->ringFd, IORING_OFF_CQ_RING);
+    if (MAP_FAILED == map)
+    {
+      err = errno;
+      goto fail;
+    }
+    s->cqMap = map;
+  }
+  s->sqesLen = p.sq_entries * sizeof(struct io_uring_sqe);
+  map = mmap(NULL, s->sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             s->ringFd, IORING_OFF_SQES);
+  if (MAP_FAILED == map)
+  {
+    err = errno;
+    goto fail;
+  }
+  s->sqes = map;
+
+  s->sqHead = (unsigned *)((uint8_t *)s->sqMap + p.sq_off.head);
+  s->sqTail = (unsigned *)((uint8_t *)s->sqMap + p.sq_off.tail);
+  s->sqMask = (unsigned *)((uint8_t *)s->sqMap + p.sq_off.ring_mask);
+  s->sqArray = (unsigned *)((uint8_t *)s->sqMap + p.sq_off.array);
+  s->cqHead = (unsigned *)((uint8_t *)s->cqMap + p.cq_off.head);
+  s->cqTail = (unsigned *)((uint8_t *)s->cqMap + p.cq_off.tail);
+  s->cqMask = (unsigned *)((uint8_t *)s->cqMap + p.cq_off.ring_mask);
+  s->cqes = (struct io_uring_cqe *)((uint8_t *)s->cqMap + p.cq_off.cqes);
+
+  /* The buffer ring must be page aligned; the buffers follow it */
+  page = sysconf(_SC_PAGESIZE);
+  s->bufOffset = (URING_BUF_COUNT * sizeof(struct io_uring_buf) + page - 1) & ~(size_t)(page - 1);
+  s->bufMapLen = s->bufOffset + (URING_BUF_COUNT * URING_BUF_SIZE);
+  map = mmap(NULL, s->bufMapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == map)
+  {
+    err = errno;
+    goto fail;
+  }
+  s->bufRing = map;
+  s->bufs = (uint8_t *)map + s->bufOffset;
+
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (uint64_t)(uintptr_t)s->bufRing;
+  reg.ring_entries = URING_BUF_COUNT;
+  reg.bgid = URING_BUF_GROUP;
+  if (0 > syscall(__NR_io_uring_register, s->ringFd, IORING_REGISTER_PBUF_RING, &reg, 1))
+  {
+    err = errno;
+    goto fail;
+  }
+  for (i = 0; i < URING_BUF_COUNT; i++)
+  {
+    uring_recycle(s, i);
+  }
+
+  if (!socket)
+  {
+    struct termios t;
+
+    /*
+     * With VMIN 0 an empty tty reads as zero bytes, which io_uring
+     * takes for end of file. Let readiness come from the kernel instead.
+     */
+    if ((0 == tcgetattr(s->handle, &t)) && (0 == t.c_cc[VMIN]))
+    {
+      t.c_cc[VMIN] = 1;
+      if (0 != tcsetattr(s->handle, TCSANOW, &t))
+      {
+        err = errno;
+        goto fail;
+      }
+    }
+  }
+
+  c->uring = s;
+  return TMR_SUCCESS;
+
+fail:
+  uring_free(s);
+  return TMR_ERROR_COMM_ERRNO(err);
+}
+
+/**
+ * Retire the outstanding receive and release the ring. The transport
+ * handle itself is left open.
+ */
+void
+TMR_SR_uringDetach(TMR_SR_SerialPortNativeContext *c)
+{
+  UringSession *s;
+  struct io_uring_sqe *sqe;
+  uint64_t deadline, now;
+
+  s = c->uring;
+  if (NULL == s)
+  {
+    return;
+  }
+  c->uring = NULL;
+
+  /* The buffers must not be unmapped while the kernel may still fill them */
+  if (s->armed)
+  {
+    sqe = uring_getSqe(s);
+    if (NULL != sqe)
+    {
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = URING_TAG_RX;
+      sqe->user_data = URING_TAG_CANCEL;
+      uring_pushSqe(s);
+    }
+    deadline = uring_monotonicMs() + URING_CANCEL_TIMEOUT_MS;
+    while (s->armed)
+    {
+      now = uring_monotonicMs();
+      if ((now >= deadline) || ((0 != uring_enter(s, 1, deadline - now)) && (EINTR != errno)))
+      {
+        break;
+      }
+      uring_reap(s);
+    }
+  }
+  uring_free(s);
+}
+
+/**
+ * Receive path used in place of TMR_SR_nativeReceiveBytes() once
+ * TMR_SR_uringAttach() has succeeded. Same contract: the timeout
+ * covers the whole receive.
+ */
+TMR_Status
+TMR_SR_uringReceiveBytes(TMR_SR_SerialPortNativeContext *c, uint32_t length,
+                         uint32_t *messageLength, uint8_t *message, uint32_t timeoutMs)
+{
+  UringSession *s;
+  uint64_t deadline, now;
+  int err;
+
+  s = c->uring;
+  *messageLength = 0;
+  deadline = uring_monotonicMs() + timeoutMs;
+
+  while (length > 0)
+  {
+    if (0 < s->filledCount)
+    {
+      UringFilled *f = &s->filled[s->filledHead];
+      uint32_t avail = f->len - f->off;
+
+      if (avail > length)
+      {
+        avail = length;
+      }
+      memcpy(message, s->bufs + ((size_t)f->bid * URING_BUF_SIZE) + f->off, avail);
+      f->off += avail;
+      message += avail;
+      length -= avail;
+      *messageLength += avail;
+      if (f->off == f->len)
+      {
+        uring_recycle(s, f->bid);
+        s->filledHead = (s->filledHead + 1) & (URING_BUF_COUNT - 1);
+        s->filledCount--;
+      }
+      continue;
+    }
+
+    uring_reap(s);
+    if (0 < s->filledCount)
+    {
+      continue;
+    }
+    if (0 != s->error)
+    {
+      err = s->error;
+      s->error = 0;
+      return TMR_ERROR_COMM_ERRNO(err);
+    }
+    if (s->eof)
+    {
+      /* Peer closed or device went away, as the poll path reports it */
+      return TMR_ERROR_TIMEOUT;
+    }
+
+    now = uring_monotonicMs();
+    if (now >= deadline)
+    {
+      return TMR_ERROR_TIMEOUT;
+    }
+    if (!s->armed)
+    {
+      uring_arm(s);
+    }
+    err = uring_enter(s, 1, deadline - now);
+    if ((0 != err) && (ETIME != err) && (EINTR != err) && (EBUSY != err))
+    {
+      return TMR_ERROR_COMM_ERRNO(err);
+    }
+  }
+
+  return TMR_SUCCESS;
+}
+
+/**
+ * Discard received data that has not been handed to the caller yet.
+ */
+void
+TMR_SR_uringFlush(TMR_SR_SerialPortNativeContext *c)
+{
+  UringSession *s;
+
+  s = c->uring;
+  uring_reap(s);
+  while (0 < s->filledCount)
+  {
+    uring_recycle(s, s->filled[s->filledHead].bid);
+    s->filledHead = (s->filledHead + 1) & (URING_BUF_COUNT - 1);
+    s->filledCount--;
+  }
+  s->error = 0;
+}
+
+#endif /* TMR_ENABLE_SERIAL_TRANSPORT_URING */
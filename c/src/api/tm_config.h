@@ -176,6 +176,35 @@ extern "C" {
 /* Define the macro to enable flush bytes. */
 #define TMR_ENABLE_WAKE_PREAMBLES                                       0
 
+#if TMR_ENABLE_WAKE_PREAMBLES
+/**
+ * A module that answered a command within this many milliseconds is
+ * assumed to still be awake and gets no wake-up preamble.
+ */
+#define TMR_SR_WAKE_IDLE_MS                                             50
+/* Number of 8-byte 0xFF blocks in a full wake-up preamble. */
+#define TMR_SR_WAKE_PREAMBLE_BLOCKS                                     25
+/* Delay between wake-up preamble blocks, in milliseconds. */
+#define TMR_SR_WAKE_PREAMBLE_DELAY_MS                                   9
+/**
+ * Response timeout of the power mode probe sent when the power mode
+ * of the module is not known yet.
+ */
+#define TMR_SR_WAKE_PROBE_TIMEOUT_MS                                    100
+#endif /* TMR_ENABLE_WAKE_PREAMBLES */
+
+/**
+ * Number of consecutive receive failures after which the serial reader
+ * falls back from discarding stale input to the full TMR_flush().
+ */
+#define TMR_SR_FULL_FLUSH_THRESHOLD                                     3
+
+/**
+ * Maximum number of bytes scanned for the next valid frame after a
+ * CRC error before the receive gives up.
+ */
+#define TMR_SR_RESYNC_MAX_BYTES                                         512
+
 /**
   Define TMR_ENABLE_CRC for USB interface.
 */
@@ -262,6 +291,37 @@ extern "C" {
  */
 #define TMR_LLRP_KEEP_ALIVE_TIMEOUT 5000
 
+/**
+ * SO_RCVBUF to request for the LLRP reader socket, in bytes. A larger
+ * buffer rides out bursts of tag reports while the reads are being
+ * processed. 0 keeps the system default.
+ */
+#define TMR_LLRP_SOCKET_RCVBUF 0
+
+/**
+ * Set to 1 to hand transport listeners compact LLRP XML: no
+ * indentation, and each message on a single line. Cheaper to render
+ * and log when listening at full report rate. Needs an LTKC with
+ * LTKC_HAS_XML_GROWABLE; ignored otherwise.
+ */
+#define TMR_LLRP_TRANSPORT_XML_COMPACT 0
+
+/**
+ * Set to 0 to send the LLRP connect-time queries one at a time,
+ * waiting for each response, for readers that can't take several
+ * requests in flight. See TMR_LLRP_getConnectTimings().
+ */
+#define TMR_LLRP_CONNECT_PIPELINE 1
+
+/**
+ * Set to 0 to send the ADD_ACCESSSPEC and ENABLE_ACCESSSPEC of a
+ * standalone LLRP tag operation one at a time, waiting for each
+ * response. START_ROSPEC waits for both either way, so a tag operation
+ * that reuses its ROSpec costs two round trips with this set and three
+ * without. See TMR_LLRP_startTagOp().
+ */
+#define TMR_LLRP_TAGOP_PIPELINE 1
+
 /** To build API for baremetal plateform. */
 //#define BARE_METAL
 
@@ -308,6 +368,73 @@ Note:To run readsync_baremetal codelet you have to
 
 #define TMR_ENABLE_BACKGROUND_READS
 
+/**
+ * Define this to include TMR_startTransportCapture(), which records
+ * every frame sent to or received from the reader into a binary
+ * capture file using a background writer thread. When the capture is
+ * not running the cost on the I/O path is a single pointer test.
+ */
+#if !defined(WIN32) && !defined(WINCE)
+#define TMR_ENABLE_TRANSPORT_CAPTURE
+#endif
+
+/**
+ * Size of the receive buffer of the native serial transport. Each
+ * read pulls everything the driver has ready into this buffer, so a
+ * whole response usually costs a single system call.
+ */
+#define TMR_SR_NATIVE_RX_BUFFER_SIZE 2048
+
+/**
+ * Time allowed for the TCP serial transport to connect to a networked
+ * module, across all addresses its name resolves to.
+ */
+#define TMR_SR_TCP_CONNECT_TIMEOUT_MS 3000
+
+/**
+ * TCP keepalive tuning for the TCP serial transport, so that a dead
+ * module is noticed within about IDLE + INTERVAL * COUNT seconds.
+ */
+#define TMR_SR_TCP_KEEPALIVE_IDLE_S 10
+#define TMR_SR_TCP_KEEPALIVE_INTERVAL_S 2
+#define TMR_SR_TCP_KEEPALIVE_COUNT 3
+
+/**
+ * Define this to include the sim:// serial transport, a software
+ * emulation of an EAPI module used to test and benchmark the serial
+ * reader without hardware. See TMR_SR_SerialTransportSimInit().
+ */
+#if !defined(WIN32) && !defined(WINCE)
+#define TMR_ENABLE_SERIAL_TRANSPORT_SIM
+#endif
+
+/**
+ * Define this to include the replay:// serial transport, which answers
+ * the serial reader from a capture written by TMR_startTransportCapture().
+ * See TMR_SR_SerialTransportReplayInit().
+ */
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+#define TMR_ENABLE_SERIAL_TRANSPORT_REPLAY
+#endif
+
+/**
+ * Define this to include the io_uring receive path of the POSIX serial
+ * and TCP transports, selected with TMR_SR_SerialTransportNativeUringInit()
+ * and TMR_SR_SerialTransportTcpUringInit(). Kernels without io_uring,
+ * or with it disabled, get the poll() path.
+ */
+#if defined(__linux__)
+#define TMR_ENABLE_SERIAL_TRANSPORT_URING
+#endif
+
+/**
+ * Define this to allow baud rates without a Bxxx constant on Linux,
+ * set through the termios2 BOTHER interface.
+ */
+#if defined(__linux__)
+#define TMR_ENABLE_CUSTOM_BAUD_RATES
+#endif
+
 /**
  * Define this to include TMR_strerror().
  */
@@ -372,6 +499,24 @@ Note:To run readsync_baremetal codelet you have to
  */
 #undef TMR_ENABLE_BACKGROUND_READS
 
+/**
+ * Define this to include TMR_startTransportCapture().
+ */
+#undef TMR_ENABLE_TRANSPORT_CAPTURE
+#undef TMR_ENABLE_SERIAL_TRANSPORT_SIM
+#undef TMR_ENABLE_SERIAL_TRANSPORT_REPLAY
+#undef TMR_ENABLE_SERIAL_TRANSPORT_URING
+
+/**
+ * Size of the receive buffer of the native serial transport.
+ */
+#define TMR_SR_NATIVE_RX_BUFFER_SIZE 0
+
+/**
+ * Define this to allow baud rates without a Bxxx constant on Linux.
+ */
+#undef TMR_ENABLE_CUSTOM_BAUD_RATES
+
 /**
  * Define this to include TMR_strerror().
  */
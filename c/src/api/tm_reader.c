@@ -315,6 +315,10 @@ TMR_reader_init_internal(struct TMR_Reader *reader)
   reader->readParams.readPlan = &reader->readParams.defaultReadPlan;
   reader->connected = false;
   reader->transportListeners = NULL;
+  reader->rawTransportListeners = NULL;
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  reader->transportCapture = NULL;
+#endif
   reader->readParams.onTime = 0;
 #ifdef SINGLE_THREAD_ASYNC_READ
   reader->readParams.asyncOnTime = 250;
@@ -984,6 +988,78 @@ TMR_paramGet(struct TMR_Reader *reader, TMR_Param key, void *value)
   return ret;
 }
 
+TMR_Status
+TMR_paramGetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                 void *values[], TMR_Status status[])
+{
+  TMR_Status ret, paramRet;
+  uint32_t i;
+
+  if ((NULL == reader) ||
+      ((0 < count) && ((NULL == keys) || (NULL == values))))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+#ifdef TMR_ENABLE_LLRP_READER
+  if (TMR_READER_TYPE_LLRP == reader->readerType)
+  {
+    return TMR_LLRP_paramGetMany(reader, count, keys, values, status);
+  }
+#endif
+
+  ret = TMR_SUCCESS;
+  for (i = 0; i < count; i++)
+  {
+    paramRet = TMR_paramGet(reader, keys[i], values[i]);
+    if (NULL != status)
+    {
+      status[i] = paramRet;
+    }
+    if (TMR_SUCCESS == ret)
+    {
+      ret = paramRet;
+    }
+  }
+  return ret;
+}
+
+TMR_Status
+TMR_paramSetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                 const void *values[], TMR_Status status[])
+{
+  TMR_Status ret, paramRet;
+  uint32_t i;
+
+  if ((NULL == reader) ||
+      ((0 < count) && ((NULL == keys) || (NULL == values))))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+#ifdef TMR_ENABLE_LLRP_READER
+  if (TMR_READER_TYPE_LLRP == reader->readerType)
+  {
+    return TMR_LLRP_paramSetMany(reader, count, keys, values, status);
+  }
+#endif
+
+  ret = TMR_SUCCESS;
+  for (i = 0; i < count; i++)
+  {
+    paramRet = TMR_paramSet(reader, keys[i], values[i]);
+    if (NULL != status)
+    {
+      status[i] = paramRet;
+    }
+    if (TMR_SUCCESS == ret)
+    {
+      ret = paramRet;
+    }
+  }
+  return ret;
+}
+
 
 TMR_Status
 TMR_addTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *b)
@@ -996,13 +1072,13 @@ TMR_addTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *b)
 }
 
 
-TMR_Status
-TMR_removeTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *b)
+static TMR_Status
+removeTransportListenerBlock(TMR_TransportListenerBlock **list, TMR_TransportListenerBlock *b)
 {
   TMR_TransportListenerBlock *block, **prev;
 
-  prev = &reader->transportListeners;
-  block = reader->transportListeners;
+  prev = list;
+  block = *list;
   while (NULL != block)
   {
     if (block == b)
@@ -1022,14 +1098,36 @@ TMR_removeTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *b)
 }
 
 
-void
-TMR__notifyTransportListeners(TMR_Reader *reader, bool tx, 
-                              uint32_t dataLen, uint8_t *data,
-                              int timeout)
+TMR_Status
+TMR_removeTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *b)
+{
+  return removeTransportListenerBlock(&reader->transportListeners, b);
+}
+
+
+TMR_Status
+TMR_addRawTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *b)
 {
-  TMR_TransportListenerBlock *block;
 
-  block = reader->transportListeners;
+  b->next = reader->rawTransportListeners;
+  reader->rawTransportListeners = b;
+
+  return TMR_SUCCESS;
+}
+
+
+TMR_Status
+TMR_removeRawTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *b)
+{
+  return removeTransportListenerBlock(&reader->rawTransportListeners, b);
+}
+
+
+void
+TMR__notifyTransportListenerList(TMR_TransportListenerBlock *block, bool tx,
+                                 uint32_t dataLen, uint8_t *data,
+                                 int timeout)
+{
   while (NULL != block)
   {
     block->listener(tx, dataLen, data, timeout, block->cookie);
@@ -1037,6 +1135,17 @@ TMR__notifyTransportListeners(TMR_Reader *reader, bool tx,
   }
 }
 
+
+/* Serial frames are the same bytes for both kinds of listener */
+void
+TMR__notifyTransportListeners(TMR_Reader *reader, bool tx, 
+                              uint32_t dataLen, uint8_t *data,
+                              int timeout)
+{
+  TMR__notifyTransportListenerList(reader->transportListeners, tx, dataLen, data, timeout);
+  TMR__notifyTransportListenerList(reader->rawTransportListeners, tx, dataLen, data, timeout);
+}
+
 bool
 TMR_memoryProvider(void *cookie, uint16_t *size, uint8_t *data)
 {
@@ -336,6 +336,45 @@ typedef struct TMR_TransportListenerBlock
   struct TMR_TransportListenerBlock *next;
 } TMR_TransportListenerBlock;
 
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+/** Magic string at the start of a transport capture file */
+#define TMR_CAPTURE_MAGIC "TMRCAP01"
+/** Version of the transport capture file format */
+#define TMR_CAPTURE_VERSION 1
+/**
+ * Size of the capture file header: magic, u32 version, u32 reader type
+ * and u64 start time in microseconds, all little-endian.
+ */
+#define TMR_CAPTURE_FILE_HEADER_SIZE 24
+/**
+ * Size of each capture record header: u64 timestamp in microseconds,
+ * u32 data length, u8 flags and three reserved bytes, followed by the
+ * frame bytes.
+ */
+#define TMR_CAPTURE_RECORD_HEADER_SIZE 16
+/** Capture record flag: frame was sent to the reader */
+#define TMR_CAPTURE_FLAG_TX 0x01
+/** Capture record protocol, stored in bits 1-2 of the flags */
+#define TMR_CAPTURE_PROTOCOL_MASK 0x06
+/** Capture record protocol value for serial (EAPI) frames */
+#define TMR_CAPTURE_PROTOCOL_EAPI 0
+/** Capture record protocol value for LLRP frames */
+#define TMR_CAPTURE_PROTOCOL_LLRP 1
+
+/** Counters describing a running transport capture */
+typedef struct TMR_TransportCaptureStats
+{
+  /** Number of frames written to the capture ring */
+  uint32_t frames;
+  /** Number of frames dropped because the ring was full */
+  uint32_t dropped;
+  /** Number of frame bytes written to the capture ring */
+  uint64_t bytes;
+} TMR_TransportCaptureStats;
+
+struct TMR_TransportCapture;
+#endif /* TMR_ENABLE_TRANSPORT_CAPTURE */
+
 /** Type of functions to be registered as Status read callbacks */
 typedef void (*TMR_StatsListener)(TMR_Reader *reader, const TMR_Reader_StatsValues* value,
                                 void *cookie);
@@ -388,6 +427,11 @@ typedef struct TMR_Queue_tagReads
   } tagEntry;
 
   uint8_t bufPointer;
+#ifdef TMR_ENABLE_LLRP_READER
+  /* Raw RO_ACCESS_REPORT frame to stream tag reads from, or NULL to walk lMsg */
+  uint8_t *lFrame;
+  uint32_t lFrameLength;
+#endif
   /* Object to hold tag results */
   TMR_TagReadData trd;
   bool isStatusResponse;
@@ -456,6 +500,10 @@ struct TMR_Reader
   enum TMR_ReaderType readerType;
   bool connected;
   TMR_TransportListenerBlock *transportListeners;
+  TMR_TransportListenerBlock *rawTransportListeners;
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+  struct TMR_TransportCapture *transportCapture;
+#endif
 
   TMR_readParams readParams;
   TMR_tagOpParams tagOpParams;
@@ -984,6 +1032,41 @@ TMR_Status TMR_paramSet(struct TMR_Reader *reader, TMR_Param key, const void *va
  */
 TMR_Status TMR_paramGet(struct TMR_Reader *reader, TMR_Param key, void *value);
 
+/**
+ * @ingroup reader
+ * Get the values of several reader parameters, as TMR_paramGet() on
+ * each in turn would. On LLRP readers the queries are sent back to
+ * back, so a set of parameters costs about one round trip instead of
+ * one per parameter.
+ *
+ * @param reader The reader to operate on.
+ * @param count Number of parameters.
+ * @param keys The parameters to get.
+ * @param[out] values Pointer to each parameter value, as for TMR_paramGet().
+ * @param[out] status Status of each parameter. May be NULL.
+ * @return TMR_SUCCESS if every parameter was got, else the first error.
+ */
+TMR_Status TMR_paramGetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                            void *values[], TMR_Status status[]);
+
+/**
+ * @ingroup reader
+ * Set several reader parameters, as TMR_paramSet() on each in turn
+ * would. On LLRP readers the commands are sent back to back.
+ * Parameters whose values depend on one another are best set
+ * separately: a command is built before the parameters ahead of it
+ * in the list have taken effect, and is sent again if that changed it.
+ *
+ * @param reader The reader to operate on.
+ * @param count Number of parameters.
+ * @param keys The parameters to set.
+ * @param values Pointer to each new value, as for TMR_paramSet().
+ * @param[out] status Status of each parameter. May be NULL.
+ * @return TMR_SUCCESS if every parameter was set, else the first error.
+ */
+TMR_Status TMR_paramSetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                            const void *values[], TMR_Status status[]);
+
 /**
  * @ingroup reader
  * Reboot the reader
@@ -1194,6 +1277,72 @@ TMR_Status TMR_addTransportListener(TMR_Reader *reader, TMR_TransportListenerBlo
  */
 TMR_Status TMR_removeTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *block);
 
+/**
+ * @ingroup reader
+ *
+ * Add a listener that is called with each frame exactly as it crosses
+ * the wire. For LLRP readers this is the binary LLRP frame, where
+ * listeners added with TMR_addTransportListener() get an XML rendering
+ * of the message; for serial readers both kinds get the same bytes.
+ *
+ * @param reader The reader to operate on.
+ * @param block A structure containing a pointer to the listener
+ * function and a user-supplied cookie value to pass to the function
+ * when called.
+ */
+TMR_Status TMR_addRawTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *block);
+
+/**
+ * @ingroup reader
+ *
+ * Remove a listener added with TMR_addRawTransportListener().
+ *
+ * @param reader The reader to operate on.
+ * @param block The structure passed to TMR_addRawTransportListener().
+ */
+TMR_Status TMR_removeRawTransportListener(TMR_Reader *reader, TMR_TransportListenerBlock *block);
+
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+/**
+ * @ingroup reader
+ *
+ * Start recording every frame sent to or received from the reader
+ * into a binary capture file. Frames are copied into a ring buffer on
+ * the I/O path and written out by a background thread; if the writer
+ * falls behind, frames are dropped rather than delaying the reader.
+ * The capture can be decoded offline with the capturedecode sample.
+ *
+ * @param reader The reader to operate on.
+ * @param filename The capture file to create.
+ * @param ringSize Size of the ring buffer in bytes. Must be a power of
+ * two and at least 4096, or 0 to use the default of 1 MB.
+ */
+TMR_Status TMR_startTransportCapture(TMR_Reader *reader, const char *filename,
+                                     uint32_t ringSize);
+
+/**
+ * @ingroup reader
+ *
+ * Stop a transport capture started with TMR_startTransportCapture(),
+ * flush the remaining frames and close the file. Must not be called
+ * while another thread is communicating with the reader.
+ *
+ * @param reader The reader to operate on.
+ */
+TMR_Status TMR_stopTransportCapture(TMR_Reader *reader);
+
+/**
+ * @ingroup reader
+ *
+ * Get the counters of the running transport capture.
+ *
+ * @param reader The reader to operate on.
+ * @param stats Structure to fill in.
+ */
+TMR_Status TMR_getTransportCaptureStats(TMR_Reader *reader,
+                                        TMR_TransportCaptureStats *stats);
+#endif /* TMR_ENABLE_TRANSPORT_CAPTURE */
+
 /**
  * @ingroup reader
  * Add a listener to the list of functions that will be called for
@@ -1410,6 +1559,16 @@ void notify_stats_listeners(TMR_Reader* reader, TMR_Reader_StatsValues* stats);
 void TMR__notifyTransportListeners(TMR_Reader *reader, bool tx, 
                                    uint32_t dataLen, uint8_t *data,
                                    int timeout);
+void TMR__notifyTransportListenerList(TMR_TransportListenerBlock *block, bool tx,
+                                      uint32_t dataLen, uint8_t *data,
+                                      int timeout);
+/** Whether any transport listener, XML or raw, is registered */
+#define TMR__hasTransportListeners(reader) \
+  ((NULL != (reader)->transportListeners) || (NULL != (reader)->rawTransportListeners))
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+void TMR__captureTransportFrame(TMR_Reader *reader, bool tx, uint8_t protocol,
+                                uint32_t dataLen, const uint8_t *data);
+#endif
 
 void notify_exception_listeners(TMR_Reader *reader, TMR_Status status);
 void reset_continuous_reading(struct TMR_Reader* reader);
@@ -53,6 +53,10 @@ TMR_Status restart_reading(struct TMR_Reader *reader);
 static void *do_background_reads(void *arg);
 static void *parse_tag_reads(void *arg);
 TMR_Status process_async_response(TMR_Reader *reader);
+#ifdef TMR_ENABLE_LLRP_READER
+TMR_Status process_async_llrp_response(TMR_Reader *reader, LLRP_tSMessage *pMsg,
+                                       bool isStatusResponse);
+#endif
 
 bool isBufferOverFlow = false;
 #endif /* TMR_ENABLE_BACKGROUND_READS */
@@ -660,7 +664,32 @@ parse_tag_reads(void *arg)
           LLRP_tSRO_ACCESS_REPORT *pReport;
           LLRP_tSTagReportData *pTagReportData;
           LLRP_tSRFSurveyReportData * pRFSurveyReportData;
+          uint32_t streamed = 0;
+
+          if (NULL != tagRead->lFrame)
+          {
+            LLRP_tSMessage *pDecoded;
+            TMR_Status ret;
 
+            /**
+             * Streamed report: the tag reads come straight from the frame.
+             * Whatever the stream can't parse, the frame is decoded for,
+             * and the rest of the report is handled below. If even that
+             * fails, the user hears about the lost reads.
+             **/
+            ret = TMR_LLRP_notifyStreamedTagReads(reader, tagRead->lFrame,
+                                                  tagRead->lFrameLength, &streamed,
+                                                  &pDecoded);
+            if (TMR_SUCCESS != ret)
+            {
+              notify_exception_listeners(reader, ret);
+            }
+            if (NULL != pDecoded)
+            {
+              TMR_LLRP_freeMessage(tagRead->tagEntry.lMsg);
+              tagRead->tagEntry.lMsg = pDecoded;
+            }
+          }
           pReport = (LLRP_tSRO_ACCESS_REPORT *)tagRead->tagEntry.lMsg;
 
           for(pTagReportData = pReport->listTagReportData;
@@ -669,6 +698,13 @@ parse_tag_reads(void *arg)
           {
             TMR_TagReadData trd;
             TMR_Status ret;
+
+            if (0 < streamed)
+            {
+              /* Already notified from the frame */
+              streamed--;
+              continue;
+            }
             TMR_TRD_init(&trd);
             ret = TMR_LLRP_parseMetadataFromMessage(reader, &trd, pTagReportData);
 
@@ -836,6 +872,7 @@ parse_tag_reads(void *arg)
       else
       {
       	TMR_LLRP_freeMessage(tagRead->tagEntry.lMsg);
+        free(tagRead->lFrame);
       }
 #endif
 
@@ -861,6 +898,16 @@ process_async_response(TMR_Reader *reader)
   {
     return ret;
   }
+#ifdef TMR_ENABLE_LLRP_READER
+  if (TMR_READER_TYPE_LLRP == reader->readerType)
+  {
+    LLRP_tSMessage *pMsg;
+
+    pMsg = reader->u.llrpReader.bufResponse[0];
+    reader->u.llrpReader.bufResponse[0] = NULL;
+    return process_async_llrp_response(reader, pMsg, reader->isStatusResponse);
+  }
+#endif
   /* Decrement Queue slots */
   sem_wait(&reader->queue_slots);
 
@@ -871,13 +918,6 @@ process_async_response(TMR_Reader *reader)
     memcpy(tagRead->tagEntry.sMsg, reader->u.serialReader.bufResponse, TMR_SR_MAX_PACKET_SIZE);
     tagRead->bufPointer = reader->u.serialReader.bufPointer;
   }
-#ifdef TMR_ENABLE_LLRP_READER
-  else
-  {
-    tagRead->tagEntry.lMsg = reader->u.llrpReader.bufResponse[0];
-    reader->u.llrpReader.bufResponse[0] = NULL;
-  }
-#endif
 
   tagRead->isStatusResponse = reader->isStatusResponse;
   /**
@@ -925,6 +965,39 @@ process_async_response(TMR_Reader *reader)
   return ret;
 }
 
+#ifdef TMR_ENABLE_LLRP_READER
+/**
+ * Queue an LLRP report for the parser thread. The message is passed
+ * in rather than taken from bufResponse, so a report may be queued
+ * by whichever thread received it. A streamed report takes its raw
+ * frame along.
+ *
+ * @param reader Reader pointer
+ * @param pMsg The report, owned by the queue from here on
+ * @param isStatusResponse Whether the report carries stats rather than tags
+ */
+TMR_Status
+process_async_llrp_response(TMR_Reader *reader, LLRP_tSMessage *pMsg, bool isStatusResponse)
+{
+  TMR_Queue_tagReads *tagRead;
+
+  /* Decrement Queue slots */
+  sem_wait(&reader->queue_slots);
+
+  tagRead = (TMR_Queue_tagReads *) malloc(sizeof(TMR_Queue_tagReads));
+  tagRead->tagEntry.lMsg = pMsg;
+  TMR_LLRP_takeStreamedFrame(reader, pMsg, &tagRead->lFrame, &tagRead->lFrameLength);
+  tagRead->isStatusResponse = isStatusResponse;
+
+  /* Enqueue the tagRead into Queue */
+  enqueue(reader, tagRead);
+  /* Increment queue_length */
+  sem_post(&reader->queue_length);
+
+  return TMR_SUCCESS;
+}
+#endif
+
 static void *
 do_background_reads(void *arg)
 {
@@ -992,7 +1065,7 @@ do_background_reads(void *arg)
         {
           if (TMR_READER_TYPE_SERIAL == reader->readerType)
           {
-            reader->u.serialReader.transport.flush(&reader->u.serialReader.transport);
+            TMR_SR_recoverTransport(reader, ret);
           }
           reader->backgroundEnabled = false;
         }
@@ -1184,7 +1257,7 @@ do_background_reads(void *arg)
             if (TMR_READER_TYPE_SERIAL == reader->readerType)
             {
               /* Handling this fix for serial reader now */
-              reader->u.serialReader.transport.flush(&reader->u.serialReader.transport);
+              TMR_SR_recoverTransport(reader, ret);
             }
 
             /**
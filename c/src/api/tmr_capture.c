@@ -0,0 +1,361 @@
+/**
+ *  @file tmr_capture.c
+ *  @brief Mercury API - binary transport capture
+ *
+ *  Frames handed to the transport are copied into a lock-free ring
+ *  buffer by the I/O threads and written out to a capture file by a
+ *  background writer thread, so tracing does not stall the reader.
+ */
+
+/*
+ * Copyright (c) 2023 Novanta, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tm_reader.h"
+#include "osdep.h"
+
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+
+#include <pthread.h>
+
+/* Default ring size when the caller passes 0 (must be a power of two) */
+#define TMR_CAPTURE_DEFAULT_RING_SIZE (1u << 20)
+/* How long the writer sleeps when the ring is empty */
+#define TMR_CAPTURE_DRAIN_PERIOD_MS 5
+/* Size of the stdio buffer in front of the capture file */
+#define TMR_CAPTURE_FILE_BUFFER_SIZE (64 * 1024)
+
+#define TMR_CAPTURE_RECORD_PAD 0x80
+/*
+ * Records are kept on this alignment so that the space left before the
+ * end of the ring is always large enough for a padding record header.
+ */
+#define TMR_CAPTURE_RECORD_ALIGN 32
+
+/*
+ * Ring record header. A record is committed when len becomes non-zero;
+ * the writer zeroes every byte it consumes so that stale data can never
+ * be mistaken for a committed header.
+ */
+typedef struct TMR_CaptureRecordHdr
+{
+  /* Total record size in the ring, header and padding included */
+  uint32_t len;
+  uint32_t dataLen;
+  uint8_t flags;
+  uint8_t reserved[7];
+  uint64_t timestampUs;
+} TMR_CaptureRecordHdr;
+
+struct TMR_TransportCapture
+{
+  uint8_t *ring;
+  uint32_t size;
+  uint64_t head;
+  uint64_t tail;
+
+  uint32_t frames;
+  uint32_t dropped;
+  uint64_t bytes;
+
+  FILE *file;
+  uint8_t *fileBuf;
+  pthread_t writer;
+  bool running;
+};
+
+static uint64_t
+capture_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u);
+}
+
+static void
+capture_put_le(uint8_t *p, uint64_t value, int bytes)
+{
+  int i;
+
+  for (i = 0; i < bytes; i++)
+  {
+    p[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+/*
+ * Write every committed record between tail and head to the file and
+ * release the space back to the producers. Returns the number of bytes
+ * released.
+ */
+static uint32_t
+capture_drain(struct TMR_TransportCapture *cap)
+{
+  uint32_t released = 0;
+  uint64_t head;
+
+  head = __atomic_load_n(&cap->head, __ATOMIC_ACQUIRE);
+  while (cap->tail != head)
+  {
+    TMR_CaptureRecordHdr *hdr;
+    uint32_t len;
+
+    hdr = (TMR_CaptureRecordHdr *)(cap->ring + (cap->tail & (cap->size - 1)));
+    len = __atomic_load_n(&hdr->len, __ATOMIC_ACQUIRE);
+    if (0 == len)
+    {
+      /* Reserved but not committed yet */
+      break;
+    }
+
+    if (0 == (hdr->flags & TMR_CAPTURE_RECORD_PAD))
+    {
+      uint8_t out[TMR_CAPTURE_RECORD_HEADER_SIZE];
+
+      capture_put_le(out + 0, hdr->timestampUs, 8);
+      capture_put_le(out + 8, hdr->dataLen, 4);
+      out[12] = hdr->flags;
+      out[13] = out[14] = out[15] = 0;
+      fwrite(out, 1, sizeof(out), cap->file);
+      fwrite((uint8_t *)(hdr + 1), 1, hdr->dataLen, cap->file);
+    }
+
+    memset(hdr, 0, len);
+    __atomic_store_n(&cap->tail, cap->tail + len, __ATOMIC_RELEASE);
+    released += len;
+  }
+
+  return released;
+}
+
+static void *
+capture_writer_thread(void *arg)
+{
+  struct TMR_TransportCapture *cap = arg;
+
+  while (__atomic_load_n(&cap->running, __ATOMIC_ACQUIRE))
+  {
+    if (0 == capture_drain(cap))
+    {
+      fflush(cap->file);
+      tmr_sleep(TMR_CAPTURE_DRAIN_PERIOD_MS);
+    }
+  }
+
+  return NULL;
+}
+
+TMR_Status
+TMR_startTransportCapture(TMR_Reader *reader, const char *filename, uint32_t ringSize)
+{
+  struct TMR_TransportCapture *cap;
+  uint8_t fileHdr[TMR_CAPTURE_FILE_HEADER_SIZE];
+
+  if ((NULL == reader) || (NULL == filename))
+  {
+    return TMR_ERROR_INVALID;
+  }
+  if (NULL != reader->transportCapture)
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  if (0 == ringSize)
+  {
+    ringSize = TMR_CAPTURE_DEFAULT_RING_SIZE;
+  }
+  if ((ringSize < 4096) || (0 != (ringSize & (ringSize - 1))))
+  {
+    return TMR_ERROR_INVALID_VALUE;
+  }
+
+  cap = malloc(sizeof(*cap));
+  if (NULL == cap)
+  {
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+  memset(cap, 0, sizeof(*cap));
+  cap->size = ringSize;
+  cap->ring = calloc(1, ringSize);
+  cap->fileBuf = malloc(TMR_CAPTURE_FILE_BUFFER_SIZE);
+  if ((NULL == cap->ring) || (NULL == cap->fileBuf))
+  {
+    free(cap->ring);
+    free(cap->fileBuf);
+    free(cap);
+    return TMR_ERROR_OUT_OF_MEMORY;
+  }
+
+  cap->file = fopen(filename, "wb");
+  if (NULL == cap->file)
+  {
+    int err = errno;
+
+    free(cap->ring);
+    free(cap->fileBuf);
+    free(cap);
+    return TMR_ERROR_COMM_ERRNO(err);
+  }
+  setvbuf(cap->file, (char *)cap->fileBuf, _IOFBF, TMR_CAPTURE_FILE_BUFFER_SIZE);
+
+  memcpy(fileHdr, TMR_CAPTURE_MAGIC, 8);
+  capture_put_le(fileHdr + 8, TMR_CAPTURE_VERSION, 4);
+  capture_put_le(fileHdr + 12, (uint32_t)reader->readerType, 4);
+  capture_put_le(fileHdr + 16, capture_now_us(), 8);
+  fwrite(fileHdr, 1, sizeof(fileHdr), cap->file);
+
+  cap->running = true;
+  if (0 != pthread_create(&cap->writer, NULL, capture_writer_thread, cap))
+  {
+    fclose(cap->file);
+    free(cap->ring);
+    free(cap->fileBuf);
+    free(cap);
+    return TMR_ERROR_NO_THREADS;
+  }
+
+  __atomic_store_n(&reader->transportCapture, cap, __ATOMIC_RELEASE);
+  return TMR_SUCCESS;
+}
+
+TMR_Status
+TMR_stopTransportCapture(TMR_Reader *reader)
+{
+  struct TMR_TransportCapture *cap;
+
+  if (NULL == reader)
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  cap = __atomic_exchange_n(&reader->transportCapture, NULL, __ATOMIC_ACQ_REL);
+  if (NULL == cap)
+  {
+    return TMR_SUCCESS;
+  }
+
+  __atomic_store_n(&cap->running, false, __ATOMIC_RELEASE);
+  pthread_join(cap->writer, NULL);
+
+  /* Pick up anything committed after the writer's last pass */
+  capture_drain(cap);
+  fclose(cap->file);
+
+  free(cap->ring);
+  free(cap->fileBuf);
+  free(cap);
+
+  return TMR_SUCCESS;
+}
+
+TMR_Status
+TMR_getTransportCaptureStats(TMR_Reader *reader, TMR_TransportCaptureStats *stats)
+{
+  struct TMR_TransportCapture *cap;
+
+  if ((NULL == reader) || (NULL == stats))
+  {
+    return TMR_ERROR_INVALID;
+  }
+
+  cap = __atomic_load_n(&reader->transportCapture, __ATOMIC_ACQUIRE);
+  if (NULL == cap)
+  {
+    return TMR_ERROR_NOT_FOUND;
+  }
+
+  stats->frames = __atomic_load_n(&cap->frames, __ATOMIC_RELAXED);
+  stats->dropped = __atomic_load_n(&cap->dropped, __ATOMIC_RELAXED);
+  stats->bytes = __atomic_load_n(&cap->bytes, __ATOMIC_RELAXED);
+
+  return TMR_SUCCESS;
+}
+
+void
+TMR__captureTransportFrame(TMR_Reader *reader, bool tx, uint8_t protocol,
+                           uint32_t dataLen, const uint8_t *data)
+{
+  struct TMR_TransportCapture *cap;
+  TMR_CaptureRecordHdr *hdr;
+  uint64_t head, tail, offset, pad, need;
+
+  cap = __atomic_load_n(&reader->transportCapture, __ATOMIC_ACQUIRE);
+  if (NULL == cap)
+  {
+    return;
+  }
+
+  need = (sizeof(TMR_CaptureRecordHdr) + dataLen + TMR_CAPTURE_RECORD_ALIGN - 1)
+    & ~(uint64_t)(TMR_CAPTURE_RECORD_ALIGN - 1);
+  if (need > (cap->size / 2))
+  {
+    __atomic_fetch_add(&cap->dropped, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  /*
+   * Reserve space with a CAS on head. A record never wraps; if it does
+   * not fit before the end of the ring, the remainder is claimed as a
+   * padding record in the same reservation.
+   */
+  head = __atomic_load_n(&cap->head, __ATOMIC_RELAXED);
+  do
+  {
+    offset = head & (cap->size - 1);
+    pad = ((offset + need) > cap->size) ? (cap->size - offset) : 0;
+    tail = __atomic_load_n(&cap->tail, __ATOMIC_ACQUIRE);
+    if ((head + pad + need - tail) > cap->size)
+    {
+      /* Writer has fallen behind; never block the I/O path. */
+      __atomic_fetch_add(&cap->dropped, 1, __ATOMIC_RELAXED);
+      return;
+    }
+  }
+  while (!__atomic_compare_exchange_n(&cap->head, &head, head + pad + need,
+                                      true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+  if (0 != pad)
+  {
+    hdr = (TMR_CaptureRecordHdr *)(cap->ring + offset);
+    hdr->flags = TMR_CAPTURE_RECORD_PAD;
+    __atomic_store_n(&hdr->len, (uint32_t)pad, __ATOMIC_RELEASE);
+    offset = 0;
+  }
+
+  hdr = (TMR_CaptureRecordHdr *)(cap->ring + offset);
+  hdr->dataLen = dataLen;
+  hdr->flags = (uint8_t)((tx ? TMR_CAPTURE_FLAG_TX : 0) | (protocol << 1));
+  hdr->timestampUs = capture_now_us();
+  memcpy((uint8_t *)(hdr + 1), data, dataLen);
+  __atomic_store_n(&hdr->len, (uint32_t)need, __ATOMIC_RELEASE);
+
+  __atomic_fetch_add(&cap->frames, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&cap->bytes, dataLen, __ATOMIC_RELAXED);
+}
+
+#endif /* TMR_ENABLE_TRANSPORT_CAPTURE */
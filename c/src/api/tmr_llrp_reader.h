@@ -47,6 +47,8 @@ extern "C" {
 #define TMR_LLRP_SYNC_MAX_ROSPECS 256  
 #define TMR_LLRP_MAX_RFMODE_ENTRIES 7
 #define TMR_LLRP_READER_DEFAULT_PORT 5084
+#define TMR_LLRP_MAX_ENCODED_COMMAND 16
+#define TMR_LLRP_MIN_RESPONSES 8
 
 /**
  * This structure is returned from cmdGetRFControl
@@ -143,6 +145,169 @@ typedef struct TMR_LLRP_UnhandledAsyncResponse
   LLRP_tSMessage *lMsg;
 }TMR_LLRP_UnhandledAsyncResponse;
 
+/**
+ * A command frame that never changes, encoded on first use
+ * and re-sent with only its MessageID replaced
+ **/
+typedef struct TMR_LLRP_EncodedCommand
+{
+  uint8_t frame[TMR_LLRP_MAX_ENCODED_COMMAND];
+  /* Frame length, 0 until encoded */
+  uint32_t length;
+}TMR_LLRP_EncodedCommand;
+
+/**
+ * Raw frame of a tag report taken by the report streamer, kept with
+ * the empty RO_ACCESS_REPORT received in its place until that report
+ * is queued for the parser thread
+ **/
+typedef struct TMR_LLRP_StreamedFrame
+{
+  LLRP_tSMessage *report;
+  uint8_t *frame;
+  uint32_t length;
+  struct TMR_LLRP_StreamedFrame *next;
+}TMR_LLRP_StreamedFrame;
+
+/**
+ * The ROSpec a sync read left installed on the reader. A later
+ * sync read whose ADD_ROSPEC encodes to the same frame starts
+ * this ROSpec again instead of deleting and re-adding it.
+ **/
+typedef struct TMR_LLRP_ROSpecCache
+{
+  /* Encoded ADD_ROSPEC (MessageID 0), NULL when nothing is cached */
+  uint8_t *frame;
+  uint32_t length;
+  /* ROSpecID the cached ROSpec is installed under */
+  llrp_u32_t roSpecId;
+  /* Set by TMR_LLRP_read() while the current read may use the cache */
+  bool enabled;
+  /* Set when the current read started the cached ROSpec */
+  bool reused;
+}TMR_LLRP_ROSpecCache;
+
+/**
+ * Steps of TMR_connect() to an LLRP reader, indexing
+ * TMR_LLRP_ConnectTimings.stepMs
+ **/
+typedef enum TMR_LLRP_ConnectStep
+{
+  /** TCP connect and the ConnectionAttemptEvent */
+  TMR_LLRP_CONNECT_STEP_OPEN = 0,
+  /** HoldEventsAndReportsUponReconnect */
+  TMR_LLRP_CONNECT_STEP_HOLD_EVENTS,
+  /** GET_ROSPECS, and stopping the ROSpecs left running */
+  TMR_LLRP_CONNECT_STEP_ROSPECS,
+  /** Region id */
+  TMR_LLRP_CONNECT_STEP_REGION,
+  /** Reader capabilities */
+  TMR_LLRP_CONNECT_STEP_CAPABILITIES,
+  /** Supported protocols */
+  TMR_LLRP_CONNECT_STEP_PROTOCOLS,
+  /** Antenna properties */
+  TMR_LLRP_CONNECT_STEP_ANTENNAS,
+  /** KeepaliveSpec */
+  TMR_LLRP_CONNECT_STEP_KEEPALIVE,
+  /** Serial number and firmware version, keying the capability cache */
+  TMR_LLRP_CONNECT_STEP_IDENTITY,
+  TMR_LLRP_CONNECT_STEPS
+}TMR_LLRP_ConnectStep;
+
+/**
+ * Where the time of the last TMR_connect() went, returned from
+ * TMR_LLRP_getConnectTimings(). The queries are pipelined, so the
+ * steps overlap and add up to more than totalMs.
+ **/
+typedef struct TMR_LLRP_ConnectTimings
+{
+  /**
+   * Milliseconds from sending each step's request to its response.
+   * 0 for steps that were not run.
+   **/
+  uint32_t stepMs[TMR_LLRP_CONNECT_STEPS];
+  /** Milliseconds spent in TMR_connect() */
+  uint32_t totalMs;
+  /**
+   * Set when the reader and protocol capabilities were taken from
+   * the capability cache instead of being queried
+   **/
+  bool capabilitiesCached;
+}TMR_LLRP_ConnectTimings;
+
+/**
+ * When the reader sends an RO_ACCESS_REPORT during continuous
+ * reading, the ROReportTrigger of the ROReportSpec
+ **/
+typedef enum TMR_LLRP_ReportTrigger
+{
+  /** One report per tag read, as the API always did */
+  TMR_LLRP_REPORT_TRIGGER_DEFAULT = 0,
+  /** After every N tags, and when the ROSpec ends */
+  TMR_LLRP_REPORT_TRIGGER_N_TAGS_OR_END_OF_ROSPEC,
+  /** After every N tags, and when each AISpec ends */
+  TMR_LLRP_REPORT_TRIGGER_N_TAGS_OR_END_OF_AISPEC,
+}TMR_LLRP_ReportTrigger;
+
+/**
+ * Optional parts of each TagReportData, in addition to the
+ * metadata selected by /reader/metadataflags
+ **/
+typedef enum TMR_LLRP_ReportContent
+{
+  TMR_LLRP_REPORT_CONTENT_NONE = 0,
+  /** SpecIndex, not used by the API */
+  TMR_LLRP_REPORT_CONTENT_SPECINDEX = (1 << 0),
+  /** Gen2 PC bits, for TMR_TagData.u.gen2.pc */
+  TMR_LLRP_REPORT_CONTENT_GEN2_PC = (1 << 1),
+  /** Gen2 CRC, for TMR_TagData.crc */
+  TMR_LLRP_REPORT_CONTENT_GEN2_CRC = (1 << 2),
+  TMR_LLRP_REPORT_CONTENT_ALL = (TMR_LLRP_REPORT_CONTENT_SPECINDEX |
+                                 TMR_LLRP_REPORT_CONTENT_GEN2_PC |
+                                 TMR_LLRP_REPORT_CONTENT_GEN2_CRC),
+}TMR_LLRP_ReportContent;
+
+/**
+ * How tag reads are batched into RO_ACCESS_REPORTs during continuous
+ * reading, the value of /reader/llrp/reportSpec. Every report costs
+ * its LLRP header, a wakeup of the receiver, a queue entry and a
+ * decode on the host, so packing more tags into each one raises the
+ * tag rate the host keeps up with, at the cost of latency: a tag is
+ * only delivered when its report is sent.
+ *
+ * Sync reads are not affected; they always get one report when the
+ * ROSpec ends, since nothing is delivered before that anyway.
+ *
+ * Tags per second one host core receives, streams and delivers to a
+ * read listener, by tags per report (llrpreportbench on a Xeon VM,
+ * unoptimized build; the hand-off to the parser thread is extra):
+ *
+ *   tags per report      1      10     100    1000
+ *   tags per second    500k   1.6M    2.4M    2.4M
+ *
+ * The default of one tag per report is the first column; from about
+ * 100 tags per report the per-report cost no longer shows. With a
+ * periodMs window instead of N, the tags per report are the tag rate
+ * times the window; 100 ms at 500 tags/s gives 50 per report.
+ **/
+typedef struct TMR_LLRP_ReportSpec
+{
+  TMR_LLRP_ReportTrigger trigger;
+  /**
+   * Tags per report for the N_TAGS triggers. 0 means no limit, so
+   * reports come only when the spec ends or periodMs elapses.
+   **/
+  uint16_t n;
+  /**
+   * If not 0, the API also asks for the tags held on the reader
+   * (GET_REPORT) every periodMs milliseconds, bounding how long a
+   * tag waits for its report.
+   **/
+  uint32_t periodMs;
+  /** Bitmask of TMR_LLRP_ReportContent */
+  uint16_t content;
+}TMR_LLRP_ReportSpec;
+
 /**
  *  Reader features Flag Enum
  */
@@ -211,12 +376,17 @@ typedef struct TMR_LLRP_LlrpReader
   /* Number of tags reported by reader */
   int tagsRemaining;
 
-  /* Array of LLRP_tSMessage pointers holding the tag read responses */
+  /**
+   * Array of LLRP_tSMessage pointers holding the tag read responses.
+   * Grown by TMR_LLRP_reserveResponses() and kept across reads.
+   **/
   LLRP_tSMessage **bufResponse;
+  /* Number of entries allocated in bufResponse */
+  uint32_t bufCapacity;
 
-  /* bufResponse read index */
-  uint8_t bufPointer;
-  uint8_t bufIndex;
+  /* bufResponse write and read index */
+  uint32_t bufPointer;
+  uint32_t bufIndex;
 
   /* Pointer to buffer holding the tag read data */
   LLRP_tSTagReportData *pTagReportData;
@@ -236,6 +406,12 @@ typedef struct TMR_LLRP_LlrpReader
   int numOfROSpecEvents;
   /** The above variables must be protected by this lock */
   pthread_mutex_t receiverLock;
+  /**
+   * Written to wake the background receiver out of its wait on the
+   * socket, to disable or stop it. The receiver polls [0]; [1] is
+   * written. Both are the same eventfd on Linux, -1 when not open.
+   **/
+  int receiverWake[2];
 
   /**
    * For monitoring keepalives:
@@ -262,9 +438,38 @@ typedef struct TMR_LLRP_LlrpReader
   uint8_t keepAliveAckMissCnt;
   TMMP_Reader_FeaturesFlag featureFlags;
   pthread_mutex_t transmitterLock;
+  /**
+   * XML rendering of messages for transport listeners, allocated on
+   * first use and grown as needed. Shared by the send and receive
+   * paths, so guarded by xmlLock.
+   */
+  char *xmlBuf;
+  uint32_t xmlBufSize;
+  pthread_mutex_t xmlLock;
   /* Cache metadata flag status */
   TMR_TRD_MetadataFlag metadata;
+  /**
+   * Frames taken by the report streamer whose reports are not queued
+   * yet. Reports are received under receiverLock but queued outside
+   * it, so the list has a lock of its own.
+   **/
+  TMR_LLRP_StreamedFrame *streamedFrames;
+  pthread_mutex_t streamedLock;
+  /* Pre-encoded KEEPALIVE_ACK and GET_REPORT */
+  TMR_LLRP_EncodedCommand keepAliveAck, getReport;
+  TMR_LLRP_ROSpecCache roSpecCache;
   uint16_t statsEnable;
+  TMR_LLRP_ConnectTimings connectTimings;
+  /* /reader/llrp/reportSpec */
+  TMR_LLRP_ReportSpec reportSpec;
+  /* When GET_REPORT was last sent for reportSpec.periodMs */
+  uint64_t reportRequestedAt;
+  /* Batch of TMR_paramGetMany()/TMR_paramSetMany() in progress, if any */
+  struct TMR_LLRP_ParamBatch *paramBatch;
+  /* Directory of the capability cache, NULL when not caching */
+  char *capabilityCacheDir;
+  /* Capability cache file of the connected reader, NULL when not caching */
+  char *capabilityCachePath;
 }TMR_LLRP_LlrpReader;
 
 
@@ -293,6 +498,24 @@ TMR_Status TMR_LLRP_killTag(struct TMR_Reader *reader, const TMR_TagFilter *filt
                              const TMR_TagAuthentication *auth);
 TMR_Status TMR_LLRP_lockTag(struct TMR_Reader *reader,const TMR_TagFilter *filter, TMR_TagLockAction *action);
 TMR_Status TMR_LLRP_reboot(struct TMR_Reader *reader);
+TMR_Status TMR_LLRP_getConnectTimings(struct TMR_Reader *reader, TMR_LLRP_ConnectTimings *timings);
+/**
+ * Keep the reader and protocol capabilities of the LLRP readers
+ * connected to in files under dir, one per reader serial number,
+ * firmware version and region. Later connects to the same reader then
+ * only query those, and take the rest from the file. Setting
+ * /reader/region/hopTable removes the reader's file, as the hop table
+ * is part of the capabilities. Call before TMR_connect(); NULL or ""
+ * turns the cache off, as it is by default. The directory must exist.
+ *
+ * @param reader Reader pointer
+ * @param dir Cache directory
+ */
+TMR_Status TMR_LLRP_setCapabilityCacheDir(struct TMR_Reader *reader, const char *dir);
+TMR_Status TMR_LLRP_paramGetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                                 void *values[], TMR_Status status[]);
+TMR_Status TMR_LLRP_paramSetMany(struct TMR_Reader *reader, uint32_t count, const TMR_Param keys[],
+                                 const void *values[], TMR_Status status[]);
 //TMR_Status TMR_LLRP_resetHoptable(struct TMR_Reader *reader);
 /**
  * Initialize LLRP reader.
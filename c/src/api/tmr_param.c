@@ -174,6 +174,7 @@ static const char *paramNames[1 + TMR_PARAM_MAX] = {
   "/reader/radio/KeepRFOn", /* TMR_PARAM_RADIO_KEEP_RF_ON */
   "/reader/protocolList", /* TMR_PARAM_PROTOCOL_LIST */
 #endif /* TMR_ENABLE_HF_LF */
+  "/reader/llrp/reportSpec", /* TMR_PARAM_LLRP_REPORTSPEC */
 };
 
 
@@ -295,6 +295,8 @@ typedef enum TMR_Param
   /** "/reader/protocolList", TMR_TagProtocolList */
   TMR_PARAM_PROTOCOL_LIST,
 #endif /* TMR_ENABLE_HF_LF */
+  /** "/reader/llrp/reportSpec", TMR_LLRP_ReportSpec */
+  TMR_PARAM_LLRP_REPORTSPEC,
   TMR_PARAM_END,
   TMR_PARAM_MAX = TMR_PARAM_END-1,
 
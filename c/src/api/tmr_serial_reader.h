@@ -210,6 +210,51 @@ typedef enum TMR_TransportType
   TMR_SR_MSG_SOURCE_UNKNOWN = 0x0004,
 }TMR_TransportType;
 
+#if TMR_ENABLE_WAKE_PREAMBLES
+/**
+ * Wake-up preamble counters returned from TMR_SR_getWakePreambleStats().
+ */
+typedef struct TMR_SR_WakePreambleStats
+{
+  /** Number of commands that were preceded by a full wake-up preamble */
+  uint32_t preambles;
+  /** Number of 8-byte 0xFF blocks sent */
+  uint32_t blocks;
+  /** Number of power mode probes sent */
+  uint32_t probes;
+  /** Total time spent on preambles and probes, in milliseconds */
+  uint32_t timeMs;
+} TMR_SR_WakePreambleStats;
+#endif /* TMR_ENABLE_WAKE_PREAMBLES */
+
+/**
+ * Recovery counters for one class of receive error.
+ */
+typedef struct TMR_SR_RecoveryCounters
+{
+  /** Number of errors seen */
+  uint32_t errors;
+  /** Number of errors recovered by resynchronising on the next frame */
+  uint32_t resyncs;
+  /** Number of times the full TMR_flush() was needed */
+  uint32_t fullFlushes;
+  /** Total time from error to the next valid frame, in milliseconds */
+  uint32_t totalMs;
+  /** Longest time from error to the next valid frame, in milliseconds */
+  uint32_t maxMs;
+} TMR_SR_RecoveryCounters;
+
+/**
+ * Receive error recovery counters returned from TMR_SR_getRecoveryStats().
+ */
+typedef struct TMR_SR_RecoveryStats
+{
+  /** Recovery from receive timeouts */
+  TMR_SR_RecoveryCounters timeout;
+  /** Recovery from CRC errors */
+  TMR_SR_RecoveryCounters crc;
+} TMR_SR_RecoveryStats;
+
 /**
  * The serial reader structure.
  */
@@ -312,6 +357,10 @@ typedef struct TM_SR_SerialReader
 #if TMR_ENABLE_WAKE_PREAMBLES
   /* Option to enable or disable the pre-amble */
   bool supportsPreamble;
+  /* Time of the last valid response from the module, 0 if unknown */
+  uint64_t lastTrafficTime;
+  /* Wake-up preamble counters */
+  TMR_SR_WakePreambleStats preambleStats;
 #endif /* TMR_ENABLE_WAKE_PREAMBLES */
   /* Cache extendedEPC setting */
   bool extendedEPC;
@@ -325,6 +374,18 @@ typedef struct TM_SR_SerialReader
   bool isBapEnabled;
 #endif /* TMR_ENABLE_UHF */
   bool isM6eFamily;
+  /* Receive error recovery state and counters */
+  uint8_t consecutiveFailures;
+  uint64_t recoveryStartTime;
+  TMR_SR_RecoveryCounters *pendingRecovery;
+  TMR_SR_RecoveryStats recoveryStats;
+  /**
+   * Bytes read past a frame recovered by resynchronisation; the next
+   * receive starts with them. They have already been reported to the
+   * transport listeners and capture.
+   */
+  uint8_t pushback[TMR_SR_MAX_PACKET_SIZE];
+  uint16_t pushbackLen;
 } TMR_SR_SerialReader;
 #ifdef TMR_ENABLE_UHF
 /**
@@ -456,6 +517,22 @@ TMR_Status TMR_SR_modifyFlash(TMR_Reader *reader, uint8_t sector, uint32_t addre
                               uint8_t length, const uint8_t data[], uint32_t offset);
 TMR_Status TMR_init_UserConfigOp(TMR_SR_UserConfigOp *config, TMR_SR_UserConfigOperation op);
 TMR_Status TMR_SR_reboot(struct TMR_Reader *reader);
+/**
+ * Get the receive error recovery counters of a serial reader.
+ *
+ * @param reader The reader to operate on.
+ * @param stats Structure to fill in.
+ */
+TMR_Status TMR_SR_getRecoveryStats(struct TMR_Reader *reader, TMR_SR_RecoveryStats *stats);
+#if defined(TMR_ENABLE_UHF) && TMR_ENABLE_WAKE_PREAMBLES
+/**
+ * Get the wake-up preamble counters of a serial reader.
+ *
+ * @param reader The reader to operate on.
+ * @param stats Structure to fill in.
+ */
+TMR_Status TMR_SR_getWakePreambleStats(struct TMR_Reader *reader, TMR_SR_WakePreambleStats *stats);
+#endif
 
 /**
  * Initialize a serial reader. The reader->u.serialReader.transport
@@ -134,7 +134,8 @@ struct TMR_SR_SerialTransport
 
   /**
    * This callback takes any actions necessary (possibly none) to
-   * remove unsent data from the output path.
+   * remove unsent data from the output path and to discard input
+   * that has been received but not yet read.
    *
    * @param this The TMR_SR_SerialTransport structure.
    */
@@ -152,6 +153,26 @@ typedef struct TMR_SR_SerialPortNativeContext
   PLATFORM_HANDLE handle;
   /** The filesystem name of the serial device */
   char devicename[TMR_MAX_READER_NAME_LENGTH];
+#if TMR_SR_NATIVE_RX_BUFFER_SIZE > 0
+  /** Bytes read from the device but not yet handed to the caller */
+  uint8_t rxBuf[TMR_SR_NATIVE_RX_BUFFER_SIZE];
+  /** Read and write positions in rxBuf */
+  uint16_t rxHead, rxTail;
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_SIM
+  /** Emulator state, when opened through TMR_SR_SerialTransportSimInit() */
+  struct SimReader *sim;
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_REPLAY
+  /** Replay state, when opened through TMR_SR_SerialTransportReplayInit() */
+  struct ReplaySession *replay;
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  /** io_uring receive state, when attached at open */
+  struct UringSession *uring;
+  /** Whether open should try to attach io_uring */
+  bool uringWanted;
+#endif
 } TMR_SR_SerialPortNativeContext;
 #endif
 
@@ -200,6 +221,44 @@ __declspec(dllexport)
 TMR_Status TMR_SR_SerialTransportTcpNativeInit(TMR_SR_SerialTransport *transport,
                                             TMR_SR_SerialPortNativeContext *context,
                                             const char *device);
+#if !defined(WIN32) && !defined(WINCE)
+/** @private Receive path shared by the POSIX serial and TCP transports */
+TMR_Status TMR_SR_nativeReceiveBytes(TMR_SR_SerialPortNativeContext *context, uint32_t length,
+                                     uint32_t *messageLength, uint8_t *message, uint32_t timeoutMs);
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+/**
+ * Like TMR_SR_SerialTransportNativeInit(), but receives through io_uring
+ * when the kernel supports it, falling back to poll() when it does not.
+ */
+TMR_Status TMR_SR_SerialTransportNativeUringInit(TMR_SR_SerialTransport *transport,
+                                                 TMR_SR_SerialPortNativeContext *context,
+                                                 const char *device);
+/**
+ * Like TMR_SR_SerialTransportTcpNativeInit(), but receives through
+ * io_uring when the kernel supports it, falling back to poll() when it
+ * does not.
+ */
+TMR_Status TMR_SR_SerialTransportTcpUringInit(TMR_SR_SerialTransport *transport,
+                                              TMR_SR_SerialPortNativeContext *context,
+                                              const char *device);
+/** @private io_uring receive path shared by the POSIX serial and TCP transports */
+TMR_Status TMR_SR_uringAttach(TMR_SR_SerialPortNativeContext *context, bool socket);
+void TMR_SR_uringDetach(TMR_SR_SerialPortNativeContext *context);
+TMR_Status TMR_SR_uringReceiveBytes(TMR_SR_SerialPortNativeContext *context, uint32_t length,
+                                    uint32_t *messageLength, uint8_t *message, uint32_t timeoutMs);
+void TMR_SR_uringFlush(TMR_SR_SerialPortNativeContext *context);
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_SIM
+TMR_Status TMR_SR_SerialTransportSimInit(TMR_SR_SerialTransport *transport,
+                                         TMR_SR_SerialPortNativeContext *context,
+                                         const char *device);
+#endif
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_REPLAY
+TMR_Status TMR_SR_SerialTransportReplayInit(TMR_SR_SerialTransport *transport,
+                                            TMR_SR_SerialPortNativeContext *context,
+                                            const char *device);
+#endif
 #endif /* TMR_ENABLE_SERIAL_TRANSPORT_NATIVE */
 
 #ifdef TMR_ENABLE_SERIAL_TRANSPORT_LLRP
@@ -0,0 +1,410 @@
+/**
+ * Sample program that decodes a transport capture file written by
+ * TMR_startTransportCapture()
+ * @file capturedecode.c
+ */
+
+#include <tm_reader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define usage() {errx(1, "Please provide a capture file: capture-file [--hex] [--summary]\n"\
+                         "capture-file : file written by TMR_startTransportCapture()\n"\
+                         "[--hex] : dump the bytes of every frame\n"\
+                         "[--summary] : only print the per-opcode totals\n");}
+
+void errx(int exitval, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+
+  exit(exitval);
+}
+
+#ifdef TMR_ENABLE_TRANSPORT_CAPTURE
+
+typedef struct NameEntry
+{
+  uint16_t code;
+  const char *name;
+} NameEntry;
+
+static const NameEntry eapiOpcodes[] = {
+  {0x01, "WRITE_FLASH"},
+  {0x02, "READ_FLASH"},
+  {0x03, "VERSION"},
+  {0x04, "BOOT_FIRMWARE"},
+  {0x06, "SET_BAUD_RATE"},
+  {0x07, "ERASE_FLASH"},
+  {0x08, "VERIFY_IMAGE_CRC"},
+  {0x09, "BOOT_BOOTLOADER"},
+  {0x0A, "MODIFY_FLASH"},
+  {0x0B, "GET_DSP_SILICON_ID"},
+  {0x0C, "GET_CURRENT_PROGRAM"},
+  {0x0D, "WRITE_FLASH_SECTOR"},
+  {0x0E, "GET_SECTOR_SIZE"},
+  {0x0F, "MODIFY_FLASH_SECTOR"},
+  {0x10, "HW_VERSION"},
+  {0x22, "READ_TAG_ID_MULTIPLE"},
+  {0x23, "WRITE_TAG_ID"},
+  {0x24, "WRITE_TAG_DATA"},
+  {0x25, "LOCK_TAG"},
+  {0x26, "KILL_TAG"},
+  {0x27, "PASS_THROUGH"},
+  {0x28, "READ_TAG_DATA"},
+  {0x29, "GET_TAG_ID_BUFFER"},
+  {0x2A, "CLEAR_TAG_ID_BUFFER"},
+  {0x2D, "WRITE_TAG_SPECIFIC"},
+  {0x2E, "ERASE_BLOCK_TAG_SPECIFIC"},
+  {0x2F, "MULTI_PROTOCOL_TAG_OP"},
+  {0x61, "GET_ANTENNA_PORT"},
+  {0x62, "GET_READ_TX_POWER"},
+  {0x63, "GET_TAG_PROTOCOL"},
+  {0x64, "GET_WRITE_TX_POWER"},
+  {0x65, "GET_FREQ_HOP_TABLE"},
+  {0x66, "GET_USER_GPIO_INPUTS"},
+  {0x67, "GET_REGION"},
+  {0x68, "GET_POWER_MODE"},
+  {0x69, "GET_USER_MODE"},
+  {0x6A, "GET_READER_OPTIONAL_PARAMS"},
+  {0x6B, "GET_PROTOCOL_PARAM"},
+  {0x6C, "GET_READER_STATS"},
+  {0x6D, "GET_USER_PROFILE"},
+  {0x70, "GET_AVAILABLE_PROTOCOLS"},
+  {0x71, "GET_AVAILABLE_REGIONS"},
+  {0x72, "GET_TEMPERATURE"},
+  {0x91, "SET_ANTENNA_PORT"},
+  {0x92, "SET_READ_TX_POWER"},
+  {0x93, "SET_TAG_PROTOCOL"},
+  {0x94, "SET_WRITE_TX_POWER"},
+  {0x95, "SET_FREQ_HOP_TABLE"},
+  {0x96, "SET_USER_GPIO_OUTPUTS"},
+  {0x97, "SET_REGION"},
+  {0x98, "SET_POWER_MODE"},
+  {0x99, "SET_USER_MODE"},
+  {0x9A, "SET_READER_OPTIONAL_PARAMS"},
+  {0x9B, "SET_PROTOCOL_PARAM"},
+  {0x9D, "SET_USER_PROFILE"},
+  {0x9E, "SET_PROTOCOL_LICENSEKEY"},
+  {0xC1, "SET_OPERATING_FREQ"},
+  {0xC3, "TX_CW_SIGNAL"},
+};
+
+static const NameEntry llrpTypes[] = {
+  {1, "GET_READER_CAPABILITIES"},
+  {2, "GET_READER_CONFIG"},
+  {3, "SET_READER_CONFIG"},
+  {4, "CLOSE_CONNECTION_RESPONSE"},
+  {11, "GET_READER_CAPABILITIES_RESPONSE"},
+  {12, "GET_READER_CONFIG_RESPONSE"},
+  {13, "SET_READER_CONFIG_RESPONSE"},
+  {14, "CLOSE_CONNECTION"},
+  {20, "ADD_ROSPEC"},
+  {21, "DELETE_ROSPEC"},
+  {22, "START_ROSPEC"},
+  {23, "STOP_ROSPEC"},
+  {24, "ENABLE_ROSPEC"},
+  {25, "DISABLE_ROSPEC"},
+  {26, "GET_ROSPECS"},
+  {30, "ADD_ROSPEC_RESPONSE"},
+  {31, "DELETE_ROSPEC_RESPONSE"},
+  {32, "START_ROSPEC_RESPONSE"},
+  {33, "STOP_ROSPEC_RESPONSE"},
+  {34, "ENABLE_ROSPEC_RESPONSE"},
+  {35, "DISABLE_ROSPEC_RESPONSE"},
+  {36, "GET_ROSPECS_RESPONSE"},
+  {40, "ADD_ACCESSSPEC"},
+  {41, "DELETE_ACCESSSPEC"},
+  {42, "ENABLE_ACCESSSPEC"},
+  {43, "DISABLE_ACCESSSPEC"},
+  {44, "GET_ACCESSSPECS"},
+  {46, "CLIENT_REQUEST_OP"},
+  {50, "ADD_ACCESSSPEC_RESPONSE"},
+  {51, "DELETE_ACCESSSPEC_RESPONSE"},
+  {52, "ENABLE_ACCESSSPEC_RESPONSE"},
+  {53, "DISABLE_ACCESSSPEC_RESPONSE"},
+  {54, "GET_ACCESSSPECS_RESPONSE"},
+  {56, "CLIENT_REQUEST_OP_RESPONSE"},
+  {60, "GET_REPORT"},
+  {61, "RO_ACCESS_REPORT"},
+  {62, "KEEPALIVE"},
+  {63, "READER_EVENT_NOTIFICATION"},
+  {64, "ENABLE_EVENTS_AND_REPORTS"},
+  {72, "KEEPALIVE_ACK"},
+  {100, "ERROR_MESSAGE"},
+  {1023, "CUSTOM_MESSAGE"},
+};
+
+#define NAME_COUNT(table) (sizeof(table) / sizeof((table)[0]))
+
+/* Per-opcode totals, indexed by protocol, direction and code */
+static uint32_t eapiCount[2][256];
+static uint32_t llrpCount[2][1024];
+
+static const char *
+lookupName(const NameEntry *table, size_t count, uint16_t code)
+{
+  size_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    if (table[i].code == code)
+    {
+      return table[i].name;
+    }
+  }
+  return "UNKNOWN";
+}
+
+static uint64_t
+getLE(const uint8_t *p, int bytes)
+{
+  uint64_t value = 0;
+  int i;
+
+  for (i = bytes - 1; i >= 0; i--)
+  {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+static uint32_t
+getBE(const uint8_t *p, int bytes)
+{
+  uint32_t value = 0;
+  int i;
+
+  for (i = 0; i < bytes; i++)
+  {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+static void
+printHex(const uint8_t *data, uint32_t len)
+{
+  uint32_t i;
+
+  for (i = 0; i < len; i++)
+  {
+    printf("%s%02x", (0 == (i % 16)) ? "\n    " : " ", data[i]);
+  }
+  printf("\n");
+}
+
+static void
+decodeEapi(bool tx, const uint8_t *data, uint32_t len, bool quiet)
+{
+  uint8_t opcode;
+  uint32_t i;
+
+  /* Wake-up preambles are sent as separate blocks of 0xFF bytes */
+  for (i = 0; (i < len) && (0xFF == data[i]); i++);
+  if ((i == len) || (len < 3) || (0xFF != data[0]))
+  {
+    if (!quiet)
+    {
+      printf("EAPI %s (%u bytes)\n", (i == len) ? "preamble" : "fragment", len);
+    }
+    return;
+  }
+
+  opcode = data[2];
+  eapiCount[tx ? 1 : 0][opcode]++;
+  if (quiet)
+  {
+    return;
+  }
+
+  printf("EAPI %-26s op=0x%02x len=%u", lookupName(eapiOpcodes, NAME_COUNT(eapiOpcodes), opcode),
+         opcode, data[1]);
+  if ((false == tx) && (len >= 5))
+  {
+    printf(" status=0x%04x", getBE(data + 3, 2));
+  }
+  printf("\n");
+}
+
+static void
+decodeLlrp(bool tx, const uint8_t *data, uint32_t len, bool quiet)
+{
+  uint16_t type;
+  uint32_t msgLen, msgId;
+
+  if (len < 10)
+  {
+    if (!quiet)
+    {
+      printf("LLRP short frame (%u bytes)\n", len);
+    }
+    return;
+  }
+
+  type = (uint16_t)(getBE(data, 2) & 0x3FF);
+  msgLen = getBE(data + 2, 4);
+  msgId = getBE(data + 6, 4);
+  llrpCount[tx ? 1 : 0][type]++;
+  if (quiet)
+  {
+    return;
+  }
+
+  printf("LLRP %-32s type=%u len=%u id=%u", lookupName(llrpTypes, NAME_COUNT(llrpTypes), type),
+         type, msgLen, msgId);
+  if ((1023 == type) && (len >= 15))
+  {
+    printf(" vendor=%u subtype=%u", getBE(data + 10, 4), data[14]);
+  }
+  printf("\n");
+}
+
+static void
+printSummary(void)
+{
+  int dir, code;
+
+  printf("\nSummary:\n");
+  for (dir = 1; dir >= 0; dir--)
+  {
+    for (code = 0; code < 256; code++)
+    {
+      if (0 != eapiCount[dir][code])
+      {
+        printf("  %s EAPI %-32s %u\n", dir ? "TX" : "RX",
+               lookupName(eapiOpcodes, NAME_COUNT(eapiOpcodes), (uint16_t)code), eapiCount[dir][code]);
+      }
+    }
+    for (code = 0; code < 1024; code++)
+    {
+      if (0 != llrpCount[dir][code])
+      {
+        printf("  %s LLRP %-32s %u\n", dir ? "TX" : "RX",
+               lookupName(llrpTypes, NAME_COUNT(llrpTypes), (uint16_t)code), llrpCount[dir][code]);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  FILE *fp;
+  uint8_t fileHdr[TMR_CAPTURE_FILE_HEADER_SIZE];
+  uint8_t recHdr[TMR_CAPTURE_RECORD_HEADER_SIZE];
+  uint8_t *data = NULL;
+  uint32_t dataSize = 0;
+  uint64_t startUs, prevUs;
+  uint32_t frames = 0;
+  bool hex = false, summaryOnly = false;
+  int i;
+
+  if (argc < 2)
+  {
+    usage();
+  }
+
+  for (i = 2; i < argc; i++)
+  {
+    if (0 == strcmp("--hex", argv[i]))
+    {
+      hex = true;
+    }
+    else if (0 == strcmp("--summary", argv[i]))
+    {
+      summaryOnly = true;
+    }
+    else
+    {
+      fprintf(stderr, "Argument %s is not recognized\n", argv[i]);
+      usage();
+    }
+  }
+
+  fp = fopen(argv[1], "rb");
+  if (NULL == fp)
+  {
+    errx(1, "Can't open %s\n", argv[1]);
+  }
+
+  if ((1 != fread(fileHdr, sizeof(fileHdr), 1, fp)) ||
+      (0 != memcmp(fileHdr, TMR_CAPTURE_MAGIC, 8)))
+  {
+    errx(1, "%s is not a transport capture file\n", argv[1]);
+  }
+  if (TMR_CAPTURE_VERSION != getLE(fileHdr + 8, 4))
+  {
+    errx(1, "Unsupported capture version %u\n", (uint32_t)getLE(fileHdr + 8, 4));
+  }
+  startUs = getLE(fileHdr + 16, 8);
+  prevUs = startUs;
+
+  while (1 == fread(recHdr, sizeof(recHdr), 1, fp))
+  {
+    uint64_t ts = getLE(recHdr, 8);
+    uint32_t len = (uint32_t)getLE(recHdr + 8, 4);
+    uint8_t flags = recHdr[12];
+    bool tx = (0 != (flags & TMR_CAPTURE_FLAG_TX));
+    uint8_t protocol = (flags & TMR_CAPTURE_PROTOCOL_MASK) >> 1;
+
+    if (len > dataSize)
+    {
+      uint8_t *grown = realloc(data, len);
+      if (NULL == grown)
+      {
+        errx(1, "Out of memory\n");
+      }
+      data = grown;
+      dataSize = len;
+    }
+    if ((0 != len) && (1 != fread(data, len, 1, fp)))
+    {
+      fprintf(stderr, "Truncated record after %u frames\n", frames);
+      break;
+    }
+    frames++;
+
+    if (!summaryOnly)
+    {
+      printf("%12.6f +%9.3fms %s ", (double)(ts - startUs) / 1e6,
+             (double)(ts - prevUs) / 1e3, tx ? "TX" : "RX");
+    }
+    prevUs = ts;
+
+    if (TMR_CAPTURE_PROTOCOL_LLRP == protocol)
+    {
+      decodeLlrp(tx, data, len, summaryOnly);
+    }
+    else
+    {
+      decodeEapi(tx, data, len, summaryOnly);
+    }
+
+    if (hex && !summaryOnly)
+    {
+      printHex(data, len);
+    }
+  }
+
+  printf("%u frames\n", frames);
+  printSummary();
+
+  free(data);
+  fclose(fp);
+  return 0;
+}
+
+#else /* TMR_ENABLE_TRANSPORT_CAPTURE */
+
+int main(int argc, char *argv[])
+{
+  errx(1, "Transport capture is not enabled in this build\n");
+  return 1;
+}
+
+#endif /* TMR_ENABLE_TRANSPORT_CAPTURE */
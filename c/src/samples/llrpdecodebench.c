@@ -0,0 +1,430 @@
+/**
+ * Sample program that measures how long it takes to turn an
+ * RO_ACCESS_REPORT into TMR_TagReadData as the number of TagReportData
+ * entries grows, and how many allocations that takes: by decoding the
+ * message tree with LTKC, on the heap or in a per-message arena, then
+ * parsing each entry's metadata; or by streaming the tag reads straight
+ * from the frame as continuous reading does.
+ * No reader is needed; the report is built and encoded locally.
+ * @file llrpdecodebench.c
+ */
+#include <tm_reader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#ifndef WIN32
+#include <time.h>
+#endif
+
+#define usage() {errx(1, "Please provide valid arguments, such as: [--tags n] [--iterations n] [--heap|--arena|--stream]\n"\
+                         "[--tags n] : TagReportData entries per report, e.g., '--tags 1000'; by default 100, 1000 and 10000 are run\n"\
+                         "[--iterations n] : number of reports to time for each report size, e.g., '--iterations 20'\n"\
+                         "[--heap|--arena|--stream] : only decode onto the heap, only into an arena, or only stream; by default all are run");}
+
+void errx(int exitval, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  /* As errx(3), which appends the newline itself */
+  fputc('\n', stderr);
+
+  exit(exitval);
+}
+
+#ifdef TMR_ENABLE_LLRP_READER
+
+#include "llrp_reader_imp.h"
+
+typedef enum Mode
+{
+  MODE_HEAP,
+  MODE_ARENA,
+  MODE_STREAM,
+} Mode;
+
+static const char *modeNames[] = {"heap", "arena", "stream"};
+
+/* Metadata parsed from each report, as a reader configured for it would */
+#define BENCH_METADATA (TMR_TRD_METADATA_FLAG_ANTENNAID | TMR_TRD_METADATA_FLAG_RSSI | \
+                        TMR_TRD_METADATA_FLAG_TIMESTAMP | TMR_TRD_METADATA_FLAG_READCOUNT | \
+                        TMR_TRD_METADATA_FLAG_FREQUENCY | TMR_TRD_METADATA_FLAG_PROTOCOL | \
+                        TMR_TRD_METADATA_FLAG_PHASE)
+#define BENCH_CHANNELS 50
+
+static TMR_Reader benchReader;
+static uint32_t benchFrequencies[BENCH_CHANNELS];
+
+/*
+ * The samples makefile links this program with --wrap=malloc so every
+ * allocation LTKC makes while decoding can be counted.
+ */
+static bool counting;
+static uint64_t allocations;
+
+void *__real_malloc(size_t size);
+
+void *
+__wrap_malloc(size_t size)
+{
+  if (counting)
+  {
+    allocations++;
+  }
+  return __real_malloc(size);
+}
+
+static uint64_t
+nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/**
+ * Build an RO_ACCESS_REPORT like the ones a reader sends during a
+ * large inventory and encode it into a frame.
+ */
+static uint8_t *
+encodeReport(uint32_t tags, uint32_t *frameLength)
+{
+  LLRP_tSRO_ACCESS_REPORT *pReport;
+  LLRP_tSFrameEncoder *pEncoder;
+  uint32_t bufSize, i;
+  uint8_t *buf;
+
+  pReport = LLRP_RO_ACCESS_REPORT_construct();
+  for (i = 0; i < tags; i++)
+  {
+    LLRP_tSTagReportData *pTagData;
+    LLRP_tSEPC_96 *pEpc;
+    LLRP_tSAntennaID *pAntenna;
+    LLRP_tSPeakRSSI *pRssi;
+    LLRP_tSFirstSeenTimestampUTC *pSeen;
+    LLRP_tSLastSeenTimestampUTC *pLastSeen;
+    LLRP_tSROSpecID *pROSpecID;
+    LLRP_tSChannelIndex *pChannel;
+    LLRP_tSTagSeenCount *pCount;
+    LLRP_tSC1G2_PC *pPC;
+    LLRP_tSC1G2_CRC *pCRC;
+    LLRP_tSThingMagicRFPhase *pPhase;
+    llrp_u96_t epc;
+
+    memset(&epc, 0, sizeof(epc));
+    epc.aValue[8] = (llrp_u8_t)(i >> 24);
+    epc.aValue[9] = (llrp_u8_t)(i >> 16);
+    epc.aValue[10] = (llrp_u8_t)(i >> 8);
+    epc.aValue[11] = (llrp_u8_t)i;
+
+    pTagData = LLRP_TagReportData_construct();
+    pEpc = LLRP_EPC_96_construct();
+    LLRP_EPC_96_setEPC(pEpc, epc);
+    LLRP_TagReportData_setEPCParameter(pTagData, &pEpc->hdr);
+    pROSpecID = LLRP_ROSpecID_construct();
+    LLRP_ROSpecID_setROSpecID(pROSpecID, 1);
+    LLRP_TagReportData_setROSpecID(pTagData, pROSpecID);
+    pAntenna = LLRP_AntennaID_construct();
+    LLRP_AntennaID_setAntennaID(pAntenna, 1 + (i % 4));
+    LLRP_TagReportData_setAntennaID(pTagData, pAntenna);
+    pRssi = LLRP_PeakRSSI_construct();
+    LLRP_PeakRSSI_setPeakRSSI(pRssi, -60 + (int8_t)(i % 20));
+    LLRP_TagReportData_setPeakRSSI(pTagData, pRssi);
+    pSeen = LLRP_FirstSeenTimestampUTC_construct();
+    LLRP_FirstSeenTimestampUTC_setMicroseconds(pSeen, 1000000 + i);
+    LLRP_TagReportData_setFirstSeenTimestampUTC(pTagData, pSeen);
+    pChannel = LLRP_ChannelIndex_construct();
+    LLRP_ChannelIndex_setChannelIndex(pChannel, 1 + (i % BENCH_CHANNELS));
+    LLRP_TagReportData_setChannelIndex(pTagData, pChannel);
+    pLastSeen = LLRP_LastSeenTimestampUTC_construct();
+    LLRP_LastSeenTimestampUTC_setMicroseconds(pLastSeen, 1500000000000000ull + (i * 1000ull));
+    LLRP_TagReportData_setLastSeenTimestampUTC(pTagData, pLastSeen);
+    pCount = LLRP_TagSeenCount_construct();
+    LLRP_TagSeenCount_setTagCount(pCount, 1 + (i % 3));
+    LLRP_TagReportData_setTagSeenCount(pTagData, pCount);
+    pPC = LLRP_C1G2_PC_construct();
+    LLRP_C1G2_PC_setPC_Bits(pPC, 0x3000);
+    LLRP_TagReportData_addAirProtocolTagData(pTagData, &pPC->hdr);
+    pCRC = LLRP_C1G2_CRC_construct();
+    LLRP_C1G2_CRC_setCRC(pCRC, (llrp_u16_t)(i * 7));
+    LLRP_TagReportData_addAirProtocolTagData(pTagData, &pCRC->hdr);
+    pPhase = LLRP_ThingMagicRFPhase_construct();
+    LLRP_ThingMagicRFPhase_setPhase(pPhase, (llrp_u16_t)(i % 180));
+    LLRP_TagReportData_addCustom(pTagData, &pPhase->hdr);
+    LLRP_RO_ACCESS_REPORT_addTagReportData(pReport, pTagData);
+  }
+
+  bufSize = 1024 + (tags * 128);
+  buf = malloc(bufSize);
+  if (NULL == buf)
+  {
+    errx(1, "Out of memory");
+  }
+  pEncoder = LLRP_FrameEncoder_construct(buf, bufSize);
+  LLRP_Encoder_encodeElement(&pEncoder->encoderHdr, &pReport->hdr.elementHdr);
+  if (LLRP_RC_OK != pEncoder->encoderHdr.ErrorDetails.eResultCode)
+  {
+    errx(1, "Encoding a %u tag report failed: %s", tags,
+         pEncoder->encoderHdr.ErrorDetails.pWhatStr);
+  }
+  *frameLength = pEncoder->iNext;
+  LLRP_Encoder_destruct(&pEncoder->encoderHdr);
+  LLRP_Element_destruct(&pReport->hdr.elementHdr);
+
+  return buf;
+}
+
+/**
+ * Tag reads from decoding the report into a message tree, as parse_tag_reads()
+ * gets them without streaming
+ */
+static uint32_t
+decodeTagReads(LLRP_tSTypeRegistry *pTypeRegistry, const uint8_t *frame, uint32_t frameLength,
+               bool arena, TMR_TagReadData *first)
+{
+  LLRP_tSFrameDecoder *pDecoder;
+  LLRP_tSMessage *pMessage;
+  LLRP_tSTagReportData *pTagData;
+  uint32_t parsed = 0;
+
+  pDecoder = LLRP_FrameDecoder_construct(pTypeRegistry, (uint8_t *)frame, frameLength);
+  if (arena)
+  {
+    /* As LLRP_Conn_recvMessage() does with bDecodeIntoArena set */
+    pDecoder->pArena = LLRP_Arena_construct(LLRP_ARENA_BYTES_PER_FRAME_BYTE * frameLength);
+  }
+  pMessage = LLRP_Decoder_decodeMessage(&pDecoder->decoderHdr);
+  if (NULL == pMessage)
+  {
+    errx(1, "Decoding a %u byte report failed: %s", frameLength,
+         pDecoder->decoderHdr.ErrorDetails.pWhatStr);
+  }
+  LLRP_Decoder_destruct(&pDecoder->decoderHdr);
+
+  for (pTagData = LLRP_RO_ACCESS_REPORT_beginTagReportData((LLRP_tSRO_ACCESS_REPORT *)pMessage);
+       NULL != pTagData;
+       pTagData = LLRP_RO_ACCESS_REPORT_nextTagReportData(pTagData))
+  {
+    TMR_TagReadData trd;
+
+    TMR_TRD_init(&trd);
+    if (TMR_SUCCESS == TMR_LLRP_parseMetadataFromMessage(&benchReader, &trd, pTagData))
+    {
+      if ((0 == parsed) && (NULL != first))
+      {
+        *first = trd;
+      }
+      parsed++;
+    }
+  }
+  LLRP_Element_destruct(&pMessage->elementHdr);
+
+  return parsed;
+}
+
+/**
+ * Tag reads streamed from the frame, as parse_tag_reads() gets them
+ * during continuous reading
+ */
+static uint32_t
+streamTagReads(const uint8_t *frame, uint32_t frameLength, TMR_TagReadData *first)
+{
+  TMR_LLRP_ReportStream stream;
+  TMR_Status ret;
+  uint32_t parsed = 0;
+
+  ret = TMR_LLRP_reportStreamInit(&benchReader, &stream, frame, frameLength);
+  while ((TMR_SUCCESS == ret) || (TMR_ERROR_LLRP == ret))
+  {
+    TMR_TagReadData trd;
+
+    TMR_TRD_init(&trd);
+    ret = TMR_LLRP_reportStreamNext(&benchReader, &stream, &trd);
+    if (TMR_SUCCESS == ret)
+    {
+      if ((0 == parsed) && (NULL != first))
+      {
+        *first = trd;
+      }
+      parsed++;
+    }
+  }
+  if (TMR_ERROR_NO_TAGS != ret)
+  {
+    errx(1, "Streaming a %u byte report stopped after %u tags: %s", frameLength,
+         parsed, TMR_strerr(&benchReader, ret));
+  }
+
+  return parsed;
+}
+
+/**
+ * Check that streaming gives the same tag read as decoding
+ */
+static void
+verify(const TMR_TagReadData *decoded, const TMR_TagReadData *streamed)
+{
+  if ((decoded->tag.epcByteCount != streamed->tag.epcByteCount) ||
+      (0 != memcmp(decoded->tag.epc, streamed->tag.epc, decoded->tag.epcByteCount)) ||
+      (decoded->tag.protocol != streamed->tag.protocol) ||
+      (decoded->tag.crc != streamed->tag.crc) ||
+      (0 != memcmp(decoded->tag.u.gen2.pc, streamed->tag.u.gen2.pc, sizeof(decoded->tag.u.gen2.pc))) ||
+      (decoded->metadataFlags != streamed->metadataFlags) ||
+      (decoded->antenna != streamed->antenna) ||
+      (decoded->rssi != streamed->rssi) ||
+      (decoded->readCount != streamed->readCount) ||
+      (decoded->frequency != streamed->frequency) ||
+      (decoded->phase != streamed->phase) ||
+      (decoded->timestampHigh != streamed->timestampHigh) ||
+      (decoded->timestampLow != streamed->timestampLow) ||
+      (decoded->dspMicros != streamed->dspMicros))
+  {
+    errx(1, "Streamed tag read differs from the decoded one");
+  }
+}
+
+static void
+runBench(LLRP_tSTypeRegistry *pTypeRegistry, const uint8_t *frame,
+         uint32_t frameLength, uint32_t tags, uint32_t iterations, Mode mode)
+{
+  uint32_t i, parsed = 0;
+  uint64_t start, elapsed;
+
+  allocations = 0;
+  counting = true;
+  start = nowNs();
+  for (i = 0; i < iterations; i++)
+  {
+    if (MODE_STREAM == mode)
+    {
+      parsed = streamTagReads(frame, frameLength, NULL);
+    }
+    else
+    {
+      parsed = decodeTagReads(pTypeRegistry, frame, frameLength, MODE_ARENA == mode, NULL);
+    }
+  }
+  elapsed = nowNs() - start;
+  counting = false;
+
+  if (parsed != tags)
+  {
+    errx(1, "Parsed %u of %u TagReportData entries", parsed, tags);
+  }
+  printf("%6u tags, %8u byte frame, %-6s: %10.3f ms per report, %8.1f ns per tag, %8" PRIu64 " allocations per report\n",
+         tags, frameLength, modeNames[mode], (double)elapsed / iterations / 1e6,
+         (double)elapsed / iterations / tags, allocations / iterations);
+}
+
+static void
+runSize(LLRP_tSTypeRegistry *pTypeRegistry, uint32_t tags, uint32_t iterations,
+        const bool modes[])
+{
+  TMR_TagReadData decoded, streamed;
+  uint8_t *frame;
+  uint32_t frameLength;
+  int mode;
+
+  frame = encodeReport(tags, &frameLength);
+  decodeTagReads(pTypeRegistry, frame, frameLength, false, &decoded);
+  streamTagReads(frame, frameLength, &streamed);
+  verify(&decoded, &streamed);
+
+  for (mode = MODE_HEAP; mode <= MODE_STREAM; mode++)
+  {
+    if (modes[mode])
+    {
+      runBench(pTypeRegistry, frame, frameLength, tags, iterations, (Mode)mode);
+    }
+  }
+  free(frame);
+}
+
+int main(int argc, char *argv[])
+{
+  LLRP_tSTypeRegistry *pTypeRegistry;
+  uint32_t tags = 0, iterations = 20;
+  bool modes[] = {true, true, true};
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if ((0 == strcmp("--tags", argv[i])) && (i + 1 < argc))
+    {
+      tags = atoi(argv[++i]);
+    }
+    else if ((0 == strcmp("--iterations", argv[i])) && (i + 1 < argc))
+    {
+      iterations = atoi(argv[++i]);
+    }
+    else if (0 == strcmp("--heap", argv[i]))
+    {
+      modes[MODE_ARENA] = modes[MODE_STREAM] = false;
+    }
+    else if (0 == strcmp("--arena", argv[i]))
+    {
+      modes[MODE_HEAP] = modes[MODE_STREAM] = false;
+    }
+    else if (0 == strcmp("--stream", argv[i]))
+    {
+      modes[MODE_HEAP] = modes[MODE_ARENA] = false;
+    }
+    else
+    {
+      fprintf(stderr, "Argument %s is not recognized\n", argv[i]);
+      usage();
+    }
+  }
+  if (0 == iterations)
+  {
+    usage();
+  }
+
+  pTypeRegistry = LLRP_getTheTypeRegistry();
+  if (NULL == pTypeRegistry)
+  {
+    errx(1, "Error creating the LLRP type registry");
+  }
+  LLRP_enrollTmTypesIntoRegistry(pTypeRegistry);
+
+  /* Just enough of an LLRP reader for the metadata parsers */
+  benchReader.readerType = TMR_READER_TYPE_LLRP;
+  benchReader.u.llrpReader.metadata = BENCH_METADATA;
+  strcpy(benchReader.u.llrpReader.capabilities.softwareVersion, "5.3.2.93");
+  for (i = 0; i < BENCH_CHANNELS; i++)
+  {
+    benchFrequencies[i] = 902750 + (500 * i);
+  }
+  benchReader.u.llrpReader.capabilities.freqTable.list = benchFrequencies;
+  benchReader.u.llrpReader.capabilities.freqTable.len = BENCH_CHANNELS;
+  benchReader.u.llrpReader.readPlanProtocol[1].rospecProtocol = TMR_TAG_PROTOCOL_GEN2;
+
+  if (0 != tags)
+  {
+    runSize(pTypeRegistry, tags, iterations, modes);
+  }
+  else
+  {
+    runSize(pTypeRegistry, 100, iterations, modes);
+    runSize(pTypeRegistry, 1000, iterations, modes);
+    runSize(pTypeRegistry, 10000, iterations, modes);
+  }
+
+  LLRP_TypeRegistry_destruct(pTypeRegistry);
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  errx(1, "LLRP support is not included in this build");
+  return 1;
+}
+
+#endif /* TMR_ENABLE_LLRP_READER */
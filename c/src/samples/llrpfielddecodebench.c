@@ -0,0 +1,375 @@
+/**
+ * Sample program that measures how fast LTKC decodes RO_ACCESS_REPORT
+ * frames, with the fields of each parameter read through the decoder
+ * stream ops one at a time, or by the decoders generated for each type
+ * that read them straight from the frame.
+ * Two kinds of report are decoded: one with the standard LLRP tag
+ * metadata parameters, and one whose tags carry the ThingMagic custom
+ * metadata parameters instead.
+ * No reader is needed; the reports are built and encoded locally.
+ * @file llrpfielddecodebench.c
+ */
+#include <tm_reader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#ifndef WIN32
+#include <time.h>
+#endif
+
+#define usage() {errx(1, "Please provide valid arguments, such as: [--tags n] [--iterations n] [--standard|--custom]\n"\
+                         "[--tags n] : TagReportData entries per report, e.g., '--tags 1000'; by default 100 and 1000 are run\n"\
+                         "[--iterations n] : number of reports to decode for each report size, e.g., '--iterations 200'\n"\
+                         "[--standard|--custom] : only decode reports with standard or with ThingMagic custom metadata; by default both are run\n");}
+
+void errx(int exitval, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+
+  exit(exitval);
+}
+
+#ifdef TMR_ENABLE_LLRP_READER
+
+#include "llrp_reader_imp.h"
+
+typedef enum Report
+{
+  REPORT_STANDARD,
+  REPORT_CUSTOM,
+} Report;
+
+static const char *reportNames[] = {"standard", "custom"};
+
+/* Large enough for the XML of the first tag of either report */
+#define BENCH_XML_SIZE 65536
+
+static uint64_t
+nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/**
+ * The standard LLRP metadata a reader reports for each tag
+ */
+static void
+addStandardMetadata(LLRP_tSTagReportData *pTagData, uint32_t i)
+{
+  LLRP_tSAntennaID *pAntenna;
+  LLRP_tSPeakRSSI *pRssi;
+  LLRP_tSFirstSeenTimestampUTC *pSeen;
+  LLRP_tSLastSeenTimestampUTC *pLastSeen;
+  LLRP_tSChannelIndex *pChannel;
+  LLRP_tSTagSeenCount *pCount;
+  LLRP_tSC1G2_CRC *pCRC;
+
+  pAntenna = LLRP_AntennaID_construct();
+  LLRP_AntennaID_setAntennaID(pAntenna, 1 + (i % 4));
+  LLRP_TagReportData_setAntennaID(pTagData, pAntenna);
+  pRssi = LLRP_PeakRSSI_construct();
+  LLRP_PeakRSSI_setPeakRSSI(pRssi, -60 + (int8_t)(i % 20));
+  LLRP_TagReportData_setPeakRSSI(pTagData, pRssi);
+  pSeen = LLRP_FirstSeenTimestampUTC_construct();
+  LLRP_FirstSeenTimestampUTC_setMicroseconds(pSeen, 1000000 + i);
+  LLRP_TagReportData_setFirstSeenTimestampUTC(pTagData, pSeen);
+  pLastSeen = LLRP_LastSeenTimestampUTC_construct();
+  LLRP_LastSeenTimestampUTC_setMicroseconds(pLastSeen, 1500000000000000ull + (i * 1000ull));
+  LLRP_TagReportData_setLastSeenTimestampUTC(pTagData, pLastSeen);
+  pChannel = LLRP_ChannelIndex_construct();
+  LLRP_ChannelIndex_setChannelIndex(pChannel, 1 + (i % 50));
+  LLRP_TagReportData_setChannelIndex(pTagData, pChannel);
+  pCount = LLRP_TagSeenCount_construct();
+  LLRP_TagSeenCount_setTagCount(pCount, 1 + (i % 3));
+  LLRP_TagReportData_setTagSeenCount(pTagData, pCount);
+  pCRC = LLRP_C1G2_CRC_construct();
+  LLRP_C1G2_CRC_setCRC(pCRC, (llrp_u16_t)(i * 7));
+  LLRP_TagReportData_addAirProtocolTagData(pTagData, &pCRC->hdr);
+}
+
+/**
+ * The ThingMagic custom metadata a reader reports for each tag when
+ * per antenna metadata is enabled
+ */
+static void
+addCustomMetadata(LLRP_tSTagReportData *pTagData, uint32_t i)
+{
+  LLRP_tSThingMagicRFPhase *pPhase;
+  LLRP_tSThingMagicCustomProtocolID *pProtocol;
+  LLRP_tSThingMagicMetadataGPIO *pGpio;
+  LLRP_tSThingMagicMetadataGen2 *pGen2;
+  LLRP_tSGen2QResponse *pQ;
+  LLRP_tSGen2LFResponse *pLF;
+  LLRP_tSGen2TargetResponse *pTarget;
+  int pin;
+
+  pPhase = LLRP_ThingMagicRFPhase_construct();
+  LLRP_ThingMagicRFPhase_setPhase(pPhase, (llrp_u16_t)(i % 180));
+  LLRP_TagReportData_addCustom(pTagData, &pPhase->hdr);
+  pProtocol = LLRP_ThingMagicCustomProtocolID_construct();
+  LLRP_ThingMagicCustomProtocolID_setProtocolId(pProtocol, LLRP_ThingMagicCustomProtocol_Gen2);
+  LLRP_TagReportData_addCustom(pTagData, &pProtocol->hdr);
+  pGpio = LLRP_ThingMagicMetadataGPIO_construct();
+  for (pin = 1; pin <= 4; pin++)
+  {
+    LLRP_tSGPIOStatus *pStatus;
+
+    pStatus = LLRP_GPIOStatus_construct();
+    LLRP_GPIOStatus_setid(pStatus, (llrp_u8_t)pin);
+    LLRP_GPIOStatus_setStatus(pStatus, (i >> pin) & 1);
+    LLRP_GPIOStatus_setDirection(pStatus, pin > 2);
+    LLRP_ThingMagicMetadataGPIO_addGPIOStatus(pGpio, pStatus);
+  }
+  LLRP_TagReportData_addCustom(pTagData, &pGpio->hdr);
+  pGen2 = LLRP_ThingMagicMetadataGen2_construct();
+  pQ = LLRP_Gen2QResponse_construct();
+  LLRP_Gen2QResponse_setQValue(pQ, 4);
+  LLRP_ThingMagicMetadataGen2_setGen2QResponse(pGen2, pQ);
+  pLF = LLRP_Gen2LFResponse_construct();
+  LLRP_Gen2LFResponse_setLFValue(pLF, 640);
+  LLRP_ThingMagicMetadataGen2_setGen2LFResponse(pGen2, pLF);
+  pTarget = LLRP_Gen2TargetResponse_construct();
+  LLRP_Gen2TargetResponse_setTargetValue(pTarget, i & 1);
+  LLRP_ThingMagicMetadataGen2_setGen2TargetResponse(pGen2, pTarget);
+  LLRP_TagReportData_addCustom(pTagData, &pGen2->hdr);
+}
+
+/**
+ * Build an RO_ACCESS_REPORT of the given kind and encode it into a frame.
+ */
+static uint8_t *
+encodeReport(Report report, uint32_t tags, uint32_t *frameLength)
+{
+  LLRP_tSRO_ACCESS_REPORT *pReport;
+  LLRP_tSFrameEncoder *pEncoder;
+  uint32_t bufSize, i;
+  uint8_t *buf;
+
+  pReport = LLRP_RO_ACCESS_REPORT_construct();
+  for (i = 0; i < tags; i++)
+  {
+    LLRP_tSTagReportData *pTagData;
+    LLRP_tSEPC_96 *pEpc;
+    LLRP_tSROSpecID *pROSpecID;
+    LLRP_tSC1G2_PC *pPC;
+    llrp_u96_t epc;
+
+    memset(&epc, 0, sizeof(epc));
+    epc.aValue[8] = (llrp_u8_t)(i >> 24);
+    epc.aValue[9] = (llrp_u8_t)(i >> 16);
+    epc.aValue[10] = (llrp_u8_t)(i >> 8);
+    epc.aValue[11] = (llrp_u8_t)i;
+
+    pTagData = LLRP_TagReportData_construct();
+    pEpc = LLRP_EPC_96_construct();
+    LLRP_EPC_96_setEPC(pEpc, epc);
+    LLRP_TagReportData_setEPCParameter(pTagData, &pEpc->hdr);
+    pROSpecID = LLRP_ROSpecID_construct();
+    LLRP_ROSpecID_setROSpecID(pROSpecID, 1);
+    LLRP_TagReportData_setROSpecID(pTagData, pROSpecID);
+    pPC = LLRP_C1G2_PC_construct();
+    LLRP_C1G2_PC_setPC_Bits(pPC, 0x3000);
+    LLRP_TagReportData_addAirProtocolTagData(pTagData, &pPC->hdr);
+    if (REPORT_STANDARD == report)
+    {
+      addStandardMetadata(pTagData, i);
+    }
+    else
+    {
+      addCustomMetadata(pTagData, i);
+    }
+    LLRP_RO_ACCESS_REPORT_addTagReportData(pReport, pTagData);
+  }
+
+  bufSize = 1024 + (tags * 256);
+  buf = malloc(bufSize);
+  if (NULL == buf)
+  {
+    errx(1, "Out of memory\n");
+  }
+  pEncoder = LLRP_FrameEncoder_construct(buf, bufSize);
+  LLRP_Encoder_encodeElement(&pEncoder->encoderHdr, &pReport->hdr.elementHdr);
+  if (LLRP_RC_OK != pEncoder->encoderHdr.ErrorDetails.eResultCode)
+  {
+    errx(1, "Encoding a %u tag report failed: %s\n", tags,
+         pEncoder->encoderHdr.ErrorDetails.pWhatStr);
+  }
+  *frameLength = pEncoder->iNext;
+  LLRP_Encoder_destruct(&pEncoder->encoderHdr);
+  LLRP_Element_destruct(&pReport->hdr.elementHdr);
+
+  return buf;
+}
+
+/**
+ * Decode the report into an arena, as LLRP_Conn_recvMessage() does
+ * with bDecodeIntoArena set
+ */
+static LLRP_tSMessage *
+decodeReport(LLRP_tSTypeRegistry *pTypeRegistry, uint8_t *frame, uint32_t frameLength,
+             bool byStream)
+{
+  LLRP_tSFrameDecoder *pDecoder;
+  LLRP_tSMessage *pMessage;
+
+  pDecoder = LLRP_FrameDecoder_construct(pTypeRegistry, frame, frameLength);
+  pDecoder->bDecodeFieldsByStream = byStream;
+  pDecoder->pArena = LLRP_Arena_construct(LLRP_ARENA_BYTES_PER_FRAME_BYTE * frameLength);
+  pMessage = LLRP_Decoder_decodeMessage(&pDecoder->decoderHdr);
+  if (NULL == pMessage)
+  {
+    errx(1, "Decoding a %u byte report failed: %s\n", frameLength,
+         pDecoder->decoderHdr.ErrorDetails.pWhatStr);
+  }
+  LLRP_Decoder_destruct(&pDecoder->decoderHdr);
+
+  return pMessage;
+}
+
+/**
+ * Check that both ways of decoding give the same first tag
+ */
+static void
+verify(LLRP_tSTypeRegistry *pTypeRegistry, uint8_t *frame, uint32_t frameLength)
+{
+  static char byStream[BENCH_XML_SIZE], generated[BENCH_XML_SIZE];
+  LLRP_tSMessage *pMessage;
+  int i;
+
+  for (i = 0; i < 2; i++)
+  {
+    pMessage = decodeReport(pTypeRegistry, frame, frameLength, 0 == i);
+    LLRP_toXMLString(&LLRP_RO_ACCESS_REPORT_beginTagReportData(
+                       (LLRP_tSRO_ACCESS_REPORT *)pMessage)->hdr.elementHdr,
+                     (0 == i) ? byStream : generated, BENCH_XML_SIZE);
+    LLRP_Element_destruct(&pMessage->elementHdr);
+  }
+  if (0 != strcmp(byStream, generated))
+  {
+    errx(1, "The generated decoders decoded a tag differently:\n%s\n%s\n", byStream, generated);
+  }
+}
+
+static uint64_t
+runBench(LLRP_tSTypeRegistry *pTypeRegistry, uint8_t *frame, uint32_t frameLength,
+         uint32_t iterations, bool byStream)
+{
+  uint64_t start;
+  uint32_t i;
+
+  start = nowNs();
+  for (i = 0; i < iterations; i++)
+  {
+    LLRP_Element_destruct(&decodeReport(pTypeRegistry, frame, frameLength, byStream)->elementHdr);
+  }
+
+  return nowNs() - start;
+}
+
+static void
+runSize(LLRP_tSTypeRegistry *pTypeRegistry, Report report, uint32_t tags, uint32_t iterations)
+{
+  uint64_t byStream, generated;
+  uint32_t frameLength;
+  uint8_t *frame;
+
+  frame = encodeReport(report, tags, &frameLength);
+  verify(pTypeRegistry, frame, frameLength);
+
+  /* Once each to warm up */
+  runBench(pTypeRegistry, frame, frameLength, 1, true);
+  runBench(pTypeRegistry, frame, frameLength, 1, false);
+  byStream = runBench(pTypeRegistry, frame, frameLength, iterations, true);
+  generated = runBench(pTypeRegistry, frame, frameLength, iterations, false);
+
+  printf("%-8s %6u tags, %8u byte frame: stream ops %8.1f MB/s %7.1f ns per tag, "
+         "generated %8.1f MB/s %7.1f ns per tag, %.2fx\n",
+         reportNames[report], tags, frameLength,
+         (double)frameLength * iterations * 1e3 / byStream,
+         (double)byStream / iterations / tags,
+         (double)frameLength * iterations * 1e3 / generated,
+         (double)generated / iterations / tags,
+         (double)byStream / generated);
+  free(frame);
+}
+
+int main(int argc, char *argv[])
+{
+  LLRP_tSTypeRegistry *pTypeRegistry;
+  uint32_t tags = 0, iterations = 200;
+  bool reports[] = {true, true};
+  int report, i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if ((0 == strcmp("--tags", argv[i])) && (i + 1 < argc))
+    {
+      tags = atoi(argv[++i]);
+    }
+    else if ((0 == strcmp("--iterations", argv[i])) && (i + 1 < argc))
+    {
+      iterations = atoi(argv[++i]);
+    }
+    else if (0 == strcmp("--standard", argv[i]))
+    {
+      reports[REPORT_CUSTOM] = false;
+    }
+    else if (0 == strcmp("--custom", argv[i]))
+    {
+      reports[REPORT_STANDARD] = false;
+    }
+    else
+    {
+      fprintf(stderr, "Argument %s is not recognized\n", argv[i]);
+      usage();
+    }
+  }
+  if (0 == iterations)
+  {
+    usage();
+  }
+
+  pTypeRegistry = LLRP_getTheTypeRegistry();
+  if (NULL == pTypeRegistry)
+  {
+    errx(1, "Error creating the LLRP type registry\n");
+  }
+  LLRP_enrollTmTypesIntoRegistry(pTypeRegistry);
+
+  for (report = REPORT_STANDARD; report <= REPORT_CUSTOM; report++)
+  {
+    if (!reports[report])
+    {
+      continue;
+    }
+    if (0 != tags)
+    {
+      runSize(pTypeRegistry, (Report)report, tags, iterations);
+    }
+    else
+    {
+      runSize(pTypeRegistry, (Report)report, 100, iterations);
+      runSize(pTypeRegistry, (Report)report, 1000, iterations);
+    }
+  }
+
+  LLRP_TypeRegistry_destruct(pTypeRegistry);
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  errx(1, "LLRP support is not included in this build\n");
+  return 1;
+}
+
+#endif /* TMR_ENABLE_LLRP_READER */
@@ -0,0 +1,364 @@
+/**
+ * Sample program that measures how many tags per second the host can
+ * take from an LLRP reader during continuous reading, depending on how
+ * many tags the reader packs into each RO_ACCESS_REPORT (see
+ * /reader/llrp/reportSpec). The reports are received over a local
+ * socket, streamed by the same frame hook and parser the API uses, and
+ * handed to a read listener.
+ * No reader is needed; the reports are built and encoded locally.
+ * @file llrpreportbench.c
+ */
+#include <tm_reader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#ifndef WIN32
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#endif
+
+#define usage() {errx(1, "Please provide valid arguments, such as: [--tags n] [--report n]\n"\
+                         "[--tags n] : tags to receive for each report size, e.g., '--tags 100000'\n"\
+                         "[--report n] : tags per RO_ACCESS_REPORT, e.g., '--report 50'; by default 1, 10, 100 and 1000 are run");}
+
+void errx(int exitval, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  /* As errx(3), which appends the newline itself */
+  fputc('\n', stderr);
+
+  exit(exitval);
+}
+
+#if defined(TMR_ENABLE_LLRP_READER) && defined(TMR_ENABLE_BACKGROUND_READS) && !defined(WIN32)
+
+#include "llrp_reader_imp.h"
+
+/* Metadata parsed from each report, as a reader configured for it would */
+#define BENCH_METADATA (TMR_TRD_METADATA_FLAG_ANTENNAID | TMR_TRD_METADATA_FLAG_RSSI | \
+                        TMR_TRD_METADATA_FLAG_TIMESTAMP | TMR_TRD_METADATA_FLAG_READCOUNT | \
+                        TMR_TRD_METADATA_FLAG_FREQUENCY | TMR_TRD_METADATA_FLAG_PROTOCOL | \
+                        TMR_TRD_METADATA_FLAG_PHASE)
+#define BENCH_CHANNELS 50
+
+static TMR_Reader benchReader;
+static uint32_t benchFrequencies[BENCH_CHANNELS];
+static uint64_t tagsRead;
+
+typedef struct Sender
+{
+  int fd;
+  const uint8_t *frame;
+  uint32_t frameLength;
+  uint32_t reports;
+} Sender;
+
+static uint64_t
+nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static void
+countTag(TMR_Reader *reader, const TMR_TagReadData *t, void *cookie)
+{
+  tagsRead++;
+}
+
+/**
+ * Build an RO_ACCESS_REPORT of the given number of tags, as a reader
+ * sends them with the default report content, and encode it into a frame.
+ */
+static uint8_t *
+encodeReport(uint32_t tags, uint32_t *frameLength)
+{
+  LLRP_tSRO_ACCESS_REPORT *pReport;
+  LLRP_tSFrameEncoder *pEncoder;
+  uint32_t bufSize, i;
+  uint8_t *buf;
+
+  pReport = LLRP_RO_ACCESS_REPORT_construct();
+  for (i = 0; i < tags; i++)
+  {
+    LLRP_tSTagReportData *pTagData;
+    LLRP_tSEPC_96 *pEpc;
+    LLRP_tSROSpecID *pROSpecID;
+    LLRP_tSSpecIndex *pSpecIndex;
+    LLRP_tSAntennaID *pAntenna;
+    LLRP_tSPeakRSSI *pRssi;
+    LLRP_tSChannelIndex *pChannel;
+    LLRP_tSFirstSeenTimestampUTC *pSeen;
+    LLRP_tSLastSeenTimestampUTC *pLastSeen;
+    LLRP_tSTagSeenCount *pCount;
+    LLRP_tSC1G2_PC *pPC;
+    LLRP_tSC1G2_CRC *pCRC;
+    LLRP_tSThingMagicRFPhase *pPhase;
+    llrp_u96_t epc;
+
+    memset(&epc, 0, sizeof(epc));
+    epc.aValue[8] = (llrp_u8_t)(i >> 24);
+    epc.aValue[9] = (llrp_u8_t)(i >> 16);
+    epc.aValue[10] = (llrp_u8_t)(i >> 8);
+    epc.aValue[11] = (llrp_u8_t)i;
+
+    pTagData = LLRP_TagReportData_construct();
+    pEpc = LLRP_EPC_96_construct();
+    LLRP_EPC_96_setEPC(pEpc, epc);
+    LLRP_TagReportData_setEPCParameter(pTagData, &pEpc->hdr);
+    pROSpecID = LLRP_ROSpecID_construct();
+    LLRP_ROSpecID_setROSpecID(pROSpecID, 1);
+    LLRP_TagReportData_setROSpecID(pTagData, pROSpecID);
+    pSpecIndex = LLRP_SpecIndex_construct();
+    LLRP_SpecIndex_setSpecIndex(pSpecIndex, 1);
+    LLRP_TagReportData_setSpecIndex(pTagData, pSpecIndex);
+    pAntenna = LLRP_AntennaID_construct();
+    LLRP_AntennaID_setAntennaID(pAntenna, 1 + (i % 4));
+    LLRP_TagReportData_setAntennaID(pTagData, pAntenna);
+    pRssi = LLRP_PeakRSSI_construct();
+    LLRP_PeakRSSI_setPeakRSSI(pRssi, -60 + (int8_t)(i % 20));
+    LLRP_TagReportData_setPeakRSSI(pTagData, pRssi);
+    pChannel = LLRP_ChannelIndex_construct();
+    LLRP_ChannelIndex_setChannelIndex(pChannel, 1 + (i % BENCH_CHANNELS));
+    LLRP_TagReportData_setChannelIndex(pTagData, pChannel);
+    pSeen = LLRP_FirstSeenTimestampUTC_construct();
+    LLRP_FirstSeenTimestampUTC_setMicroseconds(pSeen, 1000000 + i);
+    LLRP_TagReportData_setFirstSeenTimestampUTC(pTagData, pSeen);
+    pLastSeen = LLRP_LastSeenTimestampUTC_construct();
+    LLRP_LastSeenTimestampUTC_setMicroseconds(pLastSeen, 1500000000000000ull + (i * 1000ull));
+    LLRP_TagReportData_setLastSeenTimestampUTC(pTagData, pLastSeen);
+    pCount = LLRP_TagSeenCount_construct();
+    LLRP_TagSeenCount_setTagCount(pCount, 1 + (i % 3));
+    LLRP_TagReportData_setTagSeenCount(pTagData, pCount);
+    pPC = LLRP_C1G2_PC_construct();
+    LLRP_C1G2_PC_setPC_Bits(pPC, 0x3000);
+    LLRP_TagReportData_addAirProtocolTagData(pTagData, &pPC->hdr);
+    pCRC = LLRP_C1G2_CRC_construct();
+    LLRP_C1G2_CRC_setCRC(pCRC, (llrp_u16_t)(i * 7));
+    LLRP_TagReportData_addAirProtocolTagData(pTagData, &pCRC->hdr);
+    pPhase = LLRP_ThingMagicRFPhase_construct();
+    LLRP_ThingMagicRFPhase_setPhase(pPhase, (llrp_u16_t)(i % 180));
+    LLRP_TagReportData_addCustom(pTagData, &pPhase->hdr);
+    LLRP_RO_ACCESS_REPORT_addTagReportData(pReport, pTagData);
+  }
+
+  bufSize = 1024 + (tags * 128);
+  buf = malloc(bufSize);
+  if (NULL == buf)
+  {
+    errx(1, "Out of memory");
+  }
+  pEncoder = LLRP_FrameEncoder_construct(buf, bufSize);
+  LLRP_Encoder_encodeElement(&pEncoder->encoderHdr, &pReport->hdr.elementHdr);
+  if (LLRP_RC_OK != pEncoder->encoderHdr.ErrorDetails.eResultCode)
+  {
+    errx(1, "Encoding a %u tag report failed: %s", tags,
+         pEncoder->encoderHdr.ErrorDetails.pWhatStr);
+  }
+  *frameLength = pEncoder->iNext;
+  LLRP_Encoder_destruct(&pEncoder->encoderHdr);
+  LLRP_Element_destruct(&pReport->hdr.elementHdr);
+
+  return buf;
+}
+
+/**
+ * Plays the reader: writes the report frame to the socket as fast as
+ * the receiver takes it.
+ */
+static void *
+sendReports(void *arg)
+{
+  Sender *sender = arg;
+  uint32_t i, sent;
+
+  for (i = 0; i < sender->reports; i++)
+  {
+    for (sent = 0; sent < sender->frameLength; )
+    {
+      ssize_t n;
+
+      n = write(sender->fd, sender->frame + sent, sender->frameLength - sent);
+      if (n <= 0)
+      {
+        errx(1, "Writing report %u failed", i);
+      }
+      sent += n;
+    }
+  }
+
+  return NULL;
+}
+
+static void
+runSize(LLRP_tSTypeRegistry *pTypeRegistry, uint32_t tagsPerReport, uint32_t tags)
+{
+  TMR_LLRP_LlrpReader *lr = &benchReader.u.llrpReader;
+  LLRP_tSConnection *pConn;
+  Sender sender;
+  pthread_t thread;
+  uint64_t start, elapsed;
+  uint32_t i;
+  int sv[2];
+
+  if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+  {
+    errx(1, "Error creating a socket pair");
+  }
+  pConn = LLRP_Conn_construct(pTypeRegistry, 0);
+  if (NULL == pConn)
+  {
+    errx(1, "Error creating the LLRP connection");
+  }
+  pConn->fd = sv[0];
+  pConn->pfFrameHook = TMR_LLRP_streamReportFrame;
+  pConn->pFrameHookContext = &benchReader;
+  lr->pConn = pConn;
+
+  sender.fd = sv[1];
+  sender.frame = encodeReport(tagsPerReport, &sender.frameLength);
+  sender.reports = (tags + tagsPerReport - 1) / tagsPerReport;
+  tagsRead = 0;
+
+  start = nowNs();
+  pthread_create(&thread, NULL, sendReports, &sender);
+  for (i = 0; i < sender.reports; i++)
+  {
+    LLRP_tSMessage *pMessage;
+    LLRP_tSMessage *pDecoded;
+    uint8_t *frame;
+    uint32_t frameLength;
+    uint32_t streamed;
+
+    /* As TMR_LLRP_hasMoreTags() and parse_tag_reads() do for each report */
+    pMessage = LLRP_Conn_recvMessage(pConn, 5000);
+    if (NULL != pMessage)
+    {
+      TMR_LLRP_takeStreamedFrame(&benchReader, pMessage, &frame, &frameLength);
+    }
+    if ((NULL == pMessage) || (NULL == frame))
+    {
+      errx(1, "Report %u was not streamed", i);
+    }
+    if ((TMR_SUCCESS != TMR_LLRP_notifyStreamedTagReads(&benchReader, frame,
+                                                        frameLength, &streamed,
+                                                        &pDecoded)) ||
+        (NULL != pDecoded))
+    {
+      errx(1, "Report %u was decoded after %u streamed tags", i, streamed);
+    }
+    free(frame);
+    TMR_LLRP_freeMessage(pMessage);
+  }
+  elapsed = nowNs() - start;
+  pthread_join(thread, NULL);
+
+  if (tagsRead != (uint64_t)sender.reports * tagsPerReport)
+  {
+    errx(1, "Read %llu of %llu tags", (unsigned long long)tagsRead,
+         (unsigned long long)sender.reports * tagsPerReport);
+  }
+  printf("%5u tags per report, %6u byte frame: %9.0f tags/s, %8.0f reports/s, %7.1f ns per tag\n",
+         tagsPerReport, sender.frameLength, tagsRead * 1e9 / elapsed,
+         sender.reports * 1e9 / elapsed, (double)elapsed / tagsRead);
+
+  lr->pConn = NULL;
+  LLRP_Conn_destruct(pConn);
+  close(sv[0]);
+  close(sv[1]);
+  free((uint8_t *)sender.frame);
+}
+
+int main(int argc, char *argv[])
+{
+  LLRP_tSTypeRegistry *pTypeRegistry;
+  TMR_ReadListenerBlock rlb;
+  uint32_t tags = 200000, tagsPerReport = 0;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if ((0 == strcmp("--tags", argv[i])) && (i + 1 < argc))
+    {
+      tags = atoi(argv[++i]);
+    }
+    else if ((0 == strcmp("--report", argv[i])) && (i + 1 < argc))
+    {
+      tagsPerReport = atoi(argv[++i]);
+      if (0 == tagsPerReport)
+      {
+        usage();
+      }
+    }
+    else
+    {
+      fprintf(stderr, "Argument %s is not recognized\n", argv[i]);
+      usage();
+    }
+  }
+  if (0 == tags)
+  {
+    usage();
+  }
+
+  pTypeRegistry = LLRP_getTheTypeRegistry();
+  if (NULL == pTypeRegistry)
+  {
+    errx(1, "Error creating the LLRP type registry");
+  }
+  LLRP_enrollTmTypesIntoRegistry(pTypeRegistry);
+
+  /* Just enough of an LLRP reader in continuous reading for the streamer */
+  benchReader.readerType = TMR_READER_TYPE_LLRP;
+  benchReader.continuousReading = true;
+  benchReader.u.llrpReader.pTypeRegistry = pTypeRegistry;
+  benchReader.u.llrpReader.metadata = BENCH_METADATA;
+  strcpy(benchReader.u.llrpReader.capabilities.softwareVersion, "5.3.2.93");
+  for (i = 0; i < BENCH_CHANNELS; i++)
+  {
+    benchFrequencies[i] = 902750 + (500 * i);
+  }
+  benchReader.u.llrpReader.capabilities.freqTable.list = benchFrequencies;
+  benchReader.u.llrpReader.capabilities.freqTable.len = BENCH_CHANNELS;
+  benchReader.u.llrpReader.readPlanProtocol[1].rospecProtocol = TMR_TAG_PROTOCOL_GEN2;
+  pthread_mutex_init(&benchReader.listenerLock, NULL);
+  pthread_mutex_init(&benchReader.u.llrpReader.streamedLock, NULL);
+  rlb.listener = countTag;
+  rlb.cookie = NULL;
+  rlb.next = NULL;
+  benchReader.readListeners = &rlb;
+
+  if (0 != tagsPerReport)
+  {
+    runSize(pTypeRegistry, tagsPerReport, tags);
+  }
+  else
+  {
+    runSize(pTypeRegistry, 1, tags);
+    runSize(pTypeRegistry, 10, tags);
+    runSize(pTypeRegistry, 100, tags);
+    runSize(pTypeRegistry, 1000, tags);
+  }
+
+  LLRP_TypeRegistry_destruct(pTypeRegistry);
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  errx(1, "LLRP background reads are not included in this build");
+  return 1;
+}
+
+#endif /* TMR_ENABLE_LLRP_READER && TMR_ENABLE_BACKGROUND_READS && !WIN32 */
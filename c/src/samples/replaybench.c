@@ -0,0 +1,218 @@
+/**
+ * Sample program that measures read throughput by replaying a transport
+ * capture through the replay:// transport. It can also record a capture
+ * from the sim:// emulated module to replay later.
+ * @file replaybench.c
+ */
+#include <tm_reader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#ifndef WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define usage() {errx(1, "Please provide a capture file, such as: capture-file [--time ms] [--original] [--loop] [--record] [--tags n]\n"\
+                         "capture-file : file written by TMR_startTransportCapture(), e.g., 'site.cap'\n"\
+                         "[--time ms] : duration of the background read, e.g., '--time 2000'\n"\
+                         "[--original] : deliver frames with their recorded spacing instead of as fast as possible\n"\
+                         "[--loop] : repeat the recorded tag stream until the read is stopped\n"\
+                         "[--record] : write the capture from a sim:// read instead of replaying it\n"\
+                         "[--tags n] : with --record, emulated tag population, e.g., '--tags 1000'\n");}
+
+void errx(int exitval, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+
+  exit(exitval);
+}
+
+void checkerr(TMR_Reader* rp, TMR_Status ret, int exitval, const char *msg)
+{
+  if ((TMR_SUCCESS != ret) && (TMR_SUCCESS_STREAMING != ret))
+  {
+    errx(exitval, "Error %s: %s\n", msg, TMR_strerr(rp, ret));
+  }
+}
+
+#if defined(TMR_ENABLE_SERIAL_TRANSPORT_REPLAY) && defined(TMR_ENABLE_SERIAL_TRANSPORT_SIM)
+
+typedef struct ReadCounts
+{
+  uint64_t reads;
+  uint32_t exceptions;
+  uint32_t crcErrors;
+} ReadCounts;
+
+void callback(TMR_Reader *reader, const TMR_TagReadData *t, void *cookie)
+{
+  ((ReadCounts *)cookie)->reads++;
+}
+
+void exceptionCallback(TMR_Reader *reader, TMR_Status error, void *cookie)
+{
+  ((ReadCounts *)cookie)->exceptions++;
+  if (TMR_ERROR_CRC_ERROR == error)
+  {
+    ((ReadCounts *)cookie)->crcErrors++;
+  }
+}
+
+static uint64_t
+nowMs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+int main(int argc, char *argv[])
+{
+  TMR_Reader r, *rp;
+  TMR_Status ret;
+  TMR_Region region;
+  TMR_ReadListenerBlock rlb;
+  TMR_ReadExceptionListenerBlock reb;
+  ReadCounts counts;
+  char uri[TMR_MAX_READER_NAME_LENGTH + 16];
+  const char *file = NULL;
+  uint32_t readTime = 2000, tags = 100;
+  bool original = false, loop = false, record = false;
+  uint64_t start, elapsed;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if ((0 == strcmp("--time", argv[i])) && (i + 1 < argc))
+    {
+      readTime = atoi(argv[++i]);
+    }
+    else if ((0 == strcmp("--tags", argv[i])) && (i + 1 < argc))
+    {
+      tags = atoi(argv[++i]);
+    }
+    else if (0 == strcmp("--original", argv[i]))
+    {
+      original = true;
+    }
+    else if (0 == strcmp("--loop", argv[i]))
+    {
+      loop = true;
+    }
+    else if (0 == strcmp("--record", argv[i]))
+    {
+      record = true;
+    }
+    else if (('-' != argv[i][0]) && (NULL == file))
+    {
+      file = argv[i];
+    }
+    else
+    {
+      fprintf(stderr, "Argument %s is not recognized\n", argv[i]);
+      usage();
+    }
+  }
+  if (NULL == file)
+  {
+    usage();
+  }
+
+  rp = &r;
+  if (record)
+  {
+    ret = TMR_setSerialTransport("sim", &TMR_SR_SerialTransportSimInit);
+    checkerr(rp, ret, 1, "registering the sim transport");
+    snprintf(uri, sizeof(uri), "sim:///tags=%u,rate=%u", tags, 20 * tags);
+  }
+  else
+  {
+    ret = TMR_setSerialTransport("replay", &TMR_SR_SerialTransportReplayInit);
+    checkerr(rp, ret, 1, "registering the replay transport");
+    snprintf(uri, sizeof(uri), "replay://%s%s?timing=%s&loop=%d", ('/' == file[0]) ? "" : "/",
+             file, original ? "original" : "fast", loop ? 1 : 0);
+  }
+
+  /* TMR_create() tokenizes the URI in place */
+  ret = TMR_create(rp, uri);
+  checkerr(rp, ret, 1, "creating reader");
+  if (record)
+  {
+    ret = TMR_startTransportCapture(rp, file, 0);
+    checkerr(rp, ret, 1, "starting capture");
+  }
+
+  ret = TMR_connect(rp);
+  checkerr(rp, ret, 1, "connecting reader");
+
+  region = TMR_REGION_NA;
+  ret = TMR_paramSet(rp, TMR_PARAM_REGION_ID, &region);
+  checkerr(rp, ret, 1, "setting region");
+
+  memset(&counts, 0, sizeof(counts));
+  rlb.listener = callback;
+  rlb.cookie = &counts;
+  reb.listener = exceptionCallback;
+  reb.cookie = &counts;
+  ret = TMR_addReadListener(rp, &rlb);
+  checkerr(rp, ret, 1, "adding read listener");
+  ret = TMR_addReadExceptionListener(rp, &reb);
+  checkerr(rp, ret, 1, "adding exception listener");
+
+  start = nowMs();
+  ret = TMR_startReading(rp);
+  checkerr(rp, ret, 1, "starting reading");
+#ifndef WIN32
+  usleep(readTime * 1000);
+#else
+  Sleep(readTime);
+#endif
+  ret = TMR_stopReading(rp);
+  checkerr(rp, ret, 1, "stopping reading");
+  elapsed = nowMs() - start;
+
+  if (record)
+  {
+    TMR_TransportCaptureStats stats;
+
+    TMR_getTransportCaptureStats(rp, &stats);
+    ret = TMR_stopTransportCapture(rp);
+    checkerr(rp, ret, 1, "stopping capture");
+    printf("Recorded %u frames (%u dropped) and %" PRIu64 " reads to %s\n",
+           stats.frames, stats.dropped, counts.reads, file);
+  }
+  else if (loop)
+  {
+    printf("Replayed %" PRIu64 " reads in %" PRIu64 " ms, %" PRIu64 " tags/s, "
+           "%u exceptions (%u CRC errors)\n",
+           counts.reads, elapsed, elapsed ? (counts.reads * 1000) / elapsed : 0,
+           counts.exceptions, counts.crcErrors);
+  }
+  else
+  {
+    /* One pass is mostly setup, so it is no throughput figure */
+    printf("Replayed %" PRIu64 " reads in a single pass of %" PRIu64 " ms, "
+           "%u exceptions (%u CRC errors); use --loop for tags/s\n",
+           counts.reads, elapsed, counts.exceptions, counts.crcErrors);
+  }
+
+  TMR_destroy(rp);
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  errx(1, "The replay and sim transports are not included in this build\n");
+  return 1;
+}
+
+#endif /* TMR_ENABLE_SERIAL_TRANSPORT_REPLAY && TMR_ENABLE_SERIAL_TRANSPORT_SIM */
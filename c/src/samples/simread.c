@@ -0,0 +1,272 @@
+/**
+ * Sample program that runs the serial reader against the sim://
+ * emulated module: a synchronous read, a timed background read that
+ * reports the tag rate, and a tag memory write and read back.
+ * No hardware is needed.
+ * @file simread.c
+ */
+#include <tm_reader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#ifndef WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define usage() {errx(1, "Please provide valid arguments, such as: [--tags n] [--rate n] [--time ms] [--stats] [--trace]\n"\
+                         "[--tags n] : emulated tag population, e.g., '--tags 1000'\n"\
+                         "[--rate n] : tag reads per second, 0 for as fast as possible, e.g., '--rate 50000'\n"\
+                         "[--time ms] : duration of the background read, e.g., '--time 2000'\n"\
+                         "[--stats] : request reader stats during the background read\n"\
+                         "[--trace] : print every frame exchanged with the emulator\n");}
+
+void errx(int exitval, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+
+  exit(exitval);
+}
+
+void checkerr(TMR_Reader* rp, TMR_Status ret, int exitval, const char *msg)
+{
+  if ((TMR_SUCCESS != ret) && (TMR_SUCCESS_STREAMING != ret))
+  {
+    errx(exitval, "Error %s: %s\n", msg, TMR_strerr(rp, ret));
+  }
+}
+
+#if defined(TMR_ENABLE_SERIAL_TRANSPORT_SIM)
+
+void serialPrinter(bool tx, uint32_t dataLen, const uint8_t data[],
+                   uint32_t timeout, void *cookie)
+{
+  FILE *out = cookie;
+  uint32_t i;
+
+  fprintf(out, "%s", tx ? "Sending: " : "Received:");
+  for (i = 0; i < dataLen; i++)
+  {
+    if (i > 0 && (i & 15) == 0)
+    {
+      fprintf(out, "\n         ");
+    }
+    fprintf(out, " %02x", data[i]);
+  }
+  fprintf(out, "\n");
+}
+
+typedef struct ReadCounts
+{
+  uint64_t reads;
+  uint32_t stats;
+  uint32_t exceptions;
+  TMR_Status lastError;
+} ReadCounts;
+
+void callback(TMR_Reader *reader, const TMR_TagReadData *t, void *cookie)
+{
+  ((ReadCounts *)cookie)->reads++;
+}
+
+void statsCallback(TMR_Reader *reader, const TMR_Reader_StatsValues *stats, void *cookie)
+{
+  ((ReadCounts *)cookie)->stats++;
+}
+
+void exceptionCallback(TMR_Reader *reader, TMR_Status error, void *cookie)
+{
+  ((ReadCounts *)cookie)->exceptions++;
+  ((ReadCounts *)cookie)->lastError = error;
+}
+
+static uint64_t
+nowMs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+int main(int argc, char *argv[])
+{
+  TMR_Reader r, *rp;
+  TMR_Status ret;
+  TMR_Region region;
+  TMR_TransportListenerBlock tb;
+  TMR_ReadListenerBlock rlb;
+  TMR_StatsListenerBlock slb;
+  TMR_ReadExceptionListenerBlock reb;
+  ReadCounts counts;
+  char uri[TMR_MAX_READER_NAME_LENGTH];
+  uint32_t tags = 100, rate = 0, readTime = 1000;
+  bool stats = false, trace = false;
+  int32_t found;
+  uint64_t start, elapsed;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if ((0 == strcmp("--tags", argv[i])) && (i + 1 < argc))
+    {
+      tags = atoi(argv[++i]);
+    }
+    else if ((0 == strcmp("--rate", argv[i])) && (i + 1 < argc))
+    {
+      rate = atoi(argv[++i]);
+    }
+    else if ((0 == strcmp("--time", argv[i])) && (i + 1 < argc))
+    {
+      readTime = atoi(argv[++i]);
+    }
+    else if (0 == strcmp("--stats", argv[i]))
+    {
+      stats = true;
+    }
+    else if (0 == strcmp("--trace", argv[i]))
+    {
+      trace = true;
+    }
+    else
+    {
+      fprintf(stderr, "Argument %s is not recognized\n", argv[i]);
+      usage();
+    }
+  }
+
+  rp = &r;
+  ret = TMR_setSerialTransport("sim", &TMR_SR_SerialTransportSimInit);
+  checkerr(rp, ret, 1, "registering the sim transport");
+
+  /* TMR_create() tokenizes the URI in place */
+  snprintf(uri, sizeof(uri), "sim:///tags=%u,rate=%u", tags, rate);
+  ret = TMR_create(rp, uri);
+  checkerr(rp, ret, 1, "creating reader");
+
+  if (trace)
+  {
+    tb.listener = serialPrinter;
+    tb.cookie = stdout;
+    TMR_addTransportListener(rp, &tb);
+  }
+
+  start = nowMs();
+  ret = TMR_connect(rp);
+  checkerr(rp, ret, 1, "connecting reader");
+  printf("Connected in %" PRIu64 " ms\n", nowMs() - start);
+
+  region = TMR_REGION_NA;
+  ret = TMR_paramSet(rp, TMR_PARAM_REGION_ID, &region);
+  checkerr(rp, ret, 1, "setting region");
+
+  /* Synchronous read */
+  start = nowMs();
+  ret = TMR_read(rp, 500, &found);
+  checkerr(rp, ret, 1, "reading tags");
+  i = 0;
+  while (TMR_SUCCESS == TMR_hasMoreTags(rp))
+  {
+    TMR_TagReadData trd;
+
+    ret = TMR_getNextTag(rp, &trd);
+    checkerr(rp, ret, 1, "fetching tag");
+    i++;
+  }
+  printf("Synchronous read: %d tags reported, %d fetched in %" PRIu64 " ms\n",
+         found, i, nowMs() - start);
+
+  /* Background read */
+  memset(&counts, 0, sizeof(counts));
+  rlb.listener = callback;
+  rlb.cookie = &counts;
+  reb.listener = exceptionCallback;
+  reb.cookie = &counts;
+  ret = TMR_addReadListener(rp, &rlb);
+  checkerr(rp, ret, 1, "adding read listener");
+  ret = TMR_addReadExceptionListener(rp, &reb);
+  checkerr(rp, ret, 1, "adding exception listener");
+  if (stats)
+  {
+    TMR_Reader_StatsFlag setFlag = TMR_READER_STATS_FLAG_ALL;
+
+    ret = TMR_paramSet(rp, TMR_PARAM_READER_STATS_ENABLE, &setFlag);
+    checkerr(rp, ret, 1, "enabling reader stats");
+    slb.listener = statsCallback;
+    slb.cookie = &counts;
+    ret = TMR_addStatsListener(rp, &slb);
+    checkerr(rp, ret, 1, "adding stats listener");
+  }
+
+  start = nowMs();
+  ret = TMR_startReading(rp);
+  checkerr(rp, ret, 1, "starting reading");
+#ifndef WIN32
+  usleep(readTime * 1000);
+#else
+  Sleep(readTime);
+#endif
+  ret = TMR_stopReading(rp);
+  checkerr(rp, ret, 1, "stopping reading");
+  elapsed = nowMs() - start;
+  printf("Background read: %" PRIu64 " reads in %" PRIu64 " ms, %" PRIu64 " tags/s",
+         counts.reads, elapsed, elapsed ? (counts.reads * 1000) / elapsed : 0);
+  if (stats)
+  {
+    printf(", %u stats reports", counts.stats);
+  }
+  printf("\n");
+  if (counts.exceptions)
+  {
+    printf("%u read exceptions, last: %s\n", counts.exceptions, TMR_strerr(rp, counts.lastError));
+  }
+  TMR_removeReadListener(rp, &rlb);
+  TMR_removeReadExceptionListener(rp, &reb);
+  if (stats)
+  {
+    TMR_removeStatsListener(rp, &slb);
+  }
+
+  /* Write user memory of the first tag, then read it back */
+  {
+    uint16_t words[] = {0x1234, 0x5678};
+    uint8_t back[4];
+    TMR_uint16List data;
+    TMR_uint8List readBack;
+    TMR_TagOp op;
+
+    data.list = words;
+    data.len = data.max = 2;
+    ret = TMR_TagOp_init_GEN2_WriteData(&op, TMR_GEN2_BANK_USER, 0, &data);
+    checkerr(rp, ret, 1, "initializing write");
+    ret = TMR_executeTagOp(rp, &op, NULL, NULL);
+    checkerr(rp, ret, 1, "writing user memory");
+
+    readBack.list = back;
+    readBack.len = 0;
+    readBack.max = sizeof(back);
+    ret = TMR_TagOp_init_GEN2_ReadData(&op, TMR_GEN2_BANK_USER, 0, 2);
+    checkerr(rp, ret, 1, "initializing read");
+    ret = TMR_executeTagOp(rp, &op, NULL, &readBack);
+    checkerr(rp, ret, 1, "reading user memory");
+    printf("User memory: %02x%02x %02x%02x\n", back[0], back[1], back[2], back[3]);
+  }
+
+  TMR_destroy(rp);
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  errx(1, "The sim transport is not included in this build\n");
+  return 1;
+}
+
+#endif /* TMR_ENABLE_SERIAL_TRANSPORT_SIM */
@@ -0,0 +1,475 @@
+/**
+ * Sample program that measures the round-trip latency of the native
+ * serial transport against a pseudo-terminal pair, or of the TCP
+ * transport against a loopback stand-in server, along with the system
+ * calls and CPU time spent per frame. The stream mode plays a module
+ * that pushes tag frames back to back, as during continuous reading.
+ * @file transportbench.c
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  /* posix_openpt(), ptsname(), cfmakeraw() */
+#endif
+#include <tm_reader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define usage() {errx(1, "Please provide valid arguments, such as: [--iterations n] [--size n] [--tcp] [--ipv6] [--stream] [--uring]\n"\
+                         "[--iterations n] : number of round trips, or frames with --stream, e.g., '--iterations 1000'\n"\
+                         "[--size n] : frame size in bytes, e.g., '--size 64'\n"\
+                         "[--tcp] : use the TCP transport against a loopback server instead of a pty\n"\
+                         "[--ipv6] : with --tcp, connect over ::1 instead of 127.0.0.1\n"\
+                         "[--stream] : answer one command with a back-to-back stream of frames\n"\
+                         "[--uring] : receive through io_uring where the kernel supports it\n");}
+
+void errx(int exitval, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+
+  exit(exitval);
+}
+
+#if defined(TMR_ENABLE_SERIAL_TRANSPORT_NATIVE) && !defined(WIN32)
+
+/*
+ * System calls made by the measuring thread. The sample is linked with
+ * --wrap for each call the transports make, so the counts cover the
+ * library as well (static builds only).
+ */
+static __thread bool counting;
+static uint64_t syscalls;
+
+ssize_t __real_read(int fd, void *buf, size_t count);
+ssize_t __real_write(int fd, const void *buf, size_t count);
+int __real_poll(struct pollfd *fds, nfds_t nfds, int timeout);
+ssize_t __real_recv(int fd, void *buf, size_t len, int flags);
+ssize_t __real_sendmsg(int fd, const struct msghdr *msg, int flags);
+long __real_syscall(long number, ...);
+
+ssize_t __wrap_read(int fd, void *buf, size_t count)
+{
+  syscalls += counting;
+  return __real_read(fd, buf, count);
+}
+
+ssize_t __wrap_write(int fd, const void *buf, size_t count)
+{
+  syscalls += counting;
+  return __real_write(fd, buf, count);
+}
+
+int __wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+  syscalls += counting;
+  return __real_poll(fds, nfds, timeout);
+}
+
+ssize_t __wrap_recv(int fd, void *buf, size_t len, int flags)
+{
+  syscalls += counting;
+  return __real_recv(fd, buf, len, flags);
+}
+
+ssize_t __wrap_sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+  syscalls += counting;
+  return __real_sendmsg(fd, msg, flags);
+}
+
+long __wrap_syscall(long number, ...)
+{
+  va_list ap;
+  long a[6];
+  int i;
+
+  va_start(ap, number);
+  for (i = 0; i < 6; i++)
+  {
+    a[i] = va_arg(ap, long);
+  }
+  va_end(ap);
+  syscalls += counting;
+  return __real_syscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+/* CPU time of the calling thread, in microseconds */
+static uint64_t
+threadCpuUs(void)
+{
+  struct rusage ru;
+
+  getrusage(RUSAGE_THREAD, &ru);
+  return ((uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000)
+    + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+typedef struct EchoArgs
+{
+  int fd;
+  uint32_t size;
+  /* When non-zero, answer the first frame with this many frames */
+  uint32_t stream;
+} EchoArgs;
+
+/* Plays the module: returns every frame once it has been fully received */
+static void *
+echoThread(void *arg)
+{
+  EchoArgs *args = arg;
+  uint8_t buf[256];
+  uint32_t have = 0;
+  ssize_t ret;
+
+  for (;;)
+  {
+    ret = read(args->fd, buf + have, args->size - have);
+    if (ret <= 0)
+    {
+      break;
+    }
+    have += ret;
+    if ((have == args->size) && (0 != args->stream))
+    {
+      uint32_t i;
+
+      for (i = 0; i < args->stream; i++)
+      {
+        if (write(args->fd, buf, have) != (ssize_t)have)
+        {
+          break;
+        }
+      }
+      have = 0;
+    }
+    else if (have == args->size)
+    {
+      if (write(args->fd, buf, have) != (ssize_t)have)
+      {
+        break;
+      }
+      have = 0;
+    }
+  }
+  return NULL;
+}
+
+/* Accepts one connection on the listening socket, then echoes like the pty side */
+static void *
+acceptThread(void *arg)
+{
+  EchoArgs *args = arg;
+  int listener = args->fd;
+
+  args->fd = accept(listener, NULL, NULL);
+  close(listener);
+  if (0 > args->fd)
+  {
+    return NULL;
+  }
+  echoThread(args);
+  close(args->fd);
+  return NULL;
+}
+
+/* Create a loopback listener on an ephemeral port; returns its port */
+static int
+openListener(bool ipv6, int *listener)
+{
+  struct sockaddr_storage ss;
+  socklen_t len;
+  int on = 1;
+
+  memset(&ss, 0, sizeof(ss));
+  if (ipv6)
+  {
+    struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&ss;
+
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_addr = in6addr_loopback;
+    len = sizeof(*sin6);
+  }
+  else
+  {
+    struct sockaddr_in *sin = (struct sockaddr_in *)&ss;
+
+    sin->sin_family = AF_INET;
+    sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    len = sizeof(*sin);
+  }
+
+  *listener = socket(ss.ss_family, SOCK_STREAM, 0);
+  if (0 > *listener)
+  {
+    return -1;
+  }
+  setsockopt(*listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if ((0 != bind(*listener, (struct sockaddr *)&ss, len)) ||
+      (0 != listen(*listener, 1)) ||
+      (0 != getsockname(*listener, (struct sockaddr *)&ss, &len)))
+  {
+    close(*listener);
+    return -1;
+  }
+
+  return ntohs(ipv6 ? ((struct sockaddr_in6 *)&ss)->sin6_port
+                    : ((struct sockaddr_in *)&ss)->sin_port);
+}
+
+static uint64_t
+nowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static int
+compareU64(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+  TMR_SR_SerialTransport transport;
+  static TMR_SR_SerialPortNativeContext context;
+  TMR_Status ret;
+  EchoArgs echo;
+  pthread_t tid;
+  struct termios t;
+  uint8_t tx[256], rx[256];
+  uint64_t *samples, total = 0;
+  uint32_t iterations = 1000, size = 64, i, got;
+  uint64_t connectUs = 0, cpuUs, wallUs;
+  bool tcp = false, ipv6 = false, stream = false, uring = false;
+  TMR_Status (*serialInit)(TMR_SR_SerialTransport *, TMR_SR_SerialPortNativeContext *, const char *);
+  TMR_Status (*tcpInit)(TMR_SR_SerialTransport *, TMR_SR_SerialPortNativeContext *, const char *);
+  int master = -1;
+  char *slave;
+  char device[64];
+
+  for (i = 1; i < (uint32_t)argc; i++)
+  {
+    if ((0 == strcmp("--iterations", argv[i])) && (i + 1 < (uint32_t)argc))
+    {
+      iterations = atoi(argv[++i]);
+    }
+    else if ((0 == strcmp("--size", argv[i])) && (i + 1 < (uint32_t)argc))
+    {
+      size = atoi(argv[++i]);
+    }
+    else if (0 == strcmp("--tcp", argv[i]))
+    {
+      tcp = true;
+    }
+    else if (0 == strcmp("--ipv6", argv[i]))
+    {
+      ipv6 = true;
+    }
+    else if (0 == strcmp("--stream", argv[i]))
+    {
+      stream = true;
+    }
+    else if (0 == strcmp("--uring", argv[i]))
+    {
+      uring = true;
+    }
+    else
+    {
+      fprintf(stderr, "Argument %s is not recognized\n", argv[i]);
+      usage();
+    }
+  }
+  /* Stream frames are read as the serial reader reads them: header, then the rest */
+  if ((0 == iterations) || (0 == size) || (size > sizeof(tx)) || (stream && (size < 6)))
+  {
+    usage();
+  }
+
+  serialInit = TMR_SR_SerialTransportNativeInit;
+  tcpInit = TMR_SR_SerialTransportTcpNativeInit;
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+  if (uring)
+  {
+    serialInit = TMR_SR_SerialTransportNativeUringInit;
+    tcpInit = TMR_SR_SerialTransportTcpUringInit;
+  }
+#else
+  if (uring)
+  {
+    errx(1, "The io_uring receive path is not included in this build\n");
+  }
+#endif
+
+  echo.size = size;
+  echo.stream = stream ? iterations : 0;
+  if (tcp)
+  {
+    int listener;
+    int port = openListener(ipv6, &listener);
+    uint64_t start;
+
+    if (0 > port)
+    {
+      errx(1, "Can't create loopback listener\n");
+    }
+    snprintf(device, sizeof(device), ipv6 ? "/[::1]:%d" : "/127.0.0.1:%d", port);
+    slave = device;
+
+    echo.fd = listener;
+    pthread_create(&tid, NULL, acceptThread, &echo);
+
+    start = nowUs();
+    ret = tcpInit(&transport, &context, slave);
+    if (TMR_SUCCESS == ret)
+    {
+      ret = transport.open(&transport);
+    }
+    connectUs = nowUs() - start;
+  }
+  else
+  {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((master < 0) || (0 != grantpt(master)) || (0 != unlockpt(master)))
+    {
+      errx(1, "Can't create pseudo-terminal\n");
+    }
+    slave = ptsname(master);
+    tcgetattr(master, &t);
+    cfmakeraw(&t);
+    tcsetattr(master, TCSANOW, &t);
+
+    ret = serialInit(&transport, &context, slave);
+    if (TMR_SUCCESS == ret)
+    {
+      ret = transport.open(&transport);
+    }
+    echo.fd = master;
+    if (TMR_SUCCESS == ret)
+    {
+      pthread_create(&tid, NULL, echoThread, &echo);
+    }
+  }
+  if (TMR_SUCCESS != ret)
+  {
+    errx(1, "Error opening %s: %d\n", slave, ret);
+  }
+
+  samples = malloc(iterations * sizeof(*samples));
+  if (NULL == samples)
+  {
+    errx(1, "Out of memory\n");
+  }
+  for (i = 0; i < size; i++)
+  {
+    tx[i] = (uint8_t)i;
+  }
+
+  counting = true;
+  cpuUs = threadCpuUs();
+  wallUs = nowUs();
+  if (stream)
+  {
+    ret = transport.sendBytes(&transport, size, tx, 1000);
+    for (i = 0; (TMR_SUCCESS == ret) && (i < iterations); i++)
+    {
+      ret = transport.receiveBytes(&transport, 5, &got, rx, 1000);
+      if (TMR_SUCCESS == ret)
+      {
+        ret = transport.receiveBytes(&transport, size - 5, &got, rx + 5, 1000);
+      }
+    }
+    if (TMR_SUCCESS != ret)
+    {
+      errx(1, "Stream frame %u failed: %d\n", i, ret);
+    }
+  }
+  else
+  {
+    for (i = 0; i < iterations; i++)
+    {
+      uint64_t start = nowUs();
+
+      ret = transport.sendBytes(&transport, size, tx, 1000);
+      if (TMR_SUCCESS == ret)
+      {
+        ret = transport.receiveBytes(&transport, size, &got, rx, 1000);
+      }
+      if (TMR_SUCCESS != ret)
+      {
+        errx(1, "Round trip %u failed: %d\n", i, ret);
+      }
+      samples[i] = nowUs() - start;
+      total += samples[i];
+    }
+  }
+  wallUs = nowUs() - wallUs;
+  cpuUs = threadCpuUs() - cpuUs;
+  counting = false;
+
+  printf("%u %s of %u bytes over %s, receiving through %s\n", iterations,
+         stream ? "streamed frames" : "round trips", size, slave,
+#ifdef TMR_ENABLE_SERIAL_TRANSPORT_URING
+         (NULL != context.uring) ? "io_uring" :
+#endif
+         "poll()");
+  if (tcp)
+  {
+    printf("connect %" PRIu64 " us\n", connectUs);
+  }
+  if (stream)
+  {
+    printf("%" PRIu64 " frames/s\n", wallUs ? ((uint64_t)iterations * 1000000) / wallUs : 0);
+  }
+  else
+  {
+    qsort(samples, iterations, sizeof(*samples), compareU64);
+    printf("min %" PRIu64 " us, avg %" PRIu64 " us, p50 %" PRIu64 " us, p99 %" PRIu64 " us, max %" PRIu64 " us\n",
+           samples[0], total / iterations, samples[iterations / 2],
+           samples[(iterations * 99) / 100], samples[iterations - 1]);
+  }
+  printf("%.2f system calls per frame, %.2f us CPU per frame\n",
+         (double)syscalls / iterations, (double)cpuUs / iterations);
+
+  /* Closing our end makes the echo thread's read fail */
+  transport.shutdown(&transport);
+  pthread_join(tid, NULL);
+  if (0 <= master)
+  {
+    close(master);
+  }
+  free(samples);
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  errx(1, "The native serial transport benchmark needs a POSIX build\n");
+  return 1;
+}
+
+#endif /* TMR_ENABLE_SERIAL_TRANSPORT_NATIVE && !WIN32 */